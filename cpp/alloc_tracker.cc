@@ -0,0 +1,377 @@
+#include "alloc_tracker.h"
+
+#include <execinfo.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <typeindex>
+
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+
+namespace alloc_tracker {
+namespace internal {
+namespace {
+
+// Types beyond this share slot 0 ("<overflow>").
+constexpr int kMaxTypes = 512;
+// Granularity at which per-thread live bytes are published for peaks.
+constexpr int64_t kFlushBytes = 64 * 1024;
+// Distinct stacks kept per type; further new stacks are dropped.
+constexpr size_t kMaxStacksPerType = 64;
+
+std::string Demangle(const char* name) {
+#if defined(__GNUG__)
+  int status = -100;
+  char* ret = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+  std::string out = (status == 0) ? ret : name;
+  if (ret) std::free(ret);
+  return out;
+#else
+  return name;
+#endif
+}
+
+struct TypeInfo {
+  std::string name;
+  size_t size{};
+  std::atomic<int64_t> live_bytes{};
+  std::atomic<int64_t> peak_bytes{};
+  // Guarded by `Registry::sample_mutex`.
+  std::map<std::vector<void*>, int64_t> stacks;
+};
+
+// Only written by the owning thread; read by `Snapshot()`.
+struct ThreadSlot {
+  std::atomic<int64_t> counts[kMaxTypes][kNumEvents];
+  int64_t pending_bytes[kMaxTypes];
+  // Maximum of `pending_bytes` since the last flush (so >= 0).
+  int64_t pending_peak[kMaxTypes];
+  int sample_countdown;
+};
+
+struct Registry {
+  std::atomic<int> sample_period{0};
+  std::atomic<int> max_stack_depth{16};
+
+  std::mutex mutex;
+  int num_types{1};
+  std::map<std::type_index, int> ids;
+  TypeInfo types[kMaxTypes];
+  std::vector<ThreadSlot*> slots;
+  // Counts from threads that have exited.
+  int64_t retired[kMaxTypes][kNumEvents]{};
+
+  std::mutex sample_mutex;
+
+  Registry() {
+    types[0].name = "<overflow>";
+  }
+};
+
+// Leaked, so that it outlives thread-local and static destructors.
+Registry& registry() {
+  static Registry* const r = new Registry();
+  return *r;
+}
+
+void UpdatePeak(TypeInfo* info, int64_t live) {
+  int64_t peak = info->peak_bytes.load(std::memory_order_relaxed);
+  while (live > peak &&
+         !info->peak_bytes.compare_exchange_weak(
+             peak, live, std::memory_order_relaxed)) {}
+}
+
+// Publishes the owning thread's pending bytes for `type_id`. The peak is
+// taken as the global live bytes before the flush plus this thread's peak
+// since the last one.
+void Flush(ThreadSlot* slot, int type_id) {
+  TypeInfo& info = registry().types[type_id];
+  int64_t& pending = slot->pending_bytes[type_id];
+  int64_t& pending_peak = slot->pending_peak[type_id];
+  const int64_t live =
+      info.live_bytes.fetch_add(pending, std::memory_order_relaxed);
+  UpdatePeak(&info, live + pending_peak);
+  pending = 0;
+  pending_peak = 0;
+}
+
+ThreadSlot* AttachSlot() {
+  ThreadSlot* slot = new ThreadSlot();
+  Registry& r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  r.slots.push_back(slot);
+  return slot;
+}
+
+void RetireSlot(ThreadSlot* slot) {
+  Registry& r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  for (int id = 0; id < r.num_types; ++id) {
+    for (int e = 0; e < kNumEvents; ++e) {
+      r.retired[id][e] += slot->counts[id][e].load(std::memory_order_relaxed);
+    }
+    if (slot->pending_bytes[id] != 0 || slot->pending_peak[id] != 0) {
+      Flush(slot, id);
+    }
+  }
+  r.slots.erase(std::find(r.slots.begin(), r.slots.end(), slot));
+  delete slot;
+}
+
+// Trivially destructible, so `Snapshot()` may read it from `atexit()`.
+thread_local ThreadSlot* current_slot = nullptr;
+
+struct SlotHandle {
+  ThreadSlot* const slot{AttachSlot()};
+  SlotHandle() { current_slot = slot; }
+  ~SlotHandle() {
+    current_slot = nullptr;
+    RetireSlot(slot);
+  }
+};
+
+ThreadSlot* GetSlot() {
+  thread_local SlotHandle handle;
+  return handle.slot;
+}
+
+void Sample(int type_id) {
+  Registry& r = registry();
+  const int max_depth = r.max_stack_depth.load(std::memory_order_relaxed);
+  std::vector<void*> frames(max_depth + 1);
+  const int depth = backtrace(frames.data(), frames.size());
+  // Drop `Sample()` itself.
+  frames.erase(frames.begin());
+  frames.resize(std::max(depth - 1, 0));
+  TypeInfo& info = r.types[type_id];
+  std::lock_guard<std::mutex> lock(r.sample_mutex);
+  auto iter = info.stacks.find(frames);
+  if (iter != info.stacks.end()) {
+    ++iter->second;
+  } else if (info.stacks.size() < kMaxStacksPerType) {
+    info.stacks.emplace(std::move(frames), 1);
+  }
+}
+
+int report_pipe[2] = {-1, -1};
+
+void OnReportSignal(int) {
+  const int saved_errno = errno;
+  const char byte = 0;
+  // Only async-signal-safe calls here; the reporter thread does the work.
+  if (write(report_pipe[1], &byte, 1) < 0) {}
+  errno = saved_errno;
+}
+
+void ReporterLoop() {
+  char byte{};
+  while (true) {
+    const ssize_t n = read(report_pipe[0], &byte, 1);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    Report(std::cerr);
+  }
+}
+
+void InstallReportSignal(int signum) {
+  static std::once_flag once;
+  std::call_once(once, [signum]() {
+    if (pipe(report_pipe) != 0) {
+      std::cerr << "alloc_tracker: pipe() failed" << std::endl;
+      return;
+    }
+    std::thread(&ReporterLoop).detach();
+    struct sigaction action{};
+    action.sa_handler = &OnReportSignal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(signum, &action, nullptr);
+  });
+}
+
+void InstallReportAtExit() {
+  static std::once_flag once;
+  std::call_once(once, []() {
+    std::atexit([]() { Report(std::cerr); });
+  });
+}
+
+bool EnvFlag(const char* name, int* value) {
+  const char* text = std::getenv(name);
+  if (!text || !*text) return false;
+  *value = std::atoi(text);
+  return true;
+}
+
+}  // namespace
+
+std::atomic<bool> enabled{true};
+
+int RegisterType(const std::type_info& type, size_t type_size) {
+  Registry& r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  auto iter = r.ids.find(type);
+  if (iter != r.ids.end()) {
+    return iter->second;
+  }
+  if (r.num_types == kMaxTypes) {
+    return 0;
+  }
+  const int id = r.num_types++;
+  r.types[id].name = Demangle(type.name());
+  r.types[id].size = type_size;
+  r.ids.emplace(type, id);
+  return id;
+}
+
+void RecordSlow(int type_id, Event event, int64_t bytes) {
+  Registry& r = registry();
+  ThreadSlot* slot = GetSlot();
+  std::atomic<int64_t>& count = slot->counts[type_id][event];
+  // Single writer: a plain load / store is enough, and avoids a locked RMW.
+  count.store(
+      count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  if (bytes != 0) {
+    int64_t& pending = slot->pending_bytes[type_id];
+    pending += bytes;
+    int64_t& pending_peak = slot->pending_peak[type_id];
+    if (pending > pending_peak) pending_peak = pending;
+    if (pending >= kFlushBytes || pending <= -kFlushBytes) {
+      Flush(slot, type_id);
+    }
+  }
+  if (event == kAlloc) {
+    const int period = r.sample_period.load(std::memory_order_relaxed);
+    if (period > 0 && --slot->sample_countdown <= 0) {
+      slot->sample_countdown = period;
+      Sample(type_id);
+    }
+  }
+}
+
+}  // namespace internal
+
+using namespace internal;
+
+void Configure(const Options& options) {
+  Registry& r = registry();
+  enabled = options.enabled;
+  r.sample_period = options.sample_period;
+  r.max_stack_depth = options.max_stack_depth;
+  if (options.report_at_exit) {
+    InstallReportAtExit();
+  }
+  if (options.report_signal != 0) {
+    InstallReportSignal(options.report_signal);
+  }
+}
+
+void ConfigureFromEnv(Options options) {
+  int value{};
+  if (EnvFlag("ALLOC_TRACKER_ENABLED", &value)) {
+    options.enabled = value != 0;
+  }
+  if (EnvFlag("ALLOC_TRACKER_SAMPLE_PERIOD", &value)) {
+    options.sample_period = value;
+  }
+  if (EnvFlag("ALLOC_TRACKER_REPORT_AT_EXIT", &value)) {
+    options.report_at_exit = value != 0;
+  }
+  if (EnvFlag("ALLOC_TRACKER_REPORT_SIGNAL", &value)) {
+    options.report_signal = value;
+  }
+  Configure(options);
+}
+
+std::vector<TypeReport> Snapshot() {
+  Registry& r = registry();
+  // Other threads' slots can only be flushed by their owners, so their
+  // pending bytes are only reflected in `live_bytes`.
+  ThreadSlot* const own = current_slot;
+  std::vector<TypeReport> out;
+  std::lock_guard<std::mutex> lock(r.mutex);
+  std::lock_guard<std::mutex> sample_lock(r.sample_mutex);
+  for (int id = 0; id < r.num_types; ++id) {
+    int64_t counts[kNumEvents]{};
+    for (int e = 0; e < kNumEvents; ++e) {
+      counts[e] = r.retired[id][e];
+      for (const ThreadSlot* slot : r.slots) {
+        counts[e] += slot->counts[id][e].load(std::memory_order_relaxed);
+      }
+    }
+    if (own &&
+        (own->pending_bytes[id] != 0 || own->pending_peak[id] != 0)) {
+      Flush(own, id);
+    }
+    if (counts[kAlloc] == 0 && counts[kClaim] == 0) continue;
+    TypeInfo& info = r.types[id];
+    TypeReport report;
+    report.name = info.name;
+    report.type_size = info.size;
+    report.allocs = counts[kAlloc];
+    report.frees = counts[kFree];
+    report.claims = counts[kClaim];
+    report.releases = counts[kRelease];
+    report.live = report.claims - report.releases - report.frees;
+    report.live_bytes = report.live * static_cast<int64_t>(info.size);
+    // Keep what this snapshot saw, so that later peaks include it.
+    UpdatePeak(&info, report.live_bytes);
+    report.peak_bytes = info.peak_bytes.load(std::memory_order_relaxed);
+    for (const auto& [frames, count] : info.stacks) {
+      report.stacks.push_back({frames, count});
+    }
+    std::sort(
+        report.stacks.begin(), report.stacks.end(),
+        [](const StackSample& a, const StackSample& b) {
+          return a.count > b.count;
+        });
+    out.push_back(std::move(report));
+  }
+  return out;
+}
+
+void Report(std::ostream& os, int max_stacks_per_type) {
+  std::vector<TypeReport> reports = Snapshot();
+  std::sort(
+      reports.begin(), reports.end(),
+      [](const TypeReport& a, const TypeReport& b) {
+        return a.allocs > b.allocs;
+      });
+  os << "[ alloc_tracker ]\n";
+  os << std::setw(12) << "allocs" << std::setw(12) << "frees"
+     << std::setw(12) << "live" << std::setw(14) << "live_bytes"
+     << std::setw(14) << "peak_bytes" << std::setw(12) << "claims"
+     << std::setw(12) << "releases" << "  type\n";
+  for (const TypeReport& report : reports) {
+    os << std::setw(12) << report.allocs << std::setw(12) << report.frees
+       << std::setw(12) << report.live << std::setw(14) << report.live_bytes
+       << std::setw(14) << report.peak_bytes << std::setw(12) << report.claims
+       << std::setw(12) << report.releases << "  " << report.name << "\n";
+    const int num_stacks = std::min<int>(
+        max_stacks_per_type, report.stacks.size());
+    for (int i = 0; i < num_stacks; ++i) {
+      const StackSample& stack = report.stacks[i];
+      os << "    sampled " << stack.count << "x:\n";
+      char** symbols = backtrace_symbols(
+          stack.frames.data(), stack.frames.size());
+      for (size_t f = 0; f < stack.frames.size(); ++f) {
+        os << "      " << (symbols ? symbols[f] : "?") << "\n";
+      }
+      std::free(symbols);
+    }
+  }
+  os << std::flush;
+}
+
+}  // namespace alloc_tracker
@@ -0,0 +1,169 @@
+#pragma once
+
+// Per-type allocation / ownership tracker, cheap enough to leave enabled in
+// long-running processes.
+//
+// Plugs into `unique_ptr_tracked` (see `unique_ptr_tracked.h`) as its
+// `Tracker`, replacing the `cout`-based `ptr_tracker`:
+//
+//   alloc_tracker::unique_ptr<Foo> foo = alloc_tracker::make_unique<Foo>(...);
+//
+// Counters are kept in per-thread slots (single writer, relaxed atomics, no
+// read-modify-write on the hot path) and are only merged when a report is
+// requested. Live bytes are additionally flushed to a per-type global counter
+// in coarse batches (`kFlushBytes`) to maintain the peak, together with each
+// thread's own peak since its last flush; `Snapshot()` flushes the calling
+// thread first. The reported peak may still under-estimate the true peak by
+// at most `kFlushBytes` per other thread.
+//
+// Optionally, every `sample_period`-th tracked allocation on a thread records
+// its call stack, so the report can point at who is churning a type.
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include "unique_ptr_tracked.h"
+
+namespace alloc_tracker {
+
+struct Options {
+  // Master switch. When false, the hooks only do a relaxed load.
+  bool enabled{true};
+  // Capture a stack for every N-th tracked allocation per thread; 0 disables.
+  int sample_period{0};
+  // Maximum number of frames per sampled stack.
+  int max_stack_depth{16};
+  // Report to stderr at `exit()`.
+  bool report_at_exit{false};
+  // Report to stderr whenever this signal is received; 0 disables.
+  int report_signal{0};
+};
+
+// Applies `options`. May be called at any time; signal / exit installation
+// is only ever done once.
+void Configure(const Options& options);
+
+// Configures from `options`, overridden by the environment:
+//   ALLOC_TRACKER_ENABLED=0|1
+//   ALLOC_TRACKER_SAMPLE_PERIOD=<n>
+//   ALLOC_TRACKER_REPORT_AT_EXIT=0|1
+//   ALLOC_TRACKER_REPORT_SIGNAL=<signum>
+void ConfigureFromEnv(Options options = {});
+
+struct StackSample {
+  std::vector<void*> frames;
+  int64_t count{};
+};
+
+struct TypeReport {
+  std::string name;
+  size_t type_size{};
+  // Objects allocated through `make_unique` / `tracked_new`.
+  int64_t allocs{};
+  // Objects deleted while owned by a tracked pointer.
+  int64_t frees{};
+  // Ownership transfers into / out of tracked pointers. A move between
+  // tracked pointers (e.g. when a vector of them grows) counts as both.
+  int64_t claims{};
+  int64_t releases{};
+  // Objects currently owned by tracked pointers.
+  int64_t live{};
+  int64_t live_bytes{};
+  int64_t peak_bytes{};
+  // Most frequent sampled allocation stacks, descending by count.
+  std::vector<StackSample> stacks;
+};
+
+// Merges all per-thread slots, after flushing the calling thread's. Types
+// with no activity are omitted.
+std::vector<TypeReport> Snapshot();
+
+// Writes a table of `Snapshot()`, sorted by allocation churn.
+void Report(std::ostream& os, int max_stacks_per_type = 3);
+
+namespace internal {
+
+enum Event : int {
+  kAlloc,
+  kFree,
+  kClaim,
+  kRelease,
+  kNumEvents,
+};
+
+// Checked inline so that disabled hooks do not cost a call.
+extern std::atomic<bool> enabled;
+
+int RegisterType(const std::type_info& info, size_t type_size);
+void RecordSlow(int type_id, Event event, int64_t bytes);
+
+inline void Record(int type_id, Event event, int64_t bytes) {
+  if (enabled.load(std::memory_order_relaxed)) {
+    RecordSlow(type_id, event, bytes);
+  }
+}
+
+template <typename T>
+int type_id() {
+  static const int id = RegisterType(typeid(T), sizeof(T));
+  return id;
+}
+
+}  // namespace internal
+
+// `Tracker` for `unique_ptr_tracked` / `delete_tracker`.
+// N.B. Bytes are accounted as `sizeof(T)`, i.e. the static type.
+template <typename T>
+class tracker {
+ public:
+  static void on_alloc(T* ptr) {
+    if (ptr) {
+      internal::Record(internal::type_id<T>(), internal::kAlloc, 0);
+    }
+  }
+
+  static void on_claim(T* ptr) {
+    if (ptr) {
+      internal::Record(internal::type_id<T>(), internal::kClaim, sizeof(T));
+    }
+  }
+
+  static void on_release(T* ptr) {
+    if (ptr) {
+      internal::Record(
+          internal::type_id<T>(), internal::kRelease, -int64_t{sizeof(T)});
+    }
+  }
+
+  static void on_delete(T* ptr) {
+    if (ptr) {
+      internal::Record(
+          internal::type_id<T>(), internal::kFree, -int64_t{sizeof(T)});
+      delete ptr;
+    }
+  }
+};
+
+template <typename T>
+using unique_ptr = unique_ptr_tracked<T, std::default_delete<T>, tracker<T>>;
+
+// Allocates `T` and records it as an allocation. The result should be handed
+// to a tracked pointer, which records the claim.
+template <typename T, typename... Args>
+T* tracked_new(Args&&... args) {
+  T* ptr = new T(std::forward<Args>(args)...);
+  tracker<T>::on_alloc(ptr);
+  return ptr;
+}
+
+template <typename T, typename... Args>
+unique_ptr<T> make_unique(Args&&... args) {
+  return unique_ptr<T>(tracked_new<T>(std::forward<Args>(args)...));
+}
+
+}  // namespace alloc_tracker
@@ -0,0 +1,45 @@
+// Overhead of `alloc_tracker` hooks vs. plain `unique_ptr`.
+
+#include <memory>
+
+#include "benchmark/benchmark.h"
+
+#include "alloc_tracker.h"
+
+namespace {
+
+struct Small { int value{}; };
+
+}  // namespace
+
+static void BM_UniquePtr(benchmark::State& state) {
+  for (auto _ : state) {
+    auto ptr = std::make_unique<Small>();
+    benchmark::DoNotOptimize(ptr.get());
+  }
+}
+BENCHMARK(BM_UniquePtr)->ThreadRange(1, 8);
+
+static void BM_Tracked(benchmark::State& state) {
+  alloc_tracker::Options options;
+  options.sample_period = state.range(0);
+  alloc_tracker::Configure(options);
+  for (auto _ : state) {
+    auto ptr = alloc_tracker::make_unique<Small>();
+    benchmark::DoNotOptimize(ptr.get());
+  }
+}
+BENCHMARK(BM_Tracked)->Arg(0)->Arg(10000)->ThreadRange(1, 8);
+
+static void BM_TrackedDisabled(benchmark::State& state) {
+  alloc_tracker::Options options;
+  options.enabled = false;
+  alloc_tracker::Configure(options);
+  for (auto _ : state) {
+    auto ptr = alloc_tracker::make_unique<Small>();
+    benchmark::DoNotOptimize(ptr.get());
+  }
+}
+BENCHMARK(BM_TrackedDisabled);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,52 @@
+// Example of `alloc_tracker` with `unique_ptr_tracked`.
+// Try: ALLOC_TRACKER_REPORT_SIGNAL=10 ./alloc_tracker_main & kill -USR1 $!
+
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "alloc_tracker.h"
+
+using namespace std;
+
+struct Small { int value{}; };
+struct Big { double data[128]{}; };
+
+// Allocates and drops `Small`s in a loop; keeps a few `Big`s alive.
+void Churn(int num_iter, vector<alloc_tracker::unique_ptr<Big>>* keep) {
+  for (int i = 0; i < num_iter; ++i) {
+    auto small = alloc_tracker::make_unique<Small>();
+    small->value = i;
+    if (i % 100 == 0) {
+      keep->push_back(alloc_tracker::make_unique<Big>());
+    }
+  }
+}
+
+int main() {
+  alloc_tracker::Options options;
+  options.sample_period = 1000;
+  options.report_at_exit = true;
+  alloc_tracker::ConfigureFromEnv(options);
+
+  vector<alloc_tracker::unique_ptr<Big>> keep[4];
+  vector<thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back(&Churn, 10000, &keep[t]);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  {
+    // Ownership leaving tracked pointers is counted as a release.
+    unique_ptr<Big> untracked = std::move(keep[0].back());
+    keep[0].pop_back();
+  }
+  for (const auto& report : alloc_tracker::Snapshot()) {
+    cout << report.name << ": allocs=" << report.allocs
+         << " frees=" << report.frees << " live=" << report.live
+         << " live_bytes=" << report.live_bytes << endl;
+  }
+  return 0;
+}
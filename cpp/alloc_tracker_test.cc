@@ -0,0 +1,164 @@
+#include "alloc_tracker.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+// Types are registered process-wide, so each test uses its own.
+namespace alloc_tracker_test {
+
+struct Small { int value{}; };
+struct Moved { int value{}; };
+struct Big { char data[1024]{}; };
+struct Reported { int value{}; };
+
+}  // namespace alloc_tracker_test
+
+namespace alloc_tracker {
+namespace {
+
+using namespace alloc_tracker_test;
+
+TypeReport Find(const std::string& name) {
+  for (TypeReport& report : Snapshot()) {
+    if (report.name == name) return report;
+  }
+  ADD_FAILURE() << "No report for " << name;
+  return {};
+}
+
+TEST(AllocTrackerTest, SingleThread) {
+  {
+    auto a = make_unique<Small>();
+    auto b = make_unique<Small>();
+    { auto c = make_unique<Small>(); }
+    const TypeReport report = Find("alloc_tracker_test::Small");
+    EXPECT_EQ(report.type_size, sizeof(Small));
+    EXPECT_EQ(report.allocs, 3);
+    EXPECT_EQ(report.frees, 1);
+    EXPECT_EQ(report.claims, 3);
+    EXPECT_EQ(report.releases, 0);
+    EXPECT_EQ(report.live, 2);
+    EXPECT_EQ(report.live_bytes, 2 * int64_t{sizeof(Small)});
+    // Far below `kFlushBytes`, but the calling thread is flushed first.
+    EXPECT_EQ(report.peak_bytes, 3 * int64_t{sizeof(Small)});
+  }
+  const TypeReport report = Find("alloc_tracker_test::Small");
+  EXPECT_EQ(report.frees, 3);
+  EXPECT_EQ(report.live, 0);
+  EXPECT_EQ(report.live_bytes, 0);
+  EXPECT_EQ(report.peak_bytes, 3 * int64_t{sizeof(Small)});
+}
+
+TEST(AllocTrackerTest, MovesAndReleases) {
+  auto a = make_unique<Moved>();
+  // A move between tracked pointers is a release and a claim.
+  unique_ptr<Moved> b(std::move(a));
+  std::unique_ptr<Moved> untracked = std::move(b);
+  const TypeReport report = Find("alloc_tracker_test::Moved");
+  EXPECT_EQ(report.allocs, 1);
+  EXPECT_EQ(report.frees, 0);
+  EXPECT_EQ(report.claims, 2);
+  EXPECT_EQ(report.releases, 2);
+  EXPECT_EQ(report.live, 0);
+  EXPECT_EQ(report.peak_bytes, int64_t{sizeof(Moved)});
+}
+
+TEST(AllocTrackerTest, ManyThreads) {
+  constexpr int kThreads = 4;
+  constexpr int kPerThread = 1000;
+  constexpr int64_t kBytes = int64_t{kThreads} * kPerThread * sizeof(Big);
+  std::mutex mutex;
+  std::condition_variable cv;
+  int num_ready = 0;
+  bool release = false;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&]() {
+      std::vector<unique_ptr<Big>> keep;
+      keep.reserve(kPerThread);
+      for (int i = 0; i < kPerThread; ++i) {
+        keep.emplace_back(make_unique<Big>());
+      }
+      std::unique_lock<std::mutex> lock(mutex);
+      ++num_ready;
+      cv.notify_all();
+      cv.wait(lock, [&]() { return release; });
+    });
+  }
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&]() { return num_ready == kThreads; });
+  }
+  // Merged from the slots of running threads.
+  TypeReport report = Find("alloc_tracker_test::Big");
+  EXPECT_EQ(report.allocs, kThreads * kPerThread);
+  // Each is claimed by `make_unique`, then moved into `keep`.
+  EXPECT_EQ(report.claims, 2 * kThreads * kPerThread);
+  EXPECT_EQ(report.releases, kThreads * kPerThread);
+  EXPECT_EQ(report.frees, 0);
+  EXPECT_EQ(report.live_bytes, kBytes);
+  EXPECT_EQ(report.peak_bytes, kBytes);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    release = true;
+  }
+  cv.notify_all();
+  for (std::thread& thread : threads) thread.join();
+  // Merged from the slots of exited threads.
+  report = Find("alloc_tracker_test::Big");
+  EXPECT_EQ(report.allocs, kThreads * kPerThread);
+  EXPECT_EQ(report.frees, kThreads * kPerThread);
+  EXPECT_EQ(report.live, 0);
+  EXPECT_EQ(report.live_bytes, 0);
+  EXPECT_EQ(report.peak_bytes, kBytes);
+}
+
+TEST(AllocTrackerTest, Disabled) {
+  Options options;
+  options.enabled = false;
+  Configure(options);
+  { auto ignored = make_unique<Reported>(); }
+  Configure(Options{});
+  for (const TypeReport& report : Snapshot()) {
+    EXPECT_NE(report.name, "alloc_tracker_test::Reported");
+  }
+}
+
+TEST(AllocTrackerTest, Report) {
+  auto a = make_unique<Reported>();
+  std::ostringstream os;
+  alloc_tracker::Report(os);
+  const std::string text = os.str();
+  EXPECT_EQ(text.rfind("[ alloc_tracker ]\n", 0), 0u);
+  std::istringstream lines(text);
+  std::string line;
+  bool found = false;
+  while (std::getline(lines, line)) {
+    if (line.find("alloc_tracker_test::Reported") == std::string::npos) {
+      continue;
+    }
+    found = true;
+    std::istringstream fields(line);
+    int64_t allocs, frees, live, live_bytes, peak_bytes, claims, releases;
+    fields >> allocs >> frees >> live >> live_bytes >> peak_bytes >> claims >>
+        releases;
+    EXPECT_EQ(allocs, 1);
+    EXPECT_EQ(frees, 0);
+    EXPECT_EQ(live, 1);
+    EXPECT_EQ(live_bytes, int64_t{sizeof(Reported)});
+    EXPECT_EQ(peak_bytes, int64_t{sizeof(Reported)});
+    EXPECT_EQ(claims, 1);
+    EXPECT_EQ(releases, 0);
+  }
+  EXPECT_TRUE(found);
+}
+
+}  // namespace
+}  // namespace alloc_tracker
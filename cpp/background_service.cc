@@ -0,0 +1,403 @@
+#include "background_service.h"
+
+#include <pthread.h>
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+
+namespace background {
+namespace internal {
+
+namespace {
+
+int64_t ThreadCpuNs(clockid_t clock) {
+  timespec t{};
+  if (clock_gettime(clock, &t) != 0) return 0;
+  return static_cast<int64_t>(t.tv_sec) * 1000000000 + t.tv_nsec;
+}
+
+void UpdateMax(std::atomic<int64_t>* max, int64_t value) {
+  int64_t current = max->load(std::memory_order_relaxed);
+  while (value > current &&
+         !max->compare_exchange_weak(current, value,
+                                     std::memory_order_relaxed)) {}
+}
+
+}  // namespace
+
+struct TaskState {
+  TaskId id{};
+  std::string name;
+  bool is_worker{};
+  BackgroundService::TaskFunc func;
+  BackgroundService::WorkerFunc worker_func;
+  // 0 for `ScheduleOnce`.
+  Clock::duration period{};
+  std::atomic<bool> cancelled{false};
+
+  // Guarded by `ServiceState::mutex`.
+  Clock::time_point scheduled;
+  int64_t expiry_tick{};
+  bool finished{};
+  // Set while a worker thread runs, so `Stats()` can read its CPU clock.
+  bool has_cpu_clock{};
+  clockid_t cpu_clock{};
+
+  // Written by the thread running the task.
+  std::atomic<int64_t> wakeups{0};
+  std::atomic<int64_t> cpu_ns{0};
+  std::atomic<int64_t> missed{0};
+  std::atomic<int64_t> max_lateness_ns{0};
+};
+
+struct ThreadEntry {
+  std::thread thread;
+  std::string name;
+  // Guarded by `ServiceState::mutex`.
+  bool done{};
+  std::string running;  // Task a pool thread is running, if any.
+};
+
+struct ServiceState : std::enable_shared_from_this<ServiceState> {
+  explicit ServiceState(const BackgroundService::Options& options_in)
+      : options(options_in), start(Clock::now()), wheel(options.wheel_slots) {}
+
+  StopToken Token(std::shared_ptr<TaskState> task) {
+    return StopToken(shared_from_this(), std::move(task));
+  }
+
+  int64_t TickAtOrAfter(Clock::time_point time) const {
+    if (time <= start) return 0;
+    const Clock::duration since = time - start;
+    return (since + options.tick - Clock::duration(1)) / options.tick;
+  }
+
+  // Requires `mutex`.
+  void Arm(const std::shared_ptr<TaskState>& task) {
+    task->expiry_tick = std::max(TickAtOrAfter(task->scheduled), next_tick);
+    wheel[task->expiry_tick % wheel.size()].push_back(task);
+    const bool earliest =
+        expiries.empty() || task->expiry_tick < expiries.top();
+    expiries.push(task->expiry_tick);
+    if (earliest) timer_cv.notify_one();
+  }
+
+  // Requires `mutex`.
+  ThreadEntry* AddThread(std::string name) {
+    threads.push_back(std::make_unique<ThreadEntry>());
+    threads.back()->name = std::move(name);
+    return threads.back().get();
+  }
+
+  // Requires `mutex`.
+  void ThreadDone(ThreadEntry* entry) {
+    entry->done = true;
+    done_cv.notify_all();
+  }
+
+  void TimerLoop(ThreadEntry* entry) {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+      if (expiries.empty()) {
+        timer_cv.wait(lock);
+        continue;
+      }
+      const Clock::time_point due = start + expiries.top() * options.tick;
+      const Clock::time_point now = Clock::now();
+      if (now < due) {
+        timer_cv.wait_until(lock, due);
+        continue;
+      }
+      // Expire every slot from `next_tick` up to now; after a gap of a full
+      // turn or more, each slot is visited once.
+      const int64_t last = (now - start) / options.tick;
+      const int64_t slots = static_cast<int64_t>(wheel.size());
+      const int64_t count = std::min(last - next_tick + 1, slots);
+      for (int64_t k = 0; k < count; ++k) {
+        auto& slot = wheel[(next_tick + k) % slots];
+        auto keep = slot.begin();
+        for (auto& task : slot) {
+          if (task->expiry_tick > last) {
+            *keep++ = std::move(task);
+            continue;
+          }
+          if (task->cancelled) {
+            task->finished = true;
+          } else {
+            queue.push_back(std::move(task));
+            queue_cv.notify_one();
+          }
+        }
+        slot.erase(keep, slot.end());
+      }
+      next_tick = last + 1;
+      while (!expiries.empty() && expiries.top() <= last) expiries.pop();
+    }
+    ThreadDone(entry);
+  }
+
+  void PoolLoop(ThreadEntry* entry) {
+    const clockid_t clock = CLOCK_THREAD_CPUTIME_ID;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      queue_cv.wait(lock, [this]() { return stopping || !queue.empty(); });
+      if (stopping) break;
+      std::shared_ptr<TaskState> task = std::move(queue.front());
+      queue.pop_front();
+      entry->running = task->name;
+      const Clock::time_point scheduled = task->scheduled;
+      lock.unlock();
+
+      UpdateMax(&task->max_lateness_ns,
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    Clock::now() - scheduled).count());
+      const int64_t cpu_start = ThreadCpuNs(clock);
+      bool again = false;
+      try {
+        again = task->func(Token(task));
+      } catch (const std::exception& e) {
+        std::cerr << "BackgroundService: task '" << task->name
+                  << "' threw: " << e.what() << "\n";
+      }
+      task->cpu_ns += ThreadCpuNs(clock) - cpu_start;
+      task->wakeups += 1;
+
+      lock.lock();
+      entry->running.clear();
+      if (again && task->period > Clock::duration::zero() &&
+          !task->cancelled && !stopping) {
+        // Fixed rate; runs already due are skipped, not run back to back.
+        Clock::time_point next = scheduled + task->period;
+        const Clock::time_point now = Clock::now();
+        if (next < now) {
+          const int64_t missed = (now - next) / task->period + 1;
+          task->missed += missed;
+          next += missed * task->period;
+        }
+        task->scheduled = next;
+        Arm(task);
+      } else {
+        task->finished = true;
+      }
+    }
+    ThreadDone(entry);
+  }
+
+  void WorkerMain(ThreadEntry* entry, std::shared_ptr<TaskState> task) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (pthread_getcpuclockid(pthread_self(), &task->cpu_clock) == 0) {
+        task->has_cpu_clock = true;
+      }
+    }
+    try {
+      task->worker_func(Token(task));
+    } catch (const std::exception& e) {
+      std::cerr << "BackgroundService: worker '" << task->name
+                << "' threw: " << e.what() << "\n";
+    }
+    const int64_t cpu = ThreadCpuNs(CLOCK_THREAD_CPUTIME_ID);
+    std::lock_guard<std::mutex> lock(mutex);
+    task->cpu_ns = cpu;
+    task->has_cpu_clock = false;
+    task->finished = true;
+    ThreadDone(entry);
+  }
+
+  const BackgroundService::Options options;
+  const Clock::time_point start;
+
+  std::mutex mutex;
+  std::condition_variable timer_cv;
+  std::condition_variable queue_cv;
+  std::condition_variable stop_cv;
+  std::condition_variable done_cv;
+  std::atomic<bool> stopping{false};
+
+  // Timer wheel: slot `tick % size` holds the tasks expiring at `tick`, or
+  // a multiple of `size` ticks later.
+  std::vector<std::vector<std::shared_ptr<TaskState>>> wheel;
+  // Expiry tick of every task in `wheel`, so the next due tick is known
+  // without scanning the wheel.
+  std::priority_queue<int64_t, std::vector<int64_t>, std::greater<int64_t>>
+      expiries;
+  int64_t next_tick{};
+  std::deque<std::shared_ptr<TaskState>> queue;
+
+  std::vector<std::shared_ptr<TaskState>> tasks;
+  std::vector<std::unique_ptr<ThreadEntry>> threads;
+  bool stopped{};
+  bool stop_result{};
+  std::vector<std::string> unfinished;
+};
+
+}  // namespace internal
+
+using internal::ServiceState;
+using internal::TaskState;
+using internal::ThreadEntry;
+
+bool StopToken::stop_requested() const {
+  return service_->stopping || task_->cancelled;
+}
+
+bool StopToken::WaitFor(Clock::duration timeout) const {
+  task_->wakeups += 1;
+  std::unique_lock<std::mutex> lock(service_->mutex);
+  return service_->stop_cv.wait_for(
+      lock, timeout, [this]() { return stop_requested(); });
+}
+
+BackgroundService::BackgroundService(Options options) {
+  if (options.num_threads < 1 || options.wheel_slots < 1 ||
+      options.tick <= Clock::duration::zero()) {
+    throw std::invalid_argument("BackgroundService: bad options");
+  }
+  state_ = std::make_shared<ServiceState>(options);
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  ThreadEntry* timer = state_->AddThread("timer");
+  timer->thread = std::thread(&ServiceState::TimerLoop, state_, timer);
+  for (int i = 0; i < options.num_threads; ++i) {
+    ThreadEntry* pool = state_->AddThread("pool");
+    pool->thread = std::thread(&ServiceState::PoolLoop, state_, pool);
+  }
+}
+
+BackgroundService::~BackgroundService() { Stop(std::chrono::seconds(5)); }
+
+TaskId BackgroundService::SchedulePeriodic(
+    std::string name, Clock::duration period, TaskFunc func) {
+  if (period <= Clock::duration::zero()) {
+    throw std::invalid_argument("SchedulePeriodic: period must be positive");
+  }
+  auto task = std::make_shared<TaskState>();
+  task->name = std::move(name);
+  task->func = std::move(func);
+  task->period = period;
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  task->id = static_cast<TaskId>(state_->tasks.size());
+  state_->tasks.push_back(task);
+  if (state_->stopping) {
+    task->finished = true;
+  } else {
+    task->scheduled = Clock::now() + period;
+    state_->Arm(task);
+  }
+  return task->id;
+}
+
+TaskId BackgroundService::ScheduleOnce(
+    std::string name, Clock::duration delay, TaskFunc func) {
+  auto task = std::make_shared<TaskState>();
+  task->name = std::move(name);
+  task->func = std::move(func);
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  task->id = static_cast<TaskId>(state_->tasks.size());
+  state_->tasks.push_back(task);
+  if (state_->stopping) {
+    task->finished = true;
+  } else {
+    task->scheduled = Clock::now() + delay;
+    state_->Arm(task);
+  }
+  return task->id;
+}
+
+TaskId BackgroundService::StartWorker(std::string name, WorkerFunc func) {
+  auto task = std::make_shared<TaskState>();
+  task->name = std::move(name);
+  task->is_worker = true;
+  task->worker_func = std::move(func);
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  task->id = static_cast<TaskId>(state_->tasks.size());
+  state_->tasks.push_back(task);
+  if (state_->stopping) {
+    task->finished = true;
+  } else {
+    ThreadEntry* entry = state_->AddThread(task->name);
+    entry->thread =
+        std::thread(&ServiceState::WorkerMain, state_, entry, task);
+  }
+  return task->id;
+}
+
+void BackgroundService::Cancel(TaskId id) {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  if (id < 0 || id >= static_cast<TaskId>(state_->tasks.size())) return;
+  state_->tasks[id]->cancelled = true;
+  state_->stop_cv.notify_all();
+}
+
+bool BackgroundService::Stop(Clock::duration timeout) {
+  ServiceState& state = *state_;
+  std::unique_lock<std::mutex> lock(state.mutex);
+  if (state.stopped) return state.stop_result;
+  state.stopped = true;
+  state.stopping = true;
+  // Tasks waiting for a timer or a pool thread will not run.
+  for (auto& task : state.queue) task->finished = true;
+  state.queue.clear();
+  for (auto& slot : state.wheel) {
+    for (auto& task : slot) task->finished = true;
+    slot.clear();
+  }
+  state.timer_cv.notify_all();
+  state.queue_cv.notify_all();
+  state.stop_cv.notify_all();
+  state.done_cv.wait_for(lock, timeout, [&state]() {
+    return std::all_of(state.threads.begin(), state.threads.end(),
+                       [](const auto& entry) { return entry->done; });
+  });
+  std::vector<std::thread> to_join;
+  for (auto& entry : state.threads) {
+    if (entry->done) {
+      to_join.push_back(std::move(entry->thread));
+    } else {
+      entry->thread.detach();
+      state.unfinished.push_back(
+          entry->running.empty() ? entry->name :
+              entry->name + " (running " + entry->running + ")");
+    }
+  }
+  state.stop_result = state.unfinished.empty();
+  lock.unlock();
+  for (std::thread& thread : to_join) thread.join();
+  return state.stop_result;
+}
+
+std::vector<std::string> BackgroundService::unfinished() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->unfinished;
+}
+
+std::vector<TaskStats> BackgroundService::Stats() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  std::vector<TaskStats> stats;
+  stats.reserve(state_->tasks.size());
+  for (const auto& task : state_->tasks) {
+    TaskStats s;
+    s.id = task->id;
+    s.name = task->name;
+    s.is_worker = task->is_worker;
+    s.wakeups = task->wakeups;
+    s.cpu_time = std::chrono::nanoseconds(
+        task->has_cpu_clock ? internal::ThreadCpuNs(task->cpu_clock) :
+            task->cpu_ns.load());
+    s.missed = task->missed;
+    s.max_lateness = std::chrono::nanoseconds(task->max_lateness_ns.load());
+    s.finished = task->finished;
+    stats.push_back(std::move(s));
+  }
+  return stats;
+}
+
+}  // namespace background
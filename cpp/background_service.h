@@ -0,0 +1,138 @@
+#pragma once
+
+// Managed background work, instead of detached threads that run until the
+// process dies (see `thread_daemon.cc`):
+//
+// * Periodic / delayed tasks share a small thread pool, fed by a hashed
+//   timer wheel on one timer thread, so hundreds of periodic tasks do not
+//   need hundreds of sleeping threads.
+// * Long-running workers get their own thread (like `std::jthread`), and a
+//   `StopToken` whose `WaitFor` doubles as an interruptible sleep.
+// * `Stop(timeout)` asks everything to stop and joins for at most `timeout`;
+//   threads still running then are detached and reported rather than
+//   blocking shutdown forever.
+// * Per task / worker CPU time, wake-ups, and late runs are available from
+//   `Stats()`.
+//
+//   background::BackgroundService service;
+//   service.SchedulePeriodic("flush", 100ms, [&](const StopToken&) {
+//     Flush();
+//     return true;  // false to stop rescheduling.
+//   });
+//   service.StartWorker("reader", [&](const StopToken& stop) {
+//     while (!stop.stop_requested()) ReadSome(stop);
+//   });
+//   ...
+//   service.Stop(1s);
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace background {
+
+using Clock = std::chrono::steady_clock;
+
+namespace internal {
+struct ServiceState;
+struct TaskState;
+}  // namespace internal
+
+// Cooperative stop signal for one task or worker.
+class StopToken {
+ public:
+  bool stop_requested() const;
+
+  // Sleeps for `timeout`, waking early if stop is requested; returns
+  // `stop_requested()`. Counted as a wake-up in the stats.
+  bool WaitFor(Clock::duration timeout) const;
+
+ private:
+  friend struct internal::ServiceState;
+  StopToken(std::shared_ptr<internal::ServiceState> service,
+            std::shared_ptr<internal::TaskState> task)
+      : service_(std::move(service)), task_(std::move(task)) {}
+
+  std::shared_ptr<internal::ServiceState> service_;
+  std::shared_ptr<internal::TaskState> task_;
+};
+
+using TaskId = int64_t;
+
+struct TaskStats {
+  TaskId id{};
+  std::string name;
+  // Dedicated thread (`StartWorker`) rather than the pool.
+  bool is_worker{};
+  // Runs (tasks), or returns from `StopToken::WaitFor` (workers).
+  int64_t wakeups{};
+  // CPU time spent in the task / worker thread so far.
+  Clock::duration cpu_time{};
+  // Periodic runs skipped because the previous one (or the pool) was late.
+  int64_t missed{};
+  // Largest delay from a run's scheduled time to its start.
+  Clock::duration max_lateness{};
+  bool finished{};
+};
+
+class BackgroundService {
+ public:
+  struct Options {
+    // Pool threads running periodic / delayed tasks.
+    int num_threads{2};
+    // Timer wheel resolution and size; periods are rounded up to ticks.
+    Clock::duration tick{std::chrono::milliseconds(1)};
+    int wheel_slots{512};
+  };
+
+  using TaskFunc = std::function<bool(const StopToken&)>;
+  using WorkerFunc = std::function<void(const StopToken&)>;
+
+  BackgroundService() : BackgroundService(Options{}) {}
+  explicit BackgroundService(Options options);
+
+  // `Stop(std::chrono::seconds(5))`, if not stopped already.
+  ~BackgroundService();
+
+  BackgroundService(const BackgroundService&) = delete;
+  BackgroundService& operator=(const BackgroundService&) = delete;
+
+  // Runs `func` on the pool every `period` (fixed rate, first run one period
+  // from now) until it returns false, is cancelled, or the service stops. A
+  // task never overlaps itself; runs that would have started while it was
+  // still running are skipped and counted as missed.
+  TaskId SchedulePeriodic(std::string name, Clock::duration period,
+                          TaskFunc func);
+
+  // Runs `func` once on the pool after `delay` (its return value is
+  // ignored).
+  TaskId ScheduleOnce(std::string name, Clock::duration delay, TaskFunc func);
+
+  // Runs `func` on a new thread; it should return soon after its token's
+  // stop is requested.
+  TaskId StartWorker(std::string name, WorkerFunc func);
+
+  // Requests stop for one task or worker; a periodic task is not run again.
+  // Does not wait.
+  void Cancel(TaskId id);
+
+  // Requests stop for everything, and waits up to `timeout` for all threads
+  // to finish. Returns true if they all did; otherwise the rest are detached
+  // (they keep only shared state alive) and their names are in
+  // `unfinished()`. Later calls return the first result.
+  bool Stop(Clock::duration timeout);
+
+  // Tasks and workers that had not finished when `Stop` gave up.
+  std::vector<std::string> unfinished() const;
+
+  // One entry per task / worker, in creation order.
+  std::vector<TaskStats> Stats() const;
+
+ private:
+  std::shared_ptr<internal::ServiceState> state_;
+};
+
+}  // namespace background
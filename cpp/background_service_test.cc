@@ -0,0 +1,196 @@
+#include "background_service.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+namespace background {
+namespace {
+
+using namespace std::chrono_literals;
+
+void SpinFor(Clock::duration duration) {
+  const Clock::time_point end = Clock::now() + duration;
+  while (Clock::now() < end) {}
+}
+
+TEST(BackgroundServiceTest, PeriodicAndOnce) {
+  BackgroundService service;
+  std::atomic<int> ticks{0};
+  std::atomic<int> once{0};
+  service.SchedulePeriodic("tick", 5ms, [&](const StopToken&) {
+    return ++ticks < 4;
+  });
+  service.ScheduleOnce("once", 1ms, [&](const StopToken&) {
+    ++once;
+    return true;  // Ignored.
+  });
+  for (int i = 0; i < 2000 && (ticks < 4 || once < 1); ++i) {
+    std::this_thread::sleep_for(1ms);
+  }
+  std::this_thread::sleep_for(20ms);
+  EXPECT_EQ(ticks, 4);
+  EXPECT_EQ(once, 1);
+  EXPECT_TRUE(service.Stop(1s));
+  const std::vector<TaskStats> stats = service.Stats();
+  ASSERT_EQ(stats.size(), 2u);
+  EXPECT_EQ(stats[0].name, "tick");
+  EXPECT_EQ(stats[0].wakeups, 4);
+  EXPECT_TRUE(stats[0].finished);
+  EXPECT_FALSE(stats[0].is_worker);
+  EXPECT_EQ(stats[1].wakeups, 1);
+  EXPECT_TRUE(stats[1].finished);
+}
+
+TEST(BackgroundServiceTest, ManyPeriodicTasksOnOneThread) {
+  BackgroundService::Options options;
+  options.num_threads = 1;
+  options.wheel_slots = 16;  // Periods span several turns of the wheel.
+  BackgroundService service(options);
+  constexpr int kTasks = 200;
+  std::vector<std::unique_ptr<std::atomic<int>>> counts;
+  for (int i = 0; i < kTasks; ++i) {
+    counts.push_back(std::make_unique<std::atomic<int>>(0));
+    std::atomic<int>* count = counts.back().get();
+    service.SchedulePeriodic(
+        "task" + std::to_string(i), std::chrono::milliseconds(10 + i % 30),
+        [count](const StopToken&) { return ++*count < 3; });
+  }
+  const Clock::time_point deadline = Clock::now() + 5s;
+  for (int i = 0; i < kTasks; ++i) {
+    while (*counts[i] < 3 && Clock::now() < deadline) {
+      std::this_thread::sleep_for(1ms);
+    }
+    EXPECT_EQ(*counts[i], 3) << i;
+  }
+  EXPECT_TRUE(service.Stop(1s));
+}
+
+TEST(BackgroundServiceTest, Cancel) {
+  BackgroundService service;
+  std::atomic<int> runs{0};
+  const TaskId periodic = service.SchedulePeriodic(
+      "periodic", 2ms, [&](const StopToken&) { ++runs; return true; });
+  const TaskId once = service.ScheduleOnce(
+      "once", 20ms, [&](const StopToken&) { runs += 1000; return true; });
+  while (runs == 0) std::this_thread::sleep_for(1ms);
+  service.Cancel(periodic);
+  service.Cancel(once);
+  std::this_thread::sleep_for(10ms);
+  const int after_cancel = runs;
+  std::this_thread::sleep_for(40ms);
+  EXPECT_EQ(runs, after_cancel);
+  EXPECT_LT(runs, 1000);
+  const std::vector<TaskStats> stats = service.Stats();
+  EXPECT_TRUE(stats[periodic].finished);
+  EXPECT_TRUE(stats[once].finished);
+}
+
+TEST(BackgroundServiceTest, WorkerStopsOnRequest) {
+  BackgroundService service;
+  std::atomic<bool> cancelled_saw_stop{false};
+  const TaskId first = service.StartWorker("first", [&](const StopToken& t) {
+    while (!t.WaitFor(1s)) {}
+    cancelled_saw_stop = t.stop_requested();
+  });
+  service.StartWorker("second", [&](const StopToken& t) {
+    while (!t.WaitFor(1ms)) {}
+  });
+  service.Cancel(first);
+  for (int i = 0; i < 1000 && !service.Stats()[first].finished; ++i) {
+    std::this_thread::sleep_for(1ms);
+  }
+  EXPECT_TRUE(cancelled_saw_stop);
+  EXPECT_FALSE(service.Stats()[1].finished);
+  const Clock::time_point start = Clock::now();
+  EXPECT_TRUE(service.Stop(1s));
+  EXPECT_LT(Clock::now() - start, 500ms);
+  const std::vector<TaskStats> stats = service.Stats();
+  EXPECT_TRUE(stats[1].is_worker);
+  EXPECT_TRUE(stats[1].finished);
+  EXPECT_GE(stats[1].wakeups, 1);
+  EXPECT_TRUE(service.unfinished().empty());
+}
+
+TEST(BackgroundServiceTest, PendingTasksFinishOnStop) {
+  BackgroundService::Options options;
+  options.num_threads = 1;
+  BackgroundService service(options);
+  std::atomic<bool> started{false};
+  // Occupies the only pool thread, so "queued" is stuck in the queue.
+  service.ScheduleOnce("busy", 0ms, [&](const StopToken&) {
+    started = true;
+    SpinFor(30ms);
+    return false;
+  });
+  while (!started) std::this_thread::sleep_for(1ms);
+  service.ScheduleOnce("queued", 0ms, [](const StopToken&) { return false; });
+  service.SchedulePeriodic("later", 1h, [](const StopToken&) { return true; });
+  std::this_thread::sleep_for(5ms);
+  EXPECT_TRUE(service.Stop(1s));
+  const std::vector<TaskStats> stats = service.Stats();
+  ASSERT_EQ(stats.size(), 3u);
+  EXPECT_EQ(stats[0].wakeups, 1);
+  EXPECT_EQ(stats[1].wakeups, 0);
+  EXPECT_EQ(stats[2].wakeups, 0);
+  for (const TaskStats& s : stats) EXPECT_TRUE(s.finished) << s.name;
+}
+
+TEST(BackgroundServiceTest, StopIsBounded) {
+  // Shared, since the stuck worker outlives the service.
+  auto release = std::make_shared<std::atomic<bool>>(false);
+  auto finished = std::make_shared<std::atomic<bool>>(false);
+  {
+    BackgroundService service;
+    service.StartWorker("polite", [](const StopToken& t) {
+      while (!t.WaitFor(1s)) {}
+    });
+    service.StartWorker("stuck", [release, finished](const StopToken&) {
+      while (!*release) std::this_thread::sleep_for(1ms);
+      *finished = true;
+    });
+    const Clock::time_point start = Clock::now();
+    EXPECT_FALSE(service.Stop(50ms));
+    EXPECT_LT(Clock::now() - start, 1s);
+    EXPECT_EQ(service.unfinished(), std::vector<std::string>{"stuck"});
+    EXPECT_FALSE(service.Stop(1s));
+  }
+  *release = true;
+  // Do not leave its thread running into later tests.
+  while (!*finished) std::this_thread::sleep_for(1ms);
+}
+
+TEST(BackgroundServiceTest, StatsCpuTimeAndMissedRuns) {
+  BackgroundService::Options options;
+  options.num_threads = 1;
+  BackgroundService service(options);
+  std::atomic<int> runs{0};
+  // Each run takes longer than the period, so every other run is skipped.
+  service.SchedulePeriodic("slow", 5ms, [&](const StopToken&) {
+    SpinFor(7ms);
+    return ++runs < 5;
+  });
+  std::atomic<bool> spun{false};
+  const TaskId worker = service.StartWorker("spin", [&](const StopToken& t) {
+    SpinFor(20ms);
+    spun = true;
+    t.WaitFor(10s);
+  });
+  for (int i = 0; i < 5000 && (runs < 5 || !spun); ++i) {
+    std::this_thread::sleep_for(1ms);
+  }
+  // Live worker, read from its thread's CPU clock.
+  EXPECT_GE(service.Stats()[worker].cpu_time, 10ms);
+  EXPECT_TRUE(service.Stop(1s));
+  const std::vector<TaskStats> stats = service.Stats();
+  EXPECT_EQ(stats[0].wakeups, 5);
+  EXPECT_GE(stats[0].missed, 4);
+  EXPECT_GE(stats[0].cpu_time, 20ms);
+  EXPECT_GE(stats[worker].cpu_time, 10ms);
+}
+
+}  // namespace
+}  // namespace background
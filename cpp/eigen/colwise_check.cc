@@ -1,10 +1,13 @@
 // Objective: Check if colwise() / rowwise() can be used for selection
 // Followup: Implement simple row / column views to ease selection.
+// See `index_view.h` for index-list views.
 #include <iostream>
 #include <vector>
 
 #include <Eigen/Dense>
 
+#include "index_view.h"
+
 using namespace std;
 using namespace Eigen;
 
@@ -157,5 +160,11 @@ int main() {
   X_cols[1] /= 100.;
   cout << X << endl << endl;
 
+  // Same selection as `select_indices`, without the copy-out loop.
+  const index_view::IndexList sub_rows({2, 0});
+  cout << MatrixXd(index_view::rows(X, sub_rows)) << endl << endl;
+  index_view::rows(X, sub_rows) = X_sub;  // Restore rows 2 and 0.
+  cout << X << endl << endl;
+
   return 0;
 }
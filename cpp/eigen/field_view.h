@@ -0,0 +1,86 @@
+#pragma once
+
+// Views of one member of a matrix of records, as plain strided `Map`s,
+// following up on the `CwiseUnaryView` hacks in `unary_view_mutable.cc`.
+//
+//   struct Value { double a; int b; };
+//   MatrixX<Value> X(n, m);
+//   auto X_a = field_view(X, &Value::a);  // Map<MatrixXd, 0, Stride<...>>
+//   X_a *= 10;
+//   Eigen::Ref<MatrixXd, 0, FieldStride> X_a_ref = X_a;
+//
+// Since the result is a `Map` (not a `CwiseUnaryView` over a functor), it has
+// direct access: it binds to `Eigen::Ref` (with a matching stride type), and
+// assignments / reductions go through Eigen's regular `Map` evaluators, with
+// no per-coefficient functor call. The inner stride is known at compile time
+// (`sizeof(Record) / sizeof(Field)`) when the record storage is contiguous.
+//
+// N.B. Packet (SIMD) loads still need unit inner stride; for field-wise math
+// on large record sets, prefer a struct-of-arrays layout.
+
+#include <type_traits>
+#include <utility>
+
+#include <Eigen/Dense>
+
+namespace eigen_field {
+
+namespace internal {
+
+template <typename Record, typename Field, int RecordInnerStride>
+struct field_stride {
+  static_assert(
+      sizeof(Record) % sizeof(Field) == 0,
+      "Record size must be a multiple of the field size");
+  static constexpr int kRatio = sizeof(Record) / sizeof(Field);
+  static constexpr int kInner =
+      RecordInnerStride == Eigen::Dynamic ?
+      Eigen::Dynamic : RecordInnerStride * kRatio;
+};
+
+}  // namespace internal
+
+// Stride type of `field_view(xpr, &Record::field)` for a contiguous `xpr`
+// (plain matrices, columns of column-major matrices, etc.).
+template <typename Record, typename Field>
+using FieldStride = Eigen::Stride<
+    Eigen::Dynamic, internal::field_stride<Record, Field, 1>::kInner>;
+
+// Strided map of `member` over the records of `xpr`. `xpr` must have direct
+// access; the view is read-only if `xpr` is.
+template <typename XprType, typename Record, typename Field>
+auto field_view(XprType&& xpr, Field Record::* member) {
+  using Derived = typename std::decay<XprType>::type;
+  static_assert(
+      std::is_same<typename Derived::Scalar, Record>::value,
+      "Member must belong to the scalar type");
+  static_assert(
+      bool(Eigen::internal::has_direct_access<Derived>::ret),
+      "Expression must have direct access (plain object, block, map, ...)");
+  constexpr bool kIsConst =
+      std::is_const<typename std::remove_reference<XprType>::type>::value ||
+      !bool(Eigen::internal::is_lvalue<Derived>::value);
+  using Stride = internal::field_stride<
+      Record, Field,
+      Eigen::internal::inner_stride_at_compile_time<Derived>::ret>;
+  using Plain = Eigen::Matrix<
+      Field, Derived::RowsAtCompileTime, Derived::ColsAtCompileTime,
+      Derived::IsRowMajor ? Eigen::RowMajor : Eigen::ColMajor,
+      Derived::MaxRowsAtCompileTime, Derived::MaxColsAtCompileTime>;
+  using StrideType = Eigen::Stride<Eigen::Dynamic, Stride::kInner>;
+  using MapType = Eigen::Map<
+      typename std::conditional<kIsConst, const Plain, Plain>::type,
+      Eigen::Unaligned, StrideType>;
+  using FieldPtr =
+      typename std::conditional<kIsConst, const Field*, Field*>::type;
+
+  Record* const data = const_cast<Record*>(xpr.data());
+  return MapType(
+      xpr.size() == 0 ? nullptr : static_cast<FieldPtr>(&(data->*member)),
+      xpr.rows(), xpr.cols(),
+      StrideType(
+          xpr.outerStride() * Stride::kRatio,
+          xpr.innerStride() * Stride::kRatio));
+}
+
+}  // namespace eigen_field
@@ -0,0 +1,89 @@
+// Reductions / in-place updates of one field of a large record matrix:
+// `CwiseUnaryView` over an accessor functor (as in `unary_view_mutable.cc`)
+// vs. the strided `Map` from `field_view.h`.
+
+#include <Eigen/Dense>
+
+#include "benchmark/benchmark.h"
+
+#include "field_view.h"
+
+using eigen_field::field_view;
+using eigen_field::FieldStride;
+
+namespace {
+
+struct Value {
+  double a{1.5};
+  int b{2};
+};
+
+using MatrixXValue = Eigen::Matrix<Value, Eigen::Dynamic, Eigen::Dynamic>;
+
+struct get_a {
+  double operator()(const Value& v) const { return v.a; }
+};
+
+struct get_a_ref {
+  double& operator()(const Value& v) const {
+    return const_cast<Value&>(v).a;
+  }
+};
+
+}  // namespace
+
+static void BM_SumUnaryView(benchmark::State& state) {
+  const MatrixXValue X(state.range(0), 16);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(X.unaryViewExpr(get_a()).sum());
+  }
+  state.SetItemsProcessed(state.iterations() * X.size());
+}
+
+static void BM_SumFieldView(benchmark::State& state) {
+  const MatrixXValue X(state.range(0), 16);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(field_view(X, &Value::a).sum());
+  }
+  state.SetItemsProcessed(state.iterations() * X.size());
+}
+
+static void BM_ScaleUnaryView(benchmark::State& state) {
+  MatrixXValue X(state.range(0), 16);
+  for (auto _ : state) {
+    Eigen::CwiseUnaryView<get_a_ref, MatrixXValue>(X, get_a_ref()) *= 1.001;
+    benchmark::DoNotOptimize(X.data());
+  }
+  state.SetItemsProcessed(state.iterations() * X.size());
+}
+
+static void BM_ScaleFieldView(benchmark::State& state) {
+  MatrixXValue X(state.range(0), 16);
+  for (auto _ : state) {
+    field_view(X, &Value::a) *= 1.001;
+    benchmark::DoNotOptimize(X.data());
+  }
+  state.SetItemsProcessed(state.iterations() * X.size());
+}
+
+// Column-wise norms, through `Ref` (no copy).
+static void BM_ColNormsFieldViewRef(benchmark::State& state) {
+  const MatrixXValue X(state.range(0), 16);
+  Eigen::VectorXd norms(X.cols());
+  for (auto _ : state) {
+    Eigen::Ref<const Eigen::MatrixXd, 0, FieldStride<Value, double>> X_a =
+        field_view(X, &Value::a);
+    norms = X_a.colwise().norm();
+    benchmark::DoNotOptimize(norms.data());
+  }
+  state.SetItemsProcessed(state.iterations() * X.size());
+}
+
+#define SIZE_ARGS Range(64, 1 << 16)
+BENCHMARK(BM_SumUnaryView)->SIZE_ARGS;
+BENCHMARK(BM_SumFieldView)->SIZE_ARGS;
+BENCHMARK(BM_ScaleUnaryView)->SIZE_ARGS;
+BENCHMARK(BM_ScaleFieldView)->SIZE_ARGS;
+BENCHMARK(BM_ColNormsFieldViewRef)->SIZE_ARGS;
+
+BENCHMARK_MAIN();
@@ -0,0 +1,346 @@
+#pragma once
+
+// Index-list row / column views, following up on `RowView` / `ColView` in
+// `colwise_check.cc`.
+//
+//   const IndexList joints({3, 4, 5, 9});
+//   MatrixXd q_sub = rows(Q, joints);     // gather
+//   rows(Q, joints) = q_sub;              // scatter
+//   rows(Q, joints) += dq;                // read-modify-write in place
+//   double s = (rows(Q, joints).lazy() * 2).sum();  // fused, no temporary
+//
+// `IndexList` precomputes maximal contiguous runs of its indices once, so
+// that gather / scatter are a handful of `block()` copies (which Eigen
+// vectorizes) when the selection is mostly contiguous, and degrade gracefully
+// to per-row / per-column copies otherwise. Build the `IndexList` once and
+// reuse it every tick.
+//
+// Views are Eigen expressions (`ReturnByValue`), so they can be assigned to
+// any dense object without an intermediate copy; `lazy()` additionally gives
+// a coefficient-wise `CwiseNullaryOp` for composing into larger expressions.
+//
+// N.B. A view (and its `lazy()` expression) only references its `IndexList`
+// and, for lvalues, its expression; both must outlive it.
+
+#include <algorithm>
+#include <initializer_list>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Dense>
+
+namespace index_view {
+template <typename XprType, bool SelectRows, bool SelectCols>
+class IndexView;
+}  // namespace index_view
+
+namespace Eigen {
+namespace internal {
+
+template <typename XprType, bool SelectRows, bool SelectCols>
+struct traits<index_view::IndexView<XprType, SelectRows, SelectCols>> {
+  using Xpr = typename remove_all<XprType>::type;
+  enum {
+    Rows = SelectRows ? Dynamic : int(Xpr::RowsAtCompileTime),
+    Cols = SelectCols ? Dynamic : int(Xpr::ColsAtCompileTime),
+    Options =
+        (Rows == 1 && Cols != 1) ? RowMajor :
+        (Cols == 1 && Rows != 1) ? ColMajor :
+        (int(Xpr::Flags) & RowMajorBit) ? RowMajor : ColMajor,
+  };
+  using ReturnType = Matrix<typename Xpr::Scalar, Rows, Cols, Options>;
+};
+
+}  // namespace internal
+}  // namespace Eigen
+
+namespace index_view {
+
+class IndexList {
+ public:
+  using Index = Eigen::Index;
+
+  // A maximal run such that `indices[dst + k] == src + k` for
+  // `k in [0, size)`.
+  struct Run {
+    Index src{};
+    Index dst{};
+    Index size{};
+  };
+
+  IndexList() = default;
+  IndexList(std::vector<Index> indices)
+      : indices_(std::move(indices)) {
+    Init();
+  }
+  IndexList(std::initializer_list<Index> indices)
+      : indices_(indices) {
+    Init();
+  }
+
+  Index size() const { return indices_.size(); }
+  Index operator[](Index i) const { return indices_[i]; }
+  const std::vector<Index>& indices() const { return indices_; }
+  const std::vector<Run>& runs() const { return runs_; }
+  // Upper bound (exclusive) of the indices, for bounds checks.
+  Index end() const { return end_; }
+
+ private:
+  void Init() {
+    for (Index i = 0; i < size(); ++i) {
+      const Index index = indices_[i];
+      if (index < 0) {
+        throw std::runtime_error("IndexList: negative index");
+      }
+      end_ = std::max(end_, index + 1);
+      if (!runs_.empty() &&
+          runs_.back().src + runs_.back().size == index) {
+        ++runs_.back().size;
+      } else {
+        runs_.push_back({index, i, 1});
+      }
+    }
+  }
+
+  std::vector<Index> indices_;
+  std::vector<Run> runs_;
+  Index end_{};
+};
+
+namespace internal {
+
+// Calls `f(src, dst, size)` for each run; `list == nullptr` means "all of
+// `n`".
+template <typename Func>
+void ForEachRun(const IndexList* list, Eigen::Index n, Func&& f) {
+  if (!list) {
+    f(0, 0, n);
+  } else {
+    for (const IndexList::Run& run : list->runs()) {
+      f(run.src, run.dst, run.size);
+    }
+  }
+}
+
+// Calls `f(block)` for the given block of `m`. Single-row / single-column
+// blocks use `row()` / `col()` segments, which are much cheaper than a fully
+// dynamic `block()` when the runs are short.
+template <typename M, typename Func>
+void ApplyBlock(M&& m, Eigen::Index r, Eigen::Index c, Eigen::Index nr,
+                Eigen::Index nc, Func&& f) {
+  if (nr == 1) {
+    f(m.row(r).segment(c, nc));
+  } else if (nc == 1) {
+    f(m.col(c).segment(r, nr));
+  } else {
+    f(m.block(r, c, nr, nc));
+  }
+}
+
+// Two-operand version of `ApplyBlock`: `f(dst_block, src_block)`.
+template <typename Dst, typename Src, typename Func>
+void ApplyBlock(Dst&& dst, Eigen::Index dr, Eigen::Index dc, const Src& src,
+                Eigen::Index sr, Eigen::Index sc, Eigen::Index nr,
+                Eigen::Index nc, Func&& f) {
+  if (nr == 1) {
+    f(dst.row(dr).segment(dc, nc), src.row(sr).segment(sc, nc));
+  } else if (nc == 1) {
+    f(dst.col(dc).segment(dr, nr), src.col(sc).segment(sr, nr));
+  } else {
+    f(dst.block(dr, dc, nr, nc), src.block(sr, sc, nr, nc));
+  }
+}
+
+// Coefficient-wise gather, for `lazy()`. Lvalue expressions are referenced;
+// temporary ones (e.g. `Block<>`) are copied, so that the returned expression
+// does not dangle once the view is gone.
+template <typename XprType>
+struct gather_op {
+  using Index = Eigen::Index;
+  using Xpr = typename Eigen::internal::remove_all<XprType>::type;
+  using Scalar = typename Xpr::Scalar;
+  using Stored = typename std::conditional<
+      std::is_reference<XprType>::value, const Xpr*, Xpr>::type;
+
+  gather_op(const Xpr& xpr, const IndexList* row_indices,
+            const IndexList* col_indices)
+      : xpr_(Store(xpr, std::is_reference<XprType>{})),
+        row_indices_(row_indices),
+        col_indices_(col_indices) {}
+
+  Scalar operator()(Index i, Index j) const {
+    return Get(xpr_).coeff(
+        row_indices_ ? (*row_indices_)[i] : i,
+        col_indices_ ? (*col_indices_)[j] : j);
+  }
+
+ private:
+  static const Xpr* Store(const Xpr& xpr, std::true_type) { return &xpr; }
+  static Xpr Store(const Xpr& xpr, std::false_type) { return xpr; }
+  static const Xpr& Get(const Xpr* xpr) { return *xpr; }
+  static const Xpr& Get(const Xpr& xpr) { return xpr; }
+
+  Stored xpr_;
+  const IndexList* row_indices_;
+  const IndexList* col_indices_;
+};
+
+}  // namespace internal
+
+// View of `xpr` restricted to `row_indices` (if `SelectRows`) and
+// `col_indices` (if `SelectCols`).
+// `XprType` follows `RowView`: `T&` / `const T&` for lvalues, or a value type
+// for temporary expressions (e.g. `Block<>`).
+template <typename XprType, bool SelectRows, bool SelectCols>
+class IndexView
+    : public Eigen::ReturnByValue<IndexView<XprType, SelectRows, SelectCols>> {
+ public:
+  using Xpr = typename Eigen::internal::remove_all<XprType>::type;
+  using Scalar = typename Xpr::Scalar;
+  using Index = Eigen::Index;
+
+  IndexView(XprType xpr, const IndexList* row_indices,
+            const IndexList* col_indices)
+      : xpr_(std::forward<XprType>(xpr)),
+        row_indices_(row_indices),
+        col_indices_(col_indices) {
+    eigen_assert(SelectRows == (row_indices != nullptr));
+    eigen_assert(SelectCols == (col_indices != nullptr));
+    eigen_assert(!SelectRows || row_indices->end() <= xpr_.rows());
+    eigen_assert(!SelectCols || col_indices->end() <= xpr_.cols());
+  }
+
+  Index rows() const {
+    return SelectRows ? row_indices_->size() : xpr_.rows();
+  }
+  Index cols() const {
+    return SelectCols ? col_indices_->size() : xpr_.cols();
+  }
+
+  // Gather: run-wise block copies into `dest`.
+  template <typename Dest>
+  void evalTo(Dest& dest) const {
+    dest.resize(rows(), cols());
+    internal::ForEachRun(row_indices_, xpr_.rows(),
+        [&](Index r_src, Index r_dst, Index r_size) {
+      internal::ForEachRun(col_indices_, xpr_.cols(),
+          [&](Index c_src, Index c_dst, Index c_size) {
+        internal::ApplyBlock(
+            dest, r_dst, c_dst, xpr_, r_src, c_src, r_size, c_size,
+            [](auto&& dst, auto&& src) { dst = src; });
+      });
+    });
+  }
+
+  // Coefficient-wise gather expression, for fusing into larger expressions.
+  auto lazy() const {
+    using Plain = typename Eigen::internal::traits<IndexView>::ReturnType;
+    return Plain::NullaryExpr(
+        rows(), cols(),
+        internal::gather_op<XprType>(xpr_, row_indices_, col_indices_));
+  }
+
+  // Scatter: run-wise block copies from `other`.
+  template <typename OtherDerived>
+  IndexView& operator=(const Eigen::DenseBase<OtherDerived>& other) {
+    Scatter(other, [](auto&& dst, auto&& src) { dst = src; });
+    return *this;
+  }
+
+  // Needed since the implicit copy-assignment would otherwise be selected.
+  IndexView& operator=(const IndexView& other) {
+    return operator=(other.eval());
+  }
+
+  template <typename OtherDerived>
+  IndexView& operator+=(const Eigen::DenseBase<OtherDerived>& other) {
+    Scatter(other, [](auto&& dst, auto&& src) { dst += src; });
+    return *this;
+  }
+
+  template <typename OtherDerived>
+  IndexView& operator-=(const Eigen::DenseBase<OtherDerived>& other) {
+    Scatter(other, [](auto&& dst, auto&& src) { dst -= src; });
+    return *this;
+  }
+
+  IndexView& operator*=(const Scalar& value) {
+    ForEachBlock([&](Index r, Index c, Index nr, Index nc, Index, Index) {
+      internal::ApplyBlock(
+          xpr_, r, c, nr, nc, [&](auto&& block) { block *= value; });
+    });
+    return *this;
+  }
+
+  IndexView& setConstant(const Scalar& value) {
+    ForEachBlock([&](Index r, Index c, Index nr, Index nc, Index, Index) {
+      internal::ApplyBlock(
+          xpr_, r, c, nr, nc, [&](auto&& block) { block.setConstant(value); });
+    });
+    return *this;
+  }
+
+ private:
+  // Calls `f(src_row, src_col, rows, cols, dst_row, dst_col)` per block.
+  template <typename Func>
+  void ForEachBlock(Func&& f) {
+    internal::ForEachRun(row_indices_, xpr_.rows(),
+        [&](Index r_src, Index r_dst, Index r_size) {
+      internal::ForEachRun(col_indices_, xpr_.cols(),
+          [&](Index c_src, Index c_dst, Index c_size) {
+        f(r_src, c_src, r_size, c_size, r_dst, c_dst);
+      });
+    });
+  }
+
+  template <typename OtherDerived, typename Op>
+  void Scatter(const Eigen::DenseBase<OtherDerived>& other, Op&& op) {
+    eigen_assert(other.rows() == rows() && other.cols() == cols());
+    // Plain objects are used as-is; expressions (including other views,
+    // which may alias `xpr_`) are evaluated once up front.
+    const auto& src = other.derived().eval();
+    ForEachBlock([&](Index r, Index c, Index nr, Index nc, Index r_dst,
+                     Index c_dst) {
+      internal::ApplyBlock(xpr_, r, c, src, r_dst, c_dst, nr, nc, op);
+    });
+  }
+
+  XprType xpr_;
+  const IndexList* row_indices_{};
+  const IndexList* col_indices_{};
+};
+
+template <typename XprType>
+auto rows(XprType&& xpr, const IndexList& row_indices) {
+  return IndexView<XprType, true, false>(
+      std::forward<XprType>(xpr), &row_indices, nullptr);
+}
+
+template <typename XprType>
+auto cols(XprType&& xpr, const IndexList& col_indices) {
+  return IndexView<XprType, false, true>(
+      std::forward<XprType>(xpr), nullptr, &col_indices);
+}
+
+template <typename XprType>
+auto view(XprType&& xpr, const IndexList& row_indices,
+          const IndexList& col_indices) {
+  return IndexView<XprType, true, true>(
+      std::forward<XprType>(xpr), &row_indices, &col_indices);
+}
+
+// Views only reference their indices, so do not bind temporaries.
+template <typename XprType>
+void rows(XprType&&, IndexList&&) = delete;
+template <typename XprType>
+void cols(XprType&&, IndexList&&) = delete;
+template <typename XprType>
+void view(XprType&&, IndexList&&, const IndexList&) = delete;
+template <typename XprType>
+void view(XprType&&, const IndexList&, IndexList&&) = delete;
+template <typename XprType>
+void view(XprType&&, IndexList&&, IndexList&&) = delete;
+
+}  // namespace index_view
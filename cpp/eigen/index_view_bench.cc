@@ -0,0 +1,78 @@
+// Gather / scatter of a joint subset of a large state matrix, per tick:
+// index loop (copy-out / copy-in, as in `colwise_check.cc`'s
+// `select_indices`) vs. `index_view.h`.
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "benchmark/benchmark.h"
+
+#include "index_view.h"
+
+using Eigen::Index;
+using Eigen::MatrixXd;
+using index_view::IndexList;
+
+namespace {
+
+constexpr int kNumCols = 64;
+
+// `num_groups` contiguous groups of `group_size` rows, e.g. arms of a robot,
+// with a gap of 3 rows between groups.
+std::vector<Index> MakeIndices(int num_groups, int group_size) {
+  std::vector<Index> out;
+  for (int g = 0; g < num_groups; ++g) {
+    for (int k = 0; k < group_size; ++k) {
+      out.push_back(g * (group_size + 3) + k);
+    }
+  }
+  return out;
+}
+
+}  // namespace
+
+static void BM_IndexLoop(benchmark::State& state) {
+  const std::vector<Index> indices = MakeIndices(state.range(0), state.range(1));
+  MatrixXd X = MatrixXd::Random(indices.back() + 1, kNumCols);
+  MatrixXd sub(indices.size(), kNumCols);
+  for (auto _ : state) {
+    for (size_t i = 0; i < indices.size(); ++i) {
+      sub.row(i) = X.row(indices[i]);
+    }
+    sub *= 1.001;
+    for (size_t i = 0; i < indices.size(); ++i) {
+      X.row(indices[i]) = sub.row(i);
+    }
+    benchmark::DoNotOptimize(X.data());
+  }
+}
+
+static void BM_IndexView(benchmark::State& state) {
+  const IndexList indices(MakeIndices(state.range(0), state.range(1)));
+  MatrixXd X = MatrixXd::Random(indices.end(), kNumCols);
+  MatrixXd sub(indices.size(), kNumCols);
+  for (auto _ : state) {
+    sub = index_view::rows(X, indices);
+    sub *= 1.001;
+    index_view::rows(X, indices) = sub;
+    benchmark::DoNotOptimize(X.data());
+  }
+}
+
+static void BM_IndexViewInPlace(benchmark::State& state) {
+  const IndexList indices(MakeIndices(state.range(0), state.range(1)));
+  MatrixXd X = MatrixXd::Random(indices.end(), kNumCols);
+  for (auto _ : state) {
+    index_view::rows(X, indices) *= 1.001;
+    benchmark::DoNotOptimize(X.data());
+  }
+}
+
+// {num_groups, group_size}: scattered single rows through long runs.
+#define INDEX_ARGS Args({32, 1})->Args({8, 7})->Args({4, 50})->Args({1, 400})
+BENCHMARK(BM_IndexLoop)->INDEX_ARGS;
+BENCHMARK(BM_IndexView)->INDEX_ARGS;
+BENCHMARK(BM_IndexViewInPlace)->INDEX_ARGS;
+
+BENCHMARK_MAIN();
@@ -0,0 +1,102 @@
+#include "index_view.h"
+
+#include <gtest/gtest.h>
+
+using Eigen::Index;
+using Eigen::MatrixXd;
+using index_view::IndexList;
+
+namespace {
+
+MatrixXd MakeMatrix(Index rows, Index cols) {
+  MatrixXd X(rows, cols);
+  for (Index i = 0; i < X.size(); ++i) X(i) = i;
+  return X;
+}
+
+// Reference: one coefficient at a time.
+MatrixXd Gather(const MatrixXd& X, const IndexList& r, const IndexList& c) {
+  MatrixXd out(r.size(), c.size());
+  for (Index i = 0; i < r.size(); ++i) {
+    for (Index j = 0; j < c.size(); ++j) out(i, j) = X(r[i], c[j]);
+  }
+  return out;
+}
+
+IndexList All(Index n) {
+  std::vector<Index> indices(n);
+  for (Index i = 0; i < n; ++i) indices[i] = i;
+  return IndexList(indices);
+}
+
+TEST(IndexViewTest, Runs) {
+  const IndexList list({3, 4, 5, 9, 1, 2});
+  ASSERT_EQ(list.runs().size(), 3u);
+  EXPECT_EQ(list.runs()[0].src, 3);
+  EXPECT_EQ(list.runs()[0].size, 3);
+  EXPECT_EQ(list.runs()[2].dst, 4);
+  EXPECT_EQ(list.end(), 10);
+  EXPECT_THROW(IndexList({1, -1}), std::runtime_error);
+}
+
+TEST(IndexViewTest, Gather) {
+  const MatrixXd X = MakeMatrix(10, 7);
+  const IndexList r({3, 4, 5, 9, 1, 2, 2});
+  const IndexList c({6, 0, 1});
+  const MatrixXd by_rows = index_view::rows(X, r);
+  EXPECT_EQ(by_rows, Gather(X, r, All(7)));
+  const MatrixXd by_cols = index_view::cols(X, c);
+  EXPECT_EQ(by_cols, Gather(X, All(10), c));
+  const MatrixXd both = index_view::view(X, r, c);
+  EXPECT_EQ(both, Gather(X, r, c));
+  // Into an expression.
+  MatrixXd dest = MatrixXd::Zero(9, 3);
+  dest.topRows(7) = index_view::view(X, r, c);
+  EXPECT_EQ(dest.topRows(7), Gather(X, r, c));
+  // Single column.
+  const Eigen::VectorXd x = X.col(2);
+  const Eigen::VectorXd x_sub = index_view::rows(x, r);
+  EXPECT_EQ(x_sub, Gather(X.col(2), r, All(1)));
+}
+
+TEST(IndexViewTest, Scatter) {
+  const IndexList r({0, 1, 4, 6});
+  const IndexList c({2, 3});
+  MatrixXd X = MakeMatrix(8, 5);
+  const MatrixXd original = X;
+  const MatrixXd values = MakeMatrix(4, 2) * -1;
+  index_view::view(X, r, c) = values;
+  EXPECT_EQ(Gather(X, r, c), values);
+  index_view::view(X, r, c) += values;
+  EXPECT_EQ(Gather(X, r, c), 2 * values);
+  index_view::view(X, r, c) -= values;
+  index_view::view(X, r, c) *= 3;
+  EXPECT_EQ(Gather(X, r, c), 3 * values);
+  index_view::rows(X, r).setConstant(7);
+  EXPECT_TRUE((Gather(X, r, All(5)).array() == 7).all());
+  // Everything else is untouched.
+  EXPECT_EQ(X.row(2), original.row(2));
+  EXPECT_EQ(X.row(7), original.row(7));
+
+  // Aliasing views are evaluated before scattering.
+  MatrixXd Y = MakeMatrix(4, 2);
+  const IndexList reversed({3, 2, 1, 0});
+  const MatrixXd expected = Y.colwise().reverse();
+  const IndexList all = All(4);
+  index_view::rows(Y, all) = index_view::rows(Y, reversed);
+  EXPECT_EQ(Y, expected);
+}
+
+TEST(IndexViewTest, Lazy) {
+  MatrixXd X = MakeMatrix(6, 4);
+  const IndexList r({5, 1, 2});
+  const MatrixXd expected = Gather(X, r, All(4));
+  const MatrixXd doubled = index_view::rows(X, r).lazy() * 2;
+  EXPECT_EQ(doubled, 2 * expected);
+  // From a temporary block: the expression outlives the view it came from.
+  auto lazy = index_view::rows(X.leftCols(3), r).lazy();
+  const MatrixXd from_block = lazy;
+  EXPECT_EQ(from_block, expected.leftCols(3));
+}
+
+}  // namespace
@@ -0,0 +1,375 @@
+#pragma once
+
+// Random-access iterators over Eigen expressions with direct access (plain
+// objects, blocks, maps with inner / outer strides, row-major or transposed
+// views), following up on `IterableMatrix` in `iterator.cc`.
+//
+//   // Range-for / std algorithms with a statically known iterator type:
+//   for (double& x : iterable(X.row(1))) { ... }
+//   std::sort(iterable(x.segment(10, 100)).begin(), ...);
+//
+//   // Runtime dispatch to the cheapest iterator, for heavy algorithms:
+//   visit_range(X.block(0, 0, n, m), [](auto first, auto last) {
+//     std::sort(std::execution::par_unseq, first, last);
+//   });
+//
+// Layouts that are contiguous (detected at runtime) lower to raw pointers,
+// so std algorithms (including the C++17 parallel ones) get their fastest
+// paths. Single-stride layouts (e.g. a row of a column-major matrix) get
+// `StridedIterator`; general 2D blocks get `BlockIterator`.
+//
+// Elements are visited in the expression's storage order by default; pass
+// `IterOrder::kRowMajor` / `kColMajor` (as a template argument to `iterable`)
+// to traverse in a logical order instead.
+
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <Eigen/Dense>
+
+namespace eigen_iterable {
+
+using Eigen::Index;
+
+enum class IterOrder {
+  kStorage,
+  kColMajor,
+  kRowMajor,
+};
+
+// Iterator with a constant stride (in elements). Holds an index rather than
+// a pointer, so that the end iterator of a strided view does not point past
+// the end of its storage.
+template <typename T>
+class StridedIterator {
+ public:
+  using iterator_category = std::random_access_iterator_tag;
+  using value_type = typename std::remove_const<T>::type;
+  using difference_type = std::ptrdiff_t;
+  using pointer = T*;
+  using reference = T&;
+
+  StridedIterator() = default;
+  StridedIterator(T* base, Index stride, Index index = 0)
+      : base_(base), stride_(stride), index_(index) {}
+
+  reference operator*() const { return base_[index_ * stride_]; }
+  pointer operator->() const { return base_ + index_ * stride_; }
+  reference operator[](difference_type n) const {
+    return base_[(index_ + n) * stride_];
+  }
+
+  StridedIterator& operator++() { ++index_; return *this; }
+  StridedIterator& operator--() { --index_; return *this; }
+  StridedIterator operator++(int) { auto out = *this; ++*this; return out; }
+  StridedIterator operator--(int) { auto out = *this; --*this; return out; }
+  StridedIterator& operator+=(difference_type n) {
+    index_ += n;
+    return *this;
+  }
+  StridedIterator& operator-=(difference_type n) { return *this += -n; }
+  friend StridedIterator operator+(StridedIterator it, difference_type n) {
+    return it += n;
+  }
+  friend StridedIterator operator+(difference_type n, StridedIterator it) {
+    return it += n;
+  }
+  friend StridedIterator operator-(StridedIterator it, difference_type n) {
+    return it -= n;
+  }
+  friend difference_type operator-(
+      const StridedIterator& a, const StridedIterator& b) {
+    return a.index_ - b.index_;
+  }
+
+  friend bool operator==(const StridedIterator& a, const StridedIterator& b) {
+    return a.index_ == b.index_;
+  }
+  friend bool operator!=(const StridedIterator& a, const StridedIterator& b) {
+    return a.index_ != b.index_;
+  }
+  friend bool operator<(const StridedIterator& a, const StridedIterator& b) {
+    return a.index_ < b.index_;
+  }
+  friend bool operator>(const StridedIterator& a, const StridedIterator& b) {
+    return b < a;
+  }
+  friend bool operator<=(const StridedIterator& a, const StridedIterator& b) {
+    return !(b < a);
+  }
+  friend bool operator>=(const StridedIterator& a, const StridedIterator& b) {
+    return !(a < b);
+  }
+
+ private:
+  T* base_{};
+  Index stride_{1};
+  Index index_{};
+};
+
+// Iterator over an `inner_size` x `outer_size` block with arbitrary inner /
+// outer strides. Keeps the current pointer so that sequential access costs
+// no division; random jumps divide once. The pointer is only formed for
+// indices inside the block (it is null at the end), so the end iterator
+// never points past the end of the storage.
+template <typename T>
+class BlockIterator {
+ public:
+  using iterator_category = std::random_access_iterator_tag;
+  using value_type = typename std::remove_const<T>::type;
+  using difference_type = std::ptrdiff_t;
+  using pointer = T*;
+  using reference = T&;
+
+  BlockIterator() = default;
+  BlockIterator(T* base, Index inner_size, Index outer_size,
+                Index inner_stride, Index outer_stride, Index index)
+      : base_(base),
+        inner_size_(inner_size),
+        outer_size_(outer_size),
+        inner_stride_(inner_stride),
+        outer_stride_(outer_stride) {
+    Seek(index);
+  }
+
+  reference operator*() const { return *ptr_; }
+  pointer operator->() const { return ptr_; }
+  reference operator[](difference_type n) const { return *(*this + n); }
+
+  BlockIterator& operator++() {
+    if (++inner_ == inner_size_) {
+      inner_ = 0;
+      ++outer_;
+      ptr_ = outer_ < outer_size_ ? base_ + outer_ * outer_stride_ : nullptr;
+    } else {
+      ptr_ += inner_stride_;
+    }
+    return *this;
+  }
+  BlockIterator& operator--() {
+    if (inner_ == 0) {
+      inner_ = inner_size_ - 1;
+      --outer_;
+      ptr_ = base_ + outer_ * outer_stride_ + inner_ * inner_stride_;
+    } else {
+      --inner_;
+      ptr_ -= inner_stride_;
+    }
+    return *this;
+  }
+  BlockIterator operator++(int) { auto out = *this; ++*this; return out; }
+  BlockIterator operator--(int) { auto out = *this; --*this; return out; }
+  BlockIterator& operator+=(difference_type n) {
+    Seek(index() + n);
+    return *this;
+  }
+  BlockIterator& operator-=(difference_type n) { return *this += -n; }
+  friend BlockIterator operator+(BlockIterator it, difference_type n) {
+    return it += n;
+  }
+  friend BlockIterator operator+(difference_type n, BlockIterator it) {
+    return it += n;
+  }
+  friend BlockIterator operator-(BlockIterator it, difference_type n) {
+    return it -= n;
+  }
+  friend difference_type operator-(
+      const BlockIterator& a, const BlockIterator& b) {
+    return a.index() - b.index();
+  }
+
+  friend bool operator==(const BlockIterator& a, const BlockIterator& b) {
+    return a.outer_ == b.outer_ && a.inner_ == b.inner_;
+  }
+  friend bool operator!=(const BlockIterator& a, const BlockIterator& b) {
+    return !(a == b);
+  }
+  friend bool operator<(const BlockIterator& a, const BlockIterator& b) {
+    return a.index() < b.index();
+  }
+  friend bool operator>(const BlockIterator& a, const BlockIterator& b) {
+    return b < a;
+  }
+  friend bool operator<=(const BlockIterator& a, const BlockIterator& b) {
+    return !(b < a);
+  }
+  friend bool operator>=(const BlockIterator& a, const BlockIterator& b) {
+    return !(a < b);
+  }
+
+ private:
+  Index index() const { return outer_ * inner_size_ + inner_; }
+
+  void Seek(Index index) {
+    if (inner_size_ == 0) {
+      ptr_ = nullptr;
+      return;
+    }
+    outer_ = index / inner_size_;
+    inner_ = index % inner_size_;
+    ptr_ = outer_ < outer_size_
+        ? base_ + outer_ * outer_stride_ + inner_ * inner_stride_
+        : nullptr;
+  }
+
+  T* base_{};
+  T* ptr_{};
+  Index inner_size_{1};
+  Index outer_size_{};
+  Index inner_stride_{1};
+  Index outer_stride_{};
+  Index outer_{};
+  Index inner_{};
+};
+
+// Storage description of a direct-access expression, in traversal order.
+template <typename T>
+struct Layout {
+  T* data{};
+  Index inner_size{};
+  Index outer_size{};
+  Index inner_stride{1};
+  Index outer_stride{};
+
+  Index size() const { return inner_size * outer_size; }
+
+  bool is_contiguous() const {
+    return size() == 0 || (inner_stride == 1 &&
+        (outer_size == 1 || outer_stride == inner_size));
+  }
+
+  // Whether all elements are `stride()` apart.
+  bool is_single_stride() const {
+    return outer_size == 1 || inner_size == 1 ||
+        outer_stride == inner_size * inner_stride;
+  }
+  Index stride() const {
+    return inner_size == 1 ? outer_stride : inner_stride;
+  }
+};
+
+namespace internal {
+
+template <typename XprType>
+using Scalar = typename std::remove_pointer<
+    decltype(std::declval<XprType&>().data())>::type;
+
+// Whether `Derived`, traversed in `Order`, is contiguous regardless of its
+// runtime sizes.
+template <typename Derived, IterOrder Order>
+constexpr bool is_contiguous_type() {
+  constexpr int inner_stride =
+      Eigen::internal::inner_stride_at_compile_time<Derived>::ret;
+  constexpr int outer_stride =
+      Eigen::internal::outer_stride_at_compile_time<Derived>::ret;
+  constexpr bool storage_order =
+      Order == IterOrder::kStorage ||
+      (Order == IterOrder::kRowMajor) == bool(Derived::IsRowMajor);
+  if (Derived::IsVectorAtCompileTime) {
+    return inner_stride == 1;
+  }
+  return storage_order &&
+      (std::is_base_of<Eigen::PlainObjectBase<Derived>, Derived>::value ||
+       (inner_stride == 1 && outer_stride == Derived::InnerSizeAtCompileTime &&
+        Derived::InnerSizeAtCompileTime != Eigen::Dynamic));
+}
+
+}  // namespace internal
+
+template <typename XprType>
+auto GetLayout(XprType&& xpr, IterOrder order = IterOrder::kStorage) {
+  using Derived = typename std::decay<XprType>::type;
+  static_assert(
+      bool(Eigen::internal::has_direct_access<Derived>::ret),
+      "Expression must have direct access; evaluate it first");
+  Layout<internal::Scalar<XprType>> out;
+  out.data = xpr.data();
+  out.inner_size = xpr.innerSize();
+  out.outer_size = xpr.outerSize();
+  out.inner_stride = xpr.innerStride();
+  out.outer_stride = xpr.outerStride();
+  const bool storage_row_major = Derived::IsRowMajor;
+  if ((order == IterOrder::kRowMajor && !storage_row_major) ||
+      (order == IterOrder::kColMajor && storage_row_major)) {
+    std::swap(out.inner_size, out.outer_size);
+    std::swap(out.inner_stride, out.outer_stride);
+  }
+  return out;
+}
+
+// Calls `f(first, last)` with raw pointers when `xpr` is contiguous, else
+// with `StridedIterator`s or `BlockIterator`s. `f` must accept all three.
+template <typename XprType, typename Func>
+decltype(auto) visit_range(
+    XprType&& xpr, Func&& f, IterOrder order = IterOrder::kStorage) {
+  const auto layout = GetLayout(xpr, order);
+  using T = typename std::remove_pointer<decltype(layout.data)>::type;
+  if (layout.is_contiguous()) {
+    return f(layout.data, layout.data + layout.size());
+  } else if (layout.is_single_stride()) {
+    StridedIterator<T> first(layout.data, layout.stride());
+    return f(first, first + layout.size());
+  } else {
+    return f(
+        BlockIterator<T>(
+            layout.data, layout.inner_size, layout.outer_size,
+            layout.inner_stride, layout.outer_stride, 0),
+        BlockIterator<T>(
+            layout.data, layout.inner_size, layout.outer_size,
+            layout.inner_stride, layout.outer_stride, layout.size()));
+  }
+}
+
+// Range with a statically known iterator type: a raw pointer when the
+// expression type is always contiguous in `Order`, else `BlockIterator`.
+// Prefer `visit_range` for heavy algorithms.
+template <typename XprType, IterOrder Order>
+class Iterable {
+ public:
+  using Derived = typename std::decay<XprType>::type;
+  using T = internal::Scalar<XprType>;
+  using iterator = typename std::conditional<
+      internal::is_contiguous_type<Derived, Order>(),
+      T*, BlockIterator<T>>::type;
+
+  explicit Iterable(XprType&& xpr)
+      : xpr_(std::forward<XprType>(xpr)),
+        layout_(GetLayout(xpr_, Order)) {
+    if (std::is_pointer<iterator>::value && !layout_.is_contiguous()) {
+      throw std::logic_error("Iterable: expected contiguous storage");
+    }
+  }
+
+  iterator begin() const { return make(0); }
+  iterator end() const { return make(layout_.size()); }
+  Index size() const { return layout_.size(); }
+  const Layout<T>& layout() const { return layout_; }
+
+ private:
+  template <typename It = iterator>
+  typename std::enable_if<std::is_pointer<It>::value, It>::type
+  make(Index index) const {
+    return layout_.data + index;
+  }
+
+  template <typename It = iterator>
+  typename std::enable_if<!std::is_pointer<It>::value, It>::type
+  make(Index index) const {
+    return It(layout_.data, layout_.inner_size, layout_.outer_size,
+              layout_.inner_stride, layout_.outer_stride, index);
+  }
+
+  // Keeps temporary expressions (e.g. `Block<>`) alive.
+  XprType xpr_;
+  Layout<T> layout_;
+};
+
+template <IterOrder Order = IterOrder::kStorage, typename XprType>
+auto iterable(XprType&& xpr) {
+  return Iterable<XprType, Order>(std::forward<XprType>(xpr));
+}
+
+}  // namespace eigen_iterable
@@ -0,0 +1,112 @@
+// Sort / transform over large `VectorXd` blocks, sequential vs. parallel:
+// contiguous segments (raw pointers) vs. strided views (`StridedIterator`),
+// all through `iterable.h`.
+
+#include <algorithm>
+#include <cmath>
+#include <execution>
+
+#include <Eigen/Dense>
+
+#include "benchmark/benchmark.h"
+
+#include "iterable.h"
+
+using Eigen::Index;
+using Eigen::InnerStride;
+using Eigen::Map;
+using Eigen::VectorXd;
+using eigen_iterable::visit_range;
+
+namespace {
+
+constexpr int kStride = 4;
+
+// Segment of a vector with 16 elements of padding on each side.
+struct Contiguous {
+  explicit Contiguous(Index n)
+      : storage(VectorXd::Random(n + 32)) {}
+  auto view() { return storage.segment(16, storage.size() - 32); }
+  VectorXd storage;
+};
+
+// Every `kStride`-th element of a larger vector.
+struct Strided {
+  explicit Strided(Index n)
+      : storage(VectorXd::Random(n * kStride)) {}
+  auto view() {
+    return Map<VectorXd, 0, InnerStride<>>(
+        storage.data(), storage.size() / kStride, InnerStride<>(kStride));
+  }
+  VectorXd storage;
+};
+
+template <typename Data, typename Policy>
+void Sort(benchmark::State& state, Policy policy) {
+  Data data(state.range(0));
+  const VectorXd original = data.storage;
+  for (auto _ : state) {
+    state.PauseTiming();
+    data.storage = original;
+    state.ResumeTiming();
+    visit_range(data.view(), [policy](auto first, auto last) {
+      std::sort(policy, first, last);
+    });
+    benchmark::DoNotOptimize(data.storage.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename Data, typename Policy>
+void Transform(benchmark::State& state, Policy policy) {
+  Data data(state.range(0));
+  for (auto _ : state) {
+    visit_range(data.view(), [policy](auto first, auto last) {
+      std::transform(policy, first, last, first, [](double x) {
+        return std::sin(x) * 0.5;
+      });
+    });
+    benchmark::DoNotOptimize(data.storage.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+}  // namespace
+
+static void BM_SortContiguous(benchmark::State& state) {
+  Sort<Contiguous>(state, std::execution::seq);
+}
+static void BM_SortContiguousPar(benchmark::State& state) {
+  Sort<Contiguous>(state, std::execution::par_unseq);
+}
+static void BM_SortStrided(benchmark::State& state) {
+  Sort<Strided>(state, std::execution::seq);
+}
+static void BM_SortStridedPar(benchmark::State& state) {
+  Sort<Strided>(state, std::execution::par_unseq);
+}
+
+static void BM_TransformContiguous(benchmark::State& state) {
+  Transform<Contiguous>(state, std::execution::seq);
+}
+static void BM_TransformContiguousPar(benchmark::State& state) {
+  Transform<Contiguous>(state, std::execution::par_unseq);
+}
+static void BM_TransformStrided(benchmark::State& state) {
+  Transform<Strided>(state, std::execution::seq);
+}
+static void BM_TransformStridedPar(benchmark::State& state) {
+  Transform<Strided>(state, std::execution::par_unseq);
+}
+
+#define SIZE_ARGS Range(1 << 12, 1 << 22)
+BENCHMARK(BM_SortContiguous)->SIZE_ARGS;
+BENCHMARK(BM_SortContiguousPar)->SIZE_ARGS;
+BENCHMARK(BM_SortStrided)->SIZE_ARGS;
+BENCHMARK(BM_SortStridedPar)->SIZE_ARGS;
+BENCHMARK(BM_TransformContiguous)->SIZE_ARGS;
+BENCHMARK(BM_TransformContiguousPar)->SIZE_ARGS;
+BENCHMARK(BM_TransformStrided)->SIZE_ARGS;
+BENCHMARK(BM_TransformStridedPar)->SIZE_ARGS;
+
+BENCHMARK_MAIN();
@@ -0,0 +1,82 @@
+#include "iterable.h"
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using Eigen::Index;
+using Eigen::MatrixXd;
+using eigen_iterable::BlockIterator;
+using eigen_iterable::IterOrder;
+using eigen_iterable::StridedIterator;
+using eigen_iterable::iterable;
+using eigen_iterable::visit_range;
+
+namespace {
+
+MatrixXd MakeMatrix(Index rows, Index cols) {
+  MatrixXd X(rows, cols);
+  for (Index i = 0; i < X.size(); ++i) X(i) = i;
+  return X;
+}
+
+template <typename It>
+std::vector<double> Collect(It first, It last) {
+  return std::vector<double>(first, last);
+}
+
+TEST(IterableTest, Orders) {
+  const MatrixXd X = MakeMatrix(4, 5);
+  // Last row of a column-major matrix: strided, ends at the last element.
+  auto row = iterable(X.row(3));
+  EXPECT_EQ(Collect(row.begin(), row.end()),
+            (std::vector<double>{3, 7, 11, 15, 19}));
+  // Bottom-right block, in both orders.
+  auto block = iterable(X.block(2, 3, 2, 2));
+  EXPECT_EQ(Collect(block.begin(), block.end()),
+            (std::vector<double>{14, 15, 18, 19}));
+  auto by_row = iterable<IterOrder::kRowMajor>(X.block(2, 3, 2, 2));
+  EXPECT_EQ(Collect(by_row.begin(), by_row.end()),
+            (std::vector<double>{14, 18, 15, 19}));
+  // Contiguous.
+  EXPECT_TRUE((std::is_pointer<decltype(iterable(X).begin())>::value));
+}
+
+TEST(IterableTest, BlockIteratorArithmetic) {
+  MatrixXd X = MakeMatrix(4, 5);
+  auto block = iterable(X.block(1, 2, 3, 3));
+  auto first = block.begin();
+  auto last = block.end();
+  EXPECT_EQ(last - first, 9);
+  // Walking back from the end recomputes the pointer.
+  auto it = last;
+  --it;
+  EXPECT_EQ(*it, X(3, 4));
+  it -= 3;
+  EXPECT_EQ(*it, X(3, 3));
+  EXPECT_EQ(first[4], X(2, 3));
+  EXPECT_EQ(first + 9, last);
+  EXPECT_TRUE(first < last);
+  it = first;
+  for (int i = 0; i < 9; ++i) ++it;
+  EXPECT_EQ(it, last);
+
+  std::sort(first, last, std::greater<double>());
+  EXPECT_EQ(X(1, 2), 19);
+  EXPECT_EQ(X(3, 4), 9);
+}
+
+TEST(IterableTest, VisitRange) {
+  MatrixXd X = MakeMatrix(4, 5);
+  const auto sum = [](auto first, auto last) {
+    return std::accumulate(first, last, 0.);
+  };
+  EXPECT_EQ(visit_range(X, sum), X.sum());
+  EXPECT_EQ(visit_range(X.row(2), sum), X.row(2).sum());
+  EXPECT_EQ(visit_range(X.block(1, 1, 3, 4), sum), X.block(1, 1, 3, 4).sum());
+  EXPECT_EQ(visit_range(X.block(1, 1, 0, 4), sum), 0);
+}
+
+}  // namespace
@@ -1,21 +1,21 @@
+#include <algorithm>
 #include <iostream>
 #include <Eigen/Dense>
 #include <stdexcept>
 
+#include "iterable.h"
+
 using namespace std;
 using namespace Eigen;
 
-// TODO(eric.cousineau): Consider overloading std::begin() and std::end()
-
-// TODO(eric.cousineau): Do full implementation for more robust access
-// (especially for views!!!). Make static_assert for invalid types.
+// N.B. See `iterable.h` for the full implementation (strided / block views).
 template <typename XprType>
 class IterableMatrix {
  public:
   IterableMatrix(XprType&& xpr)
       : xpr_(xpr) {
     int size = xpr.size();
-    if (end() != &xpr[size]) {
+    if (size > 0 && end() != &xpr[size - 1] + 1) {
       throw std::runtime_error("Not a usable storage format");
     }
   }
@@ -68,5 +68,29 @@ int main() {
   // }
   // cout << endl;
 
+  using eigen_iterable::iterable;
+  using eigen_iterable::IterOrder;
+  // Strided: a row of a column-major matrix.
+  for (auto&& xi : iterable(X.row(1))) {
+    cout << xi << " ";
+  }
+  cout << endl;
+
+  MatrixXd Y(3, 4);
+  Y << 4, 3, 2, 1,
+       8, 7, 6, 5,
+       12, 11, 10, 9;
+  // Block, traversed in row-major order.
+  for (auto&& yi : iterable<IterOrder::kRowMajor>(Y.block(1, 1, 2, 3))) {
+    cout << yi << " ";
+  }
+  cout << endl;
+  // Sort each row in place.
+  for (int i = 0; i < Y.rows(); ++i) {
+    auto row = iterable(Y.row(i));
+    std::sort(row.begin(), row.end());
+  }
+  cout << Y << endl;
+
   return 0;
 }
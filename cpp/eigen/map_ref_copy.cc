@@ -4,97 +4,8 @@
 #include <Eigen/Dense>
 
 // This adapts Ref<Derived> as RefMap<Derived> to be non-copy-friendly.
-// Source taken from Eigen v3.3.3 (git-hg sha: 9e97af7).
-
-namespace Eigen {
-
-// Adapted From: Eigen/src/Core/util/ForwardDeclarations.h
-// @note We must preserve all three template parameters for evaluators to stay
-// in sync with Ref<>.
-template<
-    typename PlainObjectType,
-    int Options = 0,
-    typename StrideType =
-        typename internal::conditional<
-            PlainObjectType::IsVectorAtCompileTime,
-                InnerStride<1>, OuterStride<>>::type>
-class RefMap;
-
-namespace internal {
-
-// Adapted From: Eigen/src/Core/Ref.h
-template <typename PlainObjectType, int Options, typename StrideType>
-struct traits<RefMap<PlainObjectType, Options, StrideType>>
-    : public traits<Ref<PlainObjectType, Options, StrideType>> {};
-
-// Adapted From: Eigen/src/Core/CoreEvaluators.h
-template<typename PlainObjectType, int RefOptions, typename StrideType> 
-struct evaluator<RefMap<PlainObjectType, RefOptions, StrideType> >
-  : public mapbase_evaluator<RefMap<PlainObjectType, RefOptions, StrideType>, PlainObjectType>
-{
-  typedef RefMap<PlainObjectType, RefOptions, StrideType> XprType;
-  
-  enum {
-    Flags = evaluator<Map<PlainObjectType, RefOptions, StrideType> >::Flags,
-    Alignment = evaluator<Map<PlainObjectType, RefOptions, StrideType> >::Alignment
-  };
-
-  EIGEN_DEVICE_FUNC explicit evaluator(const XprType& ref)
-    : mapbase_evaluator<XprType, PlainObjectType>(ref) 
-  { }
-};
-
-}  // namespace internal
-
-// Adapted From: Eigen/src/Core/Ref.h
-/**
- * Provides Ref<Derived> semantics even for Ref<const Derived> cases.
- *
- * Eigen has a specialization of Ref<const Derived> to permit it implicitly copy
- * storage-incompatible matrices and store a local copy the intended Derived
- * type.
- * This class, on the other hand, will throw an error rather than permit
- * a copy to be created, such that it ensures that always refers back to the
- * original data.
- *
- * @ref https://forum.kde.org/viewtopic.php?f=74&t=141703
- */
-template<typename PlainObjectType, int Options, typename StrideType> class RefMap
-  : public RefBase<RefMap<PlainObjectType, Options, StrideType> >
-{
-  private:
-    typedef internal::traits<RefMap> Traits;
-    template<typename Derived>
-    EIGEN_DEVICE_FUNC inline RefMap(const PlainObjectBase<Derived>& expr,
-                                 typename internal::enable_if<bool(Traits::template match<Derived>::MatchAtCompileTime),Derived>::type* = 0);
-  public:
-
-    typedef RefBase<RefMap> Base;
-    EIGEN_DENSE_PUBLIC_INTERFACE(RefMap)
-
-    template<typename Derived>
-    EIGEN_DEVICE_FUNC inline RefMap(PlainObjectBase<Derived>& expr,
-                                 typename internal::enable_if<bool(Traits::template match<Derived>::MatchAtCompileTime),Derived>::type* = 0)
-    {
-      EIGEN_STATIC_ASSERT(bool(Traits::template match<Derived>::MatchAtCompileTime), STORAGE_LAYOUT_DOES_NOT_MATCH);
-      Base::construct(expr.derived());
-    }
-    template<typename Derived>
-    EIGEN_DEVICE_FUNC inline RefMap(const DenseBase<Derived>& expr,
-                                 typename internal::enable_if<bool(Traits::template match<Derived>::MatchAtCompileTime),Derived>::type* = 0)
-    {
-      // We actually do want this to happen, so disable this caveat.
-      // EIGEN_STATIC_ASSERT(bool(internal::is_lvalue<Derived>::value), THIS_EXPRESSION_IS_NOT_A_LVALUE__IT_IS_READ_ONLY);
-      EIGEN_STATIC_ASSERT(bool(Traits::template match<Derived>::MatchAtCompileTime), STORAGE_LAYOUT_DOES_NOT_MATCH);
-      EIGEN_STATIC_ASSERT(!Derived::IsPlainObjectBase,THIS_EXPRESSION_IS_NOT_A_LVALUE__IT_IS_READ_ONLY);
-      Base::construct(expr.const_cast_derived());
-    }
-
-    EIGEN_INHERIT_ASSIGNMENT_OPERATORS(RefMap)
-};
-
-}  // namespace Eigen
-
+// See `ref_map.h`.
+#include "ref_map.h"
 
 #define EVAL(x) std::cout << ">>> " #x ";" << std::endl; x; std::cout << std::endl
 #define PRINT(x) ">>> " #x << std::endl << (x) << std::endl << std::endl
@@ -0,0 +1,303 @@
+#pragma once
+
+// `RefMap<T>`: an `Eigen::Ref<T>` that never copies, for hot-path function
+// signatures. Promoted from the prototype in `map_ref_copy.cc`.
+//
+// `Eigen::Ref<const T>` silently evaluates into a private temporary when the
+// argument's layout or strides do not match (e.g. a row of a column-major
+// matrix passed as `Ref<const VectorXd>`). `RefMap<const T>` instead:
+//  - fails to compile when the mismatch is known at compile time
+//    (`STORAGE_LAYOUT_DOES_NOT_MATCH`, or no matching constructor), and
+//  - throws `std::runtime_error` when the mismatch is only known at runtime
+//    (e.g. a dynamic inner stride bound to `InnerStride<1>`).
+// `RefMap<T>` (mutable) behaves like `Ref<T>`, with the same runtime check.
+//
+// To find existing hidden copies, `CountedRef<const T>` is a drop-in for
+// `Ref<const T>` that, unless `NDEBUG` is defined, records every time the
+// underlying `Ref` had to copy. See `ref_map::implicit_copies()`.
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+
+#include <Eigen/Dense>
+
+namespace Eigen {
+
+// Adapted From: Eigen/src/Core/util/ForwardDeclarations.h
+// @note We must preserve all three template parameters for evaluators to stay
+// in sync with Ref<>.
+template<
+    typename PlainObjectType,
+    int Options = 0,
+    typename StrideType =
+        typename internal::conditional<
+            PlainObjectType::IsVectorAtCompileTime,
+                InnerStride<1>, OuterStride<>>::type>
+class RefMap;
+
+namespace internal {
+
+// Whether binding `expr` to `Ref<PlainObjectType, *, StrideType>` needs no
+// copy, given its runtime sizes and strides. Mirrors the checks in Eigen
+// 3.4's `RefBase::construct()`; Eigen 3.3's returns `void` and binds
+// mismatched strides anyway (e.g. a 1 x n `block()` as a `VectorXd`).
+template <typename PlainObjectType, typename StrideType, typename Derived>
+bool ref_map_strides_match(const Derived& expr) {
+  const bool row_major = (int(PlainObjectType::Flags) & RowMajorBit) != 0;
+  const bool expr_row_major = (int(Derived::Flags) & RowMajorBit) != 0;
+  Index rows = expr.rows();
+  Index cols = expr.cols();
+  // Vectors may bind either orientation, which transposes the strides.
+  if (PlainObjectType::RowsAtCompileTime == 1) {
+    if (rows != 1 && cols != 1) return false;
+    rows = 1;
+    cols = expr.size();
+  } else if (PlainObjectType::ColsAtCompileTime == 1) {
+    if (rows != 1 && cols != 1) return false;
+    rows = expr.size();
+    cols = 1;
+  }
+  const bool transpose =
+      PlainObjectType::IsVectorAtCompileTime && rows != expr.rows();
+  const bool swap = transpose != (row_major != expr_row_major);
+  const Index expr_inner = expr.innerStride() == 0 ? 1 : expr.innerStride();
+  const Index expr_outer = expr.outerStride();
+  const Index inner = swap ? expr_outer : expr_inner;
+  const Index outer = swap ? expr_inner : expr_outer;
+  const Index inner_size = row_major ? cols : rows;
+  const Index outer_size = row_major ? rows : cols;
+  // A stride along a dimension of size <= 1 is never used.
+  enum {
+    kInner = StrideType::InnerStrideAtCompileTime,
+    kOuter = StrideType::OuterStrideAtCompileTime,
+  };
+  const Index want_inner = kInner == 0 ? 1 : Index(kInner);
+  if (kInner != Dynamic && inner_size > 1 && inner != want_inner) {
+    return false;
+  }
+  const Index want_outer = kOuter == 0 ? inner * inner_size : Index(kOuter);
+  if (kOuter != Dynamic && outer_size > 1 && outer != want_outer) {
+    return false;
+  }
+  return true;
+}
+
+// Adapted From: Eigen/src/Core/Ref.h
+template <typename PlainObjectType, int Options, typename StrideType>
+struct traits<RefMap<PlainObjectType, Options, StrideType>>
+    : public traits<Ref<PlainObjectType, Options, StrideType>> {};
+
+// Adapted From: Eigen/src/Core/CoreEvaluators.h
+template<typename PlainObjectType, int RefOptions, typename StrideType>
+struct evaluator<RefMap<PlainObjectType, RefOptions, StrideType> >
+  : public mapbase_evaluator<RefMap<PlainObjectType, RefOptions, StrideType>, PlainObjectType>
+{
+  typedef RefMap<PlainObjectType, RefOptions, StrideType> XprType;
+
+  enum {
+    Flags = evaluator<Map<PlainObjectType, RefOptions, StrideType> >::Flags,
+    Alignment = evaluator<Map<PlainObjectType, RefOptions, StrideType> >::Alignment
+  };
+
+  EIGEN_DEVICE_FUNC explicit evaluator(const XprType& ref)
+    : mapbase_evaluator<XprType, PlainObjectType>(ref)
+  { }
+};
+
+}  // namespace internal
+
+// Adapted From: Eigen/src/Core/Ref.h
+/**
+ * Provides Ref<Derived> semantics even for Ref<const Derived> cases.
+ *
+ * Eigen has a specialization of Ref<const Derived> to permit it implicitly copy
+ * storage-incompatible matrices and store a local copy the intended Derived
+ * type.
+ * This class, on the other hand, will throw an error rather than permit
+ * a copy to be created, such that it ensures that always refers back to the
+ * original data.
+ *
+ * @ref https://forum.kde.org/viewtopic.php?f=74&t=141703
+ */
+template<typename PlainObjectType, int Options, typename StrideType> class RefMap
+  : public RefBase<RefMap<PlainObjectType, Options, StrideType> >
+{
+  private:
+    typedef internal::traits<RefMap> Traits;
+    enum { IsConst = std::is_const<PlainObjectType>::value };
+    template <typename Derived>
+    using EnableIfMatch = typename internal::enable_if<
+        bool(Traits::template match<Derived>::MatchAtCompileTime), Derived>::type;
+
+    // `RefBase::construct()` returns `bool` (stride check) as of Eigen
+    // 3.3.90, and `void` before that; `ref_map_strides_match` covers both.
+    template <typename Derived>
+    bool construct_checked(Derived& expr, internal::true_type /* is_void */) {
+      Base::construct(expr);
+      return true;
+    }
+    template <typename Derived>
+    bool construct_checked(Derived& expr, internal::false_type) {
+      return Base::construct(expr);
+    }
+
+    template <typename Derived>
+    void construct(Derived& expr) {
+      if (!internal::ref_map_strides_match<PlainObjectType, StrideType>(
+              expr)) {
+        throw std::runtime_error(
+            "RefMap: runtime stride does not match; refusing to copy");
+      }
+      using Result = decltype(Base::construct(expr));
+      const bool success = construct_checked(
+          expr,
+          typename internal::conditional<
+              std::is_void<Result>::value,
+              internal::true_type, internal::false_type>::type());
+      if (!success) {
+        throw std::runtime_error(
+            "RefMap: runtime stride does not match; refusing to copy");
+      }
+    }
+
+  public:
+
+    typedef RefBase<RefMap> Base;
+    EIGEN_DENSE_PUBLIC_INTERFACE(RefMap)
+
+    template<typename Derived>
+    EIGEN_DEVICE_FUNC inline RefMap(PlainObjectBase<Derived>& expr,
+                                 EnableIfMatch<Derived>* = 0)
+    {
+      EIGEN_STATIC_ASSERT(bool(Traits::template match<Derived>::MatchAtCompileTime), STORAGE_LAYOUT_DOES_NOT_MATCH);
+      construct(expr.derived());
+    }
+    // Const plain objects may only bind to `RefMap<const T>`.
+    template<typename Derived>
+    EIGEN_DEVICE_FUNC inline RefMap(const PlainObjectBase<Derived>& expr,
+                                 EnableIfMatch<Derived>* = 0)
+    {
+      EIGEN_STATIC_ASSERT(bool(IsConst), THIS_EXPRESSION_IS_NOT_A_LVALUE__IT_IS_READ_ONLY);
+      construct(expr.const_cast_derived());
+    }
+    template<typename Derived>
+    EIGEN_DEVICE_FUNC inline RefMap(const DenseBase<Derived>& expr,
+                                 EnableIfMatch<Derived>* = 0)
+    {
+      // Mutable RefMaps need an lvalue expression (`A.col(0)`, but not
+      // `Ac.col(0)` for `const MatrixXd& Ac`).
+      EIGEN_STATIC_ASSERT(bool(Traits::template match<Derived>::MatchAtCompileTime), STORAGE_LAYOUT_DOES_NOT_MATCH);
+      EIGEN_STATIC_ASSERT(!Derived::IsPlainObjectBase,THIS_EXPRESSION_IS_NOT_A_LVALUE__IT_IS_READ_ONLY);
+      EIGEN_STATIC_ASSERT(bool(IsConst) || bool(internal::is_lvalue<Derived>::value), THIS_EXPRESSION_IS_NOT_A_LVALUE__IT_IS_READ_ONLY);
+      construct(expr.const_cast_derived());
+    }
+
+    EIGEN_INHERIT_ASSIGNMENT_OPERATORS(RefMap)
+};
+
+}  // namespace Eigen
+
+namespace ref_map {
+
+// Whether implicit-copy accounting is compiled in.
+#ifndef NDEBUG
+constexpr bool kCountImplicitCopies = true;
+#else
+constexpr bool kCountImplicitCopies = false;
+#endif
+
+namespace internal {
+
+struct CopyRegistry {
+  std::atomic<int> total{};
+  std::mutex mutex;
+  // "Ref<T> <- Derived" -> count.
+  std::map<std::string, int> by_type;
+};
+
+inline CopyRegistry& copy_registry() {
+  static CopyRegistry registry;
+  return registry;
+}
+
+inline void RecordCopy(const std::type_info& ref, const std::type_info& from) {
+  CopyRegistry& registry = copy_registry();
+  ++registry.total;
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  ++registry.by_type[std::string(ref.name()) + " <- " + from.name()];
+}
+
+// Address of the first coefficient of `expr`, or nullptr if it has no direct
+// access (in which case any `Ref<const T>` must copy).
+template <typename Derived>
+const void* data_of(const Eigen::DenseBase<Derived>& expr, std::true_type) {
+  return expr.derived().data();
+}
+template <typename Derived>
+const void* data_of(const Eigen::DenseBase<Derived>&, std::false_type) {
+  return nullptr;
+}
+template <typename Derived>
+const void* data_of(const Eigen::DenseBase<Derived>& expr) {
+  return data_of(
+      expr,
+      std::integral_constant<
+          bool, bool(Eigen::internal::has_direct_access<Derived>::ret)>{});
+}
+
+}  // namespace internal
+
+// Total number of copies made by `CountedRef` (always 0 with `NDEBUG`).
+inline int implicit_copy_count() {
+  return internal::copy_registry().total;
+}
+
+// Copies by (mangled) "Ref type <- argument type".
+inline std::map<std::string, int> implicit_copies() {
+  internal::CopyRegistry& registry = internal::copy_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  return registry.by_type;
+}
+
+inline void reset_implicit_copies() {
+  internal::CopyRegistry& registry = internal::copy_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.total = 0;
+  registry.by_type.clear();
+}
+
+}  // namespace ref_map
+
+namespace Eigen {
+
+// Drop-in for `Ref<const T>` that records the copies `Ref` makes (unless
+// `NDEBUG`). Use it to find hidden temporaries, then switch the offending
+// signatures to `RefMap<const T>`.
+template <typename PlainObjectType, int Options = 0,
+          typename StrideType = typename internal::conditional<
+              PlainObjectType::IsVectorAtCompileTime,
+              InnerStride<1>, OuterStride<>>::type>
+class CountedRef : public Ref<PlainObjectType, Options, StrideType> {
+ public:
+  typedef Ref<PlainObjectType, Options, StrideType> Base;
+  static_assert(
+      std::is_const<PlainObjectType>::value,
+      "Only Ref<const T> copies; use RefMap<T> / Ref<T> otherwise");
+
+  template <typename Derived>
+  CountedRef(const DenseBase<Derived>& expr)
+      : Base(expr) {
+    if (ref_map::kCountImplicitCopies &&
+        static_cast<const void*>(this->data()) !=
+            ref_map::internal::data_of(expr)) {
+      ref_map::internal::RecordCopy(typeid(Base), typeid(Derived));
+    }
+  }
+};
+
+}  // namespace Eigen
@@ -0,0 +1,115 @@
+#include "ref_map.h"
+
+#include <type_traits>
+
+#include <gtest/gtest.h>
+
+using namespace Eigen;
+
+namespace {
+
+double SumRefMap(const RefMap<const VectorXd>& x) { return x.sum(); }
+double SumCounted(const CountedRef<const VectorXd>& x) { return x.sum(); }
+void Scale(RefMap<VectorXd> x) { x *= 2; }
+
+class RefMapTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    A_.resize(3, 3);
+    A_ << 1, 2, 3,
+          4, 5, 6,
+          7, 8, 9;
+    ref_map::reset_implicit_copies();
+  }
+
+  MatrixXd A_;
+};
+
+TEST_F(RefMapTest, Mutable) {
+  RefMap<MatrixXd> A_ref(A_);
+  EXPECT_EQ(A_ref.data(), A_.data());
+  RefMap<MatrixXd> block_ref = A_.block(1, 1, 2, 2);
+  block_ref.setZero();
+  EXPECT_EQ(A_(2, 2), 0);
+  Scale(A_.col(0));
+  EXPECT_EQ(A_(1, 0), 8);
+}
+
+TEST_F(RefMapTest, Const) {
+  const MatrixXd& A_const = A_;
+  RefMap<const MatrixXd> A_cref(A_const);
+  EXPECT_EQ(A_cref.data(), A_.data());
+  RefMap<const VectorXd> col_cref(A_const.col(1));
+  EXPECT_EQ(col_cref.data(), &A_(0, 1));
+  EXPECT_EQ(SumRefMap(A_.col(2)), 18);
+  // Writes through the original are visible.
+  A_ *= 2;
+  EXPECT_EQ(col_cref(2), 16);
+}
+
+TEST_F(RefMapTest, CompileTimeMismatch) {
+  // A row of a column-major matrix has a non-unit inner stride; `Ref<const>`
+  // would copy, `RefMap` does not bind at all.
+  using Row = decltype(A_.row(0).transpose());
+  EXPECT_TRUE((std::is_constructible<Ref<const VectorXd>, Row>::value));
+  EXPECT_FALSE((std::is_constructible<RefMap<const VectorXd>, Row>::value));
+  EXPECT_FALSE((std::is_constructible<RefMap<VectorXd>, Row>::value));
+  // Non-lvalue expressions would need a temporary.
+  using Sum = decltype(A_.col(0) + A_.col(1));
+  EXPECT_TRUE((std::is_constructible<Ref<const VectorXd>, Sum>::value));
+  EXPECT_FALSE((std::is_constructible<RefMap<const VectorXd>, Sum>::value));
+  // A row-major object never matches a column-major one.
+  using RowMajorXd = Matrix<double, Dynamic, Dynamic, RowMajor>;
+  EXPECT_FALSE((std::is_constructible<RefMap<const MatrixXd>, RowMajorXd&>::value));
+}
+
+TEST_F(RefMapTest, RuntimeMismatch) {
+  // Only known to be a row (stride 3) at runtime.
+  EXPECT_THROW(
+      RefMap<const VectorXd>(A_.block(0, 0, 1, 3)), std::runtime_error);
+  EXPECT_NO_THROW(RefMap<const VectorXd>(A_.block(0, 0, 3, 1)));
+  EXPECT_THROW(RefMap<VectorXd>(A_.block(1, 0, 1, 2)), std::runtime_error);
+  EXPECT_NO_THROW(RefMap<const RowVectorXd>(A_.block(0, 1, 2, 1)));
+}
+
+TEST_F(RefMapTest, StridesMatch) {
+  // Checked by hand, so also on Eigen versions whose `Ref` does not.
+  using internal::ref_map_strides_match;
+  const auto row = A_.block(0, 0, 1, 3);
+  const auto col = A_.block(0, 0, 3, 1);
+  const auto single = A_.block(1, 1, 1, 1);
+  const auto square = A_.block(0, 0, 2, 2);
+  EXPECT_FALSE((ref_map_strides_match<VectorXd, InnerStride<1>>(row)));
+  EXPECT_TRUE((ref_map_strides_match<VectorXd, InnerStride<1>>(col)));
+  EXPECT_TRUE((ref_map_strides_match<VectorXd, InnerStride<>>(row)));
+  EXPECT_TRUE((ref_map_strides_match<VectorXd, InnerStride<1>>(single)));
+  EXPECT_TRUE((ref_map_strides_match<RowVectorXd, InnerStride<1>>(col)));
+  EXPECT_FALSE((ref_map_strides_match<RowVectorXd, InnerStride<1>>(row)));
+  EXPECT_FALSE((ref_map_strides_match<VectorXd, InnerStride<1>>(square)));
+  EXPECT_TRUE((ref_map_strides_match<MatrixXd, OuterStride<>>(square)));
+  EXPECT_FALSE((ref_map_strides_match<MatrixXd, OuterStride<2>>(square)));
+  EXPECT_TRUE((ref_map_strides_match<MatrixXd, OuterStride<3>>(square)));
+  EXPECT_TRUE((ref_map_strides_match<MatrixXd, Stride<0, 0>>(A_)));
+  EXPECT_FALSE((ref_map_strides_match<MatrixXd, Stride<0, 0>>(square)));
+}
+
+TEST_F(RefMapTest, RefInterop) {
+  RefMap<const VectorXd> col_cref(A_.col(0));
+  Ref<const VectorXd> ref(col_cref);
+  EXPECT_EQ(ref.data(), A_.data());
+}
+
+TEST_F(RefMapTest, CountedRef) {
+  EXPECT_EQ(SumCounted(A_.col(0)), 12);
+  EXPECT_EQ(ref_map::implicit_copy_count(), 0);
+  EXPECT_EQ(SumCounted(A_.row(0).transpose()), 6);
+  EXPECT_EQ(SumCounted(A_.col(0) + A_.col(1)), 27);
+  if (ref_map::kCountImplicitCopies) {
+    EXPECT_EQ(ref_map::implicit_copy_count(), 2);
+    EXPECT_EQ(ref_map::implicit_copies().size(), 2);
+  } else {
+    EXPECT_EQ(ref_map::implicit_copy_count(), 0);
+  }
+}
+
+}  // namespace
@@ -0,0 +1,287 @@
+#pragma once
+
+// Struct-of-arrays storage for matrices of records (e.g. `Value{a, b}` from
+// `unary_view_mutable.cc`), so that field-wise math is plain, vectorizable
+// Eigen math over contiguous matrices.
+//
+//   template <>
+//   struct eigen_soa::soa_fields<Value> {
+//     static constexpr auto get() {
+//       return std::make_tuple(&Value::a, &Value::b);
+//     }
+//   };
+//
+//   soa_matrix<Value> S(X);            // from MatrixX<Value> (blocked)
+//   S.field(&Value::a) *= 10;          // MatrixXd&, contiguous
+//   Value v = S(0, 1);                 // AoS-looking element access
+//   S(0, 1) = Value{3, 4};
+//   S.to_aos(&X);                      // back to MatrixX<Value> (blocked)
+//
+// Bulk conversions transpose records <-> fields in blocks of `kBlockSize`
+// records, so each block of records is read (or written) from cache once per
+// field, and every field is written (or read) contiguously.
+//
+// Element access goes through a proxy; prefer `field()` for anything hot.
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <Eigen/Dense>
+
+namespace eigen_soa {
+
+// Specialize with `static constexpr auto get()` returning a tuple of member
+// pointers. Fields not listed are not stored (and read back as default).
+template <typename Record>
+struct soa_fields;
+
+namespace internal {
+
+template <typename Record>
+using FieldTuple = decltype(soa_fields<Record>::get());
+
+template <typename MemberPtr>
+struct member_type;
+template <typename Record, typename Field>
+struct member_type<Field Record::*> {
+  using type = Field;
+};
+
+template <typename Tuple>
+struct storage_tuple;
+template <typename... MemberPtrs>
+struct storage_tuple<std::tuple<MemberPtrs...>> {
+  using type = std::tuple<Eigen::Matrix<
+      typename member_type<MemberPtrs>::type,
+      Eigen::Dynamic, Eigen::Dynamic>...>;
+};
+
+template <typename Func, size_t... Is>
+void for_each_index(Func&& f, std::index_sequence<Is...>) {
+  (f(std::integral_constant<size_t, Is>{}), ...);
+}
+
+// Calls `f(index_constant)` for each field of `Record`.
+template <typename Record, typename Func>
+void for_each_field(Func&& f) {
+  using Tuple = FieldTuple<Record>;
+  for_each_index(
+      std::forward<Func>(f),
+      std::make_index_sequence<std::tuple_size<Tuple>::value>{});
+}
+
+}  // namespace internal
+
+template <typename Record>
+class soa_matrix {
+ public:
+  using Index = Eigen::Index;
+  using AosMatrix = Eigen::Matrix<Record, Eigen::Dynamic, Eigen::Dynamic>;
+  // Records per block for bulk conversions; a few KiB of records.
+  static constexpr Index kBlockSize = std::max<Index>(
+      16, 4096 / static_cast<Index>(sizeof(Record)));
+
+  // Proxy for one element.
+  template <typename Owner>
+  class basic_reference {
+   public:
+    basic_reference(Owner* owner, Index index)
+        : owner_(owner), index_(index) {}
+
+    operator Record() const { return owner_->get(index_); }
+
+    template <typename Field>
+    auto& operator->*(Field Record::* member) const {
+      return owner_->field(member)(index_);
+    }
+
+    basic_reference& operator=(const Record& value) {
+      owner_->set(index_, value);
+      return *this;
+    }
+
+    // Element-to-element assignment writes through, as for `Record&`,
+    // instead of reseating the proxy.
+    basic_reference& operator=(const basic_reference& other) {
+      return *this = Record(other);
+    }
+    template <typename OtherOwner>
+    basic_reference& operator=(const basic_reference<OtherOwner>& other) {
+      return *this = Record(other);
+    }
+
+   private:
+    Owner* owner_{};
+    Index index_{};
+  };
+  using reference = basic_reference<soa_matrix>;
+  using const_reference = basic_reference<const soa_matrix>;
+
+  soa_matrix() = default;
+  soa_matrix(Index rows, Index cols) { resize(rows, cols); }
+  template <typename Derived>
+  explicit soa_matrix(const Eigen::DenseBase<Derived>& aos) {
+    from_aos(aos);
+  }
+
+  Index rows() const { return rows_; }
+  Index cols() const { return cols_; }
+  Index size() const { return rows_ * cols_; }
+
+  void resize(Index rows, Index cols) {
+    rows_ = rows;
+    cols_ = cols;
+    internal::for_each_field<Record>([&](auto I) {
+      std::get<I>(storage_).resize(rows, cols);
+    });
+  }
+
+  // Contiguous storage of field `I` (in the order of `soa_fields`).
+  template <size_t I>
+  auto& field() { return std::get<I>(storage_); }
+  template <size_t I>
+  const auto& field() const { return std::get<I>(storage_); }
+
+  // Contiguous storage of `member`, which must be listed in `soa_fields`.
+  template <typename Field>
+  Eigen::Matrix<Field, Eigen::Dynamic, Eigen::Dynamic>& field(
+      Field Record::* member) {
+    return const_cast<Eigen::Matrix<Field, Eigen::Dynamic, Eigen::Dynamic>&>(
+        static_cast<const soa_matrix*>(this)->field(member));
+  }
+  template <typename Field>
+  const Eigen::Matrix<Field, Eigen::Dynamic, Eigen::Dynamic>& field(
+      Field Record::* member) const {
+    using Matrix = Eigen::Matrix<Field, Eigen::Dynamic, Eigen::Dynamic>;
+    const Matrix* out = nullptr;
+    internal::for_each_field<Record>([&](auto I) {
+      const auto& storage = std::get<I>(storage_);
+      if constexpr (std::is_same<
+          typename std::decay<decltype(storage)>::type, Matrix>::value) {
+        if (std::get<I>(fields()) == member) {
+          out = &storage;
+        }
+      }
+    });
+    if (!out) {
+      throw std::runtime_error("soa_matrix: member not in soa_fields");
+    }
+    return *out;
+  }
+
+  reference operator()(Index row, Index col) {
+    return reference(this, col * rows_ + row);
+  }
+  const_reference operator()(Index row, Index col) const {
+    return const_reference(this, col * rows_ + row);
+  }
+  reference operator()(Index index) { return reference(this, index); }
+  const_reference operator()(Index index) const {
+    return const_reference(this, index);
+  }
+
+  Record get(Index index) const {
+    Record out{};
+    internal::for_each_field<Record>([&](auto I) {
+      out.*std::get<I>(fields()) = std::get<I>(storage_).data()[index];
+    });
+    return out;
+  }
+
+  void set(Index index, const Record& value) {
+    internal::for_each_field<Record>([&](auto I) {
+      std::get<I>(storage_).data()[index] = value.*std::get<I>(fields());
+    });
+  }
+
+  // AoS -> SoA. `aos` may be any record expression with direct access.
+  template <typename Derived>
+  void from_aos(const Eigen::DenseBase<Derived>& aos) {
+    const Derived& src = aos.derived();
+    resize(src.rows(), src.cols());
+    ForEachBlock(src, [&](const Record* records, Index stride, Index start,
+                          Index count) {
+      internal::for_each_field<Record>([&](auto I) {
+        auto* out = std::get<I>(storage_).data() + start;
+        constexpr auto member = std::get<I>(fields());
+        if (stride == 1) {
+          for (Index k = 0; k < count; ++k) {
+            out[k] = records[k].*member;
+          }
+        } else {
+          for (Index k = 0; k < count; ++k) {
+            out[k] = records[k * stride].*member;
+          }
+        }
+      });
+    });
+  }
+
+  // SoA -> AoS. Fields not listed in `soa_fields` are left untouched.
+  template <typename Derived>
+  void to_aos(Eigen::PlainObjectBase<Derived>* aos) const {
+    aos->resize(rows_, cols_);
+    ForEachBlock(aos->derived(), [&](const Record* records, Index stride,
+                                     Index start, Index count) {
+      Record* dst = const_cast<Record*>(records);
+      internal::for_each_field<Record>([&](auto I) {
+        const auto* in = std::get<I>(storage_).data() + start;
+        constexpr auto member = std::get<I>(fields());
+        if (stride == 1) {
+          for (Index k = 0; k < count; ++k) {
+            dst[k].*member = in[k];
+          }
+        } else {
+          for (Index k = 0; k < count; ++k) {
+            dst[k * stride].*member = in[k];
+          }
+        }
+      });
+    });
+  }
+
+  AosMatrix to_aos() const {
+    AosMatrix out(rows_, cols_);
+    to_aos(&out);
+    return out;
+  }
+
+ private:
+  static constexpr auto fields() { return soa_fields<Record>::get(); }
+
+  // Calls `f(records, stride, start, count)` for blocks of at most
+  // `kBlockSize` records of `aos`, in column-major order; `start` is the
+  // column-major index of the first record.
+  template <typename Derived, typename Func>
+  static void ForEachBlock(const Derived& aos, Func&& f) {
+    static_assert(
+        bool(Eigen::internal::has_direct_access<Derived>::ret),
+        "AoS expression must have direct access");
+    const Index rows = aos.rows();
+    if (!Derived::IsRowMajor && aos.innerStride() == 1 &&
+        aos.outerStride() == rows) {
+      // Contiguous: block across columns too.
+      for (Index i = 0; i < aos.size(); i += kBlockSize) {
+        f(aos.data() + i, 1, i, std::min(kBlockSize, aos.size() - i));
+      }
+      return;
+    }
+    for (Index j = 0; j < aos.cols(); ++j) {
+      for (Index i = 0; i < rows; i += kBlockSize) {
+        const Index count = std::min(kBlockSize, rows - i);
+        f(&aos.coeffRef(i, j), aos.rowStride(), j * rows + i, count);
+      }
+    }
+  }
+
+  Index rows_{};
+  Index cols_{};
+  typename internal::storage_tuple<internal::FieldTuple<Record>>::type
+      storage_;
+};
+
+}  // namespace eigen_soa
@@ -0,0 +1,97 @@
+// Field-wise math on a large set of records, AoS (`field_view.h`) vs. SoA
+// (`soa_matrix.h`), and the cost of converting between the two.
+
+#include <Eigen/Dense>
+
+#include "benchmark/benchmark.h"
+
+#include "field_view.h"
+#include "soa_matrix.h"
+
+using Eigen::Index;
+using eigen_field::field_view;
+using eigen_soa::soa_matrix;
+
+namespace {
+
+struct Value {
+  double a{1.5};
+  double b{0.5};
+  int id{};
+};
+
+}  // namespace
+
+template <>
+struct eigen_soa::soa_fields<Value> {
+  static constexpr auto get() {
+    return std::make_tuple(&Value::a, &Value::b, &Value::id);
+  }
+};
+
+namespace {
+
+using MatrixXValue = Eigen::Matrix<Value, Eigen::Dynamic, Eigen::Dynamic>;
+
+}  // namespace
+
+// a += 0.5 * b
+static void BM_AxpyAos(benchmark::State& state) {
+  MatrixXValue X(state.range(0), 1);
+  for (auto _ : state) {
+    field_view(X, &Value::a) += 0.5 * field_view(X, &Value::b);
+    benchmark::DoNotOptimize(X.data());
+  }
+  state.SetItemsProcessed(state.iterations() * X.size());
+}
+
+static void BM_AxpySoa(benchmark::State& state) {
+  soa_matrix<Value> S(MatrixXValue(state.range(0), 1));
+  for (auto _ : state) {
+    S.field(&Value::a) += 0.5 * S.field(&Value::b);
+    benchmark::DoNotOptimize(S.field<0>().data());
+  }
+  state.SetItemsProcessed(state.iterations() * S.size());
+}
+
+// Per-element conversion, for reference.
+static void BM_ToSoaNaive(benchmark::State& state) {
+  const MatrixXValue X(state.range(0), 1);
+  soa_matrix<Value> S(X.rows(), X.cols());
+  for (auto _ : state) {
+    for (Index i = 0; i < X.size(); ++i) {
+      S(i) = X(i);
+    }
+    benchmark::DoNotOptimize(S.field<0>().data());
+  }
+  state.SetItemsProcessed(state.iterations() * X.size());
+}
+
+static void BM_ToSoa(benchmark::State& state) {
+  const MatrixXValue X(state.range(0), 1);
+  soa_matrix<Value> S;
+  for (auto _ : state) {
+    S.from_aos(X);
+    benchmark::DoNotOptimize(S.field<0>().data());
+  }
+  state.SetItemsProcessed(state.iterations() * X.size());
+}
+
+static void BM_ToAos(benchmark::State& state) {
+  const soa_matrix<Value> S(MatrixXValue(state.range(0), 1));
+  MatrixXValue X;
+  for (auto _ : state) {
+    S.to_aos(&X);
+    benchmark::DoNotOptimize(X.data());
+  }
+  state.SetItemsProcessed(state.iterations() * S.size());
+}
+
+#define SIZE_ARGS Range(1 << 10, 1 << 22)
+BENCHMARK(BM_AxpyAos)->SIZE_ARGS;
+BENCHMARK(BM_AxpySoa)->SIZE_ARGS;
+BENCHMARK(BM_ToSoaNaive)->SIZE_ARGS;
+BENCHMARK(BM_ToSoa)->SIZE_ARGS;
+BENCHMARK(BM_ToAos)->SIZE_ARGS;
+
+BENCHMARK_MAIN();
@@ -0,0 +1,109 @@
+#include "soa_matrix.h"
+
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+using Eigen::Index;
+using eigen_soa::soa_matrix;
+
+namespace {
+
+struct Value {
+  double a{1.5};
+  int b{2};
+  // Not stored.
+  char tag{'x'};
+};
+
+}  // namespace
+
+template <>
+struct eigen_soa::soa_fields<Value> {
+  static constexpr auto get() {
+    return std::make_tuple(&Value::a, &Value::b);
+  }
+};
+
+namespace {
+
+using MatrixXValue = Eigen::Matrix<Value, Eigen::Dynamic, Eigen::Dynamic>;
+
+// Large enough to span several conversion blocks.
+MatrixXValue MakeRecords(Index rows, Index cols) {
+  MatrixXValue X(rows, cols);
+  for (Index i = 0; i < X.size(); ++i) {
+    X(i) = Value{0.5 * i, static_cast<int>(i), 'y'};
+  }
+  return X;
+}
+
+TEST(SoaMatrixTest, RoundTrip) {
+  const MatrixXValue X = MakeRecords(1000, 3);
+  soa_matrix<Value> S(X);
+  ASSERT_EQ(S.rows(), 1000);
+  ASSERT_EQ(S.cols(), 3);
+  EXPECT_EQ(S.field(&Value::a)(7, 2), X(7, 2).a);
+  EXPECT_EQ(S.field<1>()(999, 1), X(999, 1).b);
+
+  S.field(&Value::a) *= 2;
+  S.field(&Value::b).array() += 1;
+  const MatrixXValue Y = S.to_aos();
+  for (Index i = 0; i < X.size(); ++i) {
+    EXPECT_EQ(Y(i).a, 2 * X(i).a);
+    EXPECT_EQ(Y(i).b, X(i).b + 1);
+  }
+
+  // Unlisted fields are left alone.
+  MatrixXValue Z = X;
+  S.to_aos(&Z);
+  EXPECT_EQ(Z(5).tag, 'y');
+}
+
+TEST(SoaMatrixTest, StridedSource) {
+  const MatrixXValue X = MakeRecords(600, 4);
+  soa_matrix<Value> S(X.block(10, 1, 500, 2));
+  EXPECT_EQ(S.field(&Value::b)(0, 0), X(10, 1).b);
+  EXPECT_EQ(S.field(&Value::b)(499, 1), X(509, 2).b);
+
+  const Eigen::Matrix<Value, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+      R = X.topRows(3);
+  soa_matrix<Value> T(R);
+  EXPECT_EQ(T.field(&Value::b)(2, 3), X(2, 3).b);
+}
+
+TEST(SoaMatrixTest, ElementAccess) {
+  soa_matrix<Value> S(MakeRecords(3, 2));
+  const Value v = S(1, 1);
+  EXPECT_EQ(v.b, 4);
+  EXPECT_EQ(v.tag, 'x');
+  S(1, 1) = Value{-1, -2};
+  EXPECT_EQ(S.field(&Value::a)(1, 1), -1);
+  (S(0)->*&Value::b) = 10;
+  const soa_matrix<Value>& S_const = S;
+  EXPECT_EQ(S_const(0, 0)->*&Value::b, 10);
+}
+
+TEST(SoaMatrixTest, ElementToElementAssignment) {
+  soa_matrix<Value> S(MakeRecords(3, 2));
+  S(0, 0) = S(1, 1);
+  EXPECT_EQ(S.field(&Value::a)(0, 0), 2);
+  EXPECT_EQ(S.field(&Value::b)(0, 0), 4);
+  // From another (const) matrix.
+  const soa_matrix<Value> T(MakeRecords(3, 2));
+  S(2, 1) = T(1, 0);
+  EXPECT_EQ(S.field(&Value::b)(2, 1), 1);
+  // Named proxies write through too.
+  auto dst = S(0, 1);
+  auto src = S(2, 0);
+  dst = src;
+  EXPECT_EQ(S.field(&Value::b)(0, 1), 2);
+  EXPECT_EQ(S.field(&Value::b)(2, 0), 2);
+}
+
+TEST(SoaMatrixTest, UnknownMember) {
+  soa_matrix<Value> S(2, 2);
+  EXPECT_THROW(S.field(&Value::tag), std::runtime_error);
+}
+
+}  // namespace
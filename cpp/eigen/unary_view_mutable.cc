@@ -1,8 +1,10 @@
-// TODO: See if view is compatible with Eigen::Ref<MatrixX<Scalar>>
+// N.B. For `Eigen::Ref` compatibility, see `field_view()` below.
 
 #include <iostream>
 #include <Eigen/Dense>
 
+#include "field_view.h"
+
 using namespace std;
 using namespace Eigen;
 
@@ -52,7 +54,7 @@ struct unary_mutable_helper {
   static auto run(XprType& xpr, const Op& op) {
     // lvalue
     typedef decltype(op(std::declval<Scalar&>())) lvalue_return_type;
-    auto wrap_const_cast = [&op](const Scalar& scalar) -> lvalue_return_type {
+    auto wrap_const_cast = [op](const Scalar& scalar) -> lvalue_return_type {
       return op(const_cast<Scalar&>(scalar));
     };
     typedef Eigen::CwiseUnaryView<decltype(wrap_const_cast), Derived> NonConstView;
@@ -108,12 +110,12 @@ auto unaryFieldExpr(XprType&& xpr, FieldType Scalar::* member) {
 }
 
 int main() {
-  MatrixX<Value> X(2, 2);
+  ::MatrixX<Value> X(2, 2);
   auto X_ac = X.unaryViewExpr(get_a());
   cout << X_ac << endl;
   
   // Savage. But direct.
-  auto X_am_direct = Eigen::CwiseUnaryView<get_mutable_a_direct, MatrixX<Value>>(
+  auto X_am_direct = Eigen::CwiseUnaryView<get_mutable_a_direct, ::MatrixX<Value>>(
       X, get_mutable_a_direct());
   X_am_direct.setConstant(20);
   cout << X_ac << endl;
@@ -140,5 +142,19 @@ int main() {
   auto X_bmf = unaryFieldExpr(X, &Value::b);
   cout << X_bmf << endl;
 
+  // Strided maps do work with Refs.
+  using eigen_field::field_view;
+  using eigen_field::FieldStride;
+  auto X_af = field_view(X, &Value::a);
+  Eigen::Ref<Eigen::MatrixXd, 0, FieldStride<Value, double>> X_aref = X_af;
+  X_aref(0, 1) = 3;
+  cout << X_ac << endl;
+  cout << "sum: " << field_view(Xc, &Value::a).sum() << endl;
+  // Rows are strided in both directions.
+  Eigen::Ref<Eigen::RowVectorXi, 0, Eigen::InnerStride<>> X_b_row =
+      field_view(X.row(1), &Value::b);
+  X_b_row << 7, 8;
+  cout << X_bm << endl;
+
   return 0;
 }
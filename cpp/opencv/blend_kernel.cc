@@ -0,0 +1,119 @@
+#include "blend_kernel.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define FRAME_BLEND_X86 1
+#endif
+
+namespace frame_blend {
+namespace {
+
+inline uint8_t BlendOne(uint8_t a, uint8_t b, int weight) {
+  return static_cast<uint8_t>((a * weight + b * (256 - weight) + 128) >> 8);
+}
+
+#ifdef FRAME_BLEND_X86
+
+// a * w + b * (256 - w) <= 255 * 256, so 16-bit lanes do not overflow, and
+// the sum is shifted as unsigned.
+__attribute__((target("avx2")))
+void BlendBytesAvx2(const uint8_t* a, const uint8_t* b, uint8_t* out,
+                    size_t size, int weight) {
+  const __m256i wa = _mm256_set1_epi16(static_cast<int16_t>(weight));
+  const __m256i wb = _mm256_set1_epi16(static_cast<int16_t>(256 - weight));
+  const __m256i round = _mm256_set1_epi16(128);
+  const __m256i zero = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    const __m256i x =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    const __m256i y =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+    // unpack / pack both work within 128-bit lanes, so the order survives.
+    const __m256i lo = _mm256_srli_epi16(
+        _mm256_add_epi16(
+            _mm256_add_epi16(
+                _mm256_mullo_epi16(_mm256_unpacklo_epi8(x, zero), wa),
+                _mm256_mullo_epi16(_mm256_unpacklo_epi8(y, zero), wb)),
+            round),
+        8);
+    const __m256i hi = _mm256_srli_epi16(
+        _mm256_add_epi16(
+            _mm256_add_epi16(
+                _mm256_mullo_epi16(_mm256_unpackhi_epi8(x, zero), wa),
+                _mm256_mullo_epi16(_mm256_unpackhi_epi8(y, zero), wb)),
+            round),
+        8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                        _mm256_packus_epi16(lo, hi));
+  }
+  for (; i < size; ++i) out[i] = BlendOne(a[i], b[i], weight);
+}
+
+void BlendBytesSse2(const uint8_t* a, const uint8_t* b, uint8_t* out,
+                    size_t size, int weight) {
+  const __m128i wa = _mm_set1_epi16(static_cast<int16_t>(weight));
+  const __m128i wb = _mm_set1_epi16(static_cast<int16_t>(256 - weight));
+  const __m128i round = _mm_set1_epi16(128);
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    const __m128i lo = _mm_srli_epi16(
+        _mm_add_epi16(
+            _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(x, zero), wa),
+                          _mm_mullo_epi16(_mm_unpacklo_epi8(y, zero), wb)),
+            round),
+        8);
+    const __m128i hi = _mm_srli_epi16(
+        _mm_add_epi16(
+            _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(x, zero), wa),
+                          _mm_mullo_epi16(_mm_unpackhi_epi8(y, zero), wb)),
+            round),
+        8);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                     _mm_packus_epi16(lo, hi));
+  }
+  for (; i < size; ++i) out[i] = BlendOne(a[i], b[i], weight);
+}
+
+#endif  // FRAME_BLEND_X86
+
+}  // namespace
+
+int BlendWeight(double alpha) {
+  return static_cast<int>(std::lround(std::clamp(alpha, 0.0, 1.0) * 256));
+}
+
+void BlendBytesScalar(const uint8_t* a, const uint8_t* b, uint8_t* out,
+                      size_t size, int weight) {
+  for (size_t i = 0; i < size; ++i) out[i] = BlendOne(a[i], b[i], weight);
+}
+
+bool BlendUsesAvx2() {
+#ifdef FRAME_BLEND_X86
+  static const bool avx2 = __builtin_cpu_supports("avx2");
+  return avx2;
+#else
+  return false;
+#endif
+}
+
+void BlendBytes(const uint8_t* a, const uint8_t* b, uint8_t* out, size_t size,
+                int weight) {
+#ifdef FRAME_BLEND_X86
+  if (BlendUsesAvx2()) {
+    BlendBytesAvx2(a, b, out, size, weight);
+  } else {
+    BlendBytesSse2(a, b, out, size, weight);
+  }
+#else
+  BlendBytesScalar(a, b, out, size, weight);
+#endif
+}
+
+}  // namespace frame_blend
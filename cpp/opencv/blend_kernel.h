@@ -0,0 +1,31 @@
+#pragma once
+
+// Fixed-point weighted blend of 8-bit buffers, the inner loop of
+// `cv::addWeighted(a, alpha, b, 1 - alpha, 0, out)` for CV_8U images:
+//
+//   out[i] = (a[i] * w + b[i] * (256 - w) + 128) >> 8,  w = round(alpha * 256)
+//
+// Uses AVX2 when the CPU has it (checked once at runtime), SSE2 / scalar
+// otherwise; all paths give identical results. Within 1 of `addWeighted`,
+// which rounds the floating-point sum.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace frame_blend {
+
+// `alpha` in [0, 1] as an 8.8 fixed-point weight in [0, 256].
+int BlendWeight(double alpha);
+
+// Blends `size` bytes; `out` may alias `a` or `b`.
+void BlendBytes(const uint8_t* a, const uint8_t* b, uint8_t* out, size_t size,
+                int weight);
+
+// Portable version, for tests / comparison.
+void BlendBytesScalar(const uint8_t* a, const uint8_t* b, uint8_t* out,
+                      size_t size, int weight);
+
+// Whether `BlendBytes` uses AVX2 on this CPU.
+bool BlendUsesAvx2();
+
+}  // namespace frame_blend
@@ -0,0 +1,44 @@
+#include "blend_kernel.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace frame_blend {
+namespace {
+
+TEST(BlendKernelTest, MatchesScalarAndFormula) {
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int> byte(0, 255);
+  // Odd size to cover the vector tails.
+  const size_t size = 3 * 641;
+  std::vector<uint8_t> a(size), b(size), fast(size), scalar(size);
+  for (size_t i = 0; i < size; ++i) {
+    a[i] = byte(gen);
+    b[i] = byte(gen);
+  }
+  for (int weight : {0, 1, 77, 128, 200, 255, 256}) {
+    BlendBytes(a.data(), b.data(), fast.data(), size, weight);
+    BlendBytesScalar(a.data(), b.data(), scalar.data(), size, weight);
+    EXPECT_EQ(fast, scalar) << weight;
+    for (size_t i = 0; i < size; ++i) {
+      const double expected = (a[i] * weight + b[i] * (256.0 - weight)) / 256;
+      ASSERT_NEAR(fast[i], expected, 0.5) << i;
+    }
+  }
+  BlendBytes(a.data(), b.data(), fast.data(), size, 256);
+  EXPECT_EQ(fast, a);
+  BlendBytes(a.data(), b.data(), fast.data(), size, 0);
+  EXPECT_EQ(fast, b);
+}
+
+TEST(BlendKernelTest, InPlace) {
+  std::vector<uint8_t> a(100, 200), b(100, 100);
+  BlendBytes(a.data(), b.data(), a.data(), a.size(), BlendWeight(0.5));
+  EXPECT_EQ(a, std::vector<uint8_t>(100, 150));
+}
+
+}  // namespace
+}  // namespace frame_blend
@@ -0,0 +1,191 @@
+// Pipelined version of `manip_repro.cc`: decode, blend, and display run on
+// their own threads, connected by bounded queues of slots in preallocated
+// frame rings, so nothing is allocated per frame. The blend is
+// `frame_blend::BlendFrames` (fixed-point AVX2) instead of `addWeighted`.
+//
+//   blend_pipeline [image_or_video] [--frames N] [--fps F] [--headless]
+//
+// An image is replayed as a video, scrolled by one pixel per frame. With
+// --fps, frames are "captured" at that rate (like a camera); 0 decodes as
+// fast as possible. Prints end-to-end (capture to displayed) and blend-only
+// latency percentiles.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/videoio/videoio.hpp>
+
+#include "bounded_queue.h"
+#include "frame_blend.h"
+
+using Clock = std::chrono::steady_clock;
+using Duration = std::chrono::duration<double>;
+
+namespace {
+
+// Frames in flight per ring; also the queue capacity.
+constexpr int kRingSize = 4;
+
+struct Frame {
+  int slot;
+  int index;
+  Clock::time_point captured;
+  double blend_seconds;
+};
+
+void PrintPercentiles(const char* name, std::vector<double> seconds) {
+  if (seconds.empty()) return;
+  std::sort(seconds.begin(), seconds.end());
+  auto at = [&seconds](double q) {
+    return 1000 * seconds[std::min(
+        seconds.size() - 1, static_cast<size_t>(q * seconds.size()))];
+  };
+  std::printf("%-10s p50 %7.3f  p90 %7.3f  p99 %7.3f  max %7.3f ms\n", name,
+              at(0.5), at(0.9), at(0.99), 1000 * seconds.back());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string input = "../test.png";
+  int num_frames = 600;
+  double fps = 60;
+  bool headless = false;
+  for (int i = 1; i < argc; ++i) {
+    if (!std::strcmp(argv[i], "--frames") && i + 1 < argc) {
+      num_frames = std::atoi(argv[++i]);
+    } else if (!std::strcmp(argv[i], "--fps") && i + 1 < argc) {
+      fps = std::atof(argv[++i]);
+    } else if (!std::strcmp(argv[i], "--headless")) {
+      headless = true;
+    } else {
+      input = argv[i];
+    }
+  }
+
+  // Source: a still image (scrolled), or a video.
+  cv::Mat still = cv::imread(input, cv::IMREAD_COLOR);
+  cv::VideoCapture video;
+  cv::Size size = still.size();
+  if (still.empty()) {
+    if (!video.open(input)) {
+      std::fprintf(stderr, "Cannot open %s\n", input.c_str());
+      return EXIT_FAILURE;
+    }
+    size = cv::Size(static_cast<int>(video.get(cv::CAP_PROP_FRAME_WIDTH)),
+                    static_cast<int>(video.get(cv::CAP_PROP_FRAME_HEIGHT)));
+  }
+  std::printf("%d x %d, %d frames, %s blend\n", size.width, size.height,
+              num_frames,
+              frame_blend::BlendUsesAvx2() ? "AVX2" : "SSE2 / scalar");
+
+  frame_blend::FrameRing decoded(kRingSize, size.height, size.width, CV_8UC3);
+  frame_blend::FrameRing blended(kRingSize, size.height, size.width, CV_8UC3);
+  BoundedQueue<int> decoded_free(kRingSize);
+  BoundedQueue<int> blended_free(kRingSize);
+  for (int slot = 0; slot < kRingSize; ++slot) {
+    decoded_free.Push(slot);
+    blended_free.Push(slot);
+  }
+  BoundedQueue<Frame> to_blend(kRingSize);
+  BoundedQueue<Frame> to_display(kRingSize);
+
+  const Clock::time_point pipeline_start = Clock::now();
+  std::thread decode_thread([&]() {
+    for (int index = 0; index < num_frames; ++index) {
+      if (fps > 0) {
+        std::this_thread::sleep_until(
+            pipeline_start + std::chrono::duration_cast<Clock::duration>(
+                Duration(index / fps)));
+      }
+      Frame frame{0, index, Clock::now(), 0};
+      if (!decoded_free.Pop(&frame.slot)) break;
+      cv::Mat& out = decoded[frame.slot];
+      if (still.empty()) {
+        // Reuses `out`'s buffer when the size matches.
+        if (!video.read(out)) break;
+        // A stream whose frames differ from its reported size (or are not
+        // BGR) would make `read` reallocate the slot; stop instead.
+        if (out.size() != size || out.type() != CV_8UC3) {
+          std::fprintf(stderr, "Frame %d is %d x %d (type %d), expected "
+                       "%d x %d BGR; stopping\n", index, out.cols, out.rows,
+                       out.type(), size.width, size.height);
+          break;
+        }
+      } else {
+        // Scroll left by `index` columns (two copies, no allocation).
+        const int shift = index % size.width;
+        still.colRange(shift, size.width)
+            .copyTo(out.colRange(0, size.width - shift));
+        if (shift > 0) {
+          still.colRange(0, shift)
+              .copyTo(out.colRange(size.width - shift, size.width));
+        }
+      }
+      if (!to_blend.Push(frame)) break;
+    }
+    to_blend.Close();
+  });
+
+  std::thread blend_thread([&]() {
+    cv::Mat gray(size, CV_8UC1);
+    cv::Mat gray_color(size, CV_8UC3);
+    Frame frame;
+    while (to_blend.Pop(&frame)) {
+      int out_slot;
+      if (!blended_free.Pop(&out_slot)) break;
+      const Clock::time_point start = Clock::now();
+      const cv::Mat& image = decoded[frame.slot];
+      cv::cvtColor(image, gray, cv::COLOR_BGR2GRAY);
+      cv::cvtColor(gray, gray_color, cv::COLOR_GRAY2BGR);
+      const double t = Duration(frame.captured - pipeline_start).count();
+      const double factor = (std::cos(t * (2 * M_PI)) + 1) / 2;
+      frame_blend::BlendFrames(image, gray_color, factor,
+                               &blended[out_slot]);
+      decoded_free.Push(frame.slot);
+      frame.slot = out_slot;
+      frame.blend_seconds = Duration(Clock::now() - start).count();
+      if (!to_display.Push(frame)) break;
+    }
+    to_display.Close();
+  });
+
+  // Display on the main thread (HighGUI prefers it).
+  const std::string window_name = "BlendPipeline";
+  if (!headless) {
+    cv::namedWindow(window_name, cv::WINDOW_AUTOSIZE);
+  }
+  std::vector<double> latencies, blend_times;
+  latencies.reserve(num_frames);
+  blend_times.reserve(num_frames);
+  const Clock::time_point start = Clock::now();
+  Frame frame;
+  while (to_display.Pop(&frame)) {
+    if (!headless) {
+      cv::imshow(window_name, blended[frame.slot]);
+      cv::waitKey(1);
+    }
+    blended_free.Push(frame.slot);
+    latencies.push_back(Duration(Clock::now() - frame.captured).count());
+    blend_times.push_back(frame.blend_seconds);
+  }
+  const double elapsed = Duration(Clock::now() - start).count();
+  decode_thread.join();
+  blend_thread.join();
+
+  std::printf("%zu frames in %.2f s (%.1f fps)\n", latencies.size(), elapsed,
+              latencies.size() / elapsed);
+  PrintPercentiles("end-to-end", latencies);
+  PrintPercentiles("blend", blend_times);
+  return EXIT_SUCCESS;
+}
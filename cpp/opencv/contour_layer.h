@@ -0,0 +1,112 @@
+#pragma once
+
+// Cached contour overlay: each contour set is rasterised once into a mask
+// covering only its bounding box, and drawing is a masked fill
+// (`canvas(roi).setTo(color, mask)`), so animating colors costs no line
+// rasterisation. Only sets whose contours change are re-rasterised.
+//
+//   ContourLayer layer(canvas.size());
+//   layer.SetContours(0, contours, 2);  // Rasterised on the next Render.
+//   while (...) {
+//     layer.SetColor(0, color);  // Cheap.
+//     layer.Render(canvas);      // Same pixels as drawContours(..., 2).
+//   }
+//
+// How contours are grouped into sets is up to the caller: one set per
+// independently changing group (e.g. per tracked object) keeps updates
+// local, while one set for everything that shares a color is a single fill.
+
+#include <climits>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+class ContourLayer {
+ public:
+  using Contours = std::vector<std::vector<cv::Point>>;
+
+  explicit ContourLayer(cv::Size canvas_size) : canvas_size_(canvas_size) {}
+
+  // Adds or replaces set `id`; it is re-rasterised on the next `Render`.
+  // `line_type` must be `cv::LINE_8` or `cv::LINE_4`: `cv::LINE_AA` blends
+  // edge pixels with the canvas, which a binary mask cannot reproduce.
+  void SetContours(int id, Contours contours, int thickness = 1,
+                   int line_type = cv::LINE_8) {
+    CV_Assert(line_type == cv::LINE_8 || line_type == cv::LINE_4);
+    Entry& entry = entries_[id];
+    entry.contours = std::move(contours);
+    entry.thickness = thickness;
+    entry.line_type = line_type;
+    entry.dirty = true;
+  }
+
+  // Changes the color of set `id` without re-rasterising it.
+  void SetColor(int id, const cv::Scalar& color) {
+    entries_[id].color = color;
+  }
+
+  void Remove(int id) { entries_.erase(id); }
+
+  // Fills every set's pixels in `canvas` (of the constructor's size) with
+  // its color, in id order.
+  void Render(cv::Mat& canvas) {
+    CV_Assert(canvas.size() == canvas_size_);
+    for (auto& item : entries_) {
+      Entry& entry = item.second;
+      if (entry.dirty) Rasterise(&entry);
+      if (entry.roi.area() > 0) {
+        canvas(entry.roi).setTo(entry.color, entry.mask);
+      }
+    }
+  }
+
+  // Number of set rasterisations so far, for monitoring.
+  int num_rasterised() const { return num_rasterised_; }
+
+ private:
+  struct Entry {
+    Contours contours;
+    int thickness{1};
+    int line_type{cv::LINE_8};
+    cv::Scalar color;
+    bool dirty{true};
+    // Bounding box of the drawn pixels (clipped to the canvas), and the
+    // mask over it.
+    cv::Rect roi;
+    cv::Mat1b mask;
+  };
+
+  void Rasterise(Entry* entry) {
+    entry->dirty = false;
+    ++num_rasterised_;
+    entry->roi = cv::Rect();
+    for (const std::vector<cv::Point>& contour : entry->contours) {
+      if (contour.empty()) continue;
+      const cv::Rect box = cv::boundingRect(contour);
+      entry->roi = entry->roi.area() > 0 ? (entry->roi | box) : box;
+    }
+    // Thick lines (and their round caps) extend by half the thickness.
+    const int margin = entry->thickness < 0 ? 0 : entry->thickness / 2 + 1;
+    entry->roi.x -= margin;
+    entry->roi.y -= margin;
+    entry->roi.width += 2 * margin + 1;
+    entry->roi.height += 2 * margin + 1;
+    entry->roi &= cv::Rect(cv::Point(0, 0), canvas_size_);
+    if (entry->roi.area() == 0) {
+      entry->mask.release();
+      return;
+    }
+    entry->mask.create(entry->roi.size());
+    entry->mask.setTo(0);
+    cv::drawContours(entry->mask, entry->contours, -1, cv::Scalar(255),
+                     entry->thickness, entry->line_type, cv::noArray(),
+                     INT_MAX, -entry->roi.tl());
+  }
+
+  cv::Size canvas_size_;
+  std::map<int, Entry> entries_;
+  int num_rasterised_{0};
+};
@@ -0,0 +1,99 @@
+// Per-frame cost of animating the color of N contours (small random
+// polygons on a 1080p canvas, thickness 2): `drawContours` every frame (as
+// `opencv_animation.cc` did) vs. `ContourLayer` with one set per contour or
+// a single set, and with 1% of the sets changing every frame.
+
+#include <random>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "benchmark/benchmark.h"
+
+#include "contour_layer.h"
+
+namespace {
+
+const cv::Size kCanvasSize(1920, 1080);
+
+ContourLayer::Contours RandomContours(int n, unsigned seed) {
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<int> x(0, kCanvasSize.width - 1);
+  std::uniform_int_distribution<int> y(0, kCanvasSize.height - 1);
+  std::uniform_int_distribution<int> d(-20, 20);
+  ContourLayer::Contours contours(n);
+  for (std::vector<cv::Point>& contour : contours) {
+    const cv::Point center(x(gen), y(gen));
+    for (int i = 0; i < 6; ++i) {
+      contour.push_back(center + cv::Point(d(gen), d(gen)));
+    }
+  }
+  return contours;
+}
+
+cv::Scalar Color(int frame) { return cv::Scalar(frame % 256, 255, 255); }
+
+}  // namespace
+
+static void BM_DrawContours(benchmark::State& state) {
+  const ContourLayer::Contours contours = RandomContours(state.range(0), 0);
+  cv::Mat3b canvas(kCanvasSize, cv::Vec3b(0, 0, 0));
+  int frame = 0;
+  for (auto _ : state) {
+    cv::drawContours(canvas, contours, -1, Color(frame++), 2);
+  }
+}
+
+// range(1): 0 for one set per contour, 1 for a single set.
+static void BM_ContourLayer(benchmark::State& state) {
+  const ContourLayer::Contours contours = RandomContours(state.range(0), 0);
+  const bool single_set = state.range(1);
+  cv::Mat3b canvas(kCanvasSize, cv::Vec3b(0, 0, 0));
+  ContourLayer layer(kCanvasSize);
+  if (single_set) {
+    layer.SetContours(0, contours, 2);
+  } else {
+    for (size_t i = 0; i < contours.size(); ++i) {
+      layer.SetContours(i, {contours[i]}, 2);
+    }
+  }
+  layer.Render(canvas);
+  int frame = 0;
+  const int num_sets = single_set ? 1 : contours.size();
+  for (auto _ : state) {
+    const cv::Scalar color = Color(frame++);
+    for (int i = 0; i < num_sets; ++i) layer.SetColor(i, color);
+    layer.Render(canvas);
+  }
+}
+
+static void BM_ContourLayerWithUpdates(benchmark::State& state) {
+  const int n = state.range(0);
+  const ContourLayer::Contours contours = RandomContours(n, 0);
+  const ContourLayer::Contours moved = RandomContours(n, 1);
+  cv::Mat3b canvas(kCanvasSize, cv::Vec3b(0, 0, 0));
+  ContourLayer layer(kCanvasSize);
+  for (int i = 0; i < n; ++i) layer.SetContours(i, {contours[i]}, 2);
+  layer.Render(canvas);
+  int frame = 0;
+  for (auto _ : state) {
+    const cv::Scalar color = Color(frame);
+    for (int i = 0; i < n; ++i) layer.SetColor(i, color);
+    for (int i = frame % 100; i < n; i += 100) {
+      layer.SetContours(i, {moved[i]}, 2);
+    }
+    layer.Render(canvas);
+    ++frame;
+  }
+}
+
+BENCHMARK(BM_DrawContours)->RangeMultiplier(10)->Range(100, 100000)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ContourLayer)
+    ->ArgsProduct({{100, 1000, 10000, 100000}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ContourLayerWithUpdates)->RangeMultiplier(10)->Range(100, 100000)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,77 @@
+#include "contour_layer.h"
+
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+namespace {
+
+const cv::Size kCanvasSize(320, 240);
+
+// Random polygons, some of them crossing the canvas border.
+ContourLayer::Contours RandomContours(int n, unsigned seed) {
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<int> x(-20, kCanvasSize.width + 20);
+  std::uniform_int_distribution<int> y(-20, kCanvasSize.height + 20);
+  std::uniform_int_distribution<int> offset(-15, 15);
+  std::uniform_int_distribution<int> num_vertices(1, 6);
+  ContourLayer::Contours contours(n);
+  for (std::vector<cv::Point>& contour : contours) {
+    const cv::Point center(x(gen), y(gen));
+    for (int k = num_vertices(gen); k > 0; --k) {
+      contour.emplace_back(center.x + offset(gen), center.y + offset(gen));
+    }
+  }
+  return contours;
+}
+
+cv::Mat3b Background() {
+  return cv::Mat3b(kCanvasSize, cv::Vec3b(10, 20, 30));
+}
+
+TEST(ContourLayerTest, MatchesDrawContours) {
+  const cv::Scalar colors[2] = {cv::Scalar(255, 0, 0), cv::Scalar(0, 200, 90)};
+  for (int line_type : {cv::LINE_8, cv::LINE_4}) {
+    for (int thickness : {1, 2, 3, 4, 7, cv::FILLED}) {
+      ContourLayer layer(kCanvasSize);
+      cv::Mat3b expected = Background();
+      for (int id = 0; id < 2; ++id) {
+        const ContourLayer::Contours contours = RandomContours(20, id);
+        layer.SetContours(id, contours, thickness, line_type);
+        layer.SetColor(id, colors[id]);
+        cv::drawContours(expected, contours, -1, colors[id], thickness,
+                         line_type);
+      }
+      cv::Mat3b actual = Background();
+      layer.Render(actual);
+      EXPECT_EQ(cv::norm(actual, expected, cv::NORM_INF), 0)
+          << "line_type " << line_type << ", thickness " << thickness;
+    }
+  }
+}
+
+TEST(ContourLayerTest, RecolorsWithoutRasterising) {
+  ContourLayer layer(kCanvasSize);
+  const ContourLayer::Contours contours = RandomContours(10, 3);
+  layer.SetContours(0, contours, 2);
+  layer.SetColor(0, cv::Scalar(1, 2, 3));
+  cv::Mat3b actual = Background();
+  layer.Render(actual);
+  layer.SetColor(0, cv::Scalar(4, 5, 6));
+  layer.Render(actual);
+  EXPECT_EQ(layer.num_rasterised(), 1);
+  cv::Mat3b expected = Background();
+  cv::drawContours(expected, contours, -1, cv::Scalar(4, 5, 6), 2);
+  EXPECT_EQ(cv::norm(actual, expected, cv::NORM_INF), 0);
+}
+
+TEST(ContourLayerTest, RejectsAntialiasedLines) {
+  ContourLayer layer(kCanvasSize);
+  EXPECT_THROW(layer.SetContours(0, RandomContours(1, 0), 1, cv::LINE_AA),
+               cv::Exception);
+}
+
+}  // namespace
@@ -0,0 +1,55 @@
+#pragma once
+
+// Allocation-free replacement for the per-frame
+// `cv::addWeighted(a, alpha, b, 1 - alpha, 0, out)` of `manip_repro.cc`, for
+// 8-bit images (e.g. BGR), and a ring of preallocated output frames.
+
+#include <stdexcept>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "blend_kernel.h"
+
+namespace frame_blend {
+
+// `out` = `a` * alpha + `b` * (1 - alpha), rounded as in `blend_kernel.h`.
+// `out` must already have the size and type of `a` and `b` (no
+// allocation); any of them may be non-continuous ROIs.
+inline void BlendFrames(const cv::Mat& a, const cv::Mat& b, double alpha,
+                        cv::Mat* out) {
+  if (a.size() != b.size() || a.type() != b.type() ||
+      out->size() != a.size() || out->type() != a.type() ||
+      a.depth() != CV_8U) {
+    throw std::invalid_argument("BlendFrames: mismatched or non-8-bit Mats");
+  }
+  const int weight = BlendWeight(alpha);
+  if (a.isContinuous() && b.isContinuous() && out->isContinuous()) {
+    BlendBytes(a.data, b.data, out->data, a.total() * a.elemSize(), weight);
+    return;
+  }
+  const size_t row_bytes = a.cols * a.elemSize();
+  for (int r = 0; r < a.rows; ++r) {
+    BlendBytes(a.ptr<uint8_t>(r), b.ptr<uint8_t>(r), out->ptr<uint8_t>(r),
+               row_bytes, weight);
+  }
+}
+
+// `size` frames of one shape, allocated once. Slots are handed out by index
+// so a consumer (e.g. a display thread) can keep a slot until it returns it.
+class FrameRing {
+ public:
+  FrameRing(int size, int rows, int cols, int type) {
+    for (int i = 0; i < size; ++i) {
+      frames_.emplace_back(rows, cols, type);
+    }
+  }
+
+  int size() const { return static_cast<int>(frames_.size()); }
+  cv::Mat& operator[](int slot) { return frames_[slot]; }
+
+ private:
+  std::vector<cv::Mat> frames_;
+};
+
+}  // namespace frame_blend
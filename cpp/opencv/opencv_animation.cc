@@ -1,6 +1,8 @@
 // @ref https://stackoverflow.com/questions/33882812/microsoft-visual-studio-c-opencv-animation
 #include <opencv2/opencv.hpp>
 #include <vector>
+
+#include "contour_layer.h"
 using namespace std;
 using namespace cv;
 
@@ -26,6 +28,10 @@ int main()
 
     Mat3b canvas(img.rows, img.cols, Vec3b(0,0,0));
 
+    // Rasterise the (static) contours once; only the color changes below.
+    ContourLayer layer(canvas.size());
+    layer.SetContours(0, contours, 2);
+
     while (true)
     {
         imshow("Draw", canvas);
@@ -47,8 +53,10 @@ int main()
         // Update only edge points 
         //canvas.setTo(color, edges);
 
-        // Draw a thick contour
-        drawContours(canvas, contours, -1, color, 2);
+        // Draw a thick contour: a masked fill of the cached rasterisation,
+        // same pixels as `drawContours(canvas, contours, -1, color, 2)`.
+        layer.SetColor(0, color);
+        layer.Render(canvas);
     }
 
     return 0;
@@ -0,0 +1,221 @@
+#pragma once
+
+// Multi-threaded drop-in for `pcl::VoxelGrid<PointT>` (as used in
+// `voxel_grid.cpp`), with the same `setLeafSize` / `filter` API:
+//
+//   voxel_grid::RadixVoxelGrid<pcl::PointXYZRGB> sor;
+//   sor.setInputCloud(cloud);
+//   sor.setLeafSize(0.01f, 0.01f, 0.01f);
+//   sor.filter(*cloud_filtered);
+//
+// Instead of building an (int32 voxel index, point index) vector and
+// `std::sort`ing it on one thread, this
+//  - computes 64-bit voxel keys with one SIMD multiply / floor per point,
+//  - sorts (key, index) pairs with a parallel LSD radix sort, only over the
+//    significant key bits (e.g. 3 passes for a 2 m x 2 m x 0.5 m cloud at
+//    1 cm), and
+//  - reduces runs of equal keys to centroids in parallel
+// (see `voxel_sort.h`). Since keys are 64-bit, leaf-index ranges beyond
+// int32 (where `pcl::VoxelGrid` gives up and returns the input) are fine.
+//
+// The output matches `pcl::VoxelGrid` (same voxels, same order, centroids
+// computed the same way), except for float rounding: points within a voxel
+// are summed in input order here, and in `std::sort`'s unspecified order in
+// PCL.
+//
+// Not supported: `setFilterFieldName` / limits, `setSaveLeafLayout`,
+// `setIndices`.
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <boost/mpl/size.hpp>
+#include <pcl/common/io.h>
+// For the field functors used by `pcl::VoxelGrid::applyFilter`.
+#include <pcl/filters/voxel_grid.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include "voxel_sort.h"
+
+namespace voxel_grid {
+
+template <typename PointT>
+class RadixVoxelGrid {
+ public:
+  typedef pcl::PointCloud<PointT> PointCloud;
+  typedef typename PointCloud::ConstPtr PointCloudConstPtr;
+
+  void setInputCloud(const PointCloudConstPtr& cloud) { input_ = cloud; }
+  PointCloudConstPtr getInputCloud() const { return input_; }
+
+  void setLeafSize(float lx, float ly, float lz) {
+    leaf_size_ = Eigen::Vector3f(lx, ly, lz);
+  }
+  void setLeafSize(const Eigen::Vector4f& leaf_size) {
+    leaf_size_ = leaf_size.head<3>();
+  }
+  Eigen::Vector3f getLeafSize() const { return leaf_size_; }
+
+  // Average all fields (default), or only x, y, z.
+  void setDownsampleAllData(bool downsample) {
+    downsample_all_data_ = downsample;
+  }
+  bool getDownsampleAllData() const { return downsample_all_data_; }
+
+  void setMinimumPointsNumberPerVoxel(unsigned int min_points) {
+    min_points_per_voxel_ = min_points;
+  }
+  unsigned int getMinimumPointsNumberPerVoxel() const {
+    return min_points_per_voxel_;
+  }
+
+  // 0 (default) means `std::thread::hardware_concurrency()`.
+  void setNumberOfThreads(int num_threads) { num_threads_ = num_threads; }
+
+  void filter(PointCloud& output) const;
+
+ private:
+  PointCloudConstPtr input_;
+  Eigen::Vector3f leaf_size_{Eigen::Vector3f::Zero()};
+  bool downsample_all_data_{true};
+  unsigned int min_points_per_voxel_{0};
+  int num_threads_{0};
+};
+
+template <typename PointT>
+void RadixVoxelGrid<PointT>::filter(PointCloud& output) const {
+  if (!input_) {
+    throw std::runtime_error("RadixVoxelGrid: no input cloud");
+  }
+  if ((leaf_size_.array() <= 0).any()) {
+    throw std::runtime_error("RadixVoxelGrid: leaf size must be positive");
+  }
+  const PointCloud& input = *input_;
+  const size_t n = input.points.size();
+  if (n > UINT32_MAX) {
+    throw std::runtime_error("RadixVoxelGrid: more than 2^32 points");
+  }
+  static_assert(sizeof(PointT) % sizeof(float) == 0, "Unexpected padding");
+  const int num_threads = static_cast<int>(std::min<size_t>(
+      num_threads_ > 0 ? num_threads_ :
+          std::max(1u, std::thread::hardware_concurrency()),
+      std::max<size_t>(1, n / 65536)));
+
+  output.header = input.header;
+  output.height = 1;
+  output.is_dense = true;
+  output.points.clear();
+  if (n == 0) {
+    output.width = 0;
+    return;
+  }
+
+  // Keys (PCL_ADD_POINT4D: x, y, z, padding at the start of every point).
+  const float inverse_leaf[3] = {
+      1.0f / leaf_size_[0], 1.0f / leaf_size_[1], 1.0f / leaf_size_[2]};
+  std::vector<uint64_t> all_keys(n);
+  const int key_bits = ComputeVoxelKeys(
+      &input.points[0].x, sizeof(PointT) / sizeof(float), n, inverse_leaf,
+      num_threads, all_keys.data());
+
+  // Drop invalid points, keeping the order.
+  std::vector<size_t> valid(num_threads + 1, 0);
+  ParallelRun(num_threads, [&](int t) {
+    const auto [begin, end] = Slice(n, t, num_threads);
+    for (size_t i = begin; i < end; ++i) {
+      valid[t + 1] += all_keys[i] != kInvalidVoxelKey;
+    }
+  });
+  for (int t = 0; t < num_threads; ++t) valid[t + 1] += valid[t];
+  std::vector<uint64_t> keys(valid[num_threads]);
+  std::vector<uint32_t> indices(keys.size());
+  ParallelRun(num_threads, [&](int t) {
+    const auto [begin, end] = Slice(n, t, num_threads);
+    size_t out = valid[t];
+    for (size_t i = begin; i < end; ++i) {
+      if (all_keys[i] != kInvalidVoxelKey) {
+        keys[out] = all_keys[i];
+        indices[out++] = static_cast<uint32_t>(i);
+      }
+    }
+  });
+  all_keys = std::vector<uint64_t>();
+
+  ParallelRadixSort(&keys, &indices, key_bits, num_threads);
+
+  // Centroids, as `pcl::VoxelGrid<PointT>::applyFilter`.
+  typedef typename pcl::traits::fieldList<PointT>::type FieldList;
+  int centroid_size = 4;
+  if (downsample_all_data_) {
+    centroid_size = boost::mpl::size<FieldList>::value;
+  }
+  std::vector<pcl::PCLPointField> fields;
+  int rgba_index = pcl::getFieldIndex(input, "rgb", fields);
+  if (rgba_index == -1) {
+    rgba_index = pcl::getFieldIndex(input, "rgba", fields);
+  }
+  if (rgba_index >= 0) {
+    rgba_index = fields[rgba_index].offset;
+    centroid_size += 3;
+  }
+  // Adds `point` to `centroid`, using `temporary` as scratch.
+  auto accumulate = [&](const PointT& point, Eigen::VectorXf& centroid,
+                        Eigen::VectorXf& temporary) {
+    if (!downsample_all_data_) {
+      centroid[0] += point.x;
+      centroid[1] += point.y;
+      centroid[2] += point.z;
+      return;
+    }
+    temporary.setZero();
+    pcl::for_each_type<FieldList>(
+        pcl::NdCopyPointEigenFunctor<PointT>(point, temporary));
+    if (rgba_index >= 0) {
+      pcl::RGB rgb;
+      std::memcpy(&rgb, reinterpret_cast<const char*>(&point) + rgba_index,
+                  sizeof(pcl::RGB));
+      temporary[centroid_size - 3] = rgb.r;
+      temporary[centroid_size - 2] = rgb.g;
+      temporary[centroid_size - 1] = rgb.b;
+    }
+    centroid += temporary;
+  };
+  const size_t min_size = std::max(1u, min_points_per_voxel_);
+  ParallelForEachRun(
+      keys, min_size, num_threads,
+      [&output](size_t num_runs) { output.points.resize(num_runs); },
+      [&](size_t run, size_t begin, size_t end) {
+        Eigen::VectorXf centroid = Eigen::VectorXf::Zero(centroid_size);
+        Eigen::VectorXf temporary = Eigen::VectorXf::Zero(centroid_size);
+        for (size_t i = begin; i < end; ++i) {
+          accumulate(input.points[indices[i]], centroid, temporary);
+        }
+        centroid /= static_cast<float>(end - begin);
+        PointT& out = output.points[run];
+        if (!downsample_all_data_) {
+          out.x = centroid[0];
+          out.y = centroid[1];
+          out.z = centroid[2];
+          return;
+        }
+        pcl::for_each_type<FieldList>(
+            pcl::NdCopyEigenPointFunctor<PointT>(centroid, out));
+        if (rgba_index >= 0) {
+          const float r = centroid[centroid_size - 3];
+          const float g = centroid[centroid_size - 2];
+          const float b = centroid[centroid_size - 1];
+          // Alpha is not averaged (PCL 1.8 drops it as well).
+          const int rgb = (static_cast<int>(r) << 16) |
+              (static_cast<int>(g) << 8) | static_cast<int>(b);
+          std::memcpy(reinterpret_cast<char*>(&out) + rgba_index, &rgb,
+                      sizeof(float));
+        }
+      });
+  output.width = static_cast<uint32_t>(output.points.size());
+}
+
+}  // namespace voxel_grid
@@ -0,0 +1,82 @@
+// In-memory voxel-grid filtering of synthetic XYZRGB clouds (a noisy
+// 2 m x 2 m surface) with 1 cm leaves: `pcl::VoxelGrid` vs.
+// `RadixVoxelGrid` on one thread and on all cores.
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+#include <pcl/filters/voxel_grid.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include "benchmark/benchmark.h"
+
+#include "radix_voxel_grid.h"
+
+namespace {
+
+typedef pcl::PointXYZRGB PointT;
+typedef pcl::PointCloud<PointT> PointCloud;
+
+constexpr float kLeafSize = 0.01f;
+
+PointCloud::ConstPtr SyntheticCloud(int64_t num_points) {
+  PointCloud::Ptr cloud(new PointCloud());
+  cloud->points.resize(num_points);
+  cloud->width = num_points;
+  cloud->height = 1;
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> uniform(0, 2);
+  std::normal_distribution<float> noise(0, 0.005f);
+  for (int64_t i = 0; i < num_points; ++i) {
+    PointT& point = cloud->points[i];
+    point.x = uniform(gen);
+    point.y = uniform(gen);
+    point.z = 0.25f * std::sin(3 * point.x) * std::cos(2 * point.y) +
+        noise(gen);
+    point.r = i % 256;
+    point.g = (i / 256) % 256;
+    point.b = 128;
+  }
+  return cloud;
+}
+
+}  // namespace
+
+static void BM_PclVoxelGrid(benchmark::State& state) {
+  const PointCloud::ConstPtr cloud = SyntheticCloud(state.range(0));
+  PointCloud output;
+  for (auto _ : state) {
+    pcl::VoxelGrid<PointT> sor;
+    sor.setInputCloud(cloud);
+    sor.setLeafSize(kLeafSize, kLeafSize, kLeafSize);
+    sor.filter(output);
+  }
+  state.counters["output_points"] = output.size();
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_RadixVoxelGrid(benchmark::State& state) {
+  const PointCloud::ConstPtr cloud = SyntheticCloud(state.range(0));
+  PointCloud output;
+  for (auto _ : state) {
+    voxel_grid::RadixVoxelGrid<PointT> sor;
+    sor.setInputCloud(cloud);
+    sor.setLeafSize(kLeafSize, kLeafSize, kLeafSize);
+    sor.setNumberOfThreads(state.range(1));
+    sor.filter(output);
+  }
+  state.counters["output_points"] = output.size();
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_PclVoxelGrid)
+    ->RangeMultiplier(4)->Range(1 << 20, 1 << 24)
+    ->Unit(benchmark::kMillisecond);
+// {num_points, num_threads}; 0 threads means all cores.
+BENCHMARK(BM_RadixVoxelGrid)
+    ->ArgsProduct({benchmark::CreateRange(1 << 20, 1 << 24, 4), {1, 0}})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
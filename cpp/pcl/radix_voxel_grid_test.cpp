@@ -0,0 +1,110 @@
+#include "radix_voxel_grid.h"
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+#include <gtest/gtest.h>
+#include <pcl/filters/voxel_grid.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+namespace voxel_grid {
+namespace {
+
+typedef pcl::PointXYZRGB PointT;
+typedef pcl::PointCloud<PointT> PointCloud;
+
+constexpr float kLeafSize = 0.05f;
+
+// Random colored points in a 0.5 m cube (so ~1000 voxels), every 97th one
+// NaN.
+PointCloud::ConstPtr ColoredCloud(int num_points) {
+  PointCloud::Ptr cloud(new PointCloud());
+  cloud->points.resize(num_points);
+  cloud->width = num_points;
+  cloud->height = 1;
+  cloud->is_dense = false;
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> uniform(-0.2f, 0.3f);
+  for (int i = 0; i < num_points; ++i) {
+    PointT& point = cloud->points[i];
+    point.x = i % 97 == 0 ? NAN : uniform(gen);
+    point.y = uniform(gen);
+    point.z = uniform(gen);
+    point.r = i % 256;
+    point.g = (i * 7) % 256;
+    point.b = 128;
+    point.a = 255;
+  }
+  return cloud;
+}
+
+PointCloud PclFilter(const PointCloud::ConstPtr& cloud, bool all_data) {
+  pcl::VoxelGrid<PointT> sor;
+  sor.setInputCloud(cloud);
+  sor.setLeafSize(kLeafSize, kLeafSize, kLeafSize);
+  sor.setDownsampleAllData(all_data);
+  PointCloud output;
+  sor.filter(output);
+  return output;
+}
+
+PointCloud RadixFilter(const PointCloud::ConstPtr& cloud, bool all_data,
+                       int num_threads) {
+  RadixVoxelGrid<PointT> sor;
+  sor.setInputCloud(cloud);
+  sor.setLeafSize(kLeafSize, kLeafSize, kLeafSize);
+  sor.setDownsampleAllData(all_data);
+  sor.setNumberOfThreads(num_threads);
+  PointCloud output;
+  sor.filter(output);
+  return output;
+}
+
+TEST(RadixVoxelGridTest, MatchesPclVoxelGrid) {
+  const PointCloud::ConstPtr cloud = ColoredCloud(200000);
+  const PointCloud expected = PclFilter(cloud, true);
+  ASSERT_GT(expected.size(), 500u);
+  for (int num_threads : {1, 3}) {
+    const PointCloud actual = RadixFilter(cloud, true, num_threads);
+    ASSERT_EQ(actual.size(), expected.size());
+    EXPECT_EQ(actual.width, expected.width);
+    for (size_t i = 0; i < actual.size(); ++i) {
+      const PointT& a = actual.points[i];
+      const PointT& e = expected.points[i];
+      // Sums are accumulated in a different order by PCL.
+      EXPECT_NEAR(a.x, e.x, 1e-5) << i;
+      EXPECT_NEAR(a.y, e.y, 1e-5) << i;
+      EXPECT_NEAR(a.z, e.z, 1e-5) << i;
+      // Channel means are truncated, so may land on either side.
+      EXPECT_NEAR(a.r, e.r, 1) << i;
+      EXPECT_NEAR(a.g, e.g, 1) << i;
+      EXPECT_NEAR(a.b, e.b, 1) << i;
+      EXPECT_EQ(a.a, e.a) << i;
+    }
+  }
+}
+
+TEST(RadixVoxelGridTest, MatchesPclVoxelGridXyzOnly) {
+  const PointCloud::ConstPtr cloud = ColoredCloud(50000);
+  const PointCloud expected = PclFilter(cloud, false);
+  const PointCloud actual = RadixFilter(cloud, false, 3);
+  ASSERT_EQ(actual.size(), expected.size());
+  for (size_t i = 0; i < actual.size(); ++i) {
+    EXPECT_NEAR(actual.points[i].x, expected.points[i].x, 1e-5) << i;
+    EXPECT_NEAR(actual.points[i].y, expected.points[i].y, 1e-5) << i;
+    EXPECT_NEAR(actual.points[i].z, expected.points[i].z, 1e-5) << i;
+  }
+}
+
+TEST(RadixVoxelGridTest, RejectsBadLeafSize) {
+  RadixVoxelGrid<PointT> sor;
+  sor.setInputCloud(ColoredCloud(10));
+  sor.setLeafSize(kLeafSize, 0, kLeafSize);
+  PointCloud output;
+  EXPECT_THROW(sor.filter(output), std::runtime_error);
+}
+
+}  // namespace
+}  // namespace voxel_grid
@@ -0,0 +1,500 @@
+#include "streaming_voxel_grid.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <queue>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+
+#include "voxel_key.h"
+
+namespace voxel_grid {
+namespace {
+
+// Per-thread tables are split by key so that partition `p` of all threads
+// can be merged independently.
+constexpr int kNumPartitions = 64;
+
+[[noreturn]] void ThrowErrno(const std::string& what) {
+  throw std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+// Read-only mapping of a whole file.
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& path) {
+    fd_ = open(path.c_str(), O_RDONLY);
+    if (fd_ < 0) ThrowErrno("open(" + path + ")");
+    struct stat st{};
+    if (fstat(fd_, &st) != 0) ThrowErrno("fstat(" + path + ")");
+    size_ = st.st_size;
+    if (size_ > 0) {
+      void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+      if (data == MAP_FAILED) ThrowErrno("mmap(" + path + ")");
+      data_ = static_cast<const char*>(data);
+      madvise(data, size_, MADV_SEQUENTIAL);
+    }
+  }
+
+  ~MappedFile() {
+    if (data_) munmap(const_cast<char*>(data_), size_);
+    if (fd_ >= 0) close(fd_);
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+  // Lets the kernel drop the pages of [begin, end); they are re-read from
+  // the file if touched again.
+  void Release(const char* begin, const char* end) const {
+    const uintptr_t page = sysconf(_SC_PAGESIZE);
+    const uintptr_t first =
+        (reinterpret_cast<uintptr_t>(begin) + page - 1) & ~(page - 1);
+    const uintptr_t last = reinterpret_cast<uintptr_t>(end) & ~(page - 1);
+    if (last > first) {
+      madvise(reinterpret_cast<void*>(first), last - first, MADV_DONTNEED);
+    }
+  }
+
+ private:
+  int fd_{-1};
+  const char* data_{};
+  size_t size_{};
+};
+
+// One averaged scalar of a point.
+struct Channel {
+  int offset{};
+  char type{};
+  int size{};
+};
+
+std::vector<Channel> MakeChannels(const PcdHeader& header) {
+  std::vector<Channel> out;
+  for (const PcdHeader::Field& field : header.fields) {
+    if (field.name == "_") continue;  // Padding.
+    const bool packed_color =
+        (field.name == "rgb" || field.name == "rgba") && field.size == 4;
+    for (int c = 0; c < field.count; ++c) {
+      const int offset = field.offset + c * field.size;
+      if (packed_color) {
+        for (int byte = 0; byte < 4; ++byte) {
+          out.push_back({offset + byte, 'U', 1});
+        }
+      } else {
+        out.push_back({offset, field.type, field.size});
+      }
+    }
+  }
+  return out;
+}
+
+template <typename T>
+T Load(const char* p) {
+  T value;
+  std::memcpy(&value, p, sizeof(T));
+  return value;
+}
+
+template <typename T>
+void Store(char* p, double value) {
+  const T out = std::is_floating_point<T>::value ?
+      static_cast<T>(value) : static_cast<T>(std::llround(value));
+  std::memcpy(p, &out, sizeof(T));
+}
+
+double ReadChannel(const char* point, const Channel& channel) {
+  const char* p = point + channel.offset;
+  switch (channel.type) {
+    case 'F':
+      return channel.size == 8 ? Load<double>(p) : Load<float>(p);
+    case 'I':
+      switch (channel.size) {
+        case 1: return Load<int8_t>(p);
+        case 2: return Load<int16_t>(p);
+        case 4: return Load<int32_t>(p);
+        default: return Load<int64_t>(p);
+      }
+    default:
+      switch (channel.size) {
+        case 1: return Load<uint8_t>(p);
+        case 2: return Load<uint16_t>(p);
+        case 4: return Load<uint32_t>(p);
+        default: return Load<uint64_t>(p);
+      }
+  }
+}
+
+void WriteChannel(char* point, const Channel& channel, double value) {
+  char* p = point + channel.offset;
+  switch (channel.type) {
+    case 'F':
+      return channel.size == 8 ? Store<double>(p, value) :
+          Store<float>(p, value);
+    case 'I':
+      switch (channel.size) {
+        case 1: return Store<int8_t>(p, value);
+        case 2: return Store<int16_t>(p, value);
+        case 4: return Store<int32_t>(p, value);
+        default: return Store<int64_t>(p, value);
+      }
+    default:
+      switch (channel.size) {
+        case 1: return Store<uint8_t>(p, value);
+        case 2: return Store<uint16_t>(p, value);
+        case 4: return Store<uint32_t>(p, value);
+        default: return Store<uint64_t>(p, value);
+      }
+  }
+}
+
+// Open-addressing table of voxel key -> running sums of every channel, plus
+// the point count.
+class CentroidTable {
+ public:
+  explicit CentroidTable(int num_channels)
+      : stride_(num_channels + 1) {
+    Rehash(64);
+  }
+
+  size_t size() const { return size_; }
+
+  // Sums for `key`, zero-initialized if new.
+  double* Find(uint64_t key) {
+    size_t slot = Hash(key) & mask_;
+    while (true) {
+      const uint64_t k = keys_[slot];
+      if (k == key) return &sums_[values_[slot] * stride_];
+      if (k == kInvalidVoxelKey) break;
+      slot = (slot + 1) & mask_;
+    }
+    if ((size_ + 1) * 2 > keys_.size()) {
+      Rehash(keys_.size() * 2);
+      return Find(key);
+    }
+    keys_[slot] = key;
+    values_[slot] = size_++;
+    sums_.resize(size_ * stride_, 0.0);
+    return &sums_[(size_ - 1) * stride_];
+  }
+
+  void Add(uint64_t key, const char* point,
+           const std::vector<Channel>& channels) {
+    double* sums = Find(key);
+    for (size_t c = 0; c < channels.size(); ++c) {
+      sums[c] += ReadChannel(point, channels[c]);
+    }
+    sums[channels.size()] += 1;
+  }
+
+  void Merge(const CentroidTable& other) {
+    other.ForEach([this](uint64_t key, const double* other_sums) {
+      double* sums = Find(key);
+      for (int c = 0; c < stride_; ++c) {
+        sums[c] += other_sums[c];
+      }
+    });
+  }
+
+  // Calls `f(key, sums)` per voxel. `sums` stay valid until the next insert.
+  template <typename Func>
+  void ForEach(Func&& f) const {
+    for (size_t slot = 0; slot < keys_.size(); ++slot) {
+      if (keys_[slot] != kInvalidVoxelKey) {
+        f(keys_[slot], &sums_[values_[slot] * stride_]);
+      }
+    }
+  }
+
+  // Partition of `key` among `kNumPartitions`; independent of the bits used
+  // for slots.
+  static int Partition(uint64_t key) {
+    return static_cast<int>(Hash(key) >> 58) % kNumPartitions;
+  }
+
+ private:
+  static uint64_t Hash(uint64_t key) {
+    // Murmur3 finalizer.
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+  }
+
+  void Rehash(size_t capacity) {
+    std::vector<uint64_t> keys(capacity, kInvalidVoxelKey);
+    std::vector<uint32_t> values(capacity);
+    const size_t mask = capacity - 1;
+    for (size_t slot = 0; slot < keys_.size(); ++slot) {
+      if (keys_[slot] == kInvalidVoxelKey) continue;
+      size_t s = Hash(keys_[slot]) & mask;
+      while (keys[s] != kInvalidVoxelKey) s = (s + 1) & mask;
+      keys[s] = keys_[slot];
+      values[s] = values_[slot];
+    }
+    keys_.swap(keys);
+    values_.swap(values);
+    mask_ = mask;
+  }
+
+  int stride_;
+  std::vector<uint64_t> keys_;
+  std::vector<uint32_t> values_;
+  std::vector<double> sums_;
+  size_t mask_{};
+  size_t size_{};
+};
+
+// Runs `f(thread, i)` for `i` in [0, n) on `num_threads` threads, with
+// `thread` in [0, num_threads).
+template <typename Func>
+void ParallelFor(int num_threads, int64_t n, Func&& f) {
+  std::atomic<int64_t> next{0};
+  auto work = [&](int thread) {
+    for (int64_t i; (i = next.fetch_add(1)) < n;) {
+      f(thread, i);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int t = 1; t < num_threads; ++t) {
+    threads.emplace_back(work, t);
+  }
+  work(0);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace
+
+const PcdHeader::Field* PcdHeader::field(const std::string& name) const {
+  for (const Field& f : fields) {
+    if (f.name == name) return &f;
+  }
+  return nullptr;
+}
+
+PcdHeader ReadPcdHeader(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("ReadPcdHeader: cannot open " + path);
+  }
+  PcdHeader header;
+  std::vector<int> sizes, counts;
+  std::vector<char> types;
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == '#') continue;
+    std::istringstream in(line);
+    std::string key;
+    in >> key;
+    if (key == "FIELDS") {
+      for (std::string name; in >> name;) header.fields.push_back({name});
+    } else if (key == "SIZE") {
+      for (int v; in >> v;) sizes.push_back(v);
+    } else if (key == "TYPE") {
+      for (char v; in >> v;) types.push_back(v);
+    } else if (key == "COUNT") {
+      for (int v; in >> v;) counts.push_back(v);
+    } else if (key == "WIDTH") {
+      in >> header.width;
+    } else if (key == "HEIGHT") {
+      in >> header.height;
+    } else if (key == "VIEWPOINT") {
+      std::getline(in >> std::ws, header.viewpoint);
+    } else if (key == "DATA") {
+      in >> header.data;
+      header.data_offset = file.tellg();
+      break;
+    }
+  }
+  if (header.data.empty() || header.fields.empty() ||
+      sizes.size() != header.fields.size() ||
+      types.size() != header.fields.size()) {
+    throw std::runtime_error("ReadPcdHeader: malformed header in " + path);
+  }
+  counts.resize(header.fields.size(), 1);
+  for (size_t i = 0; i < header.fields.size(); ++i) {
+    PcdHeader::Field& field = header.fields[i];
+    field.type = types[i];
+    field.size = sizes[i];
+    field.count = counts[i];
+    field.offset = header.point_step;
+    header.point_step += field.size * field.count;
+  }
+  return header;
+}
+
+std::string FormatPcdHeader(const PcdHeader& header) {
+  std::ostringstream out;
+  out << "# .PCD v0.7 - Point Cloud Data file format\nVERSION 0.7\nFIELDS";
+  for (const auto& f : header.fields) out << " " << f.name;
+  out << "\nSIZE";
+  for (const auto& f : header.fields) out << " " << f.size;
+  out << "\nTYPE";
+  for (const auto& f : header.fields) out << " " << f.type;
+  out << "\nCOUNT";
+  for (const auto& f : header.fields) out << " " << f.count;
+  out << "\nWIDTH " << header.width << "\nHEIGHT " << header.height
+      << "\nVIEWPOINT " << header.viewpoint
+      << "\nPOINTS " << header.points() << "\nDATA " << header.data << "\n";
+  return out.str();
+}
+
+StreamingVoxelGridStats StreamingVoxelGrid(
+    const std::string& input_path, const std::string& output_path,
+    const StreamingVoxelGridOptions& options) {
+  for (float leaf_size : options.leaf_size) {
+    if (!(leaf_size > 0) || !std::isfinite(leaf_size)) {
+      throw std::invalid_argument(
+          "StreamingVoxelGrid: leaf sizes must be positive and finite");
+    }
+  }
+  const PcdHeader header = ReadPcdHeader(input_path);
+  if (header.data != "binary") {
+    throw std::runtime_error(
+        "StreamingVoxelGrid: only DATA binary can be streamed, got " +
+        header.data);
+  }
+  const PcdHeader::Field* xyz[3] = {
+      header.field("x"), header.field("y"), header.field("z")};
+  for (const PcdHeader::Field* f : xyz) {
+    if (!f || f->type != 'F' || f->size != 4) {
+      throw std::runtime_error(
+          "StreamingVoxelGrid: x, y, z must be float32 fields");
+    }
+  }
+
+  MappedFile file(input_path);
+  const int64_t num_points = header.points();
+  const int64_t step = header.point_step;
+  if (header.data_offset + num_points * step >
+      static_cast<int64_t>(file.size())) {
+    throw std::runtime_error("StreamingVoxelGrid: truncated " + input_path);
+  }
+  const char* const points = file.data() + header.data_offset;
+
+  const std::vector<Channel> channels = MakeChannels(header);
+  const float inverse_leaf[3] = {
+      1 / options.leaf_size[0], 1 / options.leaf_size[1],
+      1 / options.leaf_size[2]};
+  const int num_threads = options.num_threads > 0 ?
+      options.num_threads :
+      std::max(1u, std::thread::hardware_concurrency());
+  const int64_t chunk = std::max<int64_t>(1, options.chunk_points);
+  const int64_t num_chunks = (num_points + chunk - 1) / chunk;
+
+  // tables[thread][partition].
+  std::vector<std::vector<CentroidTable>> tables(
+      num_threads,
+      std::vector<CentroidTable>(
+          kNumPartitions, CentroidTable(channels.size())));
+  std::atomic<int64_t> dropped{0};
+  ParallelFor(num_threads, num_chunks, [&](int thread, int64_t c) {
+    std::vector<CentroidTable>& local = tables[thread];
+    const char* begin = points + c * chunk * step;
+    const char* end =
+        points + std::min(num_points, (c + 1) * chunk) * step;
+    int64_t local_dropped = 0;
+    for (const char* point = begin; point < end; point += step) {
+      const uint64_t key = PackVoxelKey(
+          Load<float>(point + xyz[0]->offset),
+          Load<float>(point + xyz[1]->offset),
+          Load<float>(point + xyz[2]->offset), inverse_leaf);
+      if (key == kInvalidVoxelKey) {
+        ++local_dropped;
+        continue;
+      }
+      local[CentroidTable::Partition(key)].Add(key, point, channels);
+    }
+    dropped += local_dropped;
+    file.Release(begin, end);
+  });
+
+  // Merge partition `p` of every thread into thread 0's, and sort it.
+  using Voxel = std::pair<uint64_t, const double*>;
+  std::vector<std::vector<Voxel>> sorted(kNumPartitions);
+  ParallelFor(num_threads, kNumPartitions, [&](int, int64_t p) {
+    CentroidTable& table = tables[0][p];
+    for (int t = 1; t < num_threads; ++t) {
+      table.Merge(tables[t][p]);
+      tables[t][p] = CentroidTable(channels.size());
+    }
+    std::vector<Voxel>& out = sorted[p];
+    out.reserve(table.size());
+    table.ForEach([&out](uint64_t key, const double* sums) {
+      out.emplace_back(key, sums);
+    });
+    std::sort(out.begin(), out.end());
+  });
+
+  // K-way merge of the sorted partitions into the output.
+  int64_t num_voxels = 0;
+  for (const auto& part : sorted) num_voxels += part.size();
+  PcdHeader out_header = header;
+  out_header.width = num_voxels;
+  out_header.height = 1;
+  out_header.data = "binary";
+  std::ofstream out(output_path, std::ios::binary);
+  if (!out) {
+    throw std::runtime_error(
+        "StreamingVoxelGrid: cannot write " + output_path);
+  }
+  out << FormatPcdHeader(out_header);
+  // (key, partition, position), smallest key first.
+  using Cursor = std::tuple<uint64_t, int, size_t>;
+  std::priority_queue<Cursor, std::vector<Cursor>, std::greater<Cursor>>
+      heads;
+  for (int p = 0; p < kNumPartitions; ++p) {
+    if (!sorted[p].empty()) heads.emplace(sorted[p][0].first, p, 0);
+  }
+  std::vector<char> buffer;
+  const size_t kBufferPoints = 4096;
+  std::vector<char> record(step);
+  while (!heads.empty()) {
+    const auto [key, p, i] = heads.top();
+    heads.pop();
+    if (i + 1 < sorted[p].size()) {
+      heads.emplace(sorted[p][i + 1].first, p, i + 1);
+    }
+    const double* sums = sorted[p][i].second;
+    const double count = sums[channels.size()];
+    std::fill(record.begin(), record.end(), 0);
+    for (size_t c = 0; c < channels.size(); ++c) {
+      WriteChannel(record.data(), channels[c], sums[c] / count);
+    }
+    buffer.insert(buffer.end(), record.begin(), record.end());
+    if (buffer.size() >= kBufferPoints * step || heads.empty()) {
+      out.write(buffer.data(), buffer.size());
+      buffer.clear();
+    }
+  }
+  if (!out) {
+    throw std::runtime_error("StreamingVoxelGrid: write failed");
+  }
+
+  StreamingVoxelGridStats stats;
+  stats.input_points = num_points;
+  stats.dropped_points = dropped;
+  stats.output_points = num_voxels;
+  return stats;
+}
+
+}  // namespace voxel_grid
@@ -0,0 +1,82 @@
+#pragma once
+
+// Out-of-core voxel-grid downsampling of binary PCD files, for scans that do
+// not fit in memory as a `PCLPointCloud2` (see `voxel_grid.cpp` for the
+// in-memory `pcl::VoxelGrid` version).
+//
+// The input is memory-mapped and split into chunks of points; worker threads
+// hash each chunk's points into voxel keys (`voxel_key.h`) and accumulate
+// partial centroids in per-thread tables, which are partitioned by key so
+// that the final merge also runs in parallel. Pages of the input are dropped
+// once consumed, so resident memory is bounded by the number of occupied
+// voxels (i.e. the output), not the input.
+//
+// Like `pcl::VoxelGrid<PCLPointCloud2>` with `downsample_all_data` (the
+// default), every field is averaged (packed `rgb` / `rgba` per channel), and
+// points with non-finite coordinates are dropped. Voxels are written in
+// (z, y, x) order, as PCL does.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace voxel_grid {
+
+// Header of a PCD file (v0.7), as far as downsampling needs it.
+struct PcdHeader {
+  struct Field {
+    std::string name;
+    // 'F', 'I' or 'U'.
+    char type{};
+    int size{};
+    int count{};
+    // Byte offset within a point.
+    int offset{};
+  };
+
+  std::vector<Field> fields;
+  int64_t width{};
+  int64_t height{};
+  std::string viewpoint{"0 0 0 1 0 0 0"};
+  // "ascii", "binary" or "binary_compressed".
+  std::string data;
+  // Bytes per point.
+  int point_step{};
+  // Offset of the first point in the file.
+  int64_t data_offset{};
+
+  int64_t points() const { return width * height; }
+  // Returns nullptr if not present.
+  const Field* field(const std::string& name) const;
+};
+
+// Parses the header of `path`. Throws `std::runtime_error` on failure.
+PcdHeader ReadPcdHeader(const std::string& path);
+
+// Writes `header` (with `POINTS` = `width * height` and `DATA` = `data`).
+std::string FormatPcdHeader(const PcdHeader& header);
+
+struct StreamingVoxelGridOptions {
+  float leaf_size[3]{0.01f, 0.01f, 0.01f};
+  // 0 means `std::thread::hardware_concurrency()`.
+  int num_threads{0};
+  // Points per work item.
+  int64_t chunk_points{1 << 20};
+};
+
+struct StreamingVoxelGridStats {
+  int64_t input_points{};
+  // Points dropped for non-finite or out-of-range coordinates.
+  int64_t dropped_points{};
+  int64_t output_points{};
+};
+
+// Downsamples the binary PCD at `input_path` into `output_path`.
+// Throws `std::invalid_argument` for non-positive or non-finite leaf sizes,
+// and `std::runtime_error` on I/O errors or unsupported inputs (only
+// `DATA binary` with float `x`, `y`, `z` can be streamed).
+StreamingVoxelGridStats StreamingVoxelGrid(
+    const std::string& input_path, const std::string& output_path,
+    const StreamingVoxelGridOptions& options = {});
+
+}  // namespace voxel_grid
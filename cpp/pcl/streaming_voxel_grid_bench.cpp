@@ -0,0 +1,119 @@
+// File-to-file voxel-grid downsampling of synthetic binary PCDs (x y z rgb,
+// a noisy 2 m x 2 m surface), 1 cm leaves:
+// `pcl::VoxelGrid<PCLPointCloud2>` (read, filter, write; as in
+// `voxel_grid.cpp`) vs. `StreamingVoxelGrid`.
+//
+// Inputs are generated once under $TMPDIR (16 bytes / point, so 8 GB for the
+// largest size). PCL holds the whole cloud in memory (plus its index
+// vector), so it is only run up to 64M points.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <pcl/filters/voxel_grid.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/point_types.h>
+
+#include "benchmark/benchmark.h"
+
+#include "streaming_voxel_grid.h"
+
+namespace {
+
+constexpr float kLeafSize = 0.01f;
+
+std::string TempDir() {
+  const char* dir = std::getenv("TMPDIR");
+  return dir ? dir : "/tmp";
+}
+
+// Returns the path of a synthetic cloud with `num_points` points, writing it
+// if needed.
+std::string SyntheticPcd(int64_t num_points) {
+  const std::string path =
+      TempDir() + "/voxel_grid_bench_" + std::to_string(num_points) + ".pcd";
+  if (std::ifstream(path).good()) {
+    return path;
+  }
+  voxel_grid::PcdHeader header;
+  header.fields = {
+      {"x", 'F', 4, 1}, {"y", 'F', 4, 1}, {"z", 'F', 4, 1},
+      {"rgb", 'F', 4, 1}};
+  header.width = num_points;
+  header.height = 1;
+  header.data = "binary";
+  std::ofstream out(path, std::ios::binary);
+  out << voxel_grid::FormatPcdHeader(header);
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> uniform(0, 2);
+  std::normal_distribution<float> noise(0, 0.005f);
+  std::vector<float> buffer;
+  for (int64_t i = 0; i < num_points; ++i) {
+    const float x = uniform(gen);
+    const float y = uniform(gen);
+    const float z = 0.25f * std::sin(3 * x) * std::cos(2 * y) + noise(gen);
+    const uint32_t rgb = (i * 2654435761u) & 0xffffff;
+    float rgb_float;
+    std::memcpy(&rgb_float, &rgb, sizeof(rgb));
+    buffer.insert(buffer.end(), {x, y, z, rgb_float});
+    if (buffer.size() >= (1 << 20) || i + 1 == num_points) {
+      out.write(reinterpret_cast<const char*>(buffer.data()),
+                buffer.size() * sizeof(float));
+      buffer.clear();
+    }
+  }
+  return path;
+}
+
+}  // namespace
+
+static void BM_PclVoxelGrid(benchmark::State& state) {
+  const std::string input = SyntheticPcd(state.range(0));
+  const std::string output = TempDir() + "/voxel_grid_bench_pcl_out.pcd";
+  for (auto _ : state) {
+    pcl::PCLPointCloud2::Ptr cloud(new pcl::PCLPointCloud2());
+    pcl::PCLPointCloud2::Ptr cloud_filtered(new pcl::PCLPointCloud2());
+    pcl::PCDReader reader;
+    reader.read(input, *cloud);
+    pcl::VoxelGrid<pcl::PCLPointCloud2> sor;
+    sor.setInputCloud(cloud);
+    sor.setLeafSize(kLeafSize, kLeafSize, kLeafSize);
+    sor.filter(*cloud_filtered);
+    pcl::PCDWriter writer;
+    writer.writeBinary(output, *cloud_filtered);
+    state.counters["output_points"] =
+        cloud_filtered->width * cloud_filtered->height;
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_StreamingVoxelGrid(benchmark::State& state) {
+  const std::string input = SyntheticPcd(state.range(0));
+  const std::string output = TempDir() + "/voxel_grid_bench_stream_out.pcd";
+  voxel_grid::StreamingVoxelGridOptions options;
+  options.leaf_size[0] = options.leaf_size[1] = options.leaf_size[2] =
+      kLeafSize;
+  options.num_threads = state.range(1);
+  for (auto _ : state) {
+    const voxel_grid::StreamingVoxelGridStats stats =
+        voxel_grid::StreamingVoxelGrid(input, output, options);
+    state.counters["output_points"] = stats.output_points;
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_PclVoxelGrid)
+    ->RangeMultiplier(8)->Range(1 << 20, 1 << 26)
+    ->Unit(benchmark::kMillisecond)->Iterations(1);
+// {num_points, num_threads}; 0 threads means all cores.
+BENCHMARK(BM_StreamingVoxelGrid)
+    ->ArgsProduct({benchmark::CreateRange(1 << 20, 1 << 29, 8), {1, 0}})
+    ->Unit(benchmark::kMillisecond)->Iterations(1);
+
+BENCHMARK_MAIN();
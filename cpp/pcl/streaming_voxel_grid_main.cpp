@@ -0,0 +1,35 @@
+// Out-of-core counterpart of `voxel_grid.cpp`:
+//   streaming_voxel_grid <input.pcd> <output.pcd> [leaf_size] [num_threads]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "streaming_voxel_grid.h"
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0]
+              << " <input.pcd> <output.pcd> [leaf_size] [num_threads]\n";
+    return 1;
+  }
+  voxel_grid::StreamingVoxelGridOptions options;
+  if (argc > 3) {
+    const float leaf = std::atof(argv[3]);
+    options.leaf_size[0] = options.leaf_size[1] = options.leaf_size[2] = leaf;
+  }
+  if (argc > 4) {
+    options.num_threads = std::atoi(argv[4]);
+  }
+  const auto start = std::chrono::steady_clock::now();
+  const voxel_grid::StreamingVoxelGridStats stats =
+      voxel_grid::StreamingVoxelGrid(argv[1], argv[2], options);
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cerr << "PointCloud before filtering: " << stats.input_points
+            << " data points (" << stats.dropped_points << " dropped).\n"
+            << "PointCloud after filtering: " << stats.output_points
+            << " data points.\n"
+            << "Elapsed: " << elapsed.count() << " s\n";
+  return 0;
+}
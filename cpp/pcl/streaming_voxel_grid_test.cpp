@@ -0,0 +1,239 @@
+#include "streaming_voxel_grid.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <pcl/PCLPointCloud2.h>
+#include <pcl/common/io.h>
+#include <pcl/filters/voxel_grid.h>
+#include <pcl/io/pcd_io.h>
+
+#include "voxel_key.h"
+
+namespace voxel_grid {
+namespace {
+
+constexpr float kLeafSize = 0.05f;
+
+std::string TempPath(const std::string& name) {
+  const char* dir = std::getenv("TEST_TMPDIR");
+  if (!dir) dir = std::getenv("TMPDIR");
+  return std::string(dir ? dir : "/tmp") + "/" + name;
+}
+
+template <typename T>
+void Put(std::vector<char>* record, int offset, const T& value) {
+  std::memcpy(record->data() + offset, &value, sizeof(T));
+}
+
+template <typename T>
+T Get(const char* record, int offset) {
+  T value;
+  std::memcpy(&value, record + offset, sizeof(T));
+  return value;
+}
+
+// Random points in a 0.5 m cube (so ~1000 voxels), every 97th one NaN.
+// Calls `fill(i, record)` for the fields other than x, y, z, and returns the
+// path of the written PCD.
+template <typename Fill>
+std::string WriteCloud(const std::string& name, PcdHeader header, int n,
+                       Fill&& fill) {
+  header.point_step = 0;
+  for (PcdHeader::Field& field : header.fields) {
+    field.offset = header.point_step;
+    header.point_step += field.size * field.count;
+  }
+  header.width = n;
+  header.height = 1;
+  header.data = "binary";
+  const std::string path = TempPath(name);
+  std::ofstream out(path, std::ios::binary);
+  out << FormatPcdHeader(header);
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> uniform(-0.2f, 0.3f);
+  std::vector<char> record(header.point_step);
+  for (int i = 0; i < n; ++i) {
+    std::fill(record.begin(), record.end(), 0);
+    for (const char* axis : {"x", "y", "z"}) {
+      Put(&record, header.field(axis)->offset,
+          i % 97 == 0 ? NAN : uniform(gen));
+    }
+    fill(i, &record);
+    out.write(record.data(), record.size());
+  }
+  return path;
+}
+
+// Reads the points of a binary PCD written by `StreamingVoxelGrid`.
+std::vector<std::vector<char>> ReadRecords(const std::string& path,
+                                           PcdHeader* header) {
+  *header = ReadPcdHeader(path);
+  std::ifstream in(path, std::ios::binary);
+  in.seekg(header->data_offset);
+  std::vector<std::vector<char>> out(
+      header->points(), std::vector<char>(header->point_step));
+  for (auto& record : out) in.read(record.data(), record.size());
+  EXPECT_TRUE(in.good());
+  return out;
+}
+
+StreamingVoxelGridOptions Options(int num_threads, int64_t chunk_points) {
+  StreamingVoxelGridOptions options;
+  options.leaf_size[0] = options.leaf_size[1] = options.leaf_size[2] =
+      kLeafSize;
+  options.num_threads = num_threads;
+  options.chunk_points = chunk_points;
+  return options;
+}
+
+// Padding, packed colors and integer fields, against a plain (z, y, x)
+// ordered map of per-voxel sums.
+TEST(StreamingVoxelGridTest, MatchesReference) {
+  PcdHeader header;
+  header.fields = {{"x", 'F', 4, 1}, {"y", 'F', 4, 1}, {"z", 'F', 4, 1},
+                   {"_", 'U', 1, 4}, {"rgba", 'U', 4, 1},
+                   {"intensity", 'U', 2, 1}};
+  constexpr int kPoints = 50000;
+  const std::string input = WriteCloud(
+      "streaming_voxel_grid_test_ref.pcd", header, kPoints,
+      [](int i, std::vector<char>* record) {
+        const uint8_t color[4] = {
+            uint8_t(i % 256), uint8_t(i % 7), 10, 255};
+        std::memcpy(record->data() + 16, color, 4);
+        Put(record, 20, uint16_t(i % 1000));
+      });
+
+  struct Sums {
+    double xyz[3]{};
+    double color[4]{};
+    double intensity{};
+    int count{};
+  };
+  std::map<uint64_t, Sums> expected;
+  {
+    PcdHeader in_header;
+    const auto records = ReadRecords(input, &in_header);
+    const float inverse_leaf[3] = {
+        1 / kLeafSize, 1 / kLeafSize, 1 / kLeafSize};
+    for (const auto& record : records) {
+      const float xyz[3] = {Get<float>(record.data(), 0),
+                            Get<float>(record.data(), 4),
+                            Get<float>(record.data(), 8)};
+      const uint64_t key = PackVoxelKey(xyz[0], xyz[1], xyz[2], inverse_leaf);
+      if (key == kInvalidVoxelKey) continue;
+      Sums& sums = expected[key];
+      for (int k = 0; k < 3; ++k) sums.xyz[k] += xyz[k];
+      for (int k = 0; k < 4; ++k) {
+        sums.color[k] += static_cast<uint8_t>(record[16 + k]);
+      }
+      sums.intensity += Get<uint16_t>(record.data(), 20);
+      ++sums.count;
+    }
+  }
+
+  const std::string output = TempPath("streaming_voxel_grid_test_ref_out.pcd");
+  for (int num_threads : {1, 3}) {
+    for (int64_t chunk_points : {int64_t{1} << 20, int64_t{1000}}) {
+      const StreamingVoxelGridStats stats = StreamingVoxelGrid(
+          input, output, Options(num_threads, chunk_points));
+      EXPECT_EQ(stats.input_points, kPoints);
+      EXPECT_EQ(stats.dropped_points, (kPoints + 96) / 97);
+      ASSERT_EQ(stats.output_points, static_cast<int64_t>(expected.size()));
+      PcdHeader out_header;
+      const auto records = ReadRecords(output, &out_header);
+      EXPECT_EQ(out_header.point_step, 22);
+      auto iter = expected.begin();
+      for (const auto& record : records) {
+        const Sums& sums = (iter++)->second;
+        for (int k = 0; k < 3; ++k) {
+          EXPECT_NEAR(Get<float>(record.data(), 4 * k),
+                      sums.xyz[k] / sums.count, 1e-6);
+        }
+        for (int k = 0; k < 4; ++k) {
+          EXPECT_EQ(static_cast<uint8_t>(record[16 + k]),
+                    std::llround(sums.color[k] / sums.count));
+        }
+        EXPECT_EQ(Get<uint16_t>(record.data(), 20),
+                  std::llround(sums.intensity / sums.count));
+      }
+    }
+  }
+}
+
+// Float fields and packed rgb, against `pcl::VoxelGrid<PCLPointCloud2>`
+// (which only averages float fields correctly).
+TEST(StreamingVoxelGridTest, MatchesPclVoxelGrid) {
+  PcdHeader header;
+  header.fields = {{"x", 'F', 4, 1}, {"y", 'F', 4, 1}, {"z", 'F', 4, 1},
+                   {"rgb", 'F', 4, 1}, {"intensity", 'F', 4, 1}};
+  const std::string input = WriteCloud(
+      "streaming_voxel_grid_test_pcl.pcd", header, 50000,
+      [](int i, std::vector<char>* record) {
+        Put(record, 12, uint32_t((i * 2654435761u) & 0xffffff));
+        Put(record, 16, 0.01f * (i % 1000));
+      });
+
+  pcl::PCLPointCloud2::Ptr cloud(new pcl::PCLPointCloud2());
+  ASSERT_EQ(pcl::PCDReader().read(input, *cloud), 0);
+  pcl::PCLPointCloud2 expected;
+  pcl::VoxelGrid<pcl::PCLPointCloud2> sor;
+  sor.setInputCloud(cloud);
+  sor.setLeafSize(kLeafSize, kLeafSize, kLeafSize);
+  sor.filter(expected);
+
+  const std::string output = TempPath("streaming_voxel_grid_test_pcl_out.pcd");
+  const StreamingVoxelGridStats stats =
+      StreamingVoxelGrid(input, output, Options(3, 1000));
+  ASSERT_EQ(stats.output_points,
+            static_cast<int64_t>(expected.width) * expected.height);
+  PcdHeader out_header;
+  const auto records = ReadRecords(output, &out_header);
+  ASSERT_EQ(out_header.point_step, static_cast<int>(expected.point_step));
+  for (size_t i = 0; i < records.size(); ++i) {
+    const char* actual = records[i].data();
+    const char* reference = reinterpret_cast<const char*>(
+        &expected.data[i * expected.point_step]);
+    // Sums are accumulated in float, in a different order, by PCL.
+    for (int offset : {0, 4, 8, 16}) {
+      EXPECT_NEAR(Get<float>(actual, offset), Get<float>(reference, offset),
+                  1e-5) << i;
+    }
+    // PCL truncates channel means where this rounds, and drops alpha.
+    for (int byte = 0; byte < 3; ++byte) {
+      EXPECT_NEAR(static_cast<uint8_t>(actual[12 + byte]),
+                  static_cast<uint8_t>(reference[12 + byte]), 1) << i;
+    }
+  }
+}
+
+TEST(StreamingVoxelGridTest, RejectsUnsupportedInputs) {
+  PcdHeader header;
+  header.fields = {{"x", 'F', 4, 1}, {"y", 'F', 4, 1}, {"z", 'F', 8, 1}};
+  const std::string input = WriteCloud(
+      "streaming_voxel_grid_test_double.pcd", header, 10,
+      [](int, std::vector<char>*) {});
+  EXPECT_THROW(
+      StreamingVoxelGrid(input, TempPath("unused.pcd"), Options(1, 10)),
+      std::runtime_error);
+  EXPECT_THROW(ReadPcdHeader(TempPath("does_not_exist.pcd")),
+               std::runtime_error);
+  for (float leaf_size : {0.f, -kLeafSize, float(NAN), float(INFINITY)}) {
+    StreamingVoxelGridOptions options = Options(1, 10);
+    options.leaf_size[1] = leaf_size;
+    EXPECT_THROW(StreamingVoxelGrid(input, TempPath("unused.pcd"), options),
+                 std::invalid_argument);
+  }
+}
+
+}  // namespace
+}  // namespace voxel_grid
@@ -0,0 +1,51 @@
+#pragma once
+
+// 64-bit packed voxel keys, shared by the voxel-grid filters in this
+// directory.
+//
+// Each axis gets `kVoxelKeyBits` bits of leaf index (offset to be unsigned),
+// so that with 1 cm leaves a key covers +/- 10 km per axis, where
+// `pcl::VoxelGrid`'s int32 linear index already overflows for ~13 m cubes.
+// Keys sort by (z, y, x), i.e. in the same order as `pcl::VoxelGrid`'s
+// output.
+
+#include <cmath>
+#include <cstdint>
+
+namespace voxel_grid {
+
+constexpr int kVoxelKeyBits = 21;
+constexpr int64_t kVoxelIndexOffset = int64_t{1} << (kVoxelKeyBits - 1);
+constexpr uint64_t kVoxelIndexMask = (uint64_t{1} << kVoxelKeyBits) - 1;
+// Never produced by `PackVoxelKey`, since keys only use 63 bits.
+constexpr uint64_t kInvalidVoxelKey = ~uint64_t{0};
+
+// Returns `kInvalidVoxelKey` for non-finite points or points out of range.
+inline uint64_t PackVoxelKey(
+    float x, float y, float z, const float inverse_leaf[3]) {
+  // Leaf indices as in `pcl::VoxelGrid`; range-checked before the integer
+  // conversion (which also rejects NaN / inf).
+  const float scaled[3] = {
+      std::floor(x * inverse_leaf[0]),
+      std::floor(y * inverse_leaf[1]),
+      std::floor(z * inverse_leaf[2])};
+  uint64_t key = 0;
+  for (int i = 0; i < 3; ++i) {
+    if (!(std::fabs(scaled[i]) < kVoxelIndexOffset)) {
+      return kInvalidVoxelKey;
+    }
+    const uint64_t index =
+        static_cast<int64_t>(scaled[i]) + kVoxelIndexOffset;
+    key |= index << (i * kVoxelKeyBits);
+  }
+  return key;
+}
+
+inline void UnpackVoxelKey(uint64_t key, int64_t ijk[3]) {
+  for (int i = 0; i < 3; ++i) {
+    ijk[i] = static_cast<int64_t>((key >> (i * kVoxelKeyBits)) &
+                                  kVoxelIndexMask) - kVoxelIndexOffset;
+  }
+}
+
+}  // namespace voxel_grid
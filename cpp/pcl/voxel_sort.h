@@ -0,0 +1,208 @@
+#pragma once
+
+// Building blocks of `RadixVoxelGrid` (see `radix_voxel_grid.h`), free of
+// PCL types: voxel keys for a strided array of points, a parallel LSD radix
+// sort of (key, index) pairs, and a parallel walk over runs of equal keys.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include "voxel_key.h"
+
+namespace voxel_grid {
+
+// Runs `f(thread)` for `thread` in [0, num_threads), on the calling thread
+// and `num_threads - 1` new ones.
+template <typename Func>
+void ParallelRun(int num_threads, Func&& f) {
+  std::vector<std::thread> threads;
+  for (int t = 1; t < num_threads; ++t) {
+    threads.emplace_back(f, t);
+  }
+  f(0);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+// [begin, end) of the `thread`-th of `num_threads` even slices of [0, n).
+inline std::pair<size_t, size_t> Slice(size_t n, int thread, int num_threads) {
+  return {n * thread / num_threads, n * (thread + 1) / num_threads};
+}
+
+// Keys of `num_points` points, each starting at `points + i * stride` (in
+// floats) with x, y, z followed by one more readable float, as PCL's
+// `PCL_ADD_POINT4D` layout guarantees.
+//
+// Keys are dense linear voxel indices `(i - i_min) + (j - j_min) * nx +
+// (k - k_min) * nx * ny` (i.e. `pcl::VoxelGrid`'s, but 64-bit), so they sort
+// in the same order and need as few radix passes as possible. Points that
+// are non-finite or out of `PackVoxelKey`'s range get
+// `kInvalidVoxelKey`. Returns the number of significant key bits.
+inline int ComputeVoxelKeys(
+    const float* points, size_t stride, size_t num_points,
+    const float inverse_leaf[3], int num_threads, uint64_t* keys) {
+  // Pass 1: packed keys (one SIMD multiply / floor per point) and bounds.
+  const Eigen::Array4f inverse(
+      inverse_leaf[0], inverse_leaf[1], inverse_leaf[2], 0.0f);
+  const Eigen::Array4f limit = Eigen::Array4f::Constant(kVoxelIndexOffset);
+  std::vector<Eigen::Array4f> lower(
+      num_threads, Eigen::Array4f::Constant(kVoxelIndexOffset));
+  std::vector<Eigen::Array4f> upper(
+      num_threads, Eigen::Array4f::Constant(-kVoxelIndexOffset));
+  ParallelRun(num_threads, [&](int t) {
+    const auto [begin, end] = Slice(num_points, t, num_threads);
+    Eigen::Array4f lo = lower[t], hi = upper[t];
+    for (size_t i = begin; i < end; ++i) {
+      const Eigen::Array4f scaled =
+          (Eigen::Map<const Eigen::Array4f>(points + i * stride) * inverse)
+              .floor();
+      // Also false for NaN / inf. The fourth lane is padding.
+      if (!(scaled.head<3>().abs() < limit.head<3>()).all()) {
+        keys[i] = kInvalidVoxelKey;
+        continue;
+      }
+      const Eigen::Array4i ijk = (scaled + limit).cast<int>();
+      keys[i] = uint64_t(ijk[0]) | (uint64_t(ijk[1]) << kVoxelKeyBits) |
+          (uint64_t(ijk[2]) << (2 * kVoxelKeyBits));
+      lo = lo.min(scaled);
+      hi = hi.max(scaled);
+    }
+    lower[t] = lo;
+    upper[t] = hi;
+  });
+  Eigen::Array4f lo = lower[0], hi = upper[0];
+  for (int t = 1; t < num_threads; ++t) {
+    lo = lo.min(lower[t]);
+    hi = hi.max(upper[t]);
+  }
+  if ((lo.head<3>() > hi.head<3>()).any()) {
+    return 0;  // No valid points.
+  }
+
+  // Pass 2: packed -> dense (fits in 63 bits since each axis spans at most
+  // `kVoxelKeyBits` bits).
+  uint64_t min[3], size[3];
+  for (int a = 0; a < 3; ++a) {
+    min[a] = static_cast<uint64_t>(lo[a] + kVoxelIndexOffset);
+    size[a] = static_cast<uint64_t>(hi[a] - lo[a]) + 1;
+  }
+  const uint64_t mul_y = size[0];
+  const uint64_t mul_z = size[0] * size[1];
+  ParallelRun(num_threads, [&](int t) {
+    const auto [begin, end] = Slice(num_points, t, num_threads);
+    for (size_t i = begin; i < end; ++i) {
+      const uint64_t key = keys[i];
+      if (key == kInvalidVoxelKey) continue;
+      keys[i] = ((key & kVoxelIndexMask) - min[0]) +
+          (((key >> kVoxelKeyBits) & kVoxelIndexMask) - min[1]) * mul_y +
+          ((key >> (2 * kVoxelKeyBits)) - min[2]) * mul_z;
+    }
+  });
+  const uint64_t max_key = size[0] * size[1] * size[2] - 1;
+  int bits = 1;
+  while (bits < 64 && (max_key >> bits) != 0) ++bits;
+  return bits;
+}
+
+// Stable LSD radix sort of `keys` (8-bit digits, only over the low
+// `key_bits` bits), permuting `values` alongside. Keys with bits above
+// `key_bits` (e.g. `kInvalidVoxelKey`) must have been removed.
+template <typename Value>
+void ParallelRadixSort(
+    std::vector<uint64_t>* keys, std::vector<Value>* values, int key_bits,
+    int num_threads) {
+  constexpr int kDigitBits = 8;
+  constexpr int kBuckets = 1 << kDigitBits;
+  const size_t n = keys->size();
+  std::vector<uint64_t> keys_tmp(n);
+  std::vector<Value> values_tmp(n);
+  // counts[thread][bucket] -> output offset.
+  std::vector<std::vector<size_t>> counts(
+      num_threads, std::vector<size_t>(kBuckets));
+  for (int shift = 0; shift < key_bits; shift += kDigitBits) {
+    const uint64_t* in_keys = keys->data();
+    const Value* in_values = values->data();
+    ParallelRun(num_threads, [&](int t) {
+      const auto [begin, end] = Slice(n, t, num_threads);
+      std::vector<size_t>& count = counts[t];
+      std::fill(count.begin(), count.end(), 0);
+      for (size_t i = begin; i < end; ++i) {
+        ++count[(in_keys[i] >> shift) & (kBuckets - 1)];
+      }
+    });
+    size_t offset = 0;
+    for (int b = 0; b < kBuckets; ++b) {
+      for (int t = 0; t < num_threads; ++t) {
+        const size_t count = counts[t][b];
+        counts[t][b] = offset;
+        offset += count;
+      }
+    }
+    ParallelRun(num_threads, [&](int t) {
+      const auto [begin, end] = Slice(n, t, num_threads);
+      std::vector<size_t>& offsets = counts[t];
+      for (size_t i = begin; i < end; ++i) {
+        const size_t dst =
+            offsets[(in_keys[i] >> shift) & (kBuckets - 1)]++;
+        keys_tmp[dst] = in_keys[i];
+        values_tmp[dst] = in_values[i];
+      }
+    });
+    keys->swap(keys_tmp);
+    values->swap(values_tmp);
+  }
+}
+
+// Calls `f(run, begin, end)` for every run [begin, end) of equal `keys` with
+// at least `min_size` elements, in parallel; `run` numbers the qualifying
+// runs consecutively in key order. `prepare(num_runs)` is called first
+// (e.g. to size the output). Returns the number of qualifying runs.
+template <typename Prepare, typename Func>
+size_t ParallelForEachRun(
+    const std::vector<uint64_t>& keys, size_t min_size, int num_threads,
+    Prepare&& prepare, Func&& f) {
+  const size_t n = keys.size();
+  // Thread `t` owns the runs starting in [starts[t], starts[t + 1]).
+  // Slice starts are moved forward to the next run boundary, which keeps
+  // them sorted.
+  std::vector<size_t> starts(num_threads + 1, n);
+  for (int t = 0; t < num_threads; ++t) {
+    size_t start = Slice(n, t, num_threads).first;
+    while (start > 0 && start < n && keys[start] == keys[start - 1]) {
+      ++start;
+    }
+    starts[t] = start;
+  }
+  auto for_each_run = [&](int t, auto&& g) {
+    size_t begin = starts[t];
+    while (begin < starts[t + 1]) {
+      size_t end = begin + 1;
+      while (end < n && keys[end] == keys[begin]) ++end;
+      if (end - begin >= min_size) g(begin, end);
+      begin = end;
+    }
+  };
+  std::vector<size_t> first_run(num_threads + 1, 0);
+  ParallelRun(num_threads, [&](int t) {
+    size_t count = 0;
+    for_each_run(t, [&count](size_t, size_t) { ++count; });
+    first_run[t + 1] = count;
+  });
+  for (int t = 0; t < num_threads; ++t) {
+    first_run[t + 1] += first_run[t];
+  }
+  prepare(first_run[num_threads]);
+  ParallelRun(num_threads, [&](int t) {
+    size_t run = first_run[t];
+    for_each_run(t, [&](size_t begin, size_t end) { f(run++, begin, end); });
+  });
+  return first_run[num_threads];
+}
+
+}  // namespace voxel_grid
@@ -9,7 +9,8 @@
 #include <iostream>
 #include <thread>
 
-/* Simple error handling functions */
+// Prototype only: `exit()` from the signal thread skips cleanup and races
+// with the other threads. See `signal_service.h` for the reusable version.
 
 class SigintThread {
  public:
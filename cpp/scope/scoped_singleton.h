@@ -0,0 +1,207 @@
+#pragma once
+
+// Scoped singletons (see `weak_ptr_singleton.cc`) with a low-contention fast
+// path.
+//
+// The instance lives as long as at least one caller holds a `shared_ptr` to
+// it; once all references are dropped, the next call creates a fresh one.
+//
+// `GetScopedSingleton` keeps a per-thread `weak_ptr` to the instance, so a
+// repeat call from the same thread is one `weak_ptr::lock()` (an atomic
+// increment on the instance's control block) and touches no shared lock. The
+// shared slot, and its mutex, are only used on a thread's first call and
+// after the instance has expired.
+// N.B. The cache must not hold a strong reference, otherwise the instance
+// would never expire.
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace scope {
+
+// Single scoped-singleton cell.
+template <typename T>
+class ScopedSingletonSlot {
+ public:
+  ScopedSingletonSlot() = default;
+  ScopedSingletonSlot(const ScopedSingletonSlot&) = delete;
+  ScopedSingletonSlot& operator=(const ScopedSingletonSlot&) = delete;
+
+  // Returns the live instance, or creates one with `factory()`.
+  template <typename Factory>
+  std::shared_ptr<T> GetOrCreate(Factory&& factory) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_ptr<T> instance = ref_.lock();
+    if (!instance) {
+      instance = factory();
+      ref_ = instance;
+    }
+    return instance;
+  }
+
+  std::shared_ptr<T> GetOrCreate() {
+    return GetOrCreate([]() { return std::make_shared<T>(); });
+  }
+
+  // Returns the live instance, or nullptr if there is none.
+  std::shared_ptr<T> TryGet() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ref_.lock();
+  }
+
+  bool expired() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ref_.expired();
+  }
+
+ private:
+  std::weak_ptr<T> ref_;
+  mutable std::mutex mutex_;
+};
+
+// Concurrent map of `Key` -> `ScopedSingletonSlot<T>`.
+// The map is split into shards, each guarded by a `std::shared_mutex`, so
+// lookups of existing keys only take a shared (reader) lock on one shard.
+// Slots whose instances have expired are swept when a shard doubles in size,
+// keeping insertion amortized O(1).
+template <typename T, typename Key, typename Hash = std::hash<Key>>
+class KeyedScopedSingletons {
+ public:
+  explicit KeyedScopedSingletons(size_t num_shards = 16)
+      : shards_(num_shards) {}
+  KeyedScopedSingletons(const KeyedScopedSingletons&) = delete;
+  KeyedScopedSingletons& operator=(const KeyedScopedSingletons&) = delete;
+
+  template <typename Factory>
+  std::shared_ptr<T> GetOrCreate(const Key& key, Factory&& factory) {
+    return GetSlot(key)->GetOrCreate(std::forward<Factory>(factory));
+  }
+
+  std::shared_ptr<T> GetOrCreate(const Key& key) {
+    return GetSlot(key)->GetOrCreate();
+  }
+
+  // Number of keys currently tracked (live or not yet swept).
+  size_t size() const {
+    size_t out = 0;
+    for (auto& shard : shards_) {
+      std::shared_lock<std::shared_mutex> lock(shard.mutex);
+      out += shard.slots.size();
+    }
+    return out;
+  }
+
+ private:
+  using Slot = ScopedSingletonSlot<T>;
+
+  struct Shard {
+    mutable std::shared_mutex mutex;
+    std::unordered_map<Key, std::shared_ptr<Slot>, Hash> slots;
+    size_t sweep_at{16};
+  };
+
+  std::shared_ptr<Slot> GetSlot(const Key& key) {
+    Shard& shard = shards_[Hash{}(key) % shards_.size()];
+    {
+      std::shared_lock<std::shared_mutex> lock(shard.mutex);
+      auto iter = shard.slots.find(key);
+      if (iter != shard.slots.end()) {
+        return iter->second;
+      }
+    }
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto iter = shard.slots.find(key);
+    if (iter != shard.slots.end()) {
+      return iter->second;
+    }
+    if (shard.slots.size() >= shard.sweep_at) {
+      Sweep(&shard);
+      shard.sweep_at = std::max<size_t>(16, 2 * shard.slots.size());
+    }
+    auto slot = std::make_shared<Slot>();
+    shard.slots.emplace(key, slot);
+    return slot;
+  }
+
+  // Drops slots with no live instance that nobody else is referencing.
+  // Requires the shard's exclusive lock.
+  static void Sweep(Shard* shard) {
+    for (auto iter = shard->slots.begin(); iter != shard->slots.end();) {
+      if (iter->second.use_count() == 1 && iter->second->expired()) {
+        iter = shard->slots.erase(iter);
+      } else {
+        ++iter;
+      }
+    }
+  }
+
+  std::vector<Shard> shards_;
+};
+
+namespace internal {
+
+// Per-thread `weak_ptr`s for the keyed variant. Expired entries are swept
+// when the map doubles in size.
+template <typename T, typename Key>
+struct ThreadRefs {
+  std::unordered_map<Key, std::weak_ptr<T>> refs;
+  size_t sweep_at{16};
+
+  std::shared_ptr<T> Lock(const Key& key) const {
+    auto iter = refs.find(key);
+    return iter != refs.end() ? iter->second.lock() : nullptr;
+  }
+
+  void Set(const Key& key, const std::shared_ptr<T>& instance) {
+    if (refs.size() >= sweep_at) {
+      for (auto iter = refs.begin(); iter != refs.end();) {
+        iter = iter->second.expired() ? refs.erase(iter) : std::next(iter);
+      }
+      sweep_at = std::max<size_t>(16, 2 * refs.size());
+    }
+    refs[key] = instance;
+  }
+};
+
+}  // namespace internal
+
+// Low-contention version of `GetScopedSingleton` from `weak_ptr_singleton.cc`.
+// `Extra` may be used to create distinct singletons of the same type.
+// Each thread first tries its own cached `weak_ptr`; since a slot has at most
+// one live instance at a time, a successful `lock()` always yields the current
+// one, and the shared slot is not touched at all.
+template <typename T, typename Extra = void>
+std::shared_ptr<T> GetScopedSingleton() {
+  static ScopedSingletonSlot<T> slot;
+  static thread_local std::weak_ptr<T> thread_ref;
+  if (auto instance = thread_ref.lock()) {
+    return instance;
+  }
+  auto instance = slot.GetOrCreate();
+  thread_ref = instance;
+  return instance;
+}
+
+// Keyed variant: one scoped singleton per distinct `key`. Repeat calls for a
+// key look it up in a per-thread map first, as above.
+template <typename T, typename Extra = void, typename Key>
+std::shared_ptr<T> GetScopedSingleton(const Key& key) {
+  static KeyedScopedSingletons<T, Key> singletons;
+  static thread_local internal::ThreadRefs<T, Key> thread_refs;
+  if (auto instance = thread_refs.Lock(key)) {
+    return instance;
+  }
+  // `GetOrCreate` may re-enter for another key and modify `thread_refs`.
+  auto instance = singletons.GetOrCreate(key);
+  thread_refs.Set(key, instance);
+  return instance;
+}
+
+}  // namespace scope
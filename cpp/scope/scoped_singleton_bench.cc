@@ -0,0 +1,116 @@
+// Contention benchmark: `GetScopedSingleton` with a mutex on every call (as in
+// `weak_ptr_singleton.cc`) vs. `scoped_singleton.h`.
+//
+// Each benchmark keeps one reference alive for its whole duration, so the
+// measured calls only exercise the "already created" path.
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "scoped_singleton.h"
+
+namespace {
+
+struct Resource {
+  double value{};
+};
+
+// Reference implementation from `weak_ptr_singleton.cc`.
+template <typename T, typename Extra = void>
+std::shared_ptr<T> GetScopedSingletonMutex() {
+  struct Singleton {
+    std::weak_ptr<T> weak_ref_;
+    std::mutex mutex_;
+  };
+  static Singleton singleton;
+  std::lock_guard<std::mutex> lock(singleton.mutex_);
+  auto instance = singleton.weak_ref_.lock();
+  if (!instance) {
+    instance = std::make_shared<T>();
+    singleton.weak_ref_ = instance;
+  }
+  return instance;
+}
+
+// Reference for the keyed variant: one global mutex around a map.
+std::shared_ptr<Resource> GetKeyedMutex(int key) {
+  static std::mutex mutex;
+  static std::unordered_map<int, std::weak_ptr<Resource>> refs;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& ref = refs[key];
+  auto instance = ref.lock();
+  if (!instance) {
+    instance = std::make_shared<Resource>();
+    ref = instance;
+  }
+  return instance;
+}
+
+constexpr int kNumKeys = 64;
+
+std::shared_ptr<Resource> GetKeyedScoped(int key) {
+  return scope::GetScopedSingleton<Resource>(key);
+}
+
+// Keeps every keyed instance alive while the benchmark runs. Each benchmark
+// passes its own `keep`, so neither holds the other's instances.
+template <typename Get>
+void HoldAll(benchmark::State& state, Get&& get,
+             std::vector<std::shared_ptr<Resource>>* keep) {
+  if (state.thread_index() == 0) {
+    keep->clear();
+    for (int key = 0; key < kNumKeys; ++key) {
+      keep->push_back(get(key));
+    }
+  }
+}
+
+}  // namespace
+
+static void BM_Mutex(benchmark::State& state) {
+  auto keep = GetScopedSingletonMutex<Resource>();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(GetScopedSingletonMutex<Resource>());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Mutex)->ThreadRange(1, 16)->UseRealTime();
+
+static void BM_Scoped(benchmark::State& state) {
+  auto keep = scope::GetScopedSingleton<Resource>();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(scope::GetScopedSingleton<Resource>());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Scoped)->ThreadRange(1, 16)->UseRealTime();
+
+static void BM_KeyedMutex(benchmark::State& state) {
+  static std::vector<std::shared_ptr<Resource>> keep;
+  HoldAll(state, GetKeyedMutex, &keep);
+  int key = state.thread_index();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(GetKeyedMutex(key));
+    key = (key + 1) % kNumKeys;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_KeyedMutex)->ThreadRange(1, 16)->UseRealTime();
+
+static void BM_KeyedScoped(benchmark::State& state) {
+  static std::vector<std::shared_ptr<Resource>> keep;
+  HoldAll(state, GetKeyedScoped, &keep);
+  int key = state.thread_index();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(GetKeyedScoped(key));
+    key = (key + 1) % kNumKeys;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_KeyedScoped)->ThreadRange(1, 16)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,72 @@
+// Goal: Same as `weak_ptr_singleton.cc`, but using `scoped_singleton.h`, plus
+// the keyed variants.
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "scoped_singleton.h"
+
+using std::cout;
+using std::endl;
+using std::weak_ptr;
+using scope::GetScopedSingleton;
+
+class Resource {
+ public:
+    Resource() { cout << "ctor" << endl; }
+    ~Resource() { cout << "dtor" << endl; }
+};
+
+struct A {};
+
+int main() {
+  weak_ptr<Resource> wref;
+  weak_ptr<Resource> wref_a;
+  cout << "- default: " << wref.use_count() << endl;
+  cout << "- A: " << wref_a.use_count() << endl;
+  {
+    auto ref_1 = GetScopedSingleton<Resource>();
+    wref = ref_1;
+    cout << "- default: " << wref.use_count() << endl;
+    auto ref_2 = GetScopedSingleton<Resource>();
+    cout << "- default: " << wref.use_count() << endl;
+    {
+      auto ref_3 = GetScopedSingleton<Resource>();
+      cout << "- default: " << wref.use_count() << endl;
+      auto ref_a_1 = GetScopedSingleton<Resource, A>();
+      wref_a = ref_a_1;
+      cout << "- A: " << wref_a.use_count() << endl;
+    }
+    cout << "- default: " << wref.use_count() << endl;
+    cout << "- A: " << wref_a.use_count() << endl;
+  }
+  cout << "- default: " << wref.use_count() << endl;
+
+  {
+    auto ref_1 = GetScopedSingleton<Resource>();
+    wref = ref_1;
+    cout << "- default: " << wref.use_count() << endl;
+  }
+  cout << "- default: " << wref.use_count() << endl;
+
+  cout << "[ keyed ]" << endl;
+  weak_ptr<Resource> wref_x;
+  weak_ptr<Resource> wref_y;
+  {
+    auto ref_x_1 = GetScopedSingleton<Resource>(std::string("x"));
+    wref_x = ref_x_1;
+    auto ref_x_2 = GetScopedSingleton<Resource>(std::string("x"));
+    cout << "- x: " << wref_x.use_count() << endl;
+    {
+      auto ref_y = GetScopedSingleton<Resource>(std::string("y"));
+      wref_y = ref_y;
+      cout << "- y: " << wref_y.use_count() << endl;
+      cout << "- same: " << (ref_x_1 == ref_y) << endl;
+    }
+    cout << "- x: " << wref_x.use_count() << endl;
+    cout << "- y: " << wref_y.use_count() << endl;
+  }
+  cout << "- x: " << wref_x.use_count() << endl;
+  return 0;
+}
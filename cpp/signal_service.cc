@@ -0,0 +1,213 @@
+#include "signal_service.h"
+
+#include <poll.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <system_error>
+
+namespace signal_service {
+namespace internal {
+
+struct ShutdownState {
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::atomic<bool> requested{false};
+  // Set once `requested`; guarded by `mutex` until then.
+  int signal{};
+  Clock::time_point deadline;
+  // Registered subsystems, and the drains still running, by id.
+  std::map<int, std::pair<std::string, SignalService::DrainFunc>> subsystems;
+  std::map<int, std::string> running;
+  int next_id{};
+};
+
+}  // namespace internal
+
+using internal::ShutdownState;
+
+namespace {
+
+void ThrowErrno(const char* what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+}  // namespace
+
+bool ShutdownToken::stop_requested() const {
+  return state_->requested.load(std::memory_order_acquire);
+}
+
+int ShutdownToken::signal() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->signal;
+}
+
+Clock::time_point ShutdownToken::deadline() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->deadline;
+}
+
+void ShutdownToken::Wait() const {
+  std::unique_lock<std::mutex> lock(state_->mutex);
+  state_->cv.wait(lock, [this]() { return state_->requested.load(); });
+}
+
+bool ShutdownToken::WaitFor(Clock::duration timeout) const {
+  std::unique_lock<std::mutex> lock(state_->mutex);
+  return state_->cv.wait_for(
+      lock, timeout, [this]() { return state_->requested.load(); });
+}
+
+SignalService::SignalService(Options options)
+    : options_(std::move(options)),
+      state_(std::make_shared<ShutdownState>()) {
+  sigemptyset(&signals_);
+  for (int signal : options_.shutdown_signals) sigaddset(&signals_, signal);
+  for (const auto& item : options_.handlers) {
+    sigaddset(&signals_, item.first);
+  }
+  const int error = pthread_sigmask(SIG_BLOCK, &signals_, &old_mask_);
+  if (error != 0) {
+    throw std::system_error(error, std::generic_category(), "pthread_sigmask");
+  }
+  signal_fd_ = signalfd(-1, &signals_, SFD_CLOEXEC);
+  wake_fd_ = eventfd(0, EFD_CLOEXEC);
+  if (signal_fd_ < 0 || wake_fd_ < 0) {
+    const int saved = errno;
+    if (signal_fd_ >= 0) close(signal_fd_);
+    if (wake_fd_ >= 0) close(wake_fd_);
+    pthread_sigmask(SIG_SETMASK, &old_mask_, nullptr);
+    errno = saved;
+    ThrowErrno("signalfd / eventfd");
+  }
+  thread_ = std::thread(&SignalService::Loop, this);
+}
+
+SignalService::~SignalService() {
+  RequestShutdown();
+  WaitForShutdown();
+  const uint64_t one = 1;
+  if (write(wake_fd_, &one, sizeof(one)) != sizeof(one)) {
+    std::cerr << "SignalService: cannot wake the signal thread\n";
+  }
+  thread_.join();
+  close(signal_fd_);
+  close(wake_fd_);
+  pthread_sigmask(SIG_SETMASK, &old_mask_, nullptr);
+}
+
+int SignalService::Register(std::string name, DrainFunc drain) {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  const int id = state_->next_id++;
+  if (!state_->requested) {
+    state_->subsystems.emplace(
+        id, std::make_pair(std::move(name), std::move(drain)));
+  }
+  return id;
+}
+
+void SignalService::Unregister(int id) {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  state_->subsystems.erase(id);
+}
+
+void SignalService::RequestShutdown() { StartShutdown(0); }
+
+int SignalService::WaitForShutdown() {
+  ShutdownState& state = *state_;
+  std::unique_lock<std::mutex> lock(state.mutex);
+  state.cv.wait(lock, [&state]() { return state.requested.load(); });
+  state.cv.wait_until(lock, state.deadline,
+                      [&state]() { return state.running.empty(); });
+  return state.signal != 0 ? 128 + state.signal : 0;
+}
+
+std::vector<std::string> SignalService::timed_out() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  std::vector<std::string> names;
+  if (state_->requested && Clock::now() >= state_->deadline) {
+    for (const auto& item : state_->running) names.push_back(item.second);
+  }
+  return names;
+}
+
+void SignalService::StartShutdown(int signal) {
+  std::map<int, std::pair<std::string, DrainFunc>> subsystems;
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    if (state_->requested) return;
+    state_->signal = signal;
+    state_->deadline = Clock::now() + options_.drain_timeout;
+    subsystems.swap(state_->subsystems);
+    for (const auto& item : subsystems) {
+      state_->running.emplace(item.first, item.second.first);
+    }
+    state_->requested.store(true, std::memory_order_release);
+  }
+  state_->cv.notify_all();
+  // Drain threads inherit the mask, so the signals must be blocked even if
+  // shutdown was requested from a thread created before the service.
+  sigset_t mask;
+  pthread_sigmask(SIG_BLOCK, &signals_, &mask);
+  // Detached, so a drain that misses the deadline cannot block shutdown;
+  // it only holds on to the shared state.
+  for (auto& item : subsystems) {
+    std::thread([state = state_, id = item.first,
+                 name = std::move(item.second.first),
+                 drain = std::move(item.second.second)]() {
+      try {
+        drain(ShutdownToken(state));
+      } catch (const std::exception& e) {
+        std::cerr << "SignalService: drain '" << name
+                  << "' threw: " << e.what() << "\n";
+      }
+      {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->running.erase(id);
+      }
+      state->cv.notify_all();
+    }).detach();
+  }
+  pthread_sigmask(SIG_SETMASK, &mask, nullptr);
+}
+
+void SignalService::Loop() {
+  pollfd fds[2] = {{signal_fd_, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+  while (true) {
+    if (poll(fds, 2, -1) < 0) {
+      if (errno == EINTR) continue;
+      std::cerr << "SignalService: poll failed\n";
+      return;
+    }
+    if (fds[1].revents & POLLIN) return;
+    if (!(fds[0].revents & POLLIN)) continue;
+    signalfd_siginfo info;
+    if (read(signal_fd_, &info, sizeof(info)) != sizeof(info)) continue;
+    const int signal = static_cast<int>(info.ssi_signo);
+    const auto handler = options_.handlers.find(signal);
+    if (handler != options_.handlers.end()) {
+      handler->second(signal);
+      continue;
+    }
+    if (!state_->requested) {
+      StartShutdown(signal);
+    } else if (options_.force_exit_on_second_signal) {
+      // Still draining (or the owner is slow to exit): give up on it.
+      static const char kMessage[] =
+          "SignalService: second shutdown signal, exiting now\n";
+      if (write(STDERR_FILENO, kMessage, sizeof(kMessage) - 1) < 0) {}
+      _exit(128 + signal);
+    }
+  }
+}
+
+}  // namespace signal_service
@@ -0,0 +1,137 @@
+#pragma once
+
+// Process-wide signal handling on a dedicated thread, with an orderly
+// shutdown fanned out to registered subsystems (the reusable version of the
+// `SigintThread` prototype in `pthread_sigmask.c`, which `exit()`s from the
+// signal thread and so skips cleanup).
+//
+//   int main() {
+//     signal_service::SignalService signals;  // Before any other thread.
+//     Worker worker(signals.token());
+//     signals.Register("worker", [&](const signal_service::ShutdownToken& t) {
+//       worker.Drain(t.deadline());  // Flush buffered results.
+//     });
+//     ...
+//     return signals.WaitForShutdown();  // 130 after SIGINT.
+//   }
+//
+// The constructor blocks the signals in the calling thread, which every
+// thread created afterwards inherits, so they are only ever consumed from a
+// `signalfd` by the service thread, never delivered asynchronously: handlers
+// are ordinary code, not async-signal-safe code.
+//
+// On the first shutdown signal (or `RequestShutdown()`), the token is set,
+// which subsystems may poll or wait on to stop taking new work, and every
+// registered drain function runs on its own thread, all sharing one
+// deadline. `WaitForShutdown()` returns once they have all finished or the
+// deadline has passed; the names of drains still running are in
+// `timed_out()`. A second shutdown signal while draining `_exit`s at once
+// (unless disabled), so a stuck drain can always be interrupted.
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <signal.h>
+
+namespace signal_service {
+
+using Clock = std::chrono::steady_clock;
+
+namespace internal {
+struct ShutdownState;
+}  // namespace internal
+
+// Cheap to copy; observes the service's shutdown.
+class ShutdownToken {
+ public:
+  bool stop_requested() const;
+
+  // The signal that requested shutdown, or 0 for `RequestShutdown()` (or if
+  // not requested yet).
+  int signal() const;
+
+  // Time by which drains should be done; only meaningful once requested.
+  Clock::time_point deadline() const;
+
+  // Blocks until shutdown is requested.
+  void Wait() const;
+
+  // Like `Wait()`, up to `timeout`; returns `stop_requested()`.
+  bool WaitFor(Clock::duration timeout) const;
+
+ private:
+  friend class SignalService;
+  explicit ShutdownToken(std::shared_ptr<internal::ShutdownState> state)
+      : state_(std::move(state)) {}
+
+  std::shared_ptr<internal::ShutdownState> state_;
+};
+
+class SignalService {
+ public:
+  using DrainFunc = std::function<void(const ShutdownToken&)>;
+  using HandlerFunc = std::function<void(int signal)>;
+
+  struct Options {
+    // Signals that request shutdown.
+    std::vector<int> shutdown_signals{SIGINT, SIGTERM};
+    // Other signals to handle on the service thread (e.g. SIGHUP to reload).
+    std::map<int, HandlerFunc> handlers;
+    // Time from the shutdown request to the drain deadline.
+    Clock::duration drain_timeout{std::chrono::seconds(5)};
+    // `_exit(128 + signal)` on a second shutdown signal.
+    bool force_exit_on_second_signal{true};
+  };
+
+  SignalService() : SignalService(Options{}) {}
+  // Throws `std::system_error` if the signals cannot be blocked or the
+  // `signalfd` cannot be created.
+  explicit SignalService(Options options);
+
+  // Requests shutdown (if not yet), waits for it, stops the thread, and
+  // restores the calling thread's signal mask.
+  ~SignalService();
+
+  SignalService(const SignalService&) = delete;
+  SignalService& operator=(const SignalService&) = delete;
+
+  ShutdownToken token() const { return ShutdownToken(state_); }
+
+  // Registers a subsystem to drain on shutdown; returns an id for
+  // `Unregister`. If shutdown has already started, `drain` is not called.
+  int Register(std::string name, DrainFunc drain);
+
+  // After this returns, `id`'s drain will not be started.
+  void Unregister(int id);
+
+  // Starts shutdown as a signal would, with `signal()` 0.
+  void RequestShutdown();
+
+  // Blocks until shutdown is requested and all drains have finished, or
+  // their deadline has passed. Returns a process exit code: 128 + the
+  // signal, or 0 for `RequestShutdown()`.
+  int WaitForShutdown();
+
+  // Drains that were still running at the deadline.
+  std::vector<std::string> timed_out() const;
+
+ private:
+  void Loop();
+  void StartShutdown(int signal);
+
+  Options options_;
+  sigset_t signals_;
+  sigset_t old_mask_;
+  int signal_fd_{-1};
+  int wake_fd_{-1};
+  // Shared with tokens and drain threads, which may outlive the service.
+  std::shared_ptr<internal::ShutdownState> state_;
+  std::thread thread_;
+};
+
+}  // namespace signal_service
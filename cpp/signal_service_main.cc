@@ -0,0 +1,77 @@
+// A worker that buffers results and flushes them in batches, shut down
+// cleanly on Ctrl-C by `SignalService`: buffered results are flushed instead
+// of dropped (compare `pthread_sigmask.c`, which `exit()`s from the signal
+// thread). A second Ctrl-C exits immediately.
+
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "signal_service.h"
+
+using signal_service::Clock;
+using signal_service::ShutdownToken;
+using signal_service::SignalService;
+
+class Worker {
+ public:
+  explicit Worker(ShutdownToken token)
+      : token_(token), thread_([this]() { Run(); }) {}
+
+  ~Worker() { thread_.join(); }
+
+  // Stops producing, and flushes what is buffered by `deadline`.
+  void Drain(Clock::time_point deadline) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::cout << "Draining " << buffer_.size() << " buffered results\n";
+    for (int result : buffer_) {
+      if (Clock::now() > deadline) {
+        std::cout << "Deadline passed; dropping the rest\n";
+        break;
+      }
+      Flush(result);
+    }
+    buffer_.clear();
+  }
+
+ private:
+  void Run() {
+    using namespace std::chrono_literals;
+    int next = 0;
+    // Stops taking new work as soon as shutdown is requested.
+    while (!token_.WaitFor(50ms)) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      buffer_.push_back(next++);
+      if (buffer_.size() == 20) {
+        for (int result : buffer_) Flush(result);
+        buffer_.clear();
+      }
+    }
+  }
+
+  void Flush(int result) { flushed_ = result; }
+
+  ShutdownToken token_;
+  std::mutex mutex_;
+  std::vector<int> buffer_;
+  int flushed_{-1};
+  std::thread thread_;
+};
+
+int main() {
+  // First, so every thread below inherits the blocked signals.
+  SignalService signals;
+  Worker worker(signals.token());
+  signals.Register("worker", [&worker](const ShutdownToken& token) {
+    worker.Drain(token.deadline());
+  });
+  std::cout << "Working; Ctrl-C to stop\n";
+  const int code = signals.WaitForShutdown();
+  for (const std::string& name : signals.timed_out()) {
+    std::cout << "Timed out: " << name << "\n";
+  }
+  std::cout << "Exiting with " << code << "\n";
+  return code;
+}
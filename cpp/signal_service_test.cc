@@ -0,0 +1,120 @@
+#include "signal_service.h"
+
+#include <signal.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+namespace signal_service {
+namespace {
+
+using namespace std::chrono_literals;
+
+TEST(SignalServiceTest, SignalDrainsSubsystems) {
+  SignalService service;
+  const ShutdownToken token = service.token();
+  std::atomic<int> drained{0};
+  std::atomic<bool> saw_stop{false};
+  for (int i = 0; i < 3; ++i) {
+    service.Register("drain", [&](const ShutdownToken& t) {
+      saw_stop = t.stop_requested();
+      std::this_thread::sleep_for(10ms);
+      ++drained;
+    });
+  }
+  const int unregistered = service.Register("gone", [&](const ShutdownToken&) {
+    drained += 100;
+  });
+  service.Unregister(unregistered);
+  EXPECT_FALSE(token.stop_requested());
+  EXPECT_FALSE(token.WaitFor(1ms));
+
+  ASSERT_EQ(kill(getpid(), SIGINT), 0);
+  EXPECT_EQ(service.WaitForShutdown(), 128 + SIGINT);
+  EXPECT_TRUE(token.stop_requested());
+  EXPECT_EQ(token.signal(), SIGINT);
+  EXPECT_EQ(drained, 3);
+  EXPECT_TRUE(saw_stop);
+  EXPECT_TRUE(service.timed_out().empty());
+  // Too late to register.
+  service.Register("late", [&](const ShutdownToken&) { drained += 10; });
+}
+
+TEST(SignalServiceTest, DeadlineBoundsSlowDrains) {
+  SignalService::Options options;
+  options.drain_timeout = 50ms;
+  SignalService service(options);
+  // Shared, since the stuck drain outlives the service.
+  auto release = std::make_shared<std::atomic<bool>>(false);
+  auto finished = std::make_shared<std::atomic<bool>>(false);
+  service.Register("fast", [](const ShutdownToken&) {});
+  service.Register("stuck", [release, finished](const ShutdownToken& t) {
+    while (!*release && Clock::now() < t.deadline() + 5s) {
+      std::this_thread::sleep_for(1ms);
+    }
+    *finished = true;
+  });
+  const Clock::time_point start = Clock::now();
+  service.RequestShutdown();
+  EXPECT_EQ(service.WaitForShutdown(), 0);
+  EXPECT_LT(Clock::now() - start, 2s);
+  EXPECT_EQ(service.timed_out(), std::vector<std::string>{"stuck"});
+  *release = true;
+  // Do not leave its thread running into later tests.
+  while (!*finished) std::this_thread::sleep_for(1ms);
+}
+
+TEST(SignalServiceTest, HandlersDoNotShutDown) {
+  std::atomic<int> hups{0};
+  SignalService::Options options;
+  options.handlers[SIGHUP] = [&](int signal) {
+    EXPECT_EQ(signal, SIGHUP);
+    ++hups;
+  };
+  SignalService service(options);
+  ASSERT_EQ(kill(getpid(), SIGHUP), 0);
+  for (int i = 0; i < 1000 && hups == 0; ++i) {
+    std::this_thread::sleep_for(1ms);
+  }
+  EXPECT_EQ(hups, 1);
+  EXPECT_FALSE(service.token().stop_requested());
+}
+
+TEST(SignalServiceTest, DestructorShutsDownAndRestoresMask) {
+  bool drained = false;
+  {
+    SignalService service;
+    service.Register("drain", [&](const ShutdownToken&) { drained = true; });
+    sigset_t mask;
+    pthread_sigmask(SIG_BLOCK, nullptr, &mask);
+    EXPECT_TRUE(sigismember(&mask, SIGTERM));
+  }
+  EXPECT_TRUE(drained);
+  sigset_t mask;
+  pthread_sigmask(SIG_BLOCK, nullptr, &mask);
+  EXPECT_FALSE(sigismember(&mask, SIGTERM));
+}
+
+TEST(SignalServiceDeathTest, SecondSignalExits) {
+  ::testing::FLAGS_gtest_death_test_style = "threadsafe";
+  EXPECT_EXIT(
+      {
+        SignalService service;
+        service.Register("stuck", [](const ShutdownToken&) {
+          std::this_thread::sleep_for(10s);
+        });
+        kill(getpid(), SIGTERM);
+        service.token().Wait();
+        kill(getpid(), SIGTERM);
+        std::this_thread::sleep_for(10s);
+      },
+      ::testing::ExitedWithCode(128 + SIGTERM), "second shutdown signal");
+}
+
+}  // namespace
+}  // namespace signal_service
@@ -0,0 +1,198 @@
+// cyclictest-style jitter measurement for `anzu_periodic`, optionally under
+// synthetic load, to see whether a scheduling setup actually helps.
+//
+//   anzu_cyclictest [-t threads] [-i interval_us] [-w work_us]
+//       [-p priority] [-r] [-a cpus] [-l load_threads] [-L load_cpus]
+//       [-D seconds] [-m] [-H]
+//
+// -p > 0 uses SCHED_FIFO (or SCHED_RR with -r), which needs CAP_SYS_NICE or
+// an rtprio limit. -a pins measurement thread i to the i-th CPU of the list
+// (round robin). Load threads stream over 64 MiB each, at SCHED_OTHER.
+// -m locks memory; -H prints the non-empty histogram buckets.
+#define _GNU_SOURCE
+#include <getopt.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "anzu_periodic.h"
+
+#define LOAD_BYTES (64 << 20)
+
+static void check(bool value) {
+  if (!value) {
+    fprintf(stderr, "abort!\n");
+    exit(1);
+  }
+}
+
+static volatile bool load_stop = false;
+
+static void* run_load(void* raw) {
+  const anzu_cpu_mask_t* cpus = raw;
+  if (cpus != NULL) anzu_cpu_mask_set_thread(cpus);
+  unsigned char* buffer = malloc(LOAD_BYTES);
+  check(buffer != NULL);
+  unsigned char value = 0;
+  while (!load_stop) {
+    for (size_t i = 0; i < LOAD_BYTES; i += 64) {
+      buffer[i] += value++;
+    }
+  }
+  free(buffer);
+  return NULL;
+}
+
+static void busy_wait_ns(int64_t ns) {
+  struct timespec start, now;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  do {
+    clock_gettime(CLOCK_MONOTONIC, &now);
+  } while ((now.tv_sec - start.tv_sec) * 1000000000LL +
+           (now.tv_nsec - start.tv_nsec) < ns);
+}
+
+static bool step(void* raw) {
+  const int64_t* work_ns = raw;
+  if (*work_ns > 0) busy_wait_ns(*work_ns);
+  return true;
+}
+
+static void print_histogram(const char* name, const anzu_latency_hist_t* hist) {
+  for (int i = 0; i < ANZU_HIST_BUCKETS; ++i) {
+    if (hist->buckets[i] > 0) {
+      printf("%s %6d %9llu\n", name, i,
+             (unsigned long long)hist->buckets[i]);
+    }
+  }
+  if (hist->overflow > 0) {
+    printf("%s >%5d %9llu\n", name, ANZU_HIST_BUCKETS - 1,
+           (unsigned long long)hist->overflow);
+  }
+}
+
+static void usage(const char* argv0) {
+  fprintf(stderr,
+          "usage: %s [-t threads] [-i interval_us] [-w work_us]"
+          " [-p priority] [-r] [-a cpus] [-l load_threads] [-L load_cpus]"
+          " [-D seconds] [-m] [-H]\n",
+          argv0);
+  exit(1);
+}
+
+int main(int argc, char** argv) {
+  int num_threads = 1;
+  int64_t interval_us = 1000;
+  int64_t work_ns = 0;
+  int priority = 0;
+  bool round_robin = false;
+  anzu_cpu_mask_t* cpus = NULL;
+  int num_load = 0;
+  anzu_cpu_mask_t* load_cpus = NULL;
+  double seconds = 10;
+  bool lock = false;
+  bool histogram = false;
+  int opt;
+  while ((opt = getopt(argc, argv, "t:i:w:p:ra:l:L:D:mH")) != -1) {
+    switch (opt) {
+      case 't': num_threads = atoi(optarg); break;
+      case 'i': interval_us = atoll(optarg); break;
+      case 'w': work_ns = atoll(optarg) * 1000; break;
+      case 'p': priority = atoi(optarg); break;
+      case 'r': round_robin = true; break;
+      case 'a':
+        cpus = anzu_cpu_mask_new();
+        check(cpus != NULL);
+        if (anzu_cpu_mask_parse(cpus, optarg) != 0) usage(argv[0]);
+        break;
+      case 'l': num_load = atoi(optarg); break;
+      case 'L':
+        load_cpus = anzu_cpu_mask_new();
+        check(load_cpus != NULL);
+        if (anzu_cpu_mask_parse(load_cpus, optarg) != 0) usage(argv[0]);
+        break;
+      case 'D': seconds = atof(optarg); break;
+      case 'm': lock = true; break;
+      case 'H': histogram = true; break;
+      default: usage(argv[0]);
+    }
+  }
+  if (num_threads < 1 || interval_us < 1 || num_load < 0) usage(argv[0]);
+
+  if (lock) {
+    const int error = anzu_lock_memory();
+    if (error != 0) {
+      fprintf(stderr, "mlockall: %s\n", strerror(-error));
+    }
+  }
+
+  pthread_t* load_threads = calloc(num_load, sizeof(pthread_t));
+  check(num_load == 0 || load_threads != NULL);
+  for (int i = 0; i < num_load; ++i) {
+    check(pthread_create(&load_threads[i], NULL, run_load, load_cpus) == 0);
+  }
+
+  anzu_periodic_task_t** tasks = calloc(num_threads, sizeof(void*));
+  anzu_cpu_mask_t** affinities = calloc(num_threads, sizeof(void*));
+  check(tasks != NULL && affinities != NULL);
+  int cpu = -1;
+  for (int i = 0; i < num_threads; ++i) {
+    anzu_periodic_config_t config = anzu_periodic_config_default();
+    config.period_ns = interval_us * 1000;
+    if (priority > 0) {
+      config.sched_policy = round_robin ? SCHED_RR : SCHED_FIFO;
+      config.sched_priority = priority;
+    }
+    if (cpus != NULL) {
+      // Next CPU of the list, wrapping around.
+      do {
+        cpu = (cpu + 1) % anzu_cpu_mask_capacity(cpus);
+      } while (!anzu_cpu_mask_isset(cpus, cpu));
+      affinities[i] = anzu_cpu_mask_new();
+      check(affinities[i] != NULL);
+      anzu_cpu_mask_set(affinities[i], cpu);
+      config.affinity = affinities[i];
+    }
+    tasks[i] = anzu_periodic_start(&config, step, &work_ns);
+    check(tasks[i] != NULL);
+  }
+
+  printf("%d thread(s), interval %lld us, work %lld us, %s priority %d, "
+         "%d load thread(s), %.1f s%s\n",
+         num_threads, (long long)interval_us, (long long)(work_ns / 1000),
+         priority > 0 ? (round_robin ? "SCHED_RR" : "SCHED_FIFO") :
+             "SCHED_OTHER",
+         priority, num_load, seconds, lock ? ", memory locked" : "");
+  const struct timespec duration = {
+      (time_t)seconds, (long)((seconds - (time_t)seconds) * 1e9)};
+  nanosleep(&duration, NULL);
+
+  for (int i = 0; i < num_threads; ++i) {
+    anzu_periodic_stop(tasks[i]);
+  }
+  for (int i = 0; i < num_threads; ++i) {
+    anzu_periodic_stats_t stats;
+    anzu_periodic_join(tasks[i], &stats);
+    char name[32];
+    snprintf(name, sizeof(name), "%3d", i);
+    anzu_periodic_stats_fprint(stdout, name, &stats);
+    if (histogram) print_histogram(name, &stats.wakeup);
+    anzu_cpu_mask_free(affinities[i]);
+  }
+
+  load_stop = true;
+  for (int i = 0; i < num_load; ++i) {
+    pthread_join(load_threads[i], NULL);
+  }
+  free(load_threads);
+  free(tasks);
+  free(affinities);
+  anzu_cpu_mask_free(cpus);
+  anzu_cpu_mask_free(load_cpus);
+  return 0;
+}
@@ -0,0 +1,328 @@
+#define _GNU_SOURCE
+#include <alloca.h>
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "anzu_periodic.h"
+#include "anzu_sched_param.h"
+
+#define NS_PER_SEC 1000000000LL
+
+struct anzu_cpu_mask {
+  int capacity;
+  size_t size;
+  cpu_set_t* set;
+};
+
+anzu_cpu_mask_t* anzu_cpu_mask_new(void) {
+  anzu_cpu_mask_t* mask = malloc(sizeof(anzu_cpu_mask_t));
+  if (mask == NULL) return NULL;
+  const long num_cpus = sysconf(_SC_NPROCESSORS_CONF);
+  mask->capacity = num_cpus > CPU_SETSIZE ? (int)num_cpus : CPU_SETSIZE;
+  mask->size = CPU_ALLOC_SIZE(mask->capacity);
+  mask->set = CPU_ALLOC(mask->capacity);
+  if (mask->set == NULL) {
+    free(mask);
+    return NULL;
+  }
+  CPU_ZERO_S(mask->size, mask->set);
+  return mask;
+}
+
+void anzu_cpu_mask_free(anzu_cpu_mask_t* mask) {
+  if (mask == NULL) return;
+  CPU_FREE(mask->set);
+  free(mask);
+}
+
+int anzu_cpu_mask_capacity(const anzu_cpu_mask_t* mask) {
+  return mask->capacity;
+}
+
+int anzu_cpu_mask_set(anzu_cpu_mask_t* mask, int cpu) {
+  if (cpu < 0 || cpu >= mask->capacity) return -EINVAL;
+  CPU_SET_S(cpu, mask->size, mask->set);
+  return 0;
+}
+
+bool anzu_cpu_mask_isset(const anzu_cpu_mask_t* mask, int cpu) {
+  return cpu >= 0 && cpu < mask->capacity &&
+      CPU_ISSET_S(cpu, mask->size, mask->set);
+}
+
+int anzu_cpu_mask_count(const anzu_cpu_mask_t* mask) {
+  return CPU_COUNT_S(mask->size, mask->set);
+}
+
+static int parse_cpu(const char** text, int* cpu) {
+  char* end;
+  errno = 0;
+  const long value = strtol(*text, &end, 10);
+  if (end == *text || errno != 0 || value < 0 || value > INT_MAX) {
+    return -EINVAL;
+  }
+  *cpu = (int)value;
+  *text = end;
+  return 0;
+}
+
+int anzu_cpu_mask_parse(anzu_cpu_mask_t* mask, const char* list) {
+  const char* text = list;
+  while (true) {
+    int first, last;
+    if (parse_cpu(&text, &first) != 0) return -EINVAL;
+    last = first;
+    if (*text == '-') {
+      ++text;
+      if (parse_cpu(&text, &last) != 0 || last < first) return -EINVAL;
+    }
+    if (last >= mask->capacity) return -EINVAL;
+    for (int cpu = first; cpu <= last; ++cpu) {
+      CPU_SET_S(cpu, mask->size, mask->set);
+    }
+    if (*text == '\0') return 0;
+    if (*text++ != ',') return -EINVAL;
+  }
+}
+
+int anzu_cpu_mask_snprintf(
+    char* buffer, size_t size, const anzu_cpu_mask_t* mask) {
+  size_t offset = 0;
+  if (size > 0) buffer[0] = '\0';
+  const char* separator = "";
+  for (int cpu = 0; cpu < mask->capacity; ++cpu) {
+    if (!anzu_cpu_mask_isset(mask, cpu)) continue;
+    int last = cpu;
+    while (anzu_cpu_mask_isset(mask, last + 1)) ++last;
+    if (last == cpu) {
+      anzu_snprintf_append(buffer, size, &offset, "%s%d", separator, cpu);
+    } else {
+      anzu_snprintf_append(buffer, size, &offset,
+                           "%s%d-%d", separator, cpu, last);
+    }
+    separator = ",";
+    cpu = last;
+  }
+  return (int)offset;
+}
+
+int anzu_cpu_mask_get_thread(anzu_cpu_mask_t* mask) {
+  CPU_ZERO_S(mask->size, mask->set);
+  return sched_getaffinity(0, mask->size, mask->set) == 0 ? 0 : -errno;
+}
+
+int anzu_cpu_mask_set_thread(const anzu_cpu_mask_t* mask) {
+  return sched_setaffinity(0, mask->size, mask->set) == 0 ? 0 : -errno;
+}
+
+int anzu_lock_memory(void) {
+  return mlockall(MCL_CURRENT | MCL_FUTURE) == 0 ? 0 : -errno;
+}
+
+void anzu_prefault_stack(size_t bytes) {
+  volatile unsigned char* stack = alloca(bytes);
+  const long page = sysconf(_SC_PAGESIZE);
+  for (size_t i = 0; i < bytes; i += page) {
+    stack[i] = 0;
+  }
+}
+
+void anzu_latency_hist_reset(anzu_latency_hist_t* hist) {
+  memset(hist, 0, sizeof(*hist));
+  hist->min_ns = INT64_MAX;
+  hist->max_ns = INT64_MIN;
+}
+
+void anzu_latency_hist_add(anzu_latency_hist_t* hist, int64_t ns) {
+  const int64_t us = ns / 1000;
+  if (us >= 0 && us < ANZU_HIST_BUCKETS) {
+    hist->buckets[us] += 1;
+  } else if (us >= ANZU_HIST_BUCKETS) {
+    hist->overflow += 1;
+  } else {
+    // Early (e.g. clock adjustments); counted as 0.
+    hist->buckets[0] += 1;
+  }
+  hist->count += 1;
+  hist->sum_ns += ns;
+  if (ns < hist->min_ns) hist->min_ns = ns;
+  if (ns > hist->max_ns) hist->max_ns = ns;
+}
+
+int anzu_latency_hist_quantile_us(const anzu_latency_hist_t* hist, double q) {
+  if (hist->count == 0) return 0;
+  // Smallest bucket with at least ceil(q * count) samples at or below it.
+  uint64_t rank = (uint64_t)ceil(q * hist->count);
+  if (rank < 1) rank = 1;
+  uint64_t seen = 0;
+  for (int i = 0; i < ANZU_HIST_BUCKETS; ++i) {
+    seen += hist->buckets[i];
+    if (seen >= rank) return i + 1;
+  }
+  return ANZU_HIST_BUCKETS;
+}
+
+anzu_periodic_config_t anzu_periodic_config_default(void) {
+  anzu_periodic_config_t config;
+  memset(&config, 0, sizeof(config));
+  config.period_ns = 1000000;
+  config.sched_policy = SCHED_OTHER;
+  config.stack_prefault_bytes = 64 * 1024;
+  return config;
+}
+
+static int64_t timespec_to_ns(const struct timespec* t) {
+  return t->tv_sec * NS_PER_SEC + t->tv_nsec;
+}
+
+static struct timespec ns_to_timespec(int64_t ns) {
+  struct timespec t;
+  t.tv_sec = ns / NS_PER_SEC;
+  t.tv_nsec = ns % NS_PER_SEC;
+  return t;
+}
+
+static int64_t now_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return timespec_to_ns(&now);
+}
+
+void anzu_periodic_run(
+    const anzu_periodic_config_t* config, anzu_periodic_func_t func,
+    void* user_data, const volatile bool* stop,
+    anzu_periodic_stats_t* stats) {
+  memset(stats, 0, sizeof(*stats));
+  anzu_latency_hist_reset(&stats->wakeup);
+  anzu_latency_hist_reset(&stats->overrun);
+  stats->tid = anzu_gettid();
+
+  struct sched_param sch_param;
+  memset(&sch_param, 0, sizeof(sch_param));
+  sch_param.sched_priority = config->sched_priority;
+  stats->sched_error = -pthread_setschedparam(
+      pthread_self(), config->sched_policy, &sch_param);
+  if (config->affinity != NULL) {
+    stats->affinity_error = anzu_cpu_mask_set_thread(config->affinity);
+  }
+  if (config->stack_prefault_bytes > 0) {
+    anzu_prefault_stack(config->stack_prefault_bytes);
+  }
+
+  const int64_t period = config->period_ns;
+  int64_t wakeup = now_ns() + period;
+  while (stop == NULL || !*stop) {
+    const struct timespec deadline = ns_to_timespec(wakeup);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) ==
+           EINTR) {}
+    anzu_latency_hist_add(&stats->wakeup, now_ns() - wakeup);
+    stats->cycles += 1;
+    const bool keep_going = func(user_data);
+    const int64_t done = now_ns();
+    wakeup += period;
+    if (done > wakeup) {
+      // Overran: skip the wake-ups already past instead of running late
+      // cycles back to back.
+      anzu_latency_hist_add(&stats->overrun, done - wakeup);
+      const int64_t missed = (done - wakeup) / period + 1;
+      stats->missed_periods += missed;
+      wakeup += missed * period;
+    }
+    if (!keep_going) break;
+    if (config->max_cycles > 0 &&
+        stats->cycles >= (uint64_t)config->max_cycles) {
+      break;
+    }
+  }
+}
+
+struct anzu_periodic_task {
+  pthread_t thread;
+  anzu_periodic_config_t config;
+  anzu_cpu_mask_t* affinity;
+  anzu_periodic_func_t func;
+  void* user_data;
+  volatile bool stop;
+  anzu_periodic_stats_t stats;
+};
+
+static void* run_task(void* raw) {
+  anzu_periodic_task_t* task = raw;
+  anzu_periodic_run(
+      &task->config, task->func, task->user_data, &task->stop, &task->stats);
+  return NULL;
+}
+
+anzu_periodic_task_t* anzu_periodic_start(
+    const anzu_periodic_config_t* config, anzu_periodic_func_t func,
+    void* user_data) {
+  anzu_periodic_task_t* task = calloc(1, sizeof(anzu_periodic_task_t));
+  if (task == NULL) return NULL;
+  task->config = *config;
+  if (config->affinity != NULL) {
+    task->affinity = anzu_cpu_mask_new();
+    if (task->affinity == NULL) {
+      free(task);
+      return NULL;
+    }
+    CPU_OR_S(task->affinity->size, task->affinity->set, task->affinity->set,
+             config->affinity->set);
+    task->config.affinity = task->affinity;
+  }
+  task->func = func;
+  task->user_data = user_data;
+  const int error = pthread_create(&task->thread, NULL, run_task, task);
+  if (error != 0) {
+    anzu_cpu_mask_free(task->affinity);
+    free(task);
+    errno = error;
+    return NULL;
+  }
+  return task;
+}
+
+void anzu_periodic_stop(anzu_periodic_task_t* task) {
+  __atomic_store_n(&task->stop, true, __ATOMIC_RELAXED);
+}
+
+void anzu_periodic_join(
+    anzu_periodic_task_t* task, anzu_periodic_stats_t* stats) {
+  pthread_join(task->thread, NULL);
+  if (stats != NULL) *stats = task->stats;
+  anzu_cpu_mask_free(task->affinity);
+  free(task);
+}
+
+void anzu_periodic_stats_fprint(
+    FILE* file, const char* name, const anzu_periodic_stats_t* stats) {
+  const anzu_latency_hist_t* wakeup = &stats->wakeup;
+  const double avg_us =
+      wakeup->count > 0 ? wakeup->sum_ns / wakeup->count / 1000 : 0;
+  fprintf(file,
+          "%s: T:%6d C:%9llu Min:%7lld Avg:%7.0f P99:%6d Max:%7lld us"
+          "  Overruns:%6llu (max %lld us) Missed:%6llu\n",
+          name, stats->tid, (unsigned long long)stats->cycles,
+          wakeup->count > 0 ? (long long)(wakeup->min_ns / 1000) : 0LL,
+          avg_us, anzu_latency_hist_quantile_us(wakeup, 0.99),
+          wakeup->count > 0 ? (long long)(wakeup->max_ns / 1000) : 0LL,
+          (unsigned long long)stats->overrun.count,
+          stats->overrun.count > 0 ?
+              (long long)(stats->overrun.max_ns / 1000) : 0LL,
+          (unsigned long long)stats->missed_periods);
+  if (stats->sched_error != 0) {
+    fprintf(file, "%s:   could not set scheduling policy: %s\n", name,
+            strerror(-stats->sched_error));
+  }
+  if (stats->affinity_error != 0) {
+    fprintf(file, "%s:   could not set CPU affinity: %s\n", name,
+            strerror(-stats->affinity_error));
+  }
+}
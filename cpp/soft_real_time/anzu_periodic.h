@@ -0,0 +1,160 @@
+// Periodic (soft) real-time tasks: each runs on its own thread with a given
+// scheduling policy / priority and CPU affinity, wakes on an absolute
+// `clock_nanosleep` schedule, and records how late it woke up and how far its
+// work overran the period, so missed deadlines can be diagnosed.
+//
+//   anzu_lock_memory();
+//   anzu_periodic_config_t config = anzu_periodic_config_default();
+//   config.period_ns = 1000000;  // 1 kHz.
+//   config.sched_policy = SCHED_FIFO;
+//   config.sched_priority = 80;
+//   anzu_periodic_task_t* task = anzu_periodic_start(&config, step, data);
+//   ...
+//   anzu_periodic_stop(task);
+//   anzu_periodic_stats_t stats;
+//   anzu_periodic_join(task, &stats);
+//   anzu_periodic_stats_fprint(stdout, "control", &stats);
+//
+// Functions returning `int` return 0 on success and -errno on failure.
+#ifndef _ANZU_PERIODIC_H
+  #define _ANZU_PERIODIC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// CPU mask sized for every CPU the machine can have (and at least
+// CPU_SETSIZE), backed by `CPU_ALLOC`.
+typedef struct anzu_cpu_mask anzu_cpu_mask_t;
+
+// Returns an empty mask.
+anzu_cpu_mask_t* anzu_cpu_mask_new(void);
+
+void anzu_cpu_mask_free(anzu_cpu_mask_t* mask);
+
+// Number of CPUs the mask can hold.
+int anzu_cpu_mask_capacity(const anzu_cpu_mask_t* mask);
+
+// -EINVAL if `cpu` is out of range.
+int anzu_cpu_mask_set(anzu_cpu_mask_t* mask, int cpu);
+
+bool anzu_cpu_mask_isset(const anzu_cpu_mask_t* mask, int cpu);
+
+int anzu_cpu_mask_count(const anzu_cpu_mask_t* mask);
+
+// Sets the CPUs in a `taskset -c` style list, e.g. "0-3,6" (added to those
+// already set). -EINVAL if malformed or out of range.
+int anzu_cpu_mask_parse(anzu_cpu_mask_t* mask, const char* list);
+
+// Inverse of `anzu_cpu_mask_parse`; `snprintf` semantics.
+int anzu_cpu_mask_snprintf(
+    char* buffer, size_t size, const anzu_cpu_mask_t* mask);
+
+// Gets / sets the affinity of the calling thread.
+int anzu_cpu_mask_get_thread(anzu_cpu_mask_t* mask);
+int anzu_cpu_mask_set_thread(const anzu_cpu_mask_t* mask);
+
+// `mlockall(MCL_CURRENT | MCL_FUTURE)`, so the process never page faults on
+// memory it already has, or takes later (needs CAP_IPC_LOCK or a large
+// enough RLIMIT_MEMLOCK).
+int anzu_lock_memory(void);
+
+// Touches `bytes` of the calling thread's stack, so (with locked memory) the
+// thread does not page fault on it later.
+void anzu_prefault_stack(size_t bytes);
+
+// Latency histogram with 1 us buckets (like cyclictest's).
+#define ANZU_HIST_BUCKETS 1000
+
+typedef struct anzu_latency_hist {
+  // buckets[i] counts latencies in [i, i + 1) us; longer ones are only in
+  // `overflow`.
+  uint64_t buckets[ANZU_HIST_BUCKETS];
+  uint64_t overflow;
+  uint64_t count;
+  int64_t min_ns;
+  int64_t max_ns;
+  double sum_ns;
+} anzu_latency_hist_t;
+
+void anzu_latency_hist_reset(anzu_latency_hist_t* hist);
+
+void anzu_latency_hist_add(anzu_latency_hist_t* hist, int64_t ns);
+
+// Upper bound (in us) of the bucket holding quantile `q` in [0, 1];
+// ANZU_HIST_BUCKETS if it falls in the overflow, 0 if empty.
+int anzu_latency_hist_quantile_us(const anzu_latency_hist_t* hist, double q);
+
+typedef struct anzu_periodic_config {
+  int64_t period_ns;
+  // SCHED_OTHER, SCHED_FIFO, or SCHED_RR, with `sched_priority` for the
+  // latter two.
+  int sched_policy;
+  int sched_priority;
+  // CPUs to run on; NULL to inherit. Copied by `anzu_periodic_start`.
+  const anzu_cpu_mask_t* affinity;
+  // Stack to prefault before the first cycle.
+  size_t stack_prefault_bytes;
+  // Stop after this many cycles; 0 to run until `anzu_periodic_stop`.
+  int64_t max_cycles;
+} anzu_periodic_config_t;
+
+// 1 ms period, SCHED_OTHER, inherited affinity, 64 KiB prefault, no limit.
+anzu_periodic_config_t anzu_periodic_config_default(void);
+
+typedef struct anzu_periodic_stats {
+  // Actual minus scheduled wake-up time, every cycle.
+  anzu_latency_hist_t wakeup;
+  // For cycles whose work ended after the next wake-up time: by how much.
+  anzu_latency_hist_t overrun;
+  uint64_t cycles;
+  // Wake-ups skipped because of overruns (the schedule is never made up).
+  uint64_t missed_periods;
+  // -errno from applying the scheduling policy / affinity, or 0. The task
+  // still runs (with what it inherited) if these fail.
+  int sched_error;
+  int affinity_error;
+  int tid;
+} anzu_periodic_stats_t;
+
+// Called once per period; returns false to stop.
+typedef bool (*anzu_periodic_func_t)(void* user_data);
+
+// Runs the loop on the calling thread (applying `config` to it) until `func`
+// returns false, `max_cycles` is reached, or `*stop` (if given) becomes true.
+void anzu_periodic_run(
+    const anzu_periodic_config_t* config, anzu_periodic_func_t func,
+    void* user_data, const volatile bool* stop,
+    anzu_periodic_stats_t* stats);
+
+typedef struct anzu_periodic_task anzu_periodic_task_t;
+
+// Runs `anzu_periodic_run` on a new thread; NULL (with errno set) on
+// failure.
+anzu_periodic_task_t* anzu_periodic_start(
+    const anzu_periodic_config_t* config, anzu_periodic_func_t func,
+    void* user_data);
+
+// Asks the task to stop after its current cycle.
+void anzu_periodic_stop(anzu_periodic_task_t* task);
+
+// Waits for the task to finish, copies its stats (if `stats` is not NULL),
+// and frees it.
+void anzu_periodic_join(
+    anzu_periodic_task_t* task, anzu_periodic_stats_t* stats);
+
+// One cyclictest-style line (cycles, min / avg / p99 / max wake-up latency,
+// overruns), then the scheduling errors, if any.
+void anzu_periodic_stats_fprint(
+    FILE* file, const char* name, const anzu_periodic_stats_t* stats);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif  // __cplusplus
+
+#endif  // _ANZU_PERIODIC_H
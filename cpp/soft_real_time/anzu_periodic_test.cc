@@ -0,0 +1,149 @@
+#include "anzu_periodic.h"
+
+#include <sched.h>
+#include <time.h>
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+std::string Format(const anzu_cpu_mask_t* mask) {
+  char buffer[64];
+  anzu_cpu_mask_snprintf(buffer, sizeof(buffer), mask);
+  return buffer;
+}
+
+TEST(AnzuCpuMaskTest, ParseAndFormat) {
+  anzu_cpu_mask_t* mask = anzu_cpu_mask_new();
+  ASSERT_NE(mask, nullptr);
+  EXPECT_GE(anzu_cpu_mask_capacity(mask), CPU_SETSIZE);
+  EXPECT_EQ(anzu_cpu_mask_count(mask), 0);
+  EXPECT_EQ(anzu_cpu_mask_parse(mask, "0-3,6,10-11"), 0);
+  EXPECT_EQ(anzu_cpu_mask_count(mask), 7);
+  EXPECT_TRUE(anzu_cpu_mask_isset(mask, 6));
+  EXPECT_FALSE(anzu_cpu_mask_isset(mask, 5));
+  EXPECT_EQ(Format(mask), "0-3,6,10-11");
+
+  const int capacity = anzu_cpu_mask_capacity(mask);
+  EXPECT_EQ(anzu_cpu_mask_set(mask, capacity), -EINVAL);
+  EXPECT_EQ(anzu_cpu_mask_set(mask, -1), -EINVAL);
+  EXPECT_FALSE(anzu_cpu_mask_isset(mask, capacity));
+  for (const char* bad : {"", "1,", "3-1", "a", "1-", "-1", "0 1"}) {
+    EXPECT_EQ(anzu_cpu_mask_parse(mask, bad), -EINVAL) << bad;
+  }
+  EXPECT_EQ(anzu_cpu_mask_parse(
+      mask, std::to_string(capacity).c_str()), -EINVAL);
+
+  // Truncates like snprintf.
+  char small[5];
+  EXPECT_EQ(anzu_cpu_mask_snprintf(small, sizeof(small), mask), 11);
+  EXPECT_STREQ(small, "0-3,");
+  anzu_cpu_mask_free(mask);
+}
+
+TEST(AnzuCpuMaskTest, Thread) {
+  anzu_cpu_mask_t* mask = anzu_cpu_mask_new();
+  ASSERT_EQ(anzu_cpu_mask_get_thread(mask), 0);
+  EXPECT_GE(anzu_cpu_mask_count(mask), 1);
+  EXPECT_EQ(anzu_cpu_mask_set_thread(mask), 0);
+  anzu_cpu_mask_free(mask);
+}
+
+TEST(AnzuLatencyHistTest, Quantiles) {
+  anzu_latency_hist_t hist;
+  anzu_latency_hist_reset(&hist);
+  EXPECT_EQ(anzu_latency_hist_quantile_us(&hist, 0.5), 0);
+  for (int i = 0; i < 100; ++i) {
+    anzu_latency_hist_add(&hist, i * 1000 + 500);
+  }
+  anzu_latency_hist_add(&hist, 5000000);
+  EXPECT_EQ(hist.count, 101u);
+  EXPECT_EQ(hist.overflow, 1u);
+  EXPECT_EQ(hist.min_ns, 500);
+  EXPECT_EQ(hist.max_ns, 5000000);
+  // The 51st of 101 samples, 50.5 us.
+  EXPECT_EQ(anzu_latency_hist_quantile_us(&hist, 0.5), 51);
+  EXPECT_EQ(anzu_latency_hist_quantile_us(&hist, 0.01), 2);
+  EXPECT_EQ(anzu_latency_hist_quantile_us(&hist, 0), 1);
+  EXPECT_EQ(anzu_latency_hist_quantile_us(&hist, 1), ANZU_HIST_BUCKETS);
+}
+
+struct Counter {
+  int calls{};
+  int stop_after{-1};
+};
+
+bool Count(void* raw) {
+  Counter* counter = static_cast<Counter*>(raw);
+  return ++counter->calls != counter->stop_after;
+}
+
+bool Sleep3ms(void*) {
+  const timespec duration{0, 3000000};
+  nanosleep(&duration, nullptr);
+  return true;
+}
+
+TEST(AnzuPeriodicTest, RunsForMaxCycles) {
+  anzu_periodic_config_t config = anzu_periodic_config_default();
+  config.period_ns = 200000;
+  config.max_cycles = 50;
+  Counter counter;
+  anzu_periodic_stats_t stats;
+  anzu_periodic_run(&config, Count, &counter, nullptr, &stats);
+  EXPECT_EQ(counter.calls, 50);
+  EXPECT_EQ(stats.cycles, 50u);
+  EXPECT_EQ(stats.wakeup.count, 50u);
+  EXPECT_GE(stats.wakeup.min_ns, 0);
+  EXPECT_EQ(stats.sched_error, 0);
+}
+
+TEST(AnzuPeriodicTest, StopsWhenFuncReturnsFalse) {
+  anzu_periodic_config_t config = anzu_periodic_config_default();
+  config.period_ns = 100000;
+  Counter counter;
+  counter.stop_after = 7;
+  anzu_periodic_stats_t stats;
+  anzu_periodic_run(&config, Count, &counter, nullptr, &stats);
+  EXPECT_EQ(counter.calls, 7);
+  EXPECT_EQ(stats.cycles, 7u);
+}
+
+TEST(AnzuPeriodicTest, CountsOverruns) {
+  anzu_periodic_config_t config = anzu_periodic_config_default();
+  config.period_ns = 1000000;
+  config.max_cycles = 5;
+  anzu_periodic_stats_t stats;
+  anzu_periodic_run(&config, Sleep3ms, nullptr, nullptr, &stats);
+  EXPECT_EQ(stats.cycles, 5u);
+  // Each 3 ms cycle overruns by ~2 ms, skipping 2-3 wake-ups.
+  EXPECT_EQ(stats.overrun.count, 5u);
+  EXPECT_GE(stats.missed_periods, 10u);
+  EXPECT_GE(stats.overrun.min_ns, 1000000);
+}
+
+TEST(AnzuPeriodicTest, StartStopJoin) {
+  anzu_cpu_mask_t* affinity = anzu_cpu_mask_new();
+  anzu_cpu_mask_set(affinity, 0);
+  anzu_periodic_config_t config = anzu_periodic_config_default();
+  config.period_ns = 100000;
+  config.affinity = affinity;
+  Counter counter;
+  anzu_periodic_task_t* task = anzu_periodic_start(&config, Count, &counter);
+  // The task copies the mask.
+  anzu_cpu_mask_free(affinity);
+  ASSERT_NE(task, nullptr);
+  const timespec duration{0, 20000000};
+  nanosleep(&duration, nullptr);
+  anzu_periodic_stop(task);
+  anzu_periodic_stats_t stats;
+  anzu_periodic_join(task, &stats);
+  EXPECT_GT(stats.cycles, 0u);
+  EXPECT_EQ(stats.cycles, static_cast<uint64_t>(counter.calls));
+  EXPECT_EQ(stats.affinity_error, 0);
+  EXPECT_GT(stats.tid, 0);
+}
+
+}  // namespace
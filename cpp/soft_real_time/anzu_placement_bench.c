@@ -0,0 +1,372 @@
+// Shows what topology-aware placement (`anzu_place_*`) buys, with cache
+// misses from `perf_event_open` where permitted:
+//
+// 1. Cache-line ping-pong round trip between two threads on SMT siblings,
+//    on cores sharing the LLC, and across LLCs: why "share LLC with thread X"
+//    matters for threads that talk to each other.
+// 2. Cycle time of a 1 kHz task working on a 512 KiB set while a
+//    memory-streaming thread runs on its SMT sibling vs. wherever
+//    `anzu_place_avoid_smt_sibling` puts it.
+// 3. Throughput of one thread per physical core vs. the same threads packed
+//    two per core onto SMT siblings.
+//
+//   anzu_placement_bench [sysfs_cpu_dir]
+//
+// Scenarios the machine cannot express (e.g. no SMT, one LLC) are skipped.
+#define _GNU_SOURCE
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "anzu_periodic.h"
+#include "anzu_sched_param.h"
+
+static void check(bool value) {
+  if (!value) {
+    fprintf(stderr, "abort!\n");
+    exit(1);
+  }
+}
+
+static int64_t now_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// Pins the calling thread to the CPUs in `param` (-1 priority: unchanged).
+static void pin(const anzu_sched_param_t* param) {
+  anzu_sched_param_t copy = *param;
+  copy.sched_rr_priority = -1;
+  anzu_set_sched_param(0, &copy);
+}
+
+static void pin_cpu(int cpu) {
+  anzu_sched_param_t param;
+  memset(&param, 0, sizeof(param));
+  param.cpu_affinity[cpu] = true;
+  pin(&param);
+}
+
+// Counts L1D read misses and LLC misses of the calling thread; -1 fds (and
+// "n/a" output) where perf events are not permitted.
+typedef struct misses {
+  int l1d_fd;
+  int llc_fd;
+  uint64_t l1d;
+  uint64_t llc;
+} misses_t;
+
+static int open_counter(uint32_t type, uint64_t config) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static uint64_t read_counter(int fd) {
+  uint64_t value = 0;
+  if (fd >= 0 && read(fd, &value, sizeof(value)) != sizeof(value)) value = 0;
+  return value;
+}
+
+static void misses_start(misses_t* misses) {
+  misses->l1d_fd = open_counter(
+      PERF_TYPE_HW_CACHE,
+      PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+  misses->llc_fd =
+      open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+  misses->l1d = read_counter(misses->l1d_fd);
+  misses->llc = read_counter(misses->llc_fd);
+}
+
+static void misses_stop(misses_t* misses) {
+  misses->l1d = read_counter(misses->l1d_fd) - misses->l1d;
+  misses->llc = read_counter(misses->llc_fd) - misses->llc;
+  if (misses->l1d_fd >= 0) close(misses->l1d_fd);
+  if (misses->llc_fd >= 0) close(misses->llc_fd);
+}
+
+// Misses per `per` operations, or "n/a".
+static const char* format_misses(char* buffer, size_t size, int fd,
+                                 uint64_t count, double per) {
+  if (fd < 0) {
+    snprintf(buffer, size, "n/a");
+  } else {
+    snprintf(buffer, size, "%.3f", count / per);
+  }
+  return buffer;
+}
+
+// --- 1. Ping-pong. ---
+
+#define PING_PONG_ROUND_TRIPS 200000
+
+typedef struct ping_pong {
+  _Alignas(64) volatile int64_t value;
+  int cpu;
+} ping_pong_t;
+
+static void* run_pong(void* raw) {
+  ping_pong_t* shared = raw;
+  pin_cpu(shared->cpu);
+  for (int64_t i = 0; i < PING_PONG_ROUND_TRIPS; ++i) {
+    while (shared->value != 2 * i + 1) {}
+    shared->value = 2 * i + 2;
+  }
+  return NULL;
+}
+
+static void bench_ping_pong(const char* name, int cpu_a, int cpu_b) {
+  ping_pong_t shared;
+  shared.value = 0;
+  shared.cpu = cpu_b;
+  pthread_t pong;
+  check(pthread_create(&pong, NULL, run_pong, &shared) == 0);
+  pin_cpu(cpu_a);
+  misses_t misses;
+  misses_start(&misses);
+  const int64_t start = now_ns();
+  for (int64_t i = 0; i < PING_PONG_ROUND_TRIPS; ++i) {
+    shared.value = 2 * i + 1;
+    while (shared.value != 2 * i + 2) {}
+  }
+  const int64_t elapsed = now_ns() - start;
+  misses_stop(&misses);
+  check(pthread_join(pong, NULL) == 0);
+  char l1d[32], llc[32];
+  printf("  %-22s cpus %3d,%3d  %8.1f ns / round trip  "
+         "L1D misses %s, LLC misses %s / round trip\n",
+         name, cpu_a, cpu_b, (double)elapsed / PING_PONG_ROUND_TRIPS,
+         format_misses(l1d, sizeof(l1d), misses.l1d_fd, misses.l1d,
+                       PING_PONG_ROUND_TRIPS),
+         format_misses(llc, sizeof(llc), misses.llc_fd, misses.llc,
+                       PING_PONG_ROUND_TRIPS));
+}
+
+// --- 2. RT cycle time with a noisy neighbor. ---
+
+#define RT_WORKING_SET (512 << 10)
+#define RT_CYCLES 2000
+#define NOISE_BYTES (64 << 20)
+
+static volatile bool noise_stop;
+
+static void* run_noise(void* raw) {
+  pin(raw);
+  unsigned char* buffer = malloc(NOISE_BYTES);
+  check(buffer != NULL);
+  memset(buffer, 1, NOISE_BYTES);
+  unsigned char value = 0;
+  while (!noise_stop) {
+    for (size_t i = 0; i < NOISE_BYTES; i += 64) buffer[i] += value++;
+  }
+  free(buffer);
+  return NULL;
+}
+
+typedef struct rt_work {
+  unsigned char* buffer;
+  anzu_latency_hist_t work;
+  uint64_t sum;
+} rt_work_t;
+
+static bool rt_step(void* raw) {
+  rt_work_t* rt = raw;
+  const int64_t start = now_ns();
+  uint64_t sum = 0;
+  for (size_t i = 0; i < RT_WORKING_SET; i += 16) sum += rt->buffer[i];
+  rt->sum += sum;
+  anzu_latency_hist_add(&rt->work, now_ns() - start);
+  return true;
+}
+
+static void bench_rt(const char* name, int rt_cpu,
+                     const anzu_sched_param_t* noise_param) {
+  noise_stop = false;
+  pthread_t noise;
+  check(pthread_create(&noise, NULL, run_noise, (void*)noise_param) == 0);
+  rt_work_t rt;
+  memset(&rt, 0, sizeof(rt));
+  rt.buffer = calloc(RT_WORKING_SET, 1);
+  check(rt.buffer != NULL);
+  anzu_latency_hist_reset(&rt.work);
+  anzu_cpu_mask_t* affinity = anzu_cpu_mask_new();
+  check(affinity != NULL);
+  anzu_cpu_mask_set(affinity, rt_cpu);
+  anzu_periodic_config_t config = anzu_periodic_config_default();
+  config.affinity = affinity;
+  config.max_cycles = RT_CYCLES;
+  misses_t misses;
+  misses_start(&misses);
+  anzu_periodic_stats_t stats;
+  anzu_periodic_run(&config, rt_step, &rt, NULL, &stats);
+  misses_stop(&misses);
+  noise_stop = true;
+  check(pthread_join(noise, NULL) == 0);
+  char noise_cpus[256], l1d[32], llc[32];
+  anzu_sched_param_snprintf(noise_cpus, sizeof(noise_cpus), noise_param);
+  printf("  %-22s work p50 %4d  p99 %4d  max %6lld us  "
+         "L1D misses %s, LLC misses %s / cycle\n"
+         "  %-22s noise: %s\n",
+         name, anzu_latency_hist_quantile_us(&rt.work, 0.5),
+         anzu_latency_hist_quantile_us(&rt.work, 0.99),
+         (long long)(rt.work.max_ns / 1000),
+         format_misses(l1d, sizeof(l1d), misses.l1d_fd, misses.l1d,
+                       RT_CYCLES),
+         format_misses(llc, sizeof(llc), misses.llc_fd, misses.llc,
+                       RT_CYCLES),
+         "", noise_cpus);
+  anzu_cpu_mask_free(affinity);
+  free(rt.buffer);
+}
+
+// --- 3. One thread per core vs. packed onto SMT siblings. ---
+
+#define PER_CORE_SET (1 << 20)
+#define PER_CORE_READS (20 * 1000 * 1000)
+
+typedef struct per_core {
+  int cpu;
+  uint64_t l1d;
+  int l1d_fd;
+} per_core_t;
+
+static void* run_per_core(void* raw) {
+  per_core_t* thread = raw;
+  pin_cpu(thread->cpu);
+  uint32_t* buffer = malloc(PER_CORE_SET);
+  check(buffer != NULL);
+  const uint32_t mask = PER_CORE_SET / sizeof(uint32_t) - 1;
+  for (uint32_t i = 0; i <= mask; ++i) buffer[i] = i * 2654435761u;
+  misses_t misses;
+  misses_start(&misses);
+  // Dependent random reads over an L2-sized set.
+  uint32_t index = 0;
+  for (int i = 0; i < PER_CORE_READS; ++i) index = buffer[index & mask];
+  misses_stop(&misses);
+  thread->l1d = misses.l1d + (index == 1);  // Keeps `index` live.
+  thread->l1d_fd = misses.l1d_fd;
+  free(buffer);
+  return NULL;
+}
+
+static void bench_per_core(const char* name, const int* cpus, int n) {
+  per_core_t* threads = calloc(n, sizeof(per_core_t));
+  pthread_t* ids = calloc(n, sizeof(pthread_t));
+  check(threads != NULL && ids != NULL);
+  const int64_t start = now_ns();
+  for (int i = 0; i < n; ++i) {
+    threads[i].cpu = cpus[i];
+    check(pthread_create(&ids[i], NULL, run_per_core, &threads[i]) == 0);
+  }
+  uint64_t l1d = 0;
+  for (int i = 0; i < n; ++i) {
+    check(pthread_join(ids[i], NULL) == 0);
+    l1d += threads[i].l1d;
+  }
+  const int64_t elapsed = now_ns() - start;
+  char l1d_text[32];
+  printf("  %-22s %d threads  %7.1f M reads / s  L1D misses %s / read\n",
+         name, n, (double)n * PER_CORE_READS / elapsed * 1000,
+         format_misses(l1d_text, sizeof(l1d_text), threads[0].l1d_fd, l1d,
+                       (double)n * PER_CORE_READS));
+  free(threads);
+  free(ids);
+}
+
+int main(int argc, char** argv) {
+  static anzu_cpu_topology_t topology;
+  check(anzu_get_cpu_topology(argc > 1 ? argv[1] : NULL, &topology) == 0);
+  anzu_cpu_topology_fprint(stdout, &topology);
+
+  // Find an SMT pair, a second core on the same LLC, and a CPU on another
+  // LLC, relative to the first online CPU with an SMT sibling (or just the
+  // first online CPU).
+  int base = -1, sibling = -1, same_llc = -1, other_llc = -1;
+  for (int cpu = 0; cpu < topology.num_cpus && sibling < 0; ++cpu) {
+    if (!topology.cpus[cpu].online) continue;
+    if (base < 0) base = cpu;
+    for (int other = cpu + 1; other < topology.num_cpus; ++other) {
+      if (topology.cpus[other].online &&
+          topology.cpus[other].core == topology.cpus[cpu].core) {
+        base = cpu;
+        sibling = other;
+        break;
+      }
+    }
+  }
+  check(base >= 0);
+  const anzu_cpu_info_t* info = &topology.cpus[base];
+  for (int cpu = 0; cpu < topology.num_cpus; ++cpu) {
+    const anzu_cpu_info_t* other = &topology.cpus[cpu];
+    if (!other->online || other->core == info->core) continue;
+    if (other->llc == info->llc && same_llc < 0) same_llc = cpu;
+    if (other->llc != info->llc && other_llc < 0) other_llc = cpu;
+  }
+
+  printf("\n1. Cache-line ping-pong\n");
+  if (sibling >= 0) bench_ping_pong("SMT siblings", base, sibling);
+  if (same_llc >= 0) bench_ping_pong("shared LLC", base, same_llc);
+  if (other_llc >= 0) bench_ping_pong("different LLC", base, other_llc);
+  if (sibling < 0 && same_llc < 0 && other_llc < 0) {
+    printf("  skipped: needs 2 CPUs\n");
+  }
+
+  printf("\n2. 1 kHz task on CPU %d with a memory-streaming neighbor\n", base);
+  anzu_sched_param_t noise_param;
+  memset(&noise_param, 0, sizeof(noise_param));
+  if (sibling >= 0) {
+    noise_param.cpu_affinity[sibling] = true;
+    bench_rt("neighbor on sibling", base, &noise_param);
+  }
+  if (anzu_place_avoid_smt_sibling(&topology, base, &noise_param) > 0) {
+    bench_rt("avoid_smt_sibling", base, &noise_param);
+  }
+  if (sibling < 0) printf("  (no SMT sibling to compare against)\n");
+
+  printf("\n3. One thread per physical core vs. packed on SMT siblings\n");
+  int num_cores = 0;
+  for (int cpu = 0; cpu < topology.num_cpus; ++cpu) {
+    num_cores += topology.cpus[cpu].online && topology.cpus[cpu].core == cpu;
+  }
+  static int spread[ANZU_NPROC];
+  static int packed[ANZU_NPROC];
+  const int n = num_cores >= 2 ? (num_cores / 2) * 2 : 1;
+  anzu_sched_param_t param;
+  for (int i = 0; i < n; ++i) {
+    check(anzu_place_one_per_core(&topology, i, &param) == 1);
+    for (int cpu = 0; cpu < topology.num_cpus; ++cpu) {
+      if (param.cpu_affinity[cpu]) spread[i] = cpu;
+    }
+  }
+  bench_per_core("one_per_core", spread, n);
+  // Pairs on the cores `spread` uses first, where they have siblings.
+  int num_packed = 0;
+  for (int i = 0; i < n && num_packed < n; ++i) {
+    const int core = topology.cpus[spread[i]].core;
+    for (int cpu = 0; cpu < topology.num_cpus && num_packed < n; ++cpu) {
+      if (topology.cpus[cpu].online && topology.cpus[cpu].core == core) {
+        packed[num_packed++] = cpu;
+      }
+    }
+  }
+  if (sibling >= 0 && num_packed == n) {
+    bench_per_core("packed on siblings", packed, n);
+  } else {
+    printf("  (no SMT siblings to pack onto)\n");
+  }
+  return 0;
+}
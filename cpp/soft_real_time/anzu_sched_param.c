@@ -1,7 +1,11 @@
 #define _GNU_SOURCE
 #include <asm/unistd_64.h>
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
 #include <sched.h>
 #include <unistd.h>
+#include <stdarg.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -20,26 +24,54 @@ int anzu_gettid() {
   return syscall(__NR_gettid);
 }
 
-char* anzu_sched_param_sprintf(char* buffer, anzu_sched_param_t* param) {
-  check(buffer != NULL);
+_Static_assert(ANZU_NPROC == CPU_SETSIZE, "ANZU_NPROC must be CPU_SETSIZE");
+
+void anzu_snprintf_append(char* buffer, size_t size, size_t* offset,
+                          const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  const int n = vsnprintf(
+      *offset < size ? buffer + *offset : NULL,
+      *offset < size ? size - *offset : 0, format, args);
+  va_end(args);
+  if (n > 0) *offset += n;
+}
+
+int anzu_sched_param_snprintf(
+    char* buffer, size_t size, const anzu_sched_param_t* param) {
+  check(buffer != NULL || size == 0);
   check(param != NULL);
-  buffer += sprintf(
-      buffer,
-      "( chrt -r %d  taskset -c ",
-      param->sched_rr_priority);
-  int num_set = 0;
+  size_t offset = 0;
+  anzu_snprintf_append(buffer, size, &offset, "( chrt -r %d  taskset -c ",
+                       param->sched_rr_priority);
+  // Omit the list when it is empty, or exactly the machine's CPUs.
+  const long num_cpus = sysconf(_SC_NPROCESSORS_CONF);
+  bool all = true;
+  bool any = false;
   for (int i = 0; i < ANZU_NPROC; ++i) {
-    num_set += param->cpu_affinity[i];
+    any = any || param->cpu_affinity[i];
+    all = all && param->cpu_affinity[i] == (i < num_cpus);
   }
-  if (num_set > 0 && num_set < ANZU_NPROC) {
+  if (any && !all) {
+    const char* separator = "";
     for (int i = 0; i < ANZU_NPROC; ++i) {
-      if (param->cpu_affinity[i]) {
-        buffer += sprintf(buffer, "%d,", i);
+      if (!param->cpu_affinity[i]) continue;
+      int last = i;
+      while (last + 1 < ANZU_NPROC && param->cpu_affinity[last + 1]) {
+        ++last;
       }
+      if (last == i) {
+        anzu_snprintf_append(buffer, size, &offset, "%s%d", separator, i);
+      } else {
+        anzu_snprintf_append(buffer, size, &offset,
+                             "%s%d-%d", separator, i, last);
+      }
+      separator = ",";
+      i = last;
     }
   }
-  buffer += sprintf(buffer, " )");
-  return buffer;
+  anzu_snprintf_append(buffer, size, &offset, " )");
+  return (int)offset;
 }
 
 void anzu_set_sched_param(pid_t pid, anzu_sched_param_t* param) {
@@ -86,3 +118,263 @@ void anzu_get_sched_param_from_pid(pid_t pid, anzu_sched_param_t* param) {
     }
   }
 }
+
+// Reads a `cpulist` ("0-3,8") file into `cpus`; returns the number of CPUs,
+// or -errno.
+static int read_cpu_list(const char* path, bool cpus[ANZU_NPROC]) {
+  memset(cpus, 0, ANZU_NPROC * sizeof(bool));
+  FILE* file = fopen(path, "r");
+  if (file == NULL) return -errno;
+  char line[4096];
+  const bool ok = fgets(line, sizeof(line), file) != NULL;
+  fclose(file);
+  if (!ok) return -EINVAL;
+  int count = 0;
+  const char* text = line;
+  while (*text != '\0' && *text != '\n') {
+    char* end;
+    const long first = strtol(text, &end, 10);
+    long last = first;
+    if (end == text) return -EINVAL;
+    if (*end == '-') {
+      text = end + 1;
+      last = strtol(text, &end, 10);
+      if (end == text) return -EINVAL;
+    }
+    if (first < 0 || last >= ANZU_NPROC || last < first) return -EINVAL;
+    for (long cpu = first; cpu <= last; ++cpu) {
+      cpus[cpu] = true;
+      ++count;
+    }
+    text = end;
+    if (*text == ',') ++text;
+  }
+  return count;
+}
+
+static int lowest_cpu(const bool cpus[ANZU_NPROC], int fallback) {
+  for (int i = 0; i < ANZU_NPROC; ++i) {
+    if (cpus[i]) return i;
+  }
+  return fallback;
+}
+
+static bool read_int(const char* path, int* value) {
+  FILE* file = fopen(path, "r");
+  if (file == NULL) return false;
+  const bool ok = fscanf(file, "%d", value) == 1;
+  fclose(file);
+  return ok;
+}
+
+// Lowest CPU sharing the highest-level data / unified cache with `cpu`.
+static int read_llc(const char* dir, int cpu, bool scratch[ANZU_NPROC]) {
+  char path[PATH_MAX];
+  int best_level = -1;
+  int llc = cpu;
+  for (int index = 0;; ++index) {
+    snprintf(path, sizeof(path), "%s/cpu%d/cache/index%d/type", dir, cpu,
+             index);
+    FILE* file = fopen(path, "r");
+    if (file == NULL) break;
+    char type[32] = "";
+    const bool ok = fscanf(file, "%31s", type) == 1;
+    fclose(file);
+    if (!ok || strcmp(type, "Instruction") == 0) continue;
+    int level;
+    snprintf(path, sizeof(path), "%s/cpu%d/cache/index%d/level", dir, cpu,
+             index);
+    if (!read_int(path, &level) || level <= best_level) continue;
+    snprintf(path, sizeof(path), "%s/cpu%d/cache/index%d/shared_cpu_list",
+             dir, cpu, index);
+    if (read_cpu_list(path, scratch) > 0) {
+      best_level = level;
+      llc = lowest_cpu(scratch, cpu);
+    }
+  }
+  return llc;
+}
+
+static int read_numa_node(const char* dir, int cpu) {
+  char path[PATH_MAX];
+  snprintf(path, sizeof(path), "%s/cpu%d", dir, cpu);
+  DIR* cpu_dir = opendir(path);
+  if (cpu_dir == NULL) return -1;
+  int node = -1;
+  struct dirent* entry;
+  while ((entry = readdir(cpu_dir)) != NULL) {
+    int value;
+    char rest;
+    if (sscanf(entry->d_name, "node%d%c", &value, &rest) == 1) {
+      node = value;
+      break;
+    }
+  }
+  closedir(cpu_dir);
+  return node;
+}
+
+int anzu_get_cpu_topology(
+    const char* sysfs_cpu_dir, anzu_cpu_topology_t* topology) {
+  check(topology != NULL);
+  const char* dir =
+      sysfs_cpu_dir != NULL ? sysfs_cpu_dir : "/sys/devices/system/cpu";
+  memset(topology, 0, sizeof(anzu_cpu_topology_t));
+  char path[PATH_MAX];
+  bool possible[ANZU_NPROC];
+  bool online[ANZU_NPROC];
+  bool scratch[ANZU_NPROC];
+  snprintf(path, sizeof(path), "%s/possible", dir);
+  int result = read_cpu_list(path, possible);
+  if (result < 0) return result;
+  snprintf(path, sizeof(path), "%s/online", dir);
+  result = read_cpu_list(path, online);
+  if (result < 0) return result;
+  for (int cpu = 0; cpu < ANZU_NPROC; ++cpu) {
+    if (possible[cpu]) topology->num_cpus = cpu + 1;
+  }
+  for (int cpu = 0; cpu < topology->num_cpus; ++cpu) {
+    anzu_cpu_info_t* info = &topology->cpus[cpu];
+    info->online = online[cpu];
+    info->core = cpu;
+    info->llc = cpu;
+    info->numa_node = -1;
+    if (!info->online) continue;
+    snprintf(path, sizeof(path), "%s/cpu%d/topology/physical_package_id",
+             dir, cpu);
+    if (!read_int(path, &info->package)) info->package = 0;
+    // `core_cpus_list` replaced `thread_siblings_list` in Linux 5.x.
+    snprintf(path, sizeof(path), "%s/cpu%d/topology/core_cpus_list", dir,
+             cpu);
+    if (read_cpu_list(path, scratch) <= 0) {
+      snprintf(path, sizeof(path),
+               "%s/cpu%d/topology/thread_siblings_list", dir, cpu);
+      read_cpu_list(path, scratch);
+    }
+    info->core = lowest_cpu(scratch, cpu);
+    info->llc = read_llc(dir, cpu, scratch);
+    info->numa_node = read_numa_node(dir, cpu);
+  }
+  return 0;
+}
+
+void anzu_cpu_topology_fprint(
+    FILE* file, const anzu_cpu_topology_t* topology) {
+  fprintf(file, "cpu package core  llc numa\n");
+  for (int cpu = 0; cpu < topology->num_cpus; ++cpu) {
+    const anzu_cpu_info_t* info = &topology->cpus[cpu];
+    if (!info->online) continue;
+    fprintf(file, "%3d %7d %4d %4d %4d\n", cpu, info->package, info->core,
+            info->llc, info->numa_node);
+  }
+}
+
+int anzu_get_current_cpu(pid_t pid) {
+  if (pid == 0) {
+    const int cpu = sched_getcpu();
+    return cpu >= 0 ? cpu : -errno;
+  }
+  char path[64];
+  snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+  FILE* file = fopen(path, "r");
+  if (file == NULL) return -errno;
+  char line[1024];
+  const bool ok = fgets(line, sizeof(line), file) != NULL;
+  fclose(file);
+  // `processor` is field 39; skip the command name (field 2), which may
+  // contain spaces, by starting after its closing parenthesis.
+  const char* text = ok ? strrchr(line, ')') : NULL;
+  if (text == NULL) return -EINVAL;
+  int field = 2;
+  int cpu = -EINVAL;
+  char* save = NULL;
+  for (text = strtok_r((char*)text + 1, " ", &save); text != NULL;
+       text = strtok_r(NULL, " ", &save)) {
+    if (++field == 39) {
+      cpu = atoi(text);
+      break;
+    }
+  }
+  return cpu;
+}
+
+static bool is_valid_cpu(const anzu_cpu_topology_t* topology, int cpu) {
+  return cpu >= 0 && cpu < topology->num_cpus && topology->cpus[cpu].online;
+}
+
+int anzu_place_one_per_core(
+    const anzu_cpu_topology_t* topology, int index,
+    anzu_sched_param_t* param) {
+  check(topology != NULL && param != NULL);
+  memset(param->cpu_affinity, 0, sizeof(param->cpu_affinity));
+  if (index < 0) return -EINVAL;
+  // Order CPUs by their rank among their core's SMT siblings, then by CPU.
+  int rank[ANZU_NPROC];
+  int threads_in_core[ANZU_NPROC];
+  memset(threads_in_core, 0, sizeof(threads_in_core));
+  int num_online = 0;
+  int max_rank = 0;
+  for (int cpu = 0; cpu < topology->num_cpus; ++cpu) {
+    if (!topology->cpus[cpu].online) continue;
+    rank[cpu] = threads_in_core[topology->cpus[cpu].core]++;
+    if (rank[cpu] > max_rank) max_rank = rank[cpu];
+    ++num_online;
+  }
+  if (num_online == 0) return 0;
+  int position = index % num_online;
+  for (int r = 0; r <= max_rank; ++r) {
+    for (int cpu = 0; cpu < topology->num_cpus; ++cpu) {
+      if (!topology->cpus[cpu].online || rank[cpu] != r) continue;
+      if (position-- == 0) {
+        param->cpu_affinity[cpu] = true;
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+int anzu_place_share_llc(
+    const anzu_cpu_topology_t* topology, int cpu, anzu_sched_param_t* param) {
+  check(topology != NULL && param != NULL);
+  memset(param->cpu_affinity, 0, sizeof(param->cpu_affinity));
+  if (!is_valid_cpu(topology, cpu)) return -EINVAL;
+  const anzu_cpu_info_t* target = &topology->cpus[cpu];
+  int count = 0;
+  for (int other = 0; other < topology->num_cpus; ++other) {
+    const anzu_cpu_info_t* info = &topology->cpus[other];
+    if (info->online && info->llc == target->llc &&
+        info->core != target->core) {
+      param->cpu_affinity[other] = true;
+      ++count;
+    }
+  }
+  if (count > 0) return count;
+  // Only the core itself shares the cache.
+  for (int other = 0; other < topology->num_cpus; ++other) {
+    const anzu_cpu_info_t* info = &topology->cpus[other];
+    if (info->online && info->core == target->core) {
+      param->cpu_affinity[other] = true;
+      ++count;
+    }
+  }
+  return count;
+}
+
+int anzu_place_avoid_smt_sibling(
+    const anzu_cpu_topology_t* topology, int rt_cpu,
+    anzu_sched_param_t* param) {
+  check(topology != NULL && param != NULL);
+  memset(param->cpu_affinity, 0, sizeof(param->cpu_affinity));
+  if (!is_valid_cpu(topology, rt_cpu)) return -EINVAL;
+  const int rt_core = topology->cpus[rt_cpu].core;
+  int count = 0;
+  for (int cpu = 0; cpu < topology->num_cpus; ++cpu) {
+    const anzu_cpu_info_t* info = &topology->cpus[cpu];
+    if (info->online && info->core != rt_core) {
+      param->cpu_affinity[cpu] = true;
+      ++count;
+    }
+  }
+  return count;
+}
@@ -7,9 +7,13 @@ extern "C" {
 #endif  // __cplusplus
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
 #include <sys/types.h>
 
-#define ANZU_NPROC 64  // HACK: Eric's machine.
+// Same as glibc's CPU_SETSIZE (checked in the .c), so any CPU a `cpu_set_t`
+// can hold fits. See `anzu_periodic.h` for masks sized to the machine.
+#define ANZU_NPROC 1024
 
 typedef struct anzu_sched_param {
   int sched_rr_priority;
@@ -18,13 +22,72 @@ typedef struct anzu_sched_param {
 
 int anzu_gettid();
 
-// WARNING: No bounds checking!!!
-char* anzu_sched_param_sprintf(char* buffer, anzu_sched_param_t* param);
+// Appends to `buffer[*offset:size]` like `snprintf`; `*offset` counts the
+// full length, even past `size`. For building `*_snprintf` results.
+void anzu_snprintf_append(char* buffer, size_t size, size_t* offset,
+                          const char* format, ...);
+
+// Formats `param` as the equivalent `chrt` / `taskset` command, with CPU
+// ranges (e.g. "0-3,6"). Like `snprintf`, writes at most `size` bytes
+// (always null-terminated) and returns the length the full string needs.
+int anzu_sched_param_snprintf(
+    char* buffer, size_t size, const anzu_sched_param_t* param);
 
 void anzu_set_sched_param(pid_t pid, anzu_sched_param_t* param);
 
 void anzu_get_sched_param_from_pid(pid_t pid, anzu_sched_param_t* param);
 
+// CPU topology, as read from sysfs. Cores and caches are identified by their
+// lowest-numbered CPU, so they are unique across packages.
+typedef struct anzu_cpu_info {
+  bool online;
+  int package;  // `physical_package_id`.
+  int core;     // Lowest CPU of the physical core (its SMT siblings).
+  int llc;      // Lowest CPU sharing the last-level cache.
+  int numa_node;  // -1 if unknown.
+} anzu_cpu_info_t;
+
+typedef struct anzu_cpu_topology {
+  int num_cpus;  // Possible CPUs; `cpus[i]` for i < num_cpus.
+  anzu_cpu_info_t cpus[ANZU_NPROC];
+} anzu_cpu_topology_t;
+
+// Reads the topology from `sysfs_cpu_dir`, or "/sys/devices/system/cpu" if
+// NULL. Missing information degrades gracefully (e.g. no SMT / shared LLC
+// assumed). Returns 0, or -errno if the CPU lists cannot be read.
+int anzu_get_cpu_topology(
+    const char* sysfs_cpu_dir, anzu_cpu_topology_t* topology);
+
+// One line per online CPU.
+void anzu_cpu_topology_fprint(FILE* file, const anzu_cpu_topology_t* topology);
+
+// The CPU `pid` (a tid; 0 for the caller) last ran on, or -errno.
+int anzu_get_current_cpu(pid_t pid);
+
+// Placement policies: each sets `param->cpu_affinity` (leaving the priority
+// alone) and returns the number of CPUs chosen, 0 if there are none (the
+// affinity is then left empty, i.e. unchanged by `anzu_set_sched_param`), or
+// -EINVAL for a bad CPU.
+
+// Thread `index` of a group: spreads over physical cores first, and uses
+// SMT siblings only once every core has a thread (wrapping around after
+// that). Pins to a single CPU.
+int anzu_place_one_per_core(
+    const anzu_cpu_topology_t* topology, int index,
+    anzu_sched_param_t* param);
+
+// The CPUs sharing the last-level cache with `cpu` (e.g. where thread X
+// runs, see `anzu_get_current_cpu`), other than the SMT siblings of `cpu`
+// (unless those are all there is).
+int anzu_place_share_llc(
+    const anzu_cpu_topology_t* topology, int cpu, anzu_sched_param_t* param);
+
+// Every online CPU except `rt_cpu` and its SMT siblings, so the caller does
+// not compete with a real-time thread on `rt_cpu` for its core.
+int anzu_place_avoid_smt_sibling(
+    const anzu_cpu_topology_t* topology, int rt_cpu,
+    anzu_sched_param_t* param);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif  // __cplusplus
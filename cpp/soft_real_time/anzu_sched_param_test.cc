@@ -0,0 +1,180 @@
+#include "anzu_sched_param.h"
+
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+std::vector<int> Cpus(const anzu_sched_param_t& param) {
+  std::vector<int> cpus;
+  for (int i = 0; i < ANZU_NPROC; ++i) {
+    if (param.cpu_affinity[i]) cpus.push_back(i);
+  }
+  return cpus;
+}
+
+// Fake `/sys/devices/system/cpu` for 2 packages x 2 cores x 2 SMT threads,
+// numbered like Linux does on x86 (SMT siblings are `n` and `n + 4`), with
+// an L3 per package and a NUMA node per package. CPU 7 is offline.
+class FakeSysfs {
+ public:
+  FakeSysfs() {
+    char pattern[] = "/tmp/anzu_sysfs_XXXXXX";
+    dir_ = mkdtemp(pattern);
+    Write("possible", "0-7");
+    Write("online", "0-6");
+    for (int cpu = 0; cpu < 7; ++cpu) {
+      const int core = cpu % 4;
+      const int package = core / 2;
+      const std::string sub = "cpu" + std::to_string(cpu);
+      Write(sub + "/topology/physical_package_id", std::to_string(package));
+      Write(sub + "/topology/core_cpus_list",
+            std::to_string(core) + "," + std::to_string(core + 4));
+      const std::string l1i = std::to_string(core) + "," +
+          std::to_string(core + 4);
+      WriteCache(sub, 0, "Instruction", 1, l1i);
+      WriteCache(sub, 1, "Data", 1, l1i);
+      WriteCache(sub, 2, "Unified", 2, l1i);
+      const int first = package * 2;
+      WriteCache(sub, 3, "Unified", 3,
+                 std::to_string(first) + "-" + std::to_string(first + 1) +
+                     "," + std::to_string(first + 4) + "-" +
+                     std::to_string(first + 5));
+      Write(sub + "/node" + std::to_string(package) + "/cpulist", "");
+    }
+  }
+
+  ~FakeSysfs() {
+    const std::string command = "rm -rf '" + dir_ + "'";
+    EXPECT_EQ(std::system(command.c_str()), 0);
+  }
+
+  const char* dir() const { return dir_.c_str(); }
+
+ private:
+  void Write(const std::string& relative, const std::string& contents) {
+    size_t start = 0;
+    size_t slash;
+    while ((slash = relative.find('/', start)) != std::string::npos) {
+      mkdir((dir_ + "/" + relative.substr(0, slash)).c_str(), 0755);
+      start = slash + 1;
+    }
+    FILE* file = std::fopen((dir_ + "/" + relative).c_str(), "w");
+    ASSERT_NE(file, nullptr);
+    std::fprintf(file, "%s\n", contents.c_str());
+    std::fclose(file);
+  }
+
+  void WriteCache(const std::string& cpu, int index, const std::string& type,
+                  int level, const std::string& shared) {
+    const std::string sub = cpu + "/cache/index" + std::to_string(index);
+    Write(sub + "/type", type);
+    Write(sub + "/level", std::to_string(level));
+    Write(sub + "/shared_cpu_list", shared);
+  }
+
+  std::string dir_;
+};
+
+TEST(AnzuSchedParamTest, Snprintf) {
+  anzu_sched_param_t param{};
+  param.sched_rr_priority = 30;
+  param.cpu_affinity[0] = true;
+  char buffer[64];
+  anzu_sched_param_snprintf(buffer, sizeof(buffer), &param);
+  if (sysconf(_SC_NPROCESSORS_CONF) > 1) {
+    EXPECT_STREQ(buffer, "( chrt -r 30  taskset -c 0 )");
+  }
+  param.cpu_affinity[2] = param.cpu_affinity[3] = param.cpu_affinity[4] =
+      true;
+  anzu_sched_param_snprintf(buffer, sizeof(buffer), &param);
+  EXPECT_STREQ(buffer, "( chrt -r 30  taskset -c 0,2-4 )");
+  char small[8];
+  const int n = anzu_sched_param_snprintf(small, sizeof(small), &param);
+  EXPECT_EQ(n, static_cast<int>(std::string(buffer).size()));
+  EXPECT_STREQ(small, "( chrt ");
+}
+
+TEST(AnzuSchedParamTest, Topology) {
+  const FakeSysfs sysfs;
+  anzu_cpu_topology_t topology;
+  ASSERT_EQ(anzu_get_cpu_topology(sysfs.dir(), &topology), 0);
+  EXPECT_EQ(topology.num_cpus, 8);
+  EXPECT_FALSE(topology.cpus[7].online);
+  const anzu_cpu_info_t& cpu5 = topology.cpus[5];
+  EXPECT_TRUE(cpu5.online);
+  EXPECT_EQ(cpu5.package, 0);
+  EXPECT_EQ(cpu5.core, 1);
+  EXPECT_EQ(cpu5.llc, 0);
+  EXPECT_EQ(cpu5.numa_node, 0);
+  const anzu_cpu_info_t& cpu6 = topology.cpus[6];
+  EXPECT_EQ(cpu6.package, 1);
+  EXPECT_EQ(cpu6.core, 2);
+  EXPECT_EQ(cpu6.llc, 2);
+  EXPECT_EQ(cpu6.numa_node, 1);
+
+  EXPECT_EQ(anzu_get_cpu_topology("/nonexistent", &topology), -ENOENT);
+}
+
+TEST(AnzuSchedParamTest, Placement) {
+  const FakeSysfs sysfs;
+  anzu_cpu_topology_t topology;
+  ASSERT_EQ(anzu_get_cpu_topology(sysfs.dir(), &topology), 0);
+  anzu_sched_param_t param{};
+
+  // Physical cores (0-3) first, then their online siblings (4-6).
+  std::vector<int> order;
+  for (int index = 0; index < 8; ++index) {
+    ASSERT_EQ(anzu_place_one_per_core(&topology, index, &param), 1);
+    order.push_back(Cpus(param)[0]);
+  }
+  EXPECT_EQ(order, (std::vector<int>{0, 1, 2, 3, 4, 5, 6, 0}));
+
+  // Package 0's L3 is shared by 0, 1, 4, 5; minus 1's core.
+  EXPECT_EQ(anzu_place_share_llc(&topology, 1, &param), 2);
+  EXPECT_EQ(Cpus(param), (std::vector<int>{0, 4}));
+  EXPECT_EQ(anzu_place_share_llc(&topology, 7, &param), -EINVAL);
+
+  EXPECT_EQ(anzu_place_avoid_smt_sibling(&topology, 6, &param), 5);
+  EXPECT_EQ(Cpus(param), (std::vector<int>{0, 1, 3, 4, 5}));
+  EXPECT_EQ(anzu_place_avoid_smt_sibling(&topology, 8, &param), -EINVAL);
+}
+
+TEST(AnzuSchedParamTest, ThisMachine) {
+  anzu_cpu_topology_t topology;
+  ASSERT_EQ(anzu_get_cpu_topology(nullptr, &topology), 0);
+  const int cpu = anzu_get_current_cpu(0);
+  ASSERT_GE(cpu, 0);
+  EXPECT_TRUE(topology.cpus[cpu].online);
+  // May have migrated since.
+  EXPECT_GE(anzu_get_current_cpu(anzu_gettid()), 0);
+  anzu_sched_param_t param{};
+  EXPECT_GE(anzu_place_share_llc(&topology, cpu, &param), 1);
+}
+
+// Threads reading their own `/proc/<tid>/stat` must not share parse state.
+TEST(AnzuSchedParamTest, CurrentCpuFromManyThreads) {
+  std::vector<int> failures(4);
+  std::vector<std::thread> threads;
+  for (int& count : failures) {
+    threads.emplace_back([&count]() {
+      const pid_t tid = anzu_gettid();
+      for (int i = 0; i < 2000; ++i) {
+        const int cpu = anzu_get_current_cpu(tid);
+        if (cpu < 0 || cpu >= ANZU_NPROC) ++count;
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  EXPECT_EQ(failures, std::vector<int>(4, 0));
+}
+
+}  // namespace
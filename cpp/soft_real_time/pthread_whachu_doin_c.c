@@ -50,7 +50,7 @@ static void* run_get_thread(void* raw) {
 
   anzu_sched_param_t init_param;
   anzu_get_sched_param_from_pid(pid, &init_param);
-  anzu_sched_param_sprintf(buffer, &init_param);
+  anzu_sched_param_snprintf(buffer, sizeof(buffer), &init_param);
   printf("  get(%d) --> %s\n", pid, buffer);
 
   return NULL;
@@ -64,7 +64,7 @@ static void* run_inner_get_thread(void* raw) {
 
   anzu_sched_param_t init_param;
   anzu_get_sched_param_from_pid(pid, &init_param);
-  anzu_sched_param_sprintf(buffer, &init_param);
+  anzu_sched_param_snprintf(buffer, sizeof(buffer), &init_param);
   printf("    get(%d) --> %s\n", pid, buffer);
 
   return NULL;
@@ -78,20 +78,20 @@ static void* run_get_set_get_thread(void* raw) {
 
   anzu_sched_param_t init_param;
   anzu_get_sched_param_from_pid(pid, &init_param);
-  anzu_sched_param_sprintf(buffer, &init_param);
+  anzu_sched_param_snprintf(buffer, sizeof(buffer), &init_param);
   printf("  get(%d) --> %s\n", pid, buffer);
 
   anzu_sched_param_t user_param;
   memset(&user_param, 0, sizeof(anzu_sched_param_t));
   user_param.sched_rr_priority = 30;
   user_param.cpu_affinity[3] = true;
-  anzu_sched_param_sprintf(buffer, &user_param);
+  anzu_sched_param_snprintf(buffer, sizeof(buffer), &user_param);
   printf("  SET(%d): %s\n", pid, buffer);
   anzu_set_sched_param(pid, &user_param);
 
   anzu_sched_param_t post_param;
   anzu_get_sched_param_from_pid(pid, &post_param);
-  anzu_sched_param_sprintf(buffer, &post_param);
+  anzu_sched_param_snprintf(buffer, sizeof(buffer), &post_param);
   printf("  get(%d) --> %s\n", pid, buffer);
 
   run_as_thread(run_inner_get_thread);
@@ -105,7 +105,7 @@ int main(int argc, char** argv) {
 
   anzu_sched_param_t init_param;
   anzu_get_sched_param_from_pid(pid, &init_param);
-  anzu_sched_param_sprintf(buffer, &init_param);
+  anzu_sched_param_snprintf(buffer, sizeof(buffer), &init_param);
   printf("get(%d) --> %s\n", pid, buffer);
 
   run_as_thread(run_get_set_get_thread);
@@ -113,7 +113,7 @@ int main(int argc, char** argv) {
 
   anzu_sched_param_t post_param;
   anzu_get_sched_param_from_pid(pid, &post_param);
-  anzu_sched_param_sprintf(buffer, &post_param);
+  anzu_sched_param_snprintf(buffer, sizeof(buffer), &post_param);
   printf("get(%d) --> %s\n", pid, buffer);
 
   printf("\n");
@@ -122,7 +122,7 @@ int main(int argc, char** argv) {
   memset(&user_param2, 0, sizeof(anzu_sched_param_t));
   user_param2.sched_rr_priority = 20;
   user_param2.cpu_affinity[2] = true;
-  anzu_sched_param_sprintf(buffer, &user_param2);
+  anzu_sched_param_snprintf(buffer, sizeof(buffer), &user_param2);
   printf("SET(%d): %s\n", pid, buffer);
   anzu_set_sched_param(pid, &user_param2);
 
@@ -131,7 +131,7 @@ int main(int argc, char** argv) {
 
   anzu_sched_param_t post_param2;
   anzu_get_sched_param_from_pid(pid, &post_param2);
-  anzu_sched_param_sprintf(buffer, &post_param2);
+  anzu_sched_param_snprintf(buffer, sizeof(buffer), &post_param2);
   printf("get(%d) --> %s\n", pid, buffer);
 
   printf("\n");
@@ -47,6 +47,118 @@ def get_sched_param_from_pid(pid):
     return SchedParam(priority, cpus)
 
 
+class CpuInfo:
+    """Mirrors `anzu_cpu_info_t`: cores / caches are identified by their
+    lowest-numbered CPU."""
+    def __init__(self, package, core, llc, numa_node):
+        self.package = package
+        self.core = core
+        self.llc = llc
+        self.numa_node = numa_node
+
+    def __repr__(self):
+        return (
+            f"CpuInfo(package={self.package}, core={self.core}, "
+            f"llc={self.llc}, numa_node={self.numa_node})"
+        )
+
+
+def _read(path, default=None):
+    try:
+        with open(path) as f:
+            return f.read().strip()
+    except OSError:
+        return default
+
+
+def _parse_cpu_list(text):
+    cpus = []
+    for part in text.split(","):
+        if not part:
+            continue
+        first, _, last = part.partition("-")
+        cpus.extend(range(int(first), int(last or first) + 1))
+    return cpus
+
+
+def get_cpu_topology(sysfs_cpu_dir="/sys/devices/system/cpu"):
+    """Returns {cpu: CpuInfo} for online CPUs, like `anzu_get_cpu_topology`.
+    """
+    topology = {}
+    for cpu in _parse_cpu_list(_read(f"{sysfs_cpu_dir}/online")):
+        base = f"{sysfs_cpu_dir}/cpu{cpu}"
+        package = int(_read(f"{base}/topology/physical_package_id", 0))
+        siblings = _read(f"{base}/topology/core_cpus_list") or _read(
+            f"{base}/topology/thread_siblings_list", str(cpu)
+        )
+        core = min(_parse_cpu_list(siblings))
+        llc, llc_level = cpu, -1
+        index = 0
+        while os.path.isdir(f"{base}/cache/index{index}"):
+            cache = f"{base}/cache/index{index}"
+            index += 1
+            level = int(_read(f"{cache}/level", -1))
+            if _read(f"{cache}/type") == "Instruction" or level <= llc_level:
+                continue
+            llc = min(_parse_cpu_list(_read(f"{cache}/shared_cpu_list")))
+            llc_level = level
+        nodes = [
+            int(name[4:]) for name in os.listdir(base)
+            if name.startswith("node") and name[4:].isdigit()
+        ]
+        numa_node = nodes[0] if nodes else -1
+        topology[cpu] = CpuInfo(package, core, llc, numa_node)
+    return topology
+
+
+def get_current_cpu(pid=0):
+    """The CPU `pid` (a tid; 0 for the caller) last ran on."""
+    if pid == 0:
+        pid = gettid()
+    stat = _read(f"/proc/{pid}/stat")
+    # `processor` is field 39; the command name (field 2) may have spaces.
+    return int(stat[stat.rindex(")") + 2:].split()[39 - 3])
+
+
+# Placement policies, like `anzu_place_*`: each returns the CPUs for
+# `SchedParam.sched_affinity_cpus` ([] if there are none).
+
+
+def place_one_per_core(topology, index):
+    """Thread `index` of a group: one per physical core first, then SMT
+    siblings."""
+    rank = {}
+    per_core = {}
+    for cpu in sorted(topology):
+        core = topology[cpu].core
+        rank[cpu] = per_core.get(core, 0)
+        per_core[core] = rank[cpu] + 1
+    order = sorted(topology, key=lambda cpu: (rank[cpu], cpu))
+    return [order[index % len(order)]] if order else []
+
+
+def place_share_llc(topology, cpu):
+    """CPUs sharing the last-level cache with `cpu`, except its SMT siblings
+    (unless those are all there is)."""
+    target = topology[cpu]
+    cpus = [
+        other for other, info in sorted(topology.items())
+        if info.llc == target.llc and info.core != target.core
+    ]
+    return cpus or [
+        other for other, info in sorted(topology.items())
+        if info.core == target.core
+    ]
+
+
+def place_avoid_smt_sibling(topology, rt_cpu):
+    """Every CPU except `rt_cpu` and its SMT siblings."""
+    rt_core = topology[rt_cpu].core
+    return [
+        cpu for cpu, info in sorted(topology.items()) if info.core != rt_core
+    ]
+
+
 def main():
     pid = 0  # gettid()
     init_param = get_sched_param_from_pid(pid)
@@ -60,6 +172,19 @@ def main():
     print(f"get_sched_param_from_pid({pid}, {post_param})")
     print()
 
+    topology = get_cpu_topology()
+    for cpu, info in topology.items():
+        print(f"cpu {cpu}: {info}")
+    cpu = get_current_cpu()
+    print(f"get_current_cpu() = {cpu}")
+    print(f"place_one_per_core(topology, 1) = "
+          f"{place_one_per_core(topology, 1)}")
+    print(f"place_share_llc(topology, {cpu}) = "
+          f"{place_share_llc(topology, cpu)}")
+    print(f"place_avoid_smt_sibling(topology, {cpu}) = "
+          f"{place_avoid_smt_sibling(topology, cpu)}")
+    print()
+
 
 if __name__ == "__main__":
     main()
@@ -0,0 +1,129 @@
+// `thread_daemon.cc` detaches a `std::thread` ticking forever, which is
+// simply killed at process exit, mid-tick. `BackgroundService` runs the same
+// tick as a periodic task that stops (and is joined) with the service, and
+// shares its threads with any number of other periodic tasks.
+//
+//   thread_daemon_service            # The managed tick.
+//   thread_daemon_service compare N  # N periodic tasks: thread per task vs.
+//                                    # service.
+
+#include <sys/resource.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "background_service.h"
+
+using namespace std::chrono_literals;
+using background::BackgroundService;
+using background::Clock;
+using background::StopToken;
+
+namespace {
+
+double CpuSeconds() {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+         (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+long ContextSwitches() {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_nvcsw + usage.ru_nivcsw;
+}
+
+void Report(const char* what, int threads, int64_t ticks, double cpu,
+            long switches) {
+  std::cout << what << ": " << threads << " threads, " << ticks << " ticks, "
+            << cpu * 1e3 << " ms CPU, " << switches << " context switches\n";
+}
+
+void Compare(int num_tasks, Clock::duration period, Clock::duration run_for) {
+  {
+    std::atomic<bool> stop{false};
+    std::atomic<int64_t> ticks{0};
+    const double cpu = CpuSeconds();
+    const long switches = ContextSwitches();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_tasks; ++i) {
+      threads.emplace_back([&]() {
+        Clock::time_point next = Clock::now() + period;
+        while (!stop) {
+          std::this_thread::sleep_until(next);
+          next += period;
+          ++ticks;
+        }
+      });
+    }
+    std::this_thread::sleep_for(run_for);
+    stop = true;
+    for (std::thread& thread : threads) thread.join();
+    Report("thread per task", num_tasks, ticks, CpuSeconds() - cpu,
+           ContextSwitches() - switches);
+  }
+  {
+    std::atomic<int64_t> ticks{0};
+    const double cpu = CpuSeconds();
+    const long switches = ContextSwitches();
+    BackgroundService::Options options;
+    BackgroundService service(options);
+    for (int i = 0; i < num_tasks; ++i) {
+      service.SchedulePeriodic("task" + std::to_string(i), period,
+                               [&](const StopToken&) {
+                                 ++ticks;
+                                 return true;
+                               });
+    }
+    std::this_thread::sleep_for(run_for);
+    service.Stop(1s);
+    // Pool threads plus the timer thread.
+    Report("BackgroundService", options.num_threads + 1, ticks,
+           CpuSeconds() - cpu, ContextSwitches() - switches);
+    int64_t missed = 0;
+    Clock::duration max_lateness{};
+    for (const auto& stats : service.Stats()) {
+      missed += stats.missed;
+      max_lateness = std::max(max_lateness, stats.max_lateness);
+    }
+    std::cout << "  missed " << missed << ", max lateness "
+              << std::chrono::duration<double, std::milli>(max_lateness).count()
+              << " ms\n";
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc >= 2 && std::strcmp(argv[1], "compare") == 0) {
+    const int num_tasks = argc >= 3 ? std::atoi(argv[2]) : 500;
+    Compare(num_tasks, 10ms, 2s);
+    return 0;
+  }
+
+  BackgroundService service;
+  service.SchedulePeriodic("tick", 100ms, [](const StopToken&) {
+    std::cerr << "Tick\n";
+    return true;
+  });
+  std::this_thread::sleep_for(350ms);
+  // Unlike the detached thread, no tick is cut off half way.
+  service.Stop(1s);
+  for (const auto& stats : service.Stats()) {
+    std::cout << stats.name << ": " << stats.wakeups << " wakeups, "
+              << std::chrono::duration<double, std::micro>(stats.cpu_time)
+                     .count()
+              << " us CPU\n";
+  }
+
+  std::cout << "Finish\n";
+
+  return 0;
+}
@@ -0,0 +1,260 @@
+#pragma once
+
+// Runtime counterpart of the compile-time `impl(...)` overload selection in
+// `main.cc`: arguments arrive type-erased (e.g. from a binding layer), and
+// the overload is found from the tuple of their type IDs.
+
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include "cpp/name_trait.h"
+#include "cpp/type_pack.h"
+
+namespace variadic_dispatch {
+
+typedef size_t TypeId;
+
+// `type_hash<T>()`, computed once per type (it hashes the type's name).
+// Distinct types may collide, so matches also compare `std::type_info`.
+template <typename T>
+TypeId type_id() {
+  static const TypeId id = type_hash<T>();
+  return id;
+}
+
+// A type-erased argument. Does not own `value`.
+struct Arg {
+  TypeId type;
+  const std::type_info* info;
+  const void* value;
+  std::string (*type_name)();
+
+  template <typename T>
+  static Arg Of(const T& value) {
+    return {type_id<T>(), &typeid(T), &value, &nice_type_name<T>};
+  }
+
+  // `value` must outlive the `Arg`.
+  template <typename T>
+  static Arg Of(const T&&) = delete;
+};
+
+constexpr size_t kMaxArity = 8;
+
+// Overloads registered by exact (decayed) argument types. Each signature is
+// indexed in an open-addressing table (linear probing, at most half full)
+// keyed by a hash of its type IDs, so resolving is O(1) in the number of
+// overloads; on a hash match the `std::type_info`s are compared as well.
+// Adding is not thread-safe; resolving and calling are `const`.
+template <typename Result>
+class DispatchRegistry {
+ public:
+  // Unpacks `args` and calls the registered function (`func`, if any).
+  typedef Result (*Invoker)(void (*func)(), const Arg* args);
+
+  struct Overload {
+    size_t arity{};
+    std::array<TypeId, kMaxArity> types{};
+    std::array<const std::type_info*, kMaxArity> infos{};
+    std::string signature;
+    Invoker invoke{};
+    void (*func)(){};
+
+    Result operator()(const Arg* args) const { return invoke(func, args); }
+  };
+
+  DispatchRegistry() : slots_(kMinSlots) {}
+
+  template <typename... Args>
+  void Add(Result (*func)(Args...)) {
+    AddErased<Args...>(&InvokeFunction<Args...>,
+                       reinterpret_cast<void (*)()>(func));
+  }
+
+  // Registers the stateless functor `F` for each `type_pack<Args...>` in
+  // `Signatures`, e.g. a functor forwarding to an `impl(...)` overload set.
+  template <typename F, typename... Signatures>
+  void AddOverloads(F, Signatures...) {
+    static_assert(std::is_empty<F>::value &&
+                      std::is_default_constructible<F>::value,
+                  "F must be a stateless functor");
+    (AddSignature<F>(Signatures{}), ...);
+  }
+
+  // Returns nullptr if no overload matches.
+  const Overload* Resolve(const Arg* args, size_t n) const {
+    const size_t mask = slots_.size() - 1;
+    const size_t hash = Hash(args, n);
+    for (size_t i = hash & mask; slots_[i].index >= 0; i = (i + 1) & mask) {
+      const Slot& slot = slots_[i];
+      if (slot.hash == hash && Matches(overloads_[slot.index], args, n)) {
+        return &overloads_[slot.index];
+      }
+    }
+    return nullptr;
+  }
+
+  // Same result as `Resolve`, by checking each overload in turn.
+  const Overload* ResolveLinear(const Arg* args, size_t n) const {
+    for (const Overload& overload : overloads_) {
+      if (Matches(overload, args, n)) return &overload;
+    }
+    return nullptr;
+  }
+
+  Result Call(const Arg* args, size_t n) const {
+    const Overload* overload = Resolve(args, n);
+    if (!overload) {
+      throw std::invalid_argument(NoOverloadMessage(args, n));
+    }
+    return (*overload)(args);
+  }
+
+  Result Call(std::initializer_list<Arg> args) const {
+    return Call(args.begin(), args.size());
+  }
+
+  template <typename... Ts>
+  Result operator()(const Ts&... args) const {
+    const std::array<Arg, sizeof...(Ts)> erased{{Arg::Of(args)...}};
+    return Call(erased.data(), erased.size());
+  }
+
+  const std::vector<Overload>& overloads() const { return overloads_; }
+
+ private:
+  static constexpr size_t kMinSlots = 16;
+
+  struct Slot {
+    size_t hash{};
+    int index{-1};
+  };
+
+  template <typename... Args, typename Func, size_t... Is>
+  static Result Unpack(Func&& func, const Arg* args,
+                       std::index_sequence<Is...>) {
+    return func(*static_cast<const std::decay_t<Args>*>(args[Is].value)...);
+  }
+
+  template <typename... Args>
+  static Result InvokeFunction(void (*func)(), const Arg* args) {
+    return Unpack<Args...>(reinterpret_cast<Result (*)(Args...)>(func), args,
+                           std::index_sequence_for<Args...>{});
+  }
+
+  template <typename F, typename... Args>
+  static Result InvokeFunctor(void (*)(), const Arg* args) {
+    return Unpack<Args...>(F{}, args, std::index_sequence_for<Args...>{});
+  }
+
+  template <typename F, typename... Args>
+  void AddSignature(type_pack<Args...>) {
+    AddErased<Args...>(&InvokeFunctor<F, Args...>, nullptr);
+  }
+
+  template <typename... Args>
+  void AddErased(Invoker invoke, void (*func)()) {
+    static_assert(sizeof...(Args) <= kMaxArity, "Too many arguments");
+    Overload overload;
+    overload.arity = sizeof...(Args);
+    overload.types = {{type_id<std::decay_t<Args>>()...}};
+    overload.infos = {{&typeid(std::decay_t<Args>)...}};
+    overload.signature =
+        JoinNames({nice_type_name<std::decay_t<Args>>()...});
+    overload.invoke = invoke;
+    overload.func = func;
+    for (const Overload& existing : overloads_) {
+      if (SameTypes(existing, overload.infos.data(), overload.arity)) {
+        throw std::logic_error(
+            "Overload already registered: " + overload.signature);
+      }
+    }
+    overloads_.push_back(std::move(overload));
+    if (2 * overloads_.size() > slots_.size()) {
+      Rehash(2 * slots_.size());
+    } else {
+      Insert(overloads_.size() - 1);
+    }
+  }
+
+  static size_t Combine(size_t hash, TypeId type) {
+    return hash ^ (type + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2));
+  }
+
+  static size_t Hash(const Arg* args, size_t n) {
+    size_t hash = n;
+    for (size_t i = 0; i < n; ++i) hash = Combine(hash, args[i].type);
+    return hash;
+  }
+
+  static bool SameTypes(const Overload& overload,
+                        const std::type_info* const* infos, size_t n) {
+    if (overload.arity != n) return false;
+    for (size_t i = 0; i < n; ++i) {
+      if (*overload.infos[i] != *infos[i]) return false;
+    }
+    return true;
+  }
+
+  static bool Matches(const Overload& overload, const Arg* args, size_t n) {
+    if (overload.arity != n) return false;
+    for (size_t i = 0; i < n; ++i) {
+      if (overload.types[i] != args[i].type ||
+          *overload.infos[i] != *args[i].info) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void Insert(size_t index) {
+    const Overload& overload = overloads_[index];
+    const size_t mask = slots_.size() - 1;
+    size_t hash = overload.arity;
+    for (size_t k = 0; k < overload.arity; ++k) {
+      hash = Combine(hash, overload.types[k]);
+    }
+    size_t i = hash & mask;
+    while (slots_[i].index >= 0) i = (i + 1) & mask;
+    slots_[i] = Slot{hash, static_cast<int>(index)};
+  }
+
+  void Rehash(size_t num_slots) {
+    slots_.assign(num_slots, Slot{});
+    for (size_t i = 0; i < overloads_.size(); ++i) Insert(i);
+  }
+
+  static std::string JoinNames(std::initializer_list<std::string> names) {
+    std::string out = "(";
+    for (const std::string& name : names) {
+      if (out.size() > 1) out += ", ";
+      out += name;
+    }
+    return out + ")";
+  }
+
+  std::string NoOverloadMessage(const Arg* args, size_t n) const {
+    std::string out = "No overload for (";
+    for (size_t i = 0; i < n; ++i) {
+      if (i > 0) out += ", ";
+      out += args[i].type_name();
+    }
+    out += "); registered:";
+    for (const Overload& overload : overloads_) {
+      out += " " + overload.signature;
+    }
+    return out;
+  }
+
+  std::vector<Overload> overloads_;
+  std::vector<Slot> slots_;
+};
+
+}  // namespace variadic_dispatch
@@ -0,0 +1,81 @@
+// Resolving a type-erased call against N overloads: `DispatchRegistry`'s
+// open-addressing table vs. checking each overload in turn.
+//
+//   bazel run //cpp/variadic_dispatch:dispatch_registry_bench
+
+#include "benchmark/benchmark.h"
+
+#include <array>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "cpp/variadic_dispatch/dispatch_registry.h"
+
+using variadic_dispatch::Arg;
+using variadic_dispatch::DispatchRegistry;
+
+namespace {
+
+template <size_t K>
+struct Tag {
+  int value{static_cast<int>(K)};
+};
+
+struct sum {
+  template <size_t K>
+  int operator()(Tag<K> tag, int x) const { return tag.value + x; }
+};
+
+// N overloads `(Tag<K>, int)`, and one call of each.
+template <size_t N>
+class Overloads {
+ public:
+  Overloads() { Init(std::make_index_sequence<N>{}); }
+
+  const DispatchRegistry<int>& registry() const { return registry_; }
+  const std::vector<std::array<Arg, 2>>& calls() const { return calls_; }
+
+ private:
+  template <size_t... Ks>
+  void Init(std::index_sequence<Ks...>) {
+    registry_.AddOverloads(sum{}, type_pack<Tag<Ks>, int>{}...);
+    calls_ = {{{Arg::Of(std::get<Ks>(tags_)), Arg::Of(x_)}}...};
+  }
+
+  template <size_t... Ks>
+  static std::tuple<Tag<Ks>...> MakeTags(std::index_sequence<Ks...>);
+
+  DispatchRegistry<int> registry_;
+  decltype(MakeTags(std::make_index_sequence<N>{})) tags_;
+  int x_{1};
+  std::vector<std::array<Arg, 2>> calls_;
+};
+
+// Calls each overload in turn, so linear probing averages N / 2 checks.
+template <size_t N, bool kLinear>
+void BM_Dispatch(benchmark::State& state) {
+  const Overloads<N> overloads;
+  const DispatchRegistry<int>& registry = overloads.registry();
+  while (state.KeepRunning()) {
+    for (const auto& call : overloads.calls()) {
+      const auto* overload = kLinear ? registry.ResolveLinear(call.data(), 2)
+                                     : registry.Resolve(call.data(), 2);
+      benchmark::DoNotOptimize((*overload)(call.data()));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * N);
+}
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_Dispatch, 5, true);
+BENCHMARK_TEMPLATE(BM_Dispatch, 5, false);
+BENCHMARK_TEMPLATE(BM_Dispatch, 10, true);
+BENCHMARK_TEMPLATE(BM_Dispatch, 10, false);
+BENCHMARK_TEMPLATE(BM_Dispatch, 25, true);
+BENCHMARK_TEMPLATE(BM_Dispatch, 25, false);
+BENCHMARK_TEMPLATE(BM_Dispatch, 50, true);
+BENCHMARK_TEMPLATE(BM_Dispatch, 50, false);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,120 @@
+#include "cpp/variadic_dispatch/dispatch_registry.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <gtest/gtest.h>
+
+namespace variadic_dispatch {
+namespace {
+
+using std::string;
+
+// As the `impl(...)` prototypes in `main.cc`.
+string impl(int, int) { return "impl(int, int)"; }
+string impl(double) { return "impl(double)"; }
+template <typename T>
+string impl(std::shared_ptr<T> ptr) {
+  return "impl(shared_ptr) " + std::to_string(*ptr);
+}
+
+struct impl_overloads {
+  template <typename... Ts>
+  string operator()(Ts... args) const { return impl(args...); }
+};
+
+string concat(const string& a, const string& b) { return a + b; }
+
+TEST(DispatchRegistryTest, OverloadSet) {
+  DispatchRegistry<string> registry;
+  registry.AddOverloads(
+      impl_overloads{}, type_pack<int, int>{}, type_pack<double>{},
+      type_pack<std::shared_ptr<int>>{});
+  EXPECT_EQ(registry(1, 2), "impl(int, int)");
+  EXPECT_EQ(registry(1.5), "impl(double)");
+  EXPECT_EQ(registry(std::make_shared<int>(10)), "impl(shared_ptr) 10");
+
+  // Exact types only; no conversions.
+  try {
+    registry(1);
+    FAIL();
+  } catch (const std::invalid_argument& e) {
+    EXPECT_EQ(string(e.what()),
+              "No overload for (int); registered: (int, int) (double) "
+              "(std::shared_ptr<int>)");
+  }
+  EXPECT_THROW(registry(1, 2.), std::invalid_argument);
+  EXPECT_THROW(registry(), std::invalid_argument);
+  EXPECT_THROW(registry.AddOverloads(impl_overloads{}, type_pack<double>{}),
+               std::logic_error);
+}
+
+TEST(DispatchRegistryTest, FunctionPointer) {
+  DispatchRegistry<string> registry;
+  // Reference parameters match decayed argument types.
+  registry.Add(&concat);
+  const string a = "a";
+  const string b = "b";
+  const Arg args[] = {Arg::Of(a), Arg::Of(b)};
+  const auto* overload = registry.Resolve(args, 2);
+  ASSERT_NE(overload, nullptr);
+  EXPECT_EQ(overload, registry.ResolveLinear(args, 2));
+  EXPECT_EQ((*overload)(args), "ab");
+  const string name = nice_type_name<string>();
+  EXPECT_EQ(overload->signature, "(" + name + ", " + name + ")");
+}
+
+template <int K>
+struct Tag {};
+
+struct arity_sum {
+  template <typename... Ts>
+  int operator()(Ts...) const { return sizeof...(Ts); }
+};
+
+template <size_t... Ks>
+void AddTags(DispatchRegistry<int>* registry, std::index_sequence<Ks...>) {
+  registry->AddOverloads(arity_sum{}, type_pack<Tag<Ks>>{}...,
+                         type_pack<Tag<Ks>, Tag<Ks>>{}...);
+}
+
+template <size_t... Ks>
+void CheckTags(const DispatchRegistry<int>& registry,
+               std::index_sequence<Ks...>) {
+  const auto check = [&registry](auto tag) {
+    const Arg one[] = {Arg::Of(tag)};
+    const Arg two[] = {Arg::Of(tag), Arg::Of(tag)};
+    EXPECT_EQ(registry.Resolve(one, 1), registry.ResolveLinear(one, 1));
+    EXPECT_EQ(registry.Resolve(two, 2), registry.ResolveLinear(two, 2));
+    EXPECT_EQ(registry.Call(one, 1), 1);
+    EXPECT_EQ(registry.Call(two, 2), 2);
+  };
+  (check(Tag<Ks>{}), ...);
+}
+
+TEST(DispatchRegistryTest, ManyOverloads) {
+  // Grows the table several times.
+  DispatchRegistry<int> registry;
+  AddTags(&registry, std::make_index_sequence<50>{});
+  EXPECT_EQ(registry.overloads().size(), 100u);
+  CheckTags(registry, std::make_index_sequence<50>{});
+  const Tag<0> tag;
+  const Arg three[] = {Arg::Of(tag), Arg::Of(tag), Arg::Of(tag)};
+  EXPECT_EQ(registry.Resolve(three, 3), nullptr);
+}
+
+TEST(DispatchRegistryTest, HashCollision) {
+  DispatchRegistry<string> registry;
+  registry.AddOverloads(impl_overloads{}, type_pack<double>{});
+  // A `float` whose type ID collides with `double`'s.
+  const float value = 1.5f;
+  Arg arg = Arg::Of(value);
+  arg.type = type_id<double>();
+  EXPECT_EQ(registry.Resolve(&arg, 1), nullptr);
+  EXPECT_EQ(registry.ResolveLinear(&arg, 1), nullptr);
+  EXPECT_THROW(registry.Call(&arg, 1), std::invalid_argument);
+}
+
+}  // namespace
+}  // namespace variadic_dispatch
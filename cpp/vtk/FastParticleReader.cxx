@@ -0,0 +1,44 @@
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include <vtkSmartPointer.h>
+#include <vtkVersion.h>
+#include <vtkXMLPolyDataWriter.h>
+
+#include "fast_particle_reader.h"
+
+// `ParticleReader.cxx` with `ReadParticlesFast` in place of
+// `vtkParticleReader`; same output.
+
+int main(int argc, char* argv[]) {
+  if (argc != 3 && argc != 4) {
+    std::cerr << "Usage: " << argv[0]
+              << " InputFile(csv) OutputFile(vtp) [num_threads]" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string inputFileName = argv[1];
+  const std::string outputFileName = argv[2];
+  const int numThreads = argc == 4 ? std::atoi(argv[3]) : 0;
+
+  vtkSmartPointer<vtkPolyData> particles;
+  try {
+    particles = ReadParticlesFast(inputFileName, numThreads);
+  } catch (const std::runtime_error& e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  vtkSmartPointer<vtkXMLPolyDataWriter> writer =
+    vtkSmartPointer<vtkXMLPolyDataWriter>::New();
+#if VTK_MAJOR_VERSION <= 5
+  writer->SetInput(particles);
+#else
+  writer->SetInputData(particles);
+#endif
+  writer->SetFileName(outputFileName.c_str());
+  writer->Write();
+
+  return EXIT_SUCCESS;
+}
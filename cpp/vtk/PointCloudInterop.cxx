@@ -0,0 +1,64 @@
+#include <cstdio>
+#include <cstdlib>
+
+#include <Eigen/Dense>
+#include <vtkFloatArray.h>
+#include <vtkPointData.h>
+#include <vtkPointSource.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include "mapped_vtp.h"
+#include "vtk_eigen.h"
+
+// Zero-copy version of `ReadWritePoly.cxx`: edit VTK points through Eigen,
+// wrap an Eigen cloud as VTK points, and write / map an appended-raw VTP.
+
+using vtk_eigen::MapDataArray;
+using vtk_eigen::MapPoints;
+
+int main() {
+  // Create a point cloud.
+  vtkSmartPointer<vtkPointSource> pointSource =
+    vtkSmartPointer<vtkPointSource>::New();
+  pointSource->SetCenter(0.0, 0.0, 0.0);
+  pointSource->SetNumberOfPoints(50);
+  pointSource->SetRadius(5.0);
+  pointSource->SetOutputPointsPrecision(vtkAlgorithm::SINGLE_PRECISION);
+  pointSource->Update();
+  vtkPolyData* poly = pointSource->GetOutput();
+
+  // VTK -> Eigen: recenter in place.
+  Eigen::Map<Eigen::Matrix3Xf> xyz = MapPoints(poly->GetPoints());
+  xyz.colwise() -= Eigen::Vector3f(xyz.rowwise().mean());
+  double p[3];
+  poly->GetPoint(0, p);
+  if (p[0] != xyz(0, 0)) {
+    std::fprintf(stderr, "Map is not a view\n");
+    return EXIT_FAILURE;
+  }
+
+  // Eigen -> VTK: per-point range, stored in `range`.
+  Eigen::RowVectorXf range = xyz.colwise().norm();
+  vtkSmartPointer<vtkDataArray> range_array =
+    vtk_eigen::MakeDataArrayView<float>(range);
+  range_array->SetName("range");
+  poly->GetPointData()->AddArray(range_array);
+
+  // Write, then map the file back.
+  const char* filename = "test_raw.vtp";
+  if (!vtk_eigen::WriteAppendedRawVtp(poly, filename)) {
+    std::fprintf(stderr, "Cannot write %s\n", filename);
+    return EXIT_FAILURE;
+  }
+  vtk_eigen::MappedVtp mapped(filename);
+  if (mapped.points() != xyz ||
+      mapped.point_data<float>("range") != range) {
+    std::fprintf(stderr, "Round trip mismatch\n");
+    return EXIT_FAILURE;
+  }
+  std::printf("%ld points, mean range %g\n",
+              static_cast<long>(mapped.num_points()),
+              mapped.point_data<float>("range").mean());
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,269 @@
+#include "fast_icp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <Eigen/Eigenvalues>
+#include <Eigen/SVD>
+
+namespace fast_icp {
+namespace {
+
+// Points per thread below which more threads do not pay off.
+constexpr int kMinPointsPerThread = 2048;
+
+int NumThreads(int requested, int num_points) {
+  const int threads = requested > 0 ? requested :
+      static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  return std::max(1, std::min(threads, num_points / kMinPointsPerThread));
+}
+
+// Runs `f(thread, begin, end)` over even slices of [0, n) on `num_threads`
+// threads (the calling one included).
+template <typename Func>
+void ParallelFor(int num_threads, int n, Func&& f) {
+  auto run = [&](int t) {
+    f(t, static_cast<int>(int64_t(n) * t / num_threads),
+      static_cast<int>(int64_t(n) * (t + 1) / num_threads));
+  };
+  std::vector<std::thread> threads;
+  for (int t = 1; t < num_threads; ++t) {
+    threads.emplace_back(run, t);
+  }
+  run(0);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+struct PointToPointSums {
+  int count{0};
+  double squared_error{0};
+  Eigen::Vector3d source{Eigen::Vector3d::Zero()};
+  Eigen::Vector3d target{Eigen::Vector3d::Zero()};
+  Eigen::Matrix3d cross{Eigen::Matrix3d::Zero()};
+};
+
+struct PointToPlaneSums {
+  int count{0};
+  double squared_error{0};
+  Eigen::Matrix<double, 6, 6> ata{Eigen::Matrix<double, 6, 6>::Zero()};
+  Eigen::Matrix<double, 6, 1> atb{Eigen::Matrix<double, 6, 1>::Zero()};
+};
+
+// Kabsch: the rotation + translation best taking the source to the target
+// points in the least-squares sense.
+Eigen::Isometry3d SolvePointToPoint(const PointToPointSums& sums) {
+  const Eigen::Vector3d source_mean = sums.source / sums.count;
+  const Eigen::Vector3d target_mean = sums.target / sums.count;
+  const Eigen::Matrix3d covariance =
+      sums.cross - sums.count * source_mean * target_mean.transpose();
+  Eigen::JacobiSVD<Eigen::Matrix3d> svd(
+      covariance, Eigen::ComputeFullU | Eigen::ComputeFullV);
+  Eigen::Matrix3d d = Eigen::Matrix3d::Identity();
+  d(2, 2) = (svd.matrixV() * svd.matrixU().transpose()).determinant() < 0 ?
+      -1 : 1;
+  Eigen::Isometry3d delta = Eigen::Isometry3d::Identity();
+  delta.linear() = svd.matrixV() * d * svd.matrixU().transpose();
+  delta.translation() = target_mean - delta.linear() * source_mean;
+  return delta;
+}
+
+// Linearized point-to-plane step (small rotation angles).
+Eigen::Isometry3d SolvePointToPlane(const PointToPlaneSums& sums) {
+  const Eigen::Matrix<double, 6, 1> x = sums.ata.ldlt().solve(sums.atb);
+  const Eigen::Vector3d rotation = x.head<3>();
+  Eigen::Isometry3d delta = Eigen::Isometry3d::Identity();
+  const double angle = rotation.norm();
+  if (angle > 0) {
+    delta.linear() =
+        Eigen::AngleAxisd(angle, rotation / angle).toRotationMatrix();
+  }
+  delta.translation() = x.tail<3>();
+  return delta;
+}
+
+}  // namespace
+
+Eigen::Matrix3Xf EstimateNormals(
+    const Eigen::Matrix3Xf& points, const KdTree3f& tree, int k,
+    int num_threads) {
+  const int n = static_cast<int>(points.cols());
+  Eigen::Matrix3Xf normals(3, n);
+  ParallelFor(NumThreads(num_threads, n), n, [&](int, int begin, int end) {
+    std::vector<int> neighbors(k);
+    std::vector<float> distances(k);
+    for (int i = begin; i < end; ++i) {
+      const int found =
+          tree.Knn(points.col(i), k, neighbors.data(), distances.data());
+      Eigen::Vector3f mean = Eigen::Vector3f::Zero();
+      for (int j = 0; j < found; ++j) mean += points.col(neighbors[j]);
+      mean /= std::max(1, found);
+      Eigen::Matrix3f covariance = Eigen::Matrix3f::Zero();
+      for (int j = 0; j < found; ++j) {
+        const Eigen::Vector3f d = points.col(neighbors[j]) - mean;
+        covariance += d * d.transpose();
+      }
+      Eigen::SelfAdjointEigenSolver<Eigen::Matrix3f> solver;
+      solver.computeDirect(covariance);
+      // Eigenvalues are increasing.
+      normals.col(i) = solver.eigenvectors().col(0);
+    }
+  });
+  return normals;
+}
+
+Icp::Icp(const Eigen::Matrix3Xf& target,
+         const Eigen::Matrix3Xf& target_normals, int normal_neighbors)
+    : target_(target), tree_(target), target_normals_(target_normals) {
+  if (target_normals_.cols() != 0 &&
+      target_normals_.cols() != target_.cols()) {
+    throw std::invalid_argument("Icp: one normal per target point needed");
+  }
+  if (target_normals_.cols() == 0 && normal_neighbors > 0) {
+    target_normals_ = EstimateNormals(target_, tree_, normal_neighbors);
+  }
+}
+
+IcpResult Icp::Align(
+    const Eigen::Matrix3Xf& source, const IcpOptions& options,
+    const Eigen::Isometry3d& initial) const {
+  const bool point_to_plane = options.metric == IcpMetric::kPointToPlane;
+  if (point_to_plane && target_normals_.cols() == 0) {
+    throw std::invalid_argument("Icp: point-to-plane needs target normals");
+  }
+  IcpResult result;
+  result.transform = initial;
+  const int n = static_cast<int>(source.cols());
+  if (n == 0 || target_.cols() == 0) {
+    return result;
+  }
+  if (options.start_by_matching_centroids) {
+    const Eigen::Vector3d source_mean =
+        result.transform * source.rowwise().mean().cast<double>();
+    result.transform.pretranslate(
+        target_.rowwise().mean().cast<double>() - source_mean);
+  }
+  const int num_threads = NumThreads(options.num_threads, n);
+  const float max_distance_squared = static_cast<float>(
+      options.max_correspondence_distance *
+      options.max_correspondence_distance);
+
+  Eigen::Matrix3Xf moved(3, n);
+  std::vector<int> matches(n, -1);
+  std::vector<float> distances(n);
+  std::vector<float> kept;
+  std::vector<PointToPointSums> point_sums(num_threads);
+  std::vector<PointToPlaneSums> plane_sums(num_threads);
+  for (int iteration = 1; iteration <= options.max_iterations; ++iteration) {
+    // Correspondences.
+    const Eigen::Affine3f transform(result.transform.cast<float>());
+    ParallelFor(num_threads, n, [&](int, int begin, int end) {
+      for (int i = begin; i < end; ++i) {
+        moved.col(i) = transform * source.col(i);
+        matches[i] = tree_.Nearest(
+            moved.col(i), matches[i], &distances[i], max_distance_squared);
+      }
+    });
+
+    // Trimming: keep correspondences up to the `trim_fraction` quantile.
+    float threshold = max_distance_squared;
+    if (options.trim_fraction < 1) {
+      kept.clear();
+      for (int i = 0; i < n; ++i) {
+        if (matches[i] >= 0) kept.push_back(distances[i]);
+      }
+      const size_t keep = static_cast<size_t>(
+          std::ceil(options.trim_fraction * kept.size()));
+      if (keep > 0 && keep < kept.size()) {
+        std::nth_element(kept.begin(), kept.begin() + keep - 1, kept.end());
+        threshold = kept[keep - 1];
+      }
+    }
+
+    // Normal equations, per thread.
+    ParallelFor(num_threads, n, [&](int t, int begin, int end) {
+      if (point_to_plane) {
+        PointToPlaneSums sums;
+        for (int i = begin; i < end; ++i) {
+          if (matches[i] < 0 || distances[i] > threshold) continue;
+          const Eigen::Vector3d p = moved.col(i).cast<double>();
+          const Eigen::Vector3d q = target_.col(matches[i]).cast<double>();
+          const Eigen::Vector3d normal =
+              target_normals_.col(matches[i]).cast<double>();
+          Eigen::Matrix<double, 6, 1> a;
+          a << p.cross(normal), normal;
+          const double r = (q - p).dot(normal);
+          sums.ata.selfadjointView<Eigen::Lower>().rankUpdate(a);
+          sums.atb += a * r;
+          sums.squared_error += r * r;
+          ++sums.count;
+        }
+        plane_sums[t] = sums;
+      } else {
+        PointToPointSums sums;
+        for (int i = begin; i < end; ++i) {
+          if (matches[i] < 0 || distances[i] > threshold) continue;
+          const Eigen::Vector3d p = moved.col(i).cast<double>();
+          const Eigen::Vector3d q = target_.col(matches[i]).cast<double>();
+          sums.source += p;
+          sums.target += q;
+          sums.cross += p * q.transpose();
+          sums.squared_error += distances[i];
+          ++sums.count;
+        }
+        point_sums[t] = sums;
+      }
+    });
+
+    Eigen::Isometry3d delta;
+    int count = 0;
+    double squared_error = 0;
+    if (point_to_plane) {
+      PointToPlaneSums total;
+      for (const PointToPlaneSums& sums : plane_sums) {
+        total.count += sums.count;
+        total.squared_error += sums.squared_error;
+        total.ata += sums.ata;
+        total.atb += sums.atb;
+      }
+      total.ata.triangularView<Eigen::StrictlyUpper>() =
+          total.ata.transpose();
+      count = total.count;
+      squared_error = total.squared_error;
+      if (count < 6) break;
+      delta = SolvePointToPlane(total);
+    } else {
+      PointToPointSums total;
+      for (const PointToPointSums& sums : point_sums) {
+        total.count += sums.count;
+        total.squared_error += sums.squared_error;
+        total.source += sums.source;
+        total.target += sums.target;
+        total.cross += sums.cross;
+      }
+      count = total.count;
+      squared_error = total.squared_error;
+      if (count < 3) break;
+      delta = SolvePointToPoint(total);
+    }
+
+    result.transform = delta * result.transform;
+    result.iterations = iteration;
+    result.num_correspondences = count;
+    result.rms_error = std::sqrt(squared_error / count);
+    if (Eigen::AngleAxisd(delta.linear()).angle() <
+            options.min_rotation_delta &&
+        delta.translation().norm() < options.min_translation_delta) {
+      result.converged = true;
+      break;
+    }
+  }
+  return result;
+}
+
+}  // namespace fast_icp
@@ -0,0 +1,97 @@
+#pragma once
+
+// Rigid ICP against a fixed target, for per-frame registration:
+//
+//   fast_icp::Icp icp(target_xyz, target_normals);  // KD-tree built once.
+//   fast_icp::IcpOptions options;
+//   options.metric = fast_icp::IcpMetric::kPointToPlane;
+//   fast_icp::IcpResult result = icp.Align(source_xyz, options);
+//   // result.transform takes source points onto the target.
+//
+// Compared to `vtkIterativeClosestPointTransform` (rigid body mode), this
+// searches correspondences with a static KD-tree (see `kd_tree.h`) on all
+// threads, uses every source point instead of a subsample of landmarks,
+// optionally minimizes point-to-plane error, can trim the worst
+// correspondences, and stops once an iteration moves the source less than a
+// threshold. See `vtk_icp.h` for a `vtkPolyData` front end.
+
+#include <limits>
+
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+
+#include "kd_tree.h"
+
+namespace fast_icp {
+
+enum class IcpMetric {
+  // Sum of squared distances to the matched target points (as VTK).
+  kPointToPoint,
+  // Sum of squared distances to the matched target points' tangent planes;
+  // needs target normals. Usually converges in far fewer iterations on
+  // surfaces.
+  kPointToPlane,
+};
+
+struct IcpOptions {
+  IcpMetric metric{IcpMetric::kPointToPoint};
+  int max_iterations{50};
+  // Stop once an iteration's update rotates by less than
+  // `min_rotation_delta` (radians) and translates by less than
+  // `min_translation_delta`.
+  double min_rotation_delta{1e-5};
+  double min_translation_delta{1e-5};
+  // Keep only this fraction of correspondences, the closest ones (trimmed
+  // ICP); 1 keeps all.
+  double trim_fraction{1.0};
+  // Ignore correspondences farther apart than this.
+  double max_correspondence_distance{std::numeric_limits<double>::infinity()};
+  // Translate the source centroid onto the target centroid first.
+  bool start_by_matching_centroids{false};
+  // 0 uses all cores.
+  int num_threads{0};
+};
+
+struct IcpResult {
+  // Takes source points onto the target.
+  Eigen::Isometry3d transform{Eigen::Isometry3d::Identity()};
+  int iterations{0};
+  // Whether the delta thresholds were met before `max_iterations`.
+  bool converged{false};
+  // RMS distance (for the chosen metric) over the kept correspondences of
+  // the last iteration.
+  double rms_error{0};
+  int num_correspondences{0};
+};
+
+class Icp {
+ public:
+  // `target_normals` (unit, 3 x N) are needed for `kPointToPlane`. If empty
+  // and `normal_neighbors` > 0, they are estimated from that many nearest
+  // target points.
+  explicit Icp(const Eigen::Matrix3Xf& target,
+               const Eigen::Matrix3Xf& target_normals = Eigen::Matrix3Xf(),
+               int normal_neighbors = 0);
+
+  // Thread-safe. Throws `std::invalid_argument` for `kPointToPlane` without
+  // target normals.
+  IcpResult Align(
+      const Eigen::Matrix3Xf& source, const IcpOptions& options,
+      const Eigen::Isometry3d& initial = Eigen::Isometry3d::Identity()) const;
+
+  const KdTree3f& tree() const { return tree_; }
+  const Eigen::Matrix3Xf& target_normals() const { return target_normals_; }
+
+ private:
+  Eigen::Matrix3Xf target_;
+  KdTree3f tree_;
+  Eigen::Matrix3Xf target_normals_;
+};
+
+// Unit normals of `points` by PCA over their `k` nearest neighbors in `tree`
+// (built over `points`), oriented arbitrarily.
+Eigen::Matrix3Xf EstimateNormals(
+    const Eigen::Matrix3Xf& points, const KdTree3f& tree, int k,
+    int num_threads = 0);
+
+}  // namespace fast_icp
@@ -0,0 +1,118 @@
+// Rigid ICP on a noisy surface moved by a small rotation / translation:
+// `vtkIterativeClosestPointTransform` (cell locator, one thread) vs.
+// `VtkIcp` point-to-point / point-to-plane on 1 / all threads, for 10k-1M
+// points.
+//
+// VTK uses every source point as a landmark (its default is 200), so both
+// solve the same problem; each runs at most 50 iterations. The KD-tree /
+// locator build is included in the timings.
+
+#include <cmath>
+#include <random>
+
+#include <vtkIterativeClosestPointTransform.h>
+#include <vtkLandmarkTransform.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkTransform.h>
+#include <vtkTransformPolyDataFilter.h>
+#include <vtkVertexGlyphFilter.h>
+
+#include "benchmark/benchmark.h"
+
+#include "vtk_icp.h"
+
+namespace {
+
+constexpr int kMaxIterations = 50;
+
+vtkSmartPointer<vtkPolyData> Surface(int n, unsigned seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<float> uniform(-1, 1);
+  std::normal_distribution<float> noise(0, 0.0005f);
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  points->SetNumberOfPoints(n);
+  for (int i = 0; i < n; ++i) {
+    const float x = uniform(gen);
+    const float y = uniform(gen);
+    points->SetPoint(
+        i, x, y, 0.3f * std::sin(2 * x) * std::cos(3 * y) + 0.1f * x +
+            noise(gen));
+  }
+  vtkSmartPointer<vtkPolyData> temp = vtkSmartPointer<vtkPolyData>::New();
+  temp->SetPoints(points);
+  vtkSmartPointer<vtkVertexGlyphFilter> vertexFilter =
+      vtkSmartPointer<vtkVertexGlyphFilter>::New();
+  vertexFilter->SetInputData(temp);
+  vertexFilter->Update();
+  vtkSmartPointer<vtkPolyData> poly = vtkSmartPointer<vtkPolyData>::New();
+  poly->ShallowCopy(vertexFilter->GetOutput());
+  return poly;
+}
+
+struct Problem {
+  vtkSmartPointer<vtkPolyData> source;
+  vtkSmartPointer<vtkPolyData> target;
+};
+
+Problem MakeProblem(int n) {
+  Problem problem;
+  problem.target = Surface(n, 0);
+  vtkSmartPointer<vtkTransform> transform =
+      vtkSmartPointer<vtkTransform>::New();
+  transform->RotateWXYZ(4, 1, 2, 3);
+  transform->Translate(0.03, -0.02, 0.04);
+  vtkSmartPointer<vtkTransformPolyDataFilter> filter =
+      vtkSmartPointer<vtkTransformPolyDataFilter>::New();
+  filter->SetInputData(Surface(n, 1));
+  filter->SetTransform(transform);
+  filter->Update();
+  problem.source = filter->GetOutput();
+  return problem;
+}
+
+}  // namespace
+
+static void BM_VtkIcp(benchmark::State& state) {
+  const Problem problem = MakeProblem(state.range(0));
+  for (auto _ : state) {
+    vtkSmartPointer<vtkIterativeClosestPointTransform> icp =
+        vtkSmartPointer<vtkIterativeClosestPointTransform>::New();
+    icp->SetSource(problem.source);
+    icp->SetTarget(problem.target);
+    icp->GetLandmarkTransform()->SetModeToRigidBody();
+    icp->SetMaximumNumberOfLandmarks(state.range(0));
+    icp->SetMaximumNumberOfIterations(kMaxIterations);
+    icp->Modified();
+    icp->Update();
+    state.counters["iterations"] = icp->GetNumberOfIterations();
+    state.counters["mean_distance"] = icp->GetMeanDistance();
+  }
+}
+
+static void BM_FastIcp(benchmark::State& state) {
+  const Problem problem = MakeProblem(state.range(0));
+  const bool point_to_plane = state.range(1);
+  fast_icp::IcpOptions options;
+  options.metric = point_to_plane ? fast_icp::IcpMetric::kPointToPlane :
+      fast_icp::IcpMetric::kPointToPoint;
+  options.max_iterations = kMaxIterations;
+  options.num_threads = state.range(2);
+  for (auto _ : state) {
+    const VtkIcp icp(problem.target, point_to_plane ? 10 : 0);
+    const fast_icp::IcpResult result = icp.Align(problem.source, options);
+    state.counters["iterations"] = result.iterations;
+    state.counters["rms_error"] = result.rms_error;
+  }
+}
+
+BENCHMARK(BM_VtkIcp)
+    ->RangeMultiplier(10)->Range(10000, 1000000)
+    ->Unit(benchmark::kMillisecond)->Iterations(1);
+// {num_points, point_to_plane, num_threads}; 0 threads means all cores.
+BENCHMARK(BM_FastIcp)
+    ->ArgsProduct({{10000, 100000, 1000000}, {0, 1}, {1, 0}})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
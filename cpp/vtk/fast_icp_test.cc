@@ -0,0 +1,118 @@
+#include "fast_icp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace fast_icp {
+namespace {
+
+// Noisy samples of a smooth, non-symmetric surface in [-1, 1]^2.
+Eigen::Matrix3Xf Surface(int n, unsigned seed = 0) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<float> uniform(-1, 1);
+  Eigen::Matrix3Xf points(3, n);
+  for (int i = 0; i < n; ++i) {
+    const float x = uniform(gen);
+    const float y = uniform(gen);
+    points.col(i) << x, y, 0.3f * std::sin(2 * x) * std::cos(3 * y) + 0.1f * x;
+  }
+  return points;
+}
+
+Eigen::Isometry3d SmallMotion() {
+  Eigen::Isometry3d motion = Eigen::Isometry3d::Identity();
+  motion.rotate(Eigen::AngleAxisd(0.08, Eigen::Vector3d(1, 2, 3).normalized()));
+  motion.pretranslate(Eigen::Vector3d(0.03, -0.02, 0.04));
+  return motion;
+}
+
+TEST(KdTreeTest, MatchesBruteForce) {
+  const Eigen::Matrix3Xf points = Surface(5000);
+  const KdTree3f tree(points, 8);
+  const Eigen::Matrix3Xf queries = Surface(200, 1);
+  for (int q = 0; q < queries.cols(); ++q) {
+    const Eigen::VectorXf distances =
+        (points.colwise() - queries.col(q)).colwise().squaredNorm();
+    std::vector<int> order(points.cols());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+              [&](int a, int b) { return distances[a] < distances[b]; });
+    float d;
+    EXPECT_EQ(tree.Nearest(queries.col(q), &d), order[0]);
+    EXPECT_EQ(d, distances[order[0]]);
+    int indices[5];
+    float knn_distances[5];
+    ASSERT_EQ(tree.Knn(queries.col(q), 5, indices, knn_distances), 5);
+    for (int j = 0; j < 5; ++j) {
+      EXPECT_EQ(knn_distances[j], distances[order[j]]);
+    }
+    EXPECT_EQ(tree.Nearest(queries.col(q), &d, distances[order[0]] / 2), -1);
+  }
+}
+
+TEST(IcpTest, PointToPointRecoversMotion) {
+  const Eigen::Matrix3Xf target = Surface(20000);
+  const Eigen::Isometry3d motion = SmallMotion();
+  // Source = target moved away by `motion^-1`, so ICP should find `motion`.
+  const Eigen::Matrix3Xf source =
+      motion.inverse().cast<float>() * target;
+  const Icp icp(target);
+  IcpOptions options;
+  options.max_iterations = 100;
+  const IcpResult result = icp.Align(source, options);
+  EXPECT_TRUE(result.converged);
+  EXPECT_TRUE(result.transform.isApprox(motion, 1e-3));
+  EXPECT_LT(result.rms_error, 1e-3);
+}
+
+TEST(IcpTest, PointToPlaneConvergesFaster) {
+  const Eigen::Matrix3Xf target = Surface(20000);
+  const Eigen::Isometry3d motion = SmallMotion();
+  // Different samples of the same surface.
+  const Eigen::Matrix3Xf source =
+      motion.inverse().cast<float>() * Surface(10000, 2);
+  const Icp icp(target, Eigen::Matrix3Xf(), 10);
+  IcpOptions options;
+  options.max_iterations = 100;
+  options.min_translation_delta = 1e-5;
+  options.min_rotation_delta = 1e-5;
+  options.metric = IcpMetric::kPointToPlane;
+  const IcpResult plane = icp.Align(source, options);
+  options.metric = IcpMetric::kPointToPoint;
+  const IcpResult point = icp.Align(source, options);
+  EXPECT_TRUE(plane.converged);
+  EXPECT_LT(plane.iterations, point.iterations);
+  EXPECT_TRUE(plane.transform.isApprox(motion, 1e-2));
+}
+
+TEST(IcpTest, TrimmingRejectsOutliers) {
+  const Eigen::Matrix3Xf target = Surface(20000);
+  const Eigen::Isometry3d motion = SmallMotion();
+  Eigen::Matrix3Xf source = motion.inverse().cast<float>() * target;
+  // 10% of the source far off the surface.
+  for (int i = 0; i < source.cols(); i += 10) source(2, i) += 0.5f;
+  const Icp icp(target);
+  IcpOptions options;
+  options.max_iterations = 30;
+  options.trim_fraction = 0.85;
+  const IcpResult trimmed = icp.Align(source, options);
+  EXPECT_TRUE(trimmed.transform.isApprox(motion, 1e-2));
+  options.trim_fraction = 1;
+  const IcpResult untrimmed = icp.Align(source, options);
+  EXPECT_FALSE(untrimmed.transform.isApprox(motion, 1e-2));
+}
+
+TEST(IcpTest, PointToPlaneNeedsNormals) {
+  const Icp icp(Surface(100));
+  IcpOptions options;
+  options.metric = IcpMetric::kPointToPlane;
+  EXPECT_THROW(icp.Align(Surface(100), options), std::invalid_argument);
+}
+
+}  // namespace
+}  // namespace fast_icp
@@ -0,0 +1,73 @@
+#pragma once
+
+// Multi-threaded replacement for `vtkParticleReader` on text files (see
+// `particle_csv.h`), with the same output: float points, one vertex cell per
+// point, and the fourth column as the "Scalar" point scalars. Arrays are
+// allocated once and filled in place.
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <vtkCellArray.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include "particle_csv.h"
+
+// `num_threads` = 0 uses all cores. Throws `std::runtime_error` if `path`
+// cannot be read.
+inline vtkSmartPointer<vtkPolyData> ReadParticlesFast(
+    const std::string& path, int num_threads = 0) {
+  vtkSmartPointer<vtkFloatArray> xyz = vtkSmartPointer<vtkFloatArray>::New();
+  xyz->SetNumberOfComponents(3);
+  vtkSmartPointer<vtkFloatArray> scalars =
+      vtkSmartPointer<vtkFloatArray>::New();
+  scalars->SetName("Scalar");
+  const size_t num_allocated = particle_csv::ReadParticles(
+      path, num_threads, [&](size_t num_particles) {
+        xyz->SetNumberOfTuples(num_particles);
+        scalars->SetNumberOfTuples(num_particles);
+        return particle_csv::ParticleBuffers{
+            xyz->GetPointer(0), scalars->GetPointer(0)};
+      });
+  const vtkIdType n = static_cast<vtkIdType>(num_allocated);
+  if (n != xyz->GetNumberOfTuples()) {
+    // Malformed lines were skipped.
+    xyz->SetNumberOfTuples(n);
+    scalars->SetNumberOfTuples(n);
+  }
+
+  // Vertex cells in the legacy (count, id) layout, filled in parallel.
+  vtkSmartPointer<vtkIdTypeArray> cells =
+      vtkSmartPointer<vtkIdTypeArray>::New();
+  cells->SetNumberOfValues(2 * n);
+  vtkIdType* ids = cells->GetPointer(0);
+  const int threads = num_threads > 0 ? num_threads :
+      std::max(1u, std::thread::hardware_concurrency());
+  std::vector<std::thread> workers;
+  auto fill = [ids, n, threads](int t) {
+    for (vtkIdType i = n * t / threads; i < n * (t + 1) / threads; ++i) {
+      ids[2 * i] = 1;
+      ids[2 * i + 1] = i;
+    }
+  };
+  for (int t = 1; t < threads; ++t) workers.emplace_back(fill, t);
+  fill(0);
+  for (std::thread& worker : workers) worker.join();
+  vtkSmartPointer<vtkCellArray> verts = vtkSmartPointer<vtkCellArray>::New();
+  verts->SetCells(n, cells);
+
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  points->SetData(xyz);
+  vtkSmartPointer<vtkPolyData> poly = vtkSmartPointer<vtkPolyData>::New();
+  poly->SetPoints(points);
+  poly->SetVerts(verts);
+  poly->GetPointData()->SetScalars(scalars);
+  return poly;
+}
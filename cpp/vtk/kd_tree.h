@@ -0,0 +1,185 @@
+#pragma once
+
+// Static 3-D KD-tree over a point cloud, built once and queried from many
+// threads (queries are const). Like nanoflann: points are copied in tree
+// order so leaves are contiguous, nodes split the widest bounding box axis at
+// the median, and leaves hold up to `leaf_size` points.
+//
+//   KdTree3f tree(target);  // 3 x N.
+//   float distance_squared;
+//   int i = tree.Nearest(query, &distance_squared);  // Column of `target`.
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include <Eigen/Dense>
+
+namespace fast_icp {
+
+class KdTree3f {
+ public:
+  explicit KdTree3f(const Eigen::Matrix3Xf& points, int leaf_size = 16)
+      : leaf_size_(std::max(1, leaf_size)) {
+    const int n = static_cast<int>(points.cols());
+    indices_.resize(n);
+    std::iota(indices_.begin(), indices_.end(), 0);
+    if (n > 0) {
+      nodes_.reserve(2 * (n / leaf_size_ + 1));
+      Build(points, 0, n);
+    }
+    points_.resize(3, n);
+    tree_order_.resize(n);
+    for (int i = 0; i < n; ++i) {
+      points_.col(i) = points.col(indices_[i]);
+      tree_order_[indices_[i]] = i;
+    }
+  }
+
+  int size() const { return static_cast<int>(indices_.size()); }
+
+  // Index (into the constructor's `points`) of the point nearest `query`
+  // within `max_distance_squared`, or -1 if there is none.
+  int Nearest(const Eigen::Vector3f& query, float* distance_squared,
+              float max_distance_squared =
+                  std::numeric_limits<float>::infinity()) const {
+    return Nearest(query, -1, distance_squared, max_distance_squared);
+  }
+
+  // As above, starting from `hint` (an index, e.g. the previous answer for a
+  // slightly moved query; -1 for none): a close hint prunes most of the
+  // tree.
+  int Nearest(const Eigen::Vector3f& query, int hint, float* distance_squared,
+              float max_distance_squared =
+                  std::numeric_limits<float>::infinity()) const {
+    int best = -1;
+    float best_distance = max_distance_squared;
+    if (hint >= 0) {
+      const int i = tree_order_[hint];
+      const float d = (points_.col(i) - query).squaredNorm();
+      if (d < best_distance) {
+        best = i;
+        best_distance = d;
+      }
+    }
+    if (!nodes_.empty()) {
+      Search(0, query, &best, &best_distance);
+    }
+    *distance_squared = best_distance;
+    return best < 0 ? -1 : indices_[best];
+  }
+
+  // Up to `k` nearest points, closest first; returns how many were found.
+  int Knn(const Eigen::Vector3f& query, int k, int* indices,
+          float* distances_squared) const {
+    k = std::min(k, size());
+    int found = 0;
+    std::fill(distances_squared, distances_squared + k,
+              std::numeric_limits<float>::infinity());
+    if (k > 0) {
+      SearchKnn(0, query, k, indices, distances_squared, &found);
+    }
+    for (int i = 0; i < found; ++i) indices[i] = indices_[indices[i]];
+    return found;
+  }
+
+ private:
+  struct Node {
+    // Inner: split axis, value, and children (`left` = this + 1).
+    // Leaf: `axis` = -1 and points [begin, end).
+    int32_t axis;
+    float split;
+    int32_t begin_or_right;
+    int32_t end;
+  };
+
+  int Build(const Eigen::Matrix3Xf& points, int begin, int end) {
+    const int node = static_cast<int>(nodes_.size());
+    nodes_.push_back({-1, 0, begin, end});
+    if (end - begin <= leaf_size_) {
+      return node;
+    }
+    Eigen::Vector3f lo = points.col(indices_[begin]);
+    Eigen::Vector3f hi = lo;
+    for (int i = begin + 1; i < end; ++i) {
+      lo = lo.cwiseMin(points.col(indices_[i]));
+      hi = hi.cwiseMax(points.col(indices_[i]));
+    }
+    int axis;
+    if ((hi - lo).maxCoeff(&axis) == 0) {
+      return node;  // All points coincide.
+    }
+    const int mid = begin + (end - begin) / 2;
+    std::nth_element(
+        indices_.begin() + begin, indices_.begin() + mid,
+        indices_.begin() + end, [&points, axis](int a, int b) {
+          return points(axis, a) < points(axis, b);
+        });
+    nodes_[node].axis = axis;
+    nodes_[node].split = points(axis, indices_[mid]);
+    Build(points, begin, mid);
+    nodes_[node].begin_or_right = Build(points, mid, end);
+    return node;
+  }
+
+  void Search(int node_index, const Eigen::Vector3f& query, int* best,
+              float* best_distance) const {
+    const Node& node = nodes_[node_index];
+    if (node.axis < 0) {
+      for (int i = node.begin_or_right; i < node.end; ++i) {
+        const float d = (points_.col(i) - query).squaredNorm();
+        if (d < *best_distance) {
+          *best_distance = d;
+          *best = i;
+        }
+      }
+      return;
+    }
+    const float offset = query[node.axis] - node.split;
+    const int near = offset < 0 ? node_index + 1 : node.begin_or_right;
+    const int far = offset < 0 ? node.begin_or_right : node_index + 1;
+    Search(near, query, best, best_distance);
+    if (offset * offset < *best_distance) {
+      Search(far, query, best, best_distance);
+    }
+  }
+
+  void SearchKnn(int node_index, const Eigen::Vector3f& query, int k,
+                 int* indices, float* distances, int* found) const {
+    const Node& node = nodes_[node_index];
+    if (node.axis < 0) {
+      for (int i = node.begin_or_right; i < node.end; ++i) {
+        const float d = (points_.col(i) - query).squaredNorm();
+        if (d >= distances[k - 1]) continue;
+        // Insertion into the sorted candidates.
+        int j = std::min(*found, k - 1);
+        for (; j > 0 && distances[j - 1] > d; --j) {
+          distances[j] = distances[j - 1];
+          indices[j] = indices[j - 1];
+        }
+        distances[j] = d;
+        indices[j] = i;
+        *found = std::min(*found + 1, k);
+      }
+      return;
+    }
+    const float offset = query[node.axis] - node.split;
+    const int near = offset < 0 ? node_index + 1 : node.begin_or_right;
+    const int far = offset < 0 ? node.begin_or_right : node_index + 1;
+    SearchKnn(near, query, k, indices, distances, found);
+    if (offset * offset < distances[k - 1]) {
+      SearchKnn(far, query, k, indices, distances, found);
+    }
+  }
+
+  int leaf_size_;
+  std::vector<Node> nodes_;
+  // Points in tree order, their indices in the input, and the inverse.
+  Eigen::Matrix3Xf points_;
+  std::vector<int> indices_;
+  std::vector<int> tree_order_;
+};
+
+}  // namespace fast_icp
@@ -0,0 +1,329 @@
+#include "mapped_vtp.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+
+namespace vtk_eigen {
+
+#define VTK_EIGEN_XML_TYPE(T, Name) \
+  template <> \
+  const char* VtkXmlTypeName<T>() { return Name; }
+VTK_EIGEN_XML_TYPE(int8_t, "Int8")
+VTK_EIGEN_XML_TYPE(uint8_t, "UInt8")
+VTK_EIGEN_XML_TYPE(int16_t, "Int16")
+VTK_EIGEN_XML_TYPE(uint16_t, "UInt16")
+VTK_EIGEN_XML_TYPE(int32_t, "Int32")
+VTK_EIGEN_XML_TYPE(uint32_t, "UInt32")
+VTK_EIGEN_XML_TYPE(int64_t, "Int64")
+VTK_EIGEN_XML_TYPE(uint64_t, "UInt64")
+VTK_EIGEN_XML_TYPE(float, "Float32")
+VTK_EIGEN_XML_TYPE(double, "Float64")
+#undef VTK_EIGEN_XML_TYPE
+
+namespace {
+
+[[noreturn]] void Fail(const std::string& message) {
+  throw std::runtime_error("MappedVtp: " + message);
+}
+
+int XmlTypeSize(const std::string& type) {
+  static const std::map<std::string, int> sizes = {
+      {"Int8", 1}, {"UInt8", 1}, {"Int16", 2}, {"UInt16", 2},
+      {"Int32", 4}, {"UInt32", 4}, {"Int64", 8}, {"UInt64", 8},
+      {"Float32", 4}, {"Float64", 8}};
+  auto iter = sizes.find(type);
+  if (iter == sizes.end()) Fail("unsupported type " + type);
+  return iter->second;
+}
+
+bool IsLittleEndian() {
+  const uint16_t one = 1;
+  uint8_t first;
+  std::memcpy(&first, &one, 1);
+  return first == 1;
+}
+
+// One XML tag, e.g. `<DataArray type="Float32" offset="0"/>`.
+struct Tag {
+  std::string name;  // "/Name" for closing tags.
+  std::map<std::string, std::string> attributes;
+  bool self_closing{false};
+
+  std::string Get(const std::string& key, const std::string& fallback) const {
+    auto iter = attributes.find(key);
+    return iter == attributes.end() ? fallback : iter->second;
+  }
+  std::string Get(const std::string& key) const {
+    auto iter = attributes.find(key);
+    if (iter == attributes.end()) Fail("<" + name + "> without " + key);
+    return iter->second;
+  }
+};
+
+// Parses the tag starting at `*pos` (just past '<') and moves `*pos` past
+// its '>'. Good enough for VTK's own output; not a general XML parser.
+Tag ParseTag(const char* end, const char** pos) {
+  const char* p = *pos;
+  auto is_space = [](char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+  };
+  Tag tag;
+  while (p < end && !is_space(*p) && *p != '>' && *p != '/') {
+    tag.name += *p++;
+  }
+  if (tag.name.empty() && p < end && *p == '/') {
+    tag.name += *p++;
+    while (p < end && !is_space(*p) && *p != '>') tag.name += *p++;
+  }
+  while (true) {
+    while (p < end && is_space(*p)) ++p;
+    if (p >= end) Fail("truncated header");
+    if (*p == '>') {
+      ++p;
+      break;
+    }
+    if (*p == '/' || *p == '?') {
+      tag.self_closing = true;
+      ++p;
+      continue;
+    }
+    std::string key;
+    while (p < end && *p != '=' && *p != '>' && !is_space(*p)) key += *p++;
+    while (p < end && is_space(*p)) ++p;
+    if (p >= end || *p != '=') Fail("malformed attribute " + key);
+    ++p;
+    while (p < end && is_space(*p)) ++p;
+    if (p >= end || (*p != '"' && *p != '\'')) Fail("unquoted " + key);
+    const char quote = *p++;
+    const char* value = p;
+    while (p < end && *p != quote) ++p;
+    if (p >= end) Fail("truncated header");
+    tag.attributes[key] = std::string(value, p);
+    ++p;
+  }
+  *pos = p;
+  return tag;
+}
+
+// Closes `fd` on scope exit.
+struct FileCloser {
+  int fd;
+  ~FileCloser() { ::close(fd); }
+};
+
+void ReadAt(int fd, char* data, size_t size, off_t offset) {
+  while (size > 0) {
+    const ssize_t n = ::pread(fd, data, size, offset);
+    if (n <= 0) Fail("read failed");
+    data += n;
+    size -= n;
+    offset += n;
+  }
+}
+
+void WriteAt(int fd, const char* data, size_t size, off_t offset) {
+  while (size > 0) {
+    const ssize_t n = ::pwrite(fd, data, size, offset);
+    if (n <= 0) Fail("write failed");
+    data += n;
+    size -= n;
+    offset += n;
+  }
+}
+
+}  // namespace
+
+int AlignAppendedData(const std::string& path) {
+  constexpr size_t kBufferSize = 1 << 20;
+  const int fd = ::open(path.c_str(), O_RDWR);
+  if (fd < 0) Fail("cannot open " + path);
+  FileCloser closer{fd};
+  struct stat st;
+  if (::fstat(fd, &st) != 0) Fail("cannot stat " + path);
+  const size_t size = st.st_size;
+  std::vector<char> buffer(kBufferSize);
+  // Read until the `_` that precedes the data.
+  std::string header;
+  size_t appended = std::string::npos;
+  size_t underscore = std::string::npos;
+  while (underscore == std::string::npos && header.size() < size) {
+    const size_t n = std::min(buffer.size(), size - header.size());
+    ReadAt(fd, buffer.data(), n, header.size());
+    header.append(buffer.data(), n);
+    if (appended == std::string::npos) {
+      appended = header.find("<AppendedData");
+    }
+    if (appended != std::string::npos) {
+      underscore = header.find('_', appended);
+    } else if (header.size() >= 64 * kBufferSize) {
+      // E.g. inline data; do not read it all.
+      break;
+    }
+  }
+  if (underscore == std::string::npos) Fail(path + " has no appended data");
+  const int pad = (8 - (underscore + 1) % 8) % 8;
+  if (pad == 0) return 0;
+  // Move everything from `<AppendedData` on, last block first.
+  for (size_t end = size; end > appended;) {
+    const size_t begin = std::max(appended, end - std::min(end, kBufferSize));
+    ReadAt(fd, buffer.data(), end - begin, begin);
+    WriteAt(fd, buffer.data(), end - begin, begin + pad);
+    end = begin;
+  }
+  std::fill(buffer.begin(), buffer.begin() + pad, ' ');
+  WriteAt(fd, buffer.data(), pad, appended);
+  return pad;
+}
+
+MappedVtp::MappedVtp(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) Fail("cannot open " + path);
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    Fail("cannot stat " + path);
+  }
+  size_ = st.st_size;
+  if (size_ > 0) {
+    mapping_ = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  ::close(fd);
+  if (size_ == 0 || mapping_ == MAP_FAILED) {
+    mapping_ = nullptr;
+    Fail("cannot map " + path);
+  }
+  try {
+    const char* begin = static_cast<const char*>(mapping_);
+    const char* end = begin + size_;
+    static const char kAppended[] = "<AppendedData";
+    const char* appended = std::search(
+        begin, end, kAppended, kAppended + sizeof(kAppended) - 1);
+    if (appended == end) Fail(path + " has no appended data");
+
+    int header_size = 4;
+    int num_pieces = 0;
+    // Open elements.
+    std::vector<std::string> stack;
+    std::vector<std::pair<std::string, Tag>> arrays;
+    const char* p = begin;
+    while (p < appended) {
+      p = std::find(p, appended, '<');
+      if (p == appended) break;
+      ++p;
+      if (*p == '!') {  // Comment.
+        static const char kEnd[] = "-->";
+        p = std::search(p, appended, kEnd, kEnd + 3);
+        continue;
+      }
+      Tag tag = ParseTag(appended, &p);
+      if (tag.name == "VTKFile") {
+        if (tag.Get("type") != "PolyData") Fail(path + " is not PolyData");
+        if (tag.attributes.count("compressor")) {
+          Fail(path + " is compressed");
+        }
+        const std::string order = tag.Get("byte_order", "LittleEndian");
+        if ((order == "LittleEndian") != IsLittleEndian()) {
+          Fail(path + " has foreign byte order");
+        }
+        header_size = XmlTypeSize(tag.Get("header_type", "UInt32"));
+      } else if (tag.name == "Piece") {
+        if (++num_pieces > 1) Fail(path + " has multiple pieces");
+        num_points_ = std::stoll(tag.Get("NumberOfPoints"));
+      } else if (tag.name == "DataArray" && !stack.empty() &&
+                 (stack.back() == "Points" || stack.back() == "PointData")) {
+        arrays.emplace_back(stack.back(), tag);
+      }
+      if (tag.name[0] == '/') {
+        if (stack.empty() || stack.back() != tag.name.substr(1)) {
+          Fail(path + " has mismatched " + tag.name);
+        }
+        stack.pop_back();
+      } else if (!tag.self_closing) {
+        stack.push_back(tag.name);
+      }
+    }
+
+    p = appended + 1;
+    Tag appended_tag = ParseTag(end, &p);
+    if (appended_tag.Get("encoding") != "raw") {
+      Fail(path + " has encoded appended data");
+    }
+    p = std::find(p, end, '_');
+    if (p == end) Fail(path + " has truncated appended data");
+    const char* data = p + 1;
+
+    for (const auto& [array_section, tag] : arrays) {
+      if (tag.Get("format") != "appended") {
+        Fail(tag.Get("Name", "?") + " is not in the appended section");
+      }
+      MappedArray array;
+      array.name = tag.Get("Name", "");
+      array.type = tag.Get("type");
+      array.num_components = std::stoi(tag.Get("NumberOfComponents", "1"));
+      array.num_tuples = num_points_;
+      const uint64_t offset = std::stoull(tag.Get("offset"));
+      const uint64_t bytes = static_cast<uint64_t>(array.num_tuples) *
+          array.num_components * XmlTypeSize(array.type);
+      if (offset + header_size + bytes >
+          static_cast<uint64_t>(end - data)) {
+        Fail(array.name + " runs past the end of " + path);
+      }
+      uint64_t block_bytes = 0;
+      std::memcpy(&block_bytes, data + offset, header_size);
+      if (block_bytes != bytes) {
+        Fail(array.name + " has an unexpected size");
+      }
+      const char* values = data + offset + header_size;
+      if (reinterpret_cast<uintptr_t>(values) % XmlTypeSize(array.type)) {
+        copies_.emplace_back((bytes + 7) / 8);
+        std::memcpy(copies_.back().data(), values, bytes);
+        values = reinterpret_cast<const char*>(copies_.back().data());
+        array.mapped = false;
+      }
+      array.data = values;
+      if (array_section == "Points") {
+        points_ = std::move(array);
+      } else {
+        point_data_.push_back(std::move(array));
+      }
+    }
+  } catch (...) {
+    ::munmap(mapping_, size_);
+    throw;
+  }
+}
+
+MappedVtp::~MappedVtp() {
+  if (mapping_) ::munmap(mapping_, size_);
+}
+
+Eigen::Map<const Eigen::Matrix3Xf> MappedVtp::points() const {
+  if (!points_.data && num_points_ > 0) Fail("no points");
+  if (points_.data && (points_.type != "Float32" ||
+                       points_.num_components != 3)) {
+    Fail("points are " + points_.type + ", not Float32");
+  }
+  return {static_cast<const float*>(points_.data), 3, num_points_};
+}
+
+const MappedArray& MappedVtp::Find(
+    const std::vector<MappedArray>& arrays, const std::string& name,
+    const char* type) {
+  for (const MappedArray& array : arrays) {
+    if (array.name != name) continue;
+    if (array.type != type) {
+      Fail(name + " is " + array.type + ", not " + type);
+    }
+    return array;
+  }
+  Fail("no array " + name);
+}
+
+}  // namespace vtk_eigen
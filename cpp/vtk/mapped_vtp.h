@@ -0,0 +1,94 @@
+#pragma once
+
+// Read-only, zero-copy access to the arrays of a VTP file written with
+// appended, raw, uncompressed data (e.g. by `WriteAppendedRawVtp` in
+// `vtk_eigen.h`). The file is mmap'd and only its XML header is parsed;
+// arrays are `Eigen::Map`s into the mapping, so pages are read on first
+// touch and shared through the page cache:
+//
+//   MappedVtp vtp("cloud.vtp");
+//   Eigen::Map<const Eigen::Matrix3Xf> xyz = vtp.points();
+//   auto intensity = vtp.point_data<float>("intensity");  // 1 x N
+//
+// Maps are valid for the lifetime of the `MappedVtp`. Arrays whose values
+// are not aligned to their type in the file (VTK's writer does not align
+// them; `WriteAppendedRawVtp` aligns the start of the appended section) are
+// copied out of the mapping when the file is opened. Does not depend on
+// VTK. Throws `std::runtime_error` for files it cannot map (inline or
+// compressed data, multiple pieces, foreign byte order, ...).
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <Eigen/Core>
+
+namespace vtk_eigen {
+
+// One `<DataArray>` in the appended section.
+struct MappedArray {
+  std::string name;
+  // VTK type name, e.g. "Float32".
+  std::string type;
+  int num_components{1};
+  int64_t num_tuples{0};
+  // Start of the values, aligned to the value type.
+  const void* data{nullptr};
+  // False if the values were copied because they are misaligned in the file.
+  bool mapped{true};
+};
+
+// Inserts spaces before `<AppendedData` in the VTP file at `path`, in
+// place, so that its appended data starts at a multiple of 8 bytes. The data
+// is moved through a bounded buffer, not read into memory. Returns the number
+// of spaces inserted. Throws `std::runtime_error` if there is no appended
+// section or on I/O errors.
+int AlignAppendedData(const std::string& path);
+
+// VTK type name of `T`, e.g. "Float32" for `float`.
+template <typename T>
+const char* VtkXmlTypeName();
+
+class MappedVtp {
+ public:
+  explicit MappedVtp(const std::string& path);
+  ~MappedVtp();
+
+  MappedVtp(const MappedVtp&) = delete;
+  MappedVtp& operator=(const MappedVtp&) = delete;
+
+  int64_t num_points() const { return num_points_; }
+
+  // `<Points>`; throws unless they are Float32.
+  Eigen::Map<const Eigen::Matrix3Xf> points() const;
+
+  // `<PointData>` array `name` as components x tuples; throws if missing or
+  // not of type `T`.
+  template <typename T>
+  Eigen::Map<const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>>
+  point_data(const std::string& name) const {
+    const MappedArray& array = Find(point_data_, name, VtkXmlTypeName<T>());
+    return {static_cast<const T*>(array.data), array.num_components,
+            array.num_tuples};
+  }
+
+  const MappedArray& points_array() const { return points_; }
+  const std::vector<MappedArray>& point_data_arrays() const {
+    return point_data_;
+  }
+
+ private:
+  static const MappedArray& Find(
+      const std::vector<MappedArray>& arrays, const std::string& name,
+      const char* type);
+
+  // Owns copies of misaligned arrays (8-byte aligned).
+  std::vector<std::vector<uint64_t>> copies_;
+  void* mapping_{nullptr};
+  size_t size_{0};
+  int64_t num_points_{0};
+  MappedArray points_;
+  std::vector<MappedArray> point_data_;
+};
+
+}  // namespace vtk_eigen
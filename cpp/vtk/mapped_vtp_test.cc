@@ -0,0 +1,165 @@
+#include "mapped_vtp.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace vtk_eigen {
+namespace {
+
+std::string TempPath(const std::string& name) {
+  const char* dir = std::getenv("TEST_TMPDIR");
+  return std::string(dir ? dir : "/tmp") + "/" + name;
+}
+
+template <typename T>
+void AppendBlock(std::string* data, const T* values, uint64_t count) {
+  const uint64_t bytes = count * sizeof(T);
+  data->append(reinterpret_cast<const char*>(&bytes), sizeof(bytes));
+  data->append(reinterpret_cast<const char*>(values), bytes);
+}
+
+// Writes what `WriteAppendedRawVtp` produces (VTK 8.2) for 3 points with a
+// scalar "intensity" array and one vertex cell.
+std::string WriteSample(const std::string& header_extra = "") {
+  const float points[9] = {0, 1, 2, 3, 4, 5, 6, 7, 8};
+  const float intensity[3] = {0.5f, 1.5f, 2.5f};
+  const int64_t connectivity[3] = {0, 1, 2};
+  const int64_t offsets[1] = {3};
+  std::string data;
+  AppendBlock(&data, intensity, 3);
+  const size_t points_offset = data.size();
+  AppendBlock(&data, points, 9);
+  const size_t connectivity_offset = data.size();
+  AppendBlock(&data, connectivity, 3);
+  const size_t offsets_offset = data.size();
+  AppendBlock(&data, offsets, 1);
+
+  const std::string path = TempPath("mapped_vtp_test.vtp");
+  std::ofstream out(path, std::ios::binary);
+  out << "<?xml version=\"1.0\"?>\n"
+      << "<VTKFile type=\"PolyData\" version=\"1.0\" "
+      << "byte_order=\"LittleEndian\" header_type=\"UInt64\"" << header_extra
+      << ">\n"
+      << "  <PolyData>\n"
+      << "    <Piece NumberOfPoints=\"3\" NumberOfVerts=\"1\" "
+      << "NumberOfLines=\"0\" NumberOfStrips=\"0\" NumberOfPolys=\"0\">\n"
+      << "      <PointData Scalars=\"intensity\">\n"
+      << "        <DataArray type=\"Float32\" Name=\"intensity\" "
+      << "format=\"appended\" RangeMin=\"0.5\" RangeMax=\"2.5\" "
+      << "offset=\"0\"/>\n"
+      << "      </PointData>\n"
+      << "      <CellData>\n"
+      << "      </CellData>\n"
+      << "      <Points>\n"
+      << "        <DataArray type=\"Float32\" Name=\"Points\" "
+      << "NumberOfComponents=\"3\" format=\"appended\" offset=\""
+      << points_offset << "\">\n"
+      << "          <InformationKey name=\"L2_NORM_RANGE\" "
+      << "location=\"vtkDataArray\" length=\"2\">\n"
+      << "            <Value index=\"0\">\n"
+      << "              2.236\n"
+      << "            </Value>\n"
+      << "          </InformationKey>\n"
+      << "        </DataArray>\n"
+      << "      </Points>\n"
+      << "      <Verts>\n"
+      << "        <DataArray type=\"Int64\" Name=\"connectivity\" "
+      << "format=\"appended\" offset=\"" << connectivity_offset << "\"/>\n"
+      << "        <DataArray type=\"Int64\" Name=\"offsets\" "
+      << "format=\"appended\" offset=\"" << offsets_offset << "\"/>\n"
+      << "      </Verts>\n"
+      << "    </Piece>\n"
+      << "  </PolyData>\n"
+      << "  <AppendedData encoding=\"raw\">\n"
+      << "   _" << data << "\n"
+      << "  </AppendedData>\n"
+      << "</VTKFile>\n";
+  return path;
+}
+
+TEST(MappedVtpTest, Points) {
+  MappedVtp vtp(WriteSample());
+  EXPECT_EQ(vtp.num_points(), 3);
+  Eigen::Matrix3Xf expected(3, 3);
+  expected << 0, 3, 6,
+              1, 4, 7,
+              2, 5, 8;
+  EXPECT_EQ(vtp.points(), expected);
+}
+
+TEST(MappedVtpTest, PointData) {
+  MappedVtp vtp(WriteSample());
+  ASSERT_EQ(vtp.point_data_arrays().size(), 1);
+  auto intensity = vtp.point_data<float>("intensity");
+  EXPECT_EQ(intensity.rows(), 1);
+  EXPECT_EQ(intensity, Eigen::RowVector3f(0.5f, 1.5f, 2.5f));
+  EXPECT_THROW(vtp.point_data<double>("intensity"), std::runtime_error);
+  EXPECT_THROW(vtp.point_data<float>("missing"), std::runtime_error);
+}
+
+TEST(MappedVtpTest, MisalignedArraysAreCopied) {
+  Eigen::Matrix3Xf expected(3, 3);
+  expected << 0, 3, 6,
+              1, 4, 7,
+              2, 5, 8;
+  int num_mapped = 0;
+  for (int shift = 0; shift < 4; ++shift) {
+    MappedVtp vtp(WriteSample(std::string(shift, ' ')));
+    const MappedArray& points = vtp.points_array();
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(points.data) % alignof(float), 0);
+    num_mapped += points.mapped;
+    EXPECT_EQ(vtp.points(), expected);
+    EXPECT_EQ(vtp.point_data<float>("intensity"),
+              Eigen::RowVector3f(0.5f, 1.5f, 2.5f));
+  }
+  EXPECT_EQ(num_mapped, 1);
+}
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  return {std::istreambuf_iterator<char>(in),
+          std::istreambuf_iterator<char>()};
+}
+
+TEST(MappedVtpTest, AlignAppendedData) {
+  for (int shift = 0; shift < 8; ++shift) {
+    const std::string path = WriteSample(std::string(shift, ' '));
+    // Past the buffer size, so the data is moved in several blocks.
+    std::string trailer(3 << 20, '\0');
+    for (size_t i = 0; i < trailer.size(); ++i) trailer[i] = char(i * 7);
+    std::ofstream(path, std::ios::binary | std::ios::app) << trailer;
+    const std::string before = ReadFile(path);
+    const size_t appended = before.find("<AppendedData");
+    const int pad = (8 - (before.find('_', appended) + 1) % 8) % 8;
+
+    EXPECT_EQ(AlignAppendedData(path), pad);
+    std::string expected = before;
+    expected.insert(appended, pad, ' ');
+    EXPECT_TRUE(ReadFile(path) == expected) << shift;
+    EXPECT_EQ(AlignAppendedData(path), 0);
+
+    MappedVtp vtp(path);
+    EXPECT_TRUE(vtp.points_array().mapped);
+    EXPECT_TRUE(vtp.point_data_arrays()[0].mapped);
+    EXPECT_EQ(vtp.point_data<float>("intensity"),
+              Eigen::RowVector3f(0.5f, 1.5f, 2.5f));
+  }
+  EXPECT_THROW(AlignAppendedData(TempPath("does_not_exist.vtp")),
+               std::runtime_error);
+}
+
+TEST(MappedVtpTest, Unsupported) {
+  EXPECT_THROW(
+      MappedVtp(WriteSample(" compressor=\"vtkZLibDataCompressor\"")),
+      std::runtime_error);
+  EXPECT_THROW(MappedVtp(TempPath("does_not_exist.vtp")), std::runtime_error);
+}
+
+}  // namespace
+}  // namespace vtk_eigen
@@ -0,0 +1,242 @@
+#include "particle_csv.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace particle_csv {
+namespace {
+
+// Chunks smaller than this are not worth a thread.
+constexpr size_t kMinChunkBytes = 1 << 20;
+
+bool IsSeparator(char c) {
+  return c == ' ' || c == '\t' || c == ',' || c == '\r';
+}
+
+const char* SkipSeparators(const char* p, const char* end) {
+  while (p < end && IsSeparator(*p)) ++p;
+  return p;
+}
+
+const char* LineEnd(const char* p, const char* end) {
+  const void* newline = std::memchr(p, '\n', end - p);
+  return newline ? static_cast<const char*>(newline) : end;
+}
+
+// Whether [p, end) (one line) may hold a record: not blank, not a comment.
+bool IsRecordLine(const char* p, const char* end) {
+  p = SkipSeparators(p, end);
+  if (p == end || *p == '#' || *p == '%') return false;
+  return !(*p == '/' && p + 1 < end && p[1] == '/');
+}
+
+// Parses `[+-]digits[.digits][(e|E)[+-]digits]` at `p` into `value`,
+// correctly rounded, and returns the end of the number; nullptr for anything
+// else (more than 15 digits, large exponents, inf, ...), which is left to
+// `std::from_chars`. Uses Clinger's fast path: with a mantissa below 2^53
+// and |exponent| <= 22, one double multiply / divide is correctly rounded,
+// and rounding that to float is too unless it lies exactly between two
+// floats.
+const char* ParseFloatFast(const char* p, const char* end, float* value) {
+  static const double kPow10[] = {
+      1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+  auto is_digit = [](char c) { return static_cast<unsigned>(c - '0') < 10; };
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int exponent = 0;
+  for (; p < end && is_digit(*p); ++p, ++digits) {
+    mantissa = mantissa * 10 + (*p - '0');
+  }
+  if (p < end && *p == '.') {
+    for (++p; p < end && is_digit(*p); ++p, ++digits, --exponent) {
+      mantissa = mantissa * 10 + (*p - '0');
+    }
+  }
+  if (digits == 0 || digits > 15) return nullptr;
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    ++p;
+    bool negative_exponent = false;
+    if (p < end && (*p == '-' || *p == '+')) negative_exponent = *p++ == '-';
+    if (p == end || !is_digit(*p)) return nullptr;
+    int e = 0;
+    for (; p < end && is_digit(*p) && e < 1000; ++p) e = e * 10 + (*p - '0');
+    exponent += negative_exponent ? -e : e;
+  }
+  if (exponent < -22 || exponent > 22) return nullptr;
+  const double d = exponent < 0 ?
+      static_cast<double>(mantissa) / kPow10[-exponent] :
+      static_cast<double>(mantissa) * kPow10[exponent];
+  if (d != 0 && (d < FLT_MIN || d > FLT_MAX)) return nullptr;
+  uint64_t bits;
+  std::memcpy(&bits, &d, sizeof(d));
+  // Halfway between two floats: the low 29 of 52 mantissa bits are 1000...
+  if ((bits & ((uint64_t(1) << 29) - 1)) == (uint64_t(1) << 28)) {
+    return nullptr;
+  }
+  *value = negative ? -static_cast<float>(d) : static_cast<float>(d);
+  return p;
+}
+
+// Parses the record on line [p, end) into `values`; false if malformed.
+bool ParseRecord(const char* p, const char* end, float values[4]) {
+  for (int i = 0; i < 4; ++i) {
+    p = SkipSeparators(p, end);
+    const char* next = ParseFloatFast(p, end, &values[i]);
+    if (!next) {
+      // `from_chars` rejects a leading '+', which iostreams accept.
+      if (p < end && *p == '+') ++p;
+      const std::from_chars_result result =
+          std::from_chars(p, end, values[i]);
+      if (result.ec != std::errc()) return false;
+      next = result.ptr;
+    }
+    if (next < end && !IsSeparator(*next)) return false;
+    p = next;
+  }
+  return true;
+}
+
+template <typename Func>
+void ParallelRun(int num_threads, Func&& f) {
+  std::vector<std::thread> threads;
+  for (int t = 1; t < num_threads; ++t) {
+    threads.emplace_back(f, t);
+  }
+  f(0);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("Cannot open " + path);
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      ::close(fd);
+      throw std::runtime_error("Cannot stat " + path);
+    }
+    size_ = st.st_size;
+    if (size_ > 0) {
+      data_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if (data_ == MAP_FAILED) {
+      throw std::runtime_error("Cannot map " + path);
+    }
+    if (data_) {
+      ::madvise(data_, size_, MADV_SEQUENTIAL);
+    }
+  }
+  ~MappedFile() {
+    if (data_) ::munmap(data_, size_);
+  }
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const char* begin() const { return static_cast<const char*>(data_); }
+  const char* end() const { return begin() + size_; }
+
+ private:
+  void* data_{nullptr};
+  size_t size_{0};
+};
+
+}  // namespace
+
+size_t ParseParticles(
+    const char* begin, const char* end, int num_threads,
+    const AllocateFunc& allocate) {
+  const size_t size = end - begin;
+  if (num_threads <= 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  num_threads = static_cast<int>(std::max<size_t>(
+      1, std::min<size_t>(num_threads, size / kMinChunkBytes)));
+
+  // Chunk `t` is [starts[t], starts[t + 1]), each starting on a new line.
+  std::vector<const char*> starts(num_threads + 1, end);
+  starts[0] = begin;
+  for (int t = 1; t < num_threads; ++t) {
+    const char* p = std::max(begin + size * t / num_threads, starts[t - 1]);
+    const char* line_end = LineEnd(p, end);
+    starts[t] = line_end == end ? end : line_end + 1;
+  }
+
+  // Pass 1: record lines per chunk.
+  std::vector<size_t> offsets(num_threads + 1, 0);
+  ParallelRun(num_threads, [&](int t) {
+    const char* chunk_end = starts[t + 1];
+    size_t count = 0;
+    for (const char* p = starts[t]; p < chunk_end;) {
+      const char* line_end = LineEnd(p, chunk_end);
+      count += IsRecordLine(p, line_end);
+      // The last line may have no newline; never step past `chunk_end`.
+      p = line_end == chunk_end ? chunk_end : line_end + 1;
+    }
+    offsets[t + 1] = count;
+  });
+  for (int t = 0; t < num_threads; ++t) offsets[t + 1] += offsets[t];
+  const ParticleBuffers out = allocate(offsets[num_threads]);
+
+  // Pass 2: parse in place.
+  std::vector<size_t> parsed(num_threads, 0);
+  ParallelRun(num_threads, [&](int t) {
+    float* xyz = out.xyz + 3 * offsets[t];
+    float* scalars = out.scalars + offsets[t];
+    const char* chunk_end = starts[t + 1];
+    size_t count = 0;
+    for (const char* p = starts[t]; p < chunk_end;) {
+      const char* line_end = LineEnd(p, chunk_end);
+      float values[4];
+      if (IsRecordLine(p, line_end) && ParseRecord(p, line_end, values)) {
+        xyz[3 * count] = values[0];
+        xyz[3 * count + 1] = values[1];
+        xyz[3 * count + 2] = values[2];
+        scalars[count] = values[3];
+        ++count;
+      }
+      p = line_end == chunk_end ? chunk_end : line_end + 1;
+    }
+    parsed[t] = count;
+  });
+
+  // Close gaps left by malformed lines (rare; serial).
+  size_t total = parsed[0];
+  for (int t = 1; t < num_threads; ++t) {
+    if (total != offsets[t]) {
+      std::memmove(out.xyz + 3 * total, out.xyz + 3 * offsets[t],
+                   3 * parsed[t] * sizeof(float));
+      std::memmove(out.scalars + total, out.scalars + offsets[t],
+                   parsed[t] * sizeof(float));
+    }
+    total += parsed[t];
+  }
+  return total;
+}
+
+size_t ReadParticles(
+    const std::string& path, int num_threads, const AllocateFunc& allocate) {
+  const MappedFile file(path);
+  return ParseParticles(file.begin(), file.end(), num_threads, allocate);
+}
+
+}  // namespace particle_csv
@@ -0,0 +1,42 @@
+#pragma once
+
+// Multi-threaded parser for the text particle files read by
+// `vtkParticleReader`: one `x y z s` record per line, fields separated by
+// any mix of spaces, tabs and commas. Blank lines and lines starting with
+// '#', '%' or "//" are skipped, as are lines with fewer than 4 numbers.
+//
+// The file is mmap'd and split at newlines into one chunk per thread. A
+// first pass counts record lines per chunk, `allocate` is called once with
+// the total, and a second pass parses each chunk (with `std::from_chars`)
+// straight into the caller's buffers at the chunk's offset. See
+// `fast_particle_reader.h` for the VTK front end.
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+namespace particle_csv {
+
+// Caller-owned output for `num_particles` particles: 3 floats per particle in
+// `xyz`, one in `scalars`.
+struct ParticleBuffers {
+  float* xyz{nullptr};
+  float* scalars{nullptr};
+};
+
+using AllocateFunc = std::function<ParticleBuffers(size_t num_particles)>;
+
+// Parses [begin, end) on `num_threads` threads (0: all cores). Returns the
+// number of particles written, which is less than the number passed to
+// `allocate` only if some lines were malformed (the buffers are then
+// compacted, so the first N entries are valid).
+size_t ParseParticles(
+    const char* begin, const char* end, int num_threads,
+    const AllocateFunc& allocate);
+
+// As above, for the file at `path`. Throws `std::runtime_error` if it cannot
+// be read.
+size_t ReadParticles(
+    const std::string& path, int num_threads, const AllocateFunc& allocate);
+
+}  // namespace particle_csv
@@ -0,0 +1,79 @@
+#include "particle_csv.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace particle_csv {
+namespace {
+
+struct Particles {
+  std::vector<float> xyz;
+  std::vector<float> scalars;
+};
+
+Particles Parse(const std::string& text, int num_threads) {
+  Particles out;
+  const size_t n = ParseParticles(
+      text.data(), text.data() + text.size(), num_threads,
+      [&out](size_t num_particles) {
+        out.xyz.resize(3 * num_particles);
+        out.scalars.resize(num_particles);
+        return ParticleBuffers{out.xyz.data(), out.scalars.data()};
+      });
+  out.xyz.resize(3 * n);
+  out.scalars.resize(n);
+  return out;
+}
+
+TEST(ParticleCsvTest, Separators) {
+  const Particles out = Parse(
+      "# x y z s\n"
+      "1 2 3 4\n"
+      "\n"
+      "  5.5,\t-6e-1 ,7,+8\r\n"
+      "% comment\n"
+      "// comment\n"
+      "9 10 11 12",  // No trailing newline.
+      1);
+  EXPECT_EQ(out.xyz,
+            std::vector<float>({1, 2, 3, 5.5f, -0.6f, 7, 9, 10, 11}));
+  EXPECT_EQ(out.scalars, std::vector<float>({4, 8, 12}));
+}
+
+TEST(ParticleCsvTest, MalformedLinesAreSkipped) {
+  // Extra columns are ignored, as by `vtkParticleReader`.
+  const Particles out =
+      Parse("1 2 3\n4 5 6 7\nx 1 2 3\n1 2 3 4x\n8 9 10 11 extra\n", 1);
+  EXPECT_EQ(out.xyz, std::vector<float>({4, 5, 6, 8, 9, 10}));
+  EXPECT_EQ(out.scalars, std::vector<float>({7, 11}));
+}
+
+TEST(ParticleCsvTest, ThreadsMatchSerial) {
+  // Large enough for several chunks, with malformed lines in all of them.
+  std::string text = "# header\n";
+  for (int i = 0; text.size() < (8 << 20); ++i) {
+    text += std::to_string(i) + " " + std::to_string(i * 0.5) + ", " +
+        std::to_string(-i) + "\t" + std::to_string(i % 7) + "\n";
+    if (i % 100000 == 0) text += "bad line\n";
+  }
+  const Particles serial = Parse(text, 1);
+  const Particles parallel = Parse(text, 5);
+  EXPECT_GT(serial.scalars.size(), 100000);
+  EXPECT_EQ(serial.xyz, parallel.xyz);
+  EXPECT_EQ(serial.scalars, parallel.scalars);
+}
+
+TEST(ParticleCsvTest, NoTrailingNewline) {
+  const Particles out = Parse("1 2 3 4\n5 6 7 8", 1);
+  EXPECT_EQ(out.xyz, std::vector<float>({1, 2, 3, 5, 6, 7}));
+  EXPECT_EQ(out.scalars, std::vector<float>({4, 8}));
+}
+
+TEST(ParticleCsvTest, Empty) {
+  EXPECT_TRUE(Parse("", 4).scalars.empty());
+}
+
+}  // namespace
+}  // namespace particle_csv
@@ -0,0 +1,139 @@
+#pragma once
+
+// Zero-copy views between VTK array storage and Eigen.
+//
+//   vtkPolyData* poly = ...;
+//   Eigen::Map<Eigen::Matrix3Xf> xyz = MapPoints(poly->GetPoints());
+//   xyz.colwise() -= xyz.rowwise().mean();  // Edits the VTK points in place.
+//
+//   Eigen::Matrix3Xf cloud = ...;
+//   vtkSmartPointer<vtkPoints> points = MakePointsView(cloud);
+//   // `points` reads / writes `cloud`'s storage; `cloud` must outlive it
+//   // and must not be resized.
+//
+// Only the array-of-structs VTK storage (`vtkFloatArray`, `vtkDoubleArray`,
+// ...) is contiguous; other layouts throw.
+
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include <Eigen/Dense>
+#include <vtkDataArray.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkTypeTraits.h>
+#include <vtkVersion.h>
+#include <vtkXMLPolyDataWriter.h>
+
+#include "mapped_vtp.h"
+
+namespace vtk_eigen {
+
+// Components x tuples, column-major: one column per tuple.
+template <typename T>
+using ArrayMap = Eigen::Map<Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>>;
+
+// True if `array` stores its tuples contiguously, components interleaved.
+inline bool HasContiguousStorage(vtkAbstractArray* array) {
+#if VTK_MAJOR_VERSION * 100 + VTK_MINOR_VERSION >= 701
+  return array->GetArrayType() == vtkAbstractArray::AoSDataArrayTemplate;
+#elif VTK_MAJOR_VERSION * 100 + VTK_MINOR_VERSION >= 601
+  // Mapped arrays (6.1) are the only other layout.
+  return array->HasStandardMemoryLayout();
+#else
+  return true;
+#endif
+}
+
+// Maps `array`'s storage. Throws if its value type is not `T` or its storage
+// is not contiguous.
+template <typename T>
+ArrayMap<T> MapDataArray(vtkDataArray* array) {
+  if (!array) {
+    throw std::runtime_error("MapDataArray: null array");
+  }
+  if (array->GetDataType() != vtkTypeTraits<T>::VTKTypeID()) {
+    throw std::runtime_error(
+        std::string("MapDataArray: expected ") +
+        vtkTypeTraits<T>::SizedName() + ", got " +
+        array->GetDataTypeAsString());
+  }
+  if (!HasContiguousStorage(array)) {
+    throw std::runtime_error("MapDataArray: storage is not contiguous");
+  }
+  return ArrayMap<T>(
+      static_cast<T*>(array->GetVoidPointer(0)),
+      array->GetNumberOfComponents(), array->GetNumberOfTuples());
+}
+
+// Maps float points as 3 x N. Throws for double precision points.
+inline Eigen::Map<Eigen::Matrix3Xf> MapPoints(vtkPoints* points) {
+  if (!points) {
+    throw std::runtime_error("MapPoints: null points");
+  }
+  ArrayMap<float> map = MapDataArray<float>(points->GetData());
+  return Eigen::Map<Eigen::Matrix3Xf>(map.data(), 3, map.cols());
+}
+
+// Array of `T` that references `data` (components x tuples, column-major)
+// without copying. VTK never frees or reallocates it; `data` must outlive
+// the array.
+template <typename T, typename Derived>
+vtkSmartPointer<vtkDataArray> MakeDataArrayView(
+    Eigen::PlainObjectBase<Derived>& data) {
+  static_assert(
+      std::is_same<typename Derived::Scalar, T>::value, "Scalar mismatch");
+  static_assert(!Derived::IsRowMajor || Derived::IsVectorAtCompileTime,
+                "Data must be column-major");
+  vtkSmartPointer<vtkDataArray> array;
+  array.TakeReference(vtkDataArray::CreateDataArray(
+      vtkTypeTraits<T>::VTKTypeID()));
+  array->SetNumberOfComponents(data.rows());
+  // save = 1: VTK does not own the memory.
+  array->SetVoidArray(data.data(), data.size(), 1);
+  return array;
+}
+
+// Points that reference `xyz` without copying; see `MakeDataArrayView`.
+inline vtkSmartPointer<vtkPoints> MakePointsView(Eigen::Matrix3Xf& xyz) {
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  points->SetData(MakeDataArrayView<float>(xyz));
+  return points;
+}
+
+// Writes `poly` as a VTP file whose arrays are stored uncompressed, raw
+// (not base64) and in the appended section, so `MappedVtp` (see
+// `mapped_vtp.h`) can map them without parsing or copying. The appended
+// section is padded to start at a multiple of 8 bytes; an array is then
+// aligned unless an earlier one has a size that is not a multiple of its
+// type's size (e.g. 3 x odd Float32 points before a Float64 array). VTK
+// writes the file directly; padding it then moves the appended data once
+// more on disk (see `AlignAppendedData`). Returns false on failure.
+inline bool WriteAppendedRawVtp(vtkPolyData* poly, const std::string& path) {
+  vtkSmartPointer<vtkXMLPolyDataWriter> writer =
+      vtkSmartPointer<vtkXMLPolyDataWriter>::New();
+  writer->SetFileName(path.c_str());
+#if VTK_MAJOR_VERSION <= 5
+  writer->SetInput(poly);
+#else
+  writer->SetInputData(poly);
+#endif
+  writer->SetDataModeToAppended();
+  writer->EncodeAppendedDataOff();
+  writer->SetCompressor(nullptr);
+#if VTK_MAJOR_VERSION >= 6
+  // 64-bit block sizes, so arrays may exceed 4 GB.
+  writer->SetHeaderTypeToUInt64();
+#endif
+  if (writer->Write() != 1) return false;
+  try {
+    AlignAppendedData(path);
+  } catch (const std::runtime_error&) {
+    return false;
+  }
+  return true;
+}
+
+}  // namespace vtk_eigen
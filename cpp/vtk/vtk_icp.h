@@ -0,0 +1,79 @@
+#pragma once
+
+// `vtkPolyData` front end for `fast_icp::Icp` (see `fast_icp.h`), taking the
+// same source / target as `vtkIterativeClosestPointTransform`:
+//
+//   VtkIcp icp(target);  // Once per target.
+//   fast_icp::IcpResult result = icp.Align(source, options);  // Per frame.
+//   vtkSmartPointer<vtkMatrix4x4> m = ToVtkMatrix(result.transform);
+
+#include <stdexcept>
+
+#include <Eigen/Dense>
+#include <vtkDataArray.h>
+#include <vtkMatrix4x4.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include "fast_icp.h"
+#include "vtk_eigen.h"
+
+// 3 x N float copy of a points-like array (points or normals).
+inline Eigen::Matrix3Xf ToMatrix3Xf(vtkDataArray* data) {
+  if (!data || data->GetNumberOfTuples() == 0) {
+    return Eigen::Matrix3Xf();
+  }
+  if (data->GetNumberOfComponents() != 3) {
+    throw std::runtime_error("ToMatrix3Xf: expected 3 components");
+  }
+  if (data->GetDataType() == VTK_FLOAT) {
+    return vtk_eigen::MapDataArray<float>(data);
+  }
+  if (data->GetDataType() == VTK_DOUBLE) {
+    return vtk_eigen::MapDataArray<double>(data).cast<float>();
+  }
+  Eigen::Matrix3Xf out(3, data->GetNumberOfTuples());
+  for (vtkIdType i = 0; i < data->GetNumberOfTuples(); ++i) {
+    const double* tuple = data->GetTuple3(i);
+    out.col(i) << tuple[0], tuple[1], tuple[2];
+  }
+  return out;
+}
+
+inline vtkSmartPointer<vtkMatrix4x4> ToVtkMatrix(
+    const Eigen::Isometry3d& transform) {
+  vtkSmartPointer<vtkMatrix4x4> m = vtkSmartPointer<vtkMatrix4x4>::New();
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      m->SetElement(i, j, transform.matrix()(i, j));
+    }
+  }
+  return m;
+}
+
+class VtkIcp {
+ public:
+  // Uses the target's point normals if it has them, otherwise estimates them
+  // from `normal_neighbors` neighbors (0: only point-to-point is available).
+  explicit VtkIcp(vtkPolyData* target, int normal_neighbors = 10)
+      : icp_(ToMatrix3Xf(target->GetPoints() ?
+                             target->GetPoints()->GetData() : nullptr),
+             ToMatrix3Xf(target->GetPointData()->GetNormals()),
+             normal_neighbors) {}
+
+  fast_icp::IcpResult Align(
+      vtkPolyData* source, const fast_icp::IcpOptions& options,
+      const Eigen::Isometry3d& initial = Eigen::Isometry3d::Identity()) const {
+    return icp_.Align(
+        ToMatrix3Xf(source->GetPoints() ?
+                        source->GetPoints()->GetData() : nullptr),
+        options, initial);
+  }
+
+  const fast_icp::Icp& icp() const { return icp_; }
+
+ private:
+  fast_icp::Icp icp_;
+};
@@ -3,6 +3,7 @@ classdef MexPyProxy
         function [] = preclear()
             py_mex = MexPyProxy.py_module();
             py_mex.free();
+            mex_py_proxy('clear_cache');
         end
 
         function [] = init()
@@ -54,22 +55,73 @@ classdef MexPyProxy
             mx_handle = MexPyProxy.mx_raw_to_mx(mx_raw_handle);
             py_in = py_mex.py_raw_to_py(py_raw_in);
             % Convert each argument.
-            mx_in = cellfun(@PyProxy.fromPyValue, cell(py_in), ...
+            mx_in = cellfun(@MexPyProxy.fromPyValue, cell(py_in), ...
                 'UniformOutput', false);
             % Call the MATLAB method.
             mx_out = cell(1, nout);
             [mx_out{:}] = feval(mx_handle, mx_in{:});
             % Marshal back to C-friendly Python types.
-            py_out = cellfun(@PyProxy.toPyValue, mx_out, ...
+            py_out = cellfun(@MexPyProxy.toPyValue, mx_out, ...
                 'UniformOutput', false);
             py_raw_out = uint64(py_mex.py_to_py_raw(py_out));
         end
 
+        function py_raw_out = mx_feval_py_raw_batch(mx_raw_handle, nout, py_raw_in_batch)
+            % As `mx_feval_py_raw`, for a list of argument tuples, so that
+            % N calls from Python take a single trip through MEX.
+            py_mex = MexPyProxy.py_module();
+            mx_handle = MexPyProxy.mx_raw_to_mx(mx_raw_handle);
+            py_in_batch = cell(py_mex.py_raw_to_py(py_raw_in_batch));
+            py_out_batch = cell(size(py_in_batch));
+            for i = 1:numel(py_in_batch)
+                mx_in = cellfun(@MexPyProxy.fromPyValue, cell(py_in_batch{i}), ...
+                    'UniformOutput', false);
+                mx_out = cell(1, nout);
+                [mx_out{:}] = feval(mx_handle, mx_in{:});
+                py_out_batch{i} = cellfun(@MexPyProxy.toPyValue, mx_out, ...
+                    'UniformOutput', false);
+            end
+            py_raw_out = uint64(py_mex.py_to_py_raw(py_out_batch));
+        end
+
+        function [p] = toPyValue(m)
+            % As `PyProxy.toPyValue`, but large numeric arrays become
+            % read-only NumPy views of MATLAB's memory, without copying.
+            if MexPyProxy.isBulkNumeric(m)
+                mx_raw = MexPyProxy.mx_to_mx_raw(m);
+                p = MexPyProxy.py_module().mx_raw_to_numpy(mx_raw);
+                % The pin keeps the data; drop the erasure's reference.
+                MexPyProxy.mx_raw_ref_decr(mx_raw);
+            else
+                p = PyProxy.toPyValue(m);
+            end
+        end
+
+        function [m] = fromPyValue(p)
+            % As `PyProxy.fromPyValue`, but arrays from
+            % `py_mex_proxy.numpy_empty_mx` are taken over without copying.
+            if isa(p, 'py.numpy.ndarray')
+                pin = MexPyProxy.py_module().pinned_id(p);
+                if pin >= 0
+                    m = mex_py_proxy('take_pinned', uint64(pin));
+                    return;
+                end
+            end
+            m = PyProxy.fromPyValue(p);
+        end
+
+        function [b] = isBulkNumeric(m)
+            % Worth sharing rather than converting.
+            min_numel = 256;
+            b = (isnumeric(m) || islogical(m)) && isreal(m) && ...
+                ~issparse(m) && numel(m) >= min_numel;
+        end
+
         function [varargout] = test_call(mx_handle, varargin)
             py_mex = MexPyProxy.py_module();
             mx_raw_handle = MexPyProxy.mx_to_mx_raw(mx_handle);
             py_out = py_mex.mx_raw_feval_py(mx_raw_handle, nargout, varargin{:});
-            varargout = cellfun(@PyProxy.fromPyValue, cell(py_out), ...
+            varargout = cellfun(@MexPyProxy.fromPyValue, cell(py_out), ...
                 'UniformOutput', false);
             % Let the mx_raw_handle 'go out of scope'
             MexPyProxy.mx_raw_ref_decr(mx_raw_handle);
@@ -0,0 +1,100 @@
+// Per-call overhead of calling MATLAB from Python through `mex_py_proxy`,
+// against stand-in MEX headers (no MATLAB needed):
+//
+//   g++ -std=c++14 -O2 -I mex_stub bench/mex_py_proxy_bench.cpp -o /tmp/bench
+//   /tmp/bench [call_cost_us [item_cost_us]]
+//
+// `call_cost_us` (default 0) is spun per `mexCallMATLAB` round-trip, and
+// `item_cost_us` (default 0) per `feval` of the wrapped function (i.e. per
+// item of a batch). At 0, what remains is the proxy's own marshalling. The
+// batch rows amortize only `call_cost_us`, so they are printed only when
+// some cost is given; otherwise they would just divide one stub round-trip
+// by the batch size.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "../mex_py_proxy.cpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// `c_mx_feval_py_raw` before `CallCache`, for comparison.
+py_raw_t uncached_mx_feval_py_raw(
+    mx_raw_t mx_raw_handle, int nargout, py_raw_t py_raw_in) {
+  mxArray* mx_mx_raw_handle = mxCreateUint64Value(mx_raw_handle);
+  mxArray* mx_nargout = mxCreateUint64Value(nargout);
+  mxArray* mx_py_raw_in = mxCreateUint64Value(py_raw_in);
+  mxArray* mx_in[] = {mx_mx_raw_handle, mx_nargout, mx_py_raw_in};
+  mxArray* mx_out[1] = {nullptr};
+  int out = mexCallMATLABSafe(1, mx_out, 3, mx_in,
+                              "MexPyProxy.mx_feval_py_raw");
+  py_raw_t py_raw_out = 0xBADF00D;
+  if (out == 0) {
+    py_raw_out = mxGetUint64(mx_out[0]);
+    mxDestroyArray(mx_out[0]);
+  }
+  mxDestroyArray(mx_mx_raw_handle);
+  mxDestroyArray(mx_nargout);
+  mxDestroyArray(mx_py_raw_in);
+  return py_raw_out;
+}
+
+template <typename Func>
+void Measure(const char* name, int calls_per_iter, Func&& func) {
+  const int iters = 200000 / calls_per_iter;
+  const int64_t created = mex_stub::num_created();
+  const int64_t trips = mex_stub::num_round_trips();
+  uint64_T sum = 0;
+  const Clock::time_point start = Clock::now();
+  for (int i = 0; i < iters; ++i) {
+    sum += func(i);
+  }
+  const double seconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  const double calls = static_cast<double>(iters) * calls_per_iter;
+  std::cout << name << ": " << seconds / calls * 1e9 << " ns/call, "
+            << (mex_stub::num_created() - created) / calls
+            << " arrays/call, "
+            << (mex_stub::num_round_trips() - trips) / calls
+            << " round-trips/call (checksum " << sum % 10 << ")\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc > 1) {
+    mex_stub::call_cost() = std::chrono::microseconds(std::atoi(argv[1]));
+  }
+  if (argc > 2) {
+    mex_stub::item_cost() = std::chrono::microseconds(std::atoi(argv[2]));
+  }
+  Measure("uncached", 1, [](int i) {
+    return uncached_mx_feval_py_raw(7, 1, i);
+  });
+  Measure("cached", 1, [](int i) {
+    return c_mx_feval_py_raw(7, 1, i);
+  });
+  const bool modeled = mex_stub::call_cost().count() > 0 ||
+                       mex_stub::item_cost().count() > 0;
+  for (int batch : {16, 256}) {
+    if (!modeled) break;
+    const std::string name = "batch " + std::to_string(batch);
+    // The proxy's part of a batch is one call; packing the arguments is
+    // Python's, and is not measured.
+    mex_stub::batch_items() = batch;
+    Measure(name.c_str(), batch, [](int i) {
+      return c_mx_feval_py_raw_batch(7, 1, i);
+    });
+  }
+  mex_stub::batch_items() = 1;
+  if (!modeled) {
+    std::cout << "batch: skipped; pass call_cost_us and item_cost_us\n";
+  }
+  clear_call_cache();
+  std::cout << "leaked arrays: "
+            << mex_stub::num_created() - mex_stub::num_destroyed() << "\n";
+  return 0;
+}
@@ -1,13 +1,21 @@
 #include <dlfcn.h>
 
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
 #include <iostream>
+#include <map>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 #include <mex.h>
 #include <matrix.h>
 
+// Undocumented; see the reference counting comment below.
+extern "C" mxArray* mxCreateSharedDataCopy(const mxArray* pr);
+
 /*
 Reference counting:
 For MEX, consider `mexMakeArrayPersistent`, or undocumented
@@ -22,6 +30,16 @@ If MATLAB gets too slow due mexCallMATLAB, see if this can be bypassed by
 somehow storing a persistent function handle.
 (See comments above for persistent mxArray* objects - hopefully
 they apply to function handles?)
+=> `CallCache` below keeps persistent handles to the `MexPyProxy` entry
+points, and persistent scalar argument arrays that are overwritten in place,
+so a call from Python no longer creates / destroys arrays or resolves a name.
+`c_mx_feval_py_raw_batch` packs N calls into one `mexCallMATLAB` round-trip.
+See `bench/mex_py_proxy_bench.cpp` for the per-call overhead.
+
+Numeric arrays can cross without copying (see `PinTable`): Python wraps
+`mxGetData` of a pinned (persistent) array as a column-major NumPy array,
+and hands arrays allocated that way back with `take_pinned`, which uses the
+undocumented `mxCreateSharedDataCopy` from the link above.
 
 For Python objects in MATLAB, since MATLAB treats Python objects well, we
 not actually need reference counting.
@@ -49,13 +67,16 @@ mx_raw_t mxGetUint64(const mxArray* in) {
 }
 
 // From drakeMexUtil.cpp
+// `display_name` (default `filename`) is what is reported on error.
 int mexCallMATLABSafe(int nlhs, mxArray* plhs[], int nrhs, mxArray* prhs[],
-                       const char* filename) {
+                       const char* filename,
+                       const char* display_name = nullptr) {
   mxArray* ex = mexCallMATLABWithTrap(nlhs, plhs, nrhs, prhs, filename);
   if (ex) {
     mxArray* report = nullptr;
     mexCallMATLAB(1, &report, 1, &ex, "getReport");
-    mxArray* mxFilename = mxCreateString(filename);
+    mxArray* mxFilename =
+        mxCreateString(display_name ? display_name : filename);
     mxArray* mxStderr = mxCreateDoubleScalar(2);
     mxArray* mxFormat = 
         mxCreateString("mexCallMATLABSafe:\nError calling '%s':\n%s\n");
@@ -99,8 +120,222 @@ const string usage =
     "        [c_func_ptrs_struct] = mex_py_proxy('get_c_func_ptrs')\n" \
     "    'simple' Call Python from MATLAB from C\n" \
     "        [] = mex_py_proxy('simple')\n" \
+    "    'clear_cache' Free cached function handles and argument arrays.\n" \
+    "        [] = mex_py_proxy('clear_cache')\n" \
+    "    'take_pinned' Array pinned for Python, sharing its data.\n" \
+    "        [value] = mex_py_proxy('take_pinned', uint64(pin))\n" \
     "    'help' Show usage.";
 
+// Persistent arrays reused by every call from Python into MATLAB.
+// `mexMakeArrayPersistent` keeps MATLAB from freeing them when a MEX call
+// returns; they are freed by `clear()` (registered with `mexAtExit`).
+class CallCache {
+ public:
+  // Persistent handle to the MATLAB function `name`, created on first use.
+  // Returns nullptr on error.
+  mxArray* function_handle(const char* name) {
+    auto iter = handles_.find(name);
+    if (iter != handles_.end()) {
+      return iter->second;
+    }
+    mxArray* mx_name = mxCreateString(name);
+    mxArray* handle = nullptr;
+    const int out = mexCallMATLABSafe(1, &handle, 1, &mx_name, "str2func");
+    mxDestroyArray(mx_name);
+    if (out != 0) {
+      return nullptr;
+    }
+    mexMakeArrayPersistent(handle);
+    handles_[name] = handle;
+    return handle;
+  }
+
+  // Persistent 1x1 uint64 array for argument `index` of a call at nesting
+  // `depth`, set to `value`.
+  // Writing through `mxGetData` bypasses MATLAB's copy on write, so a
+  // callee still running sees the change: a MATLAB function that calls
+  // into Python, which calls back into MATLAB, must not have its arguments
+  // overwritten. Hence one set per depth. (Callees must also not keep the
+  // arrays past the call; the `MexPyProxy` entry points only read them.)
+  mxArray* uint64_arg(size_t depth, size_t index, mx_raw_t value) {
+    if (args_.size() <= depth) {
+      args_.resize(depth + 1);
+    }
+    std::vector<mxArray*>& args = args_[depth];
+    while (args.size() <= index) {
+      mxArray* arg = mxCreateNumericMatrix(1, 1, mxUINT64_CLASS, mxREAL);
+      mexMakeArrayPersistent(arg);
+      args.push_back(arg);
+    }
+    *static_cast<mx_raw_t*>(mxGetData(args[index])) = value;
+    return args[index];
+  }
+
+  // Number of `mexCallMATLABCached` calls in progress.
+  size_t& depth() { return depth_; }
+
+  void clear() {
+    for (auto& item : handles_) {
+      mxDestroyArray(item.second);
+    }
+    handles_.clear();
+    for (const auto& args : args_) {
+      for (mxArray* arg : args) {
+        mxDestroyArray(arg);
+      }
+    }
+    args_.clear();
+  }
+
+ private:
+  // Transparent comparator, so lookups do not build a `string`.
+  std::map<string, mxArray*, std::less<>> handles_;
+  // Indexed by depth, then argument.
+  std::vector<std::vector<mxArray*>> args_;
+  size_t depth_{0};
+};
+
+CallCache& call_cache() {
+  static CallCache cache;
+  return cache;
+}
+
+void clear_call_cache() {
+  call_cache().clear();
+}
+
+// Numeric arrays shared with NumPy. Each is made persistent, so its data stays
+// put until Python unpins it, even if MATLAB has since cleared or
+// reassigned the variable (copy on write gives MATLAB a new buffer).
+const int kMaxDims = 32;
+
+// Filled in for Python (see `mx_numeric_info_t` in `py_mex_proxy.py`).
+struct mx_numeric_info_t {
+  uint64_T pin;
+  void* data;
+  // NumPy array interface type string, e.g. "<f8".
+  char typestr[4];
+  int ndim;
+  uint64_T dims[kMaxDims];
+};
+
+struct NumericType {
+  mxClassID class_id;
+  const char* typestr;
+};
+
+const NumericType numeric_types[] = {
+  {mxDOUBLE_CLASS, "<f8"},
+  {mxSINGLE_CLASS, "<f4"},
+  {mxINT8_CLASS, "|i1"},
+  {mxUINT8_CLASS, "|u1"},
+  {mxINT16_CLASS, "<i2"},
+  {mxUINT16_CLASS, "<u2"},
+  {mxINT32_CLASS, "<i4"},
+  {mxUINT32_CLASS, "<u4"},
+  {mxINT64_CLASS, "<i8"},
+  {mxUINT64_CLASS, "<u8"},
+  {mxLOGICAL_CLASS, "|b1"},
+};
+
+class PinTable {
+ public:
+  // Takes ownership of `value`, if it is a real, dense numeric or logical
+  // array; returns 0 on success.
+  int pin(mxArray* value, mx_numeric_info_t* info) {
+    const NumericType* type = nullptr;
+    for (const auto& t : numeric_types) {
+      if (t.class_id == mxGetClassID(value)) {
+        type = &t;
+      }
+    }
+    const mwSize ndim = mxGetNumberOfDimensions(value);
+    if (!type || mxIsComplex(value) || mxIsSparse(value) ||
+        ndim > static_cast<mwSize>(kMaxDims)) {
+      mxDestroyArray(value);
+      return -1;
+    }
+    mexMakeArrayPersistent(value);
+    const uint64_T pin = next_pin_++;
+    pinned_[pin] = value;
+    info->pin = pin;
+    info->data = mxGetData(value);
+    std::memcpy(info->typestr, type->typestr, sizeof(info->typestr));
+    info->ndim = static_cast<int>(ndim);
+    const mwSize* dims = mxGetDimensions(value);
+    for (mwSize i = 0; i < ndim; ++i) {
+      info->dims[i] = dims[i];
+    }
+    return 0;
+  }
+
+  // Returns nullptr if `pin` is unknown.
+  mxArray* get(uint64_T pin) const {
+    auto iter = pinned_.find(pin);
+    return iter != pinned_.end() ? iter->second : nullptr;
+  }
+
+  int unpin(uint64_T pin) {
+    auto iter = pinned_.find(pin);
+    if (iter == pinned_.end()) {
+      return -1;
+    }
+    mxDestroyArray(iter->second);
+    pinned_.erase(iter);
+    return 0;
+  }
+
+  size_t size() const { return pinned_.size(); }
+
+  void clear() {
+    for (auto& item : pinned_) {
+      mxDestroyArray(item.second);
+    }
+    pinned_.clear();
+  }
+
+ private:
+  std::map<uint64_T, mxArray*> pinned_;
+  uint64_T next_pin_{1};
+};
+
+PinTable& pin_table() {
+  static PinTable pins;
+  return pins;
+}
+
+void at_exit() {
+  call_cache().clear();
+  pin_table().clear();
+}
+
+// Calls `name(args...)` through its cached handle, with cached arguments.
+int mexCallMATLABCached(int nlhs, mxArray* plhs[], const char* name,
+                        std::initializer_list<mx_raw_t> args) {
+  CallCache& cache = call_cache();
+  mxArray* handle = cache.function_handle(name);
+  if (!handle) {
+    return -1;
+  }
+  const size_t max_args = 3;
+  if (args.size() > max_args) {
+    return -1;
+  }
+  const size_t depth = cache.depth();
+  mxArray* mx_in[1 + max_args] = {handle};
+  int nrhs = 1;
+  for (mx_raw_t arg : args) {
+    mx_in[nrhs] = cache.uint64_arg(depth, nrhs - 1, arg);
+    ++nrhs;
+  }
+  // Calls made while this one runs (reentrancy through Python) use the
+  // next argument set.
+  ++cache.depth();
+  const int out = mexCallMATLABSafe(nlhs, plhs, nrhs, mx_in, "feval", name);
+  --cache.depth();
+  return out;
+}
+
 // <c_func_ptrs>
 // These functions will be passed from MEX to MATLAB to Python.
 
@@ -123,42 +358,81 @@ int c_simple() {
 }
 
 int c_mx_raw_ref_incr(mx_raw_t mx_raw) {
-  mxArray* mx_mx_raw = mxCreateUint64Value(mx_raw);
-  mxArray* mx_in[] = {mx_mx_raw};
-  int out = mexCallMATLABSafe(0, nullptr, 1, mx_in, "MexPyProxy.mx_raw_ref_incr");
-  mxDestroyArray(mx_mx_raw);
-  return out;
+  return mexCallMATLABCached(0, nullptr, "MexPyProxy.mx_raw_ref_incr",
+                             {mx_raw});
 }
 
 int c_mx_raw_ref_decr(mx_raw_t mx_raw) {
-  mxArray* mx_mx_raw = mxCreateUint64Value(mx_raw);
-  mxArray* mx_in[] = {mx_mx_raw};
-  int out = mexCallMATLABSafe(0, nullptr, 1, mx_in, "MexPyProxy.mx_raw_ref_decr");
-  mxDestroyArray(mx_mx_raw);
-  return out;
+  return mexCallMATLABCached(0, nullptr, "MexPyProxy.mx_raw_ref_decr",
+                             {mx_raw});
 }
 
-py_raw_t c_mx_feval_py_raw(mx_raw_t mx_raw_handle, int nargout, py_raw_t py_raw_in) {
-  mxArray* mx_mx_raw_handle = mxCreateUint64Value(mx_raw_handle);
-  mxArray* mx_nargout = mxCreateUint64Value(nargout);
-  mxArray* mx_py_raw_in = mxCreateUint64Value(py_raw_in);
-
-  const int nrhs = 3;
-  mxArray* mx_in[nrhs] = {mx_mx_raw_handle, mx_nargout, mx_py_raw_in};
-  const int nlhs = 1;
-  mxArray* mx_out[nlhs] = {NULL};
+py_raw_t mx_feval_py_raw_impl(const char* name, mx_raw_t mx_raw_handle,
+                              int nargout, py_raw_t py_raw_in) {
+  mxArray* mx_out[1] = {nullptr};
   // TODO(eric.cousineau): Handle MATLAB exceptions.
-  int out = mexCallMATLABSafe(nlhs, mx_out, nrhs, mx_in, "MexPyProxy.mx_feval_py_raw");
+  int out = mexCallMATLABCached(
+      1, mx_out, name,
+      {mx_raw_handle, static_cast<mx_raw_t>(nargout), py_raw_in});
   py_raw_t py_raw_out = 0xBADF00D;
   if (out == 0) {
     py_raw_out = reinterpret_cast<py_raw_t>(mxGetUint64(mx_out[0]));
+    mxDestroyArray(mx_out[0]);
+  }
+  return py_raw_out;
+}
+
+py_raw_t c_mx_feval_py_raw(mx_raw_t mx_raw_handle, int nargout, py_raw_t py_raw_in) {
+  return mx_feval_py_raw_impl(
+      "MexPyProxy.mx_feval_py_raw", mx_raw_handle, nargout, py_raw_in);
+}
+
+// As above, but `py_raw_in_batch` is a list of argument tuples, and the
+// result a tuple of output tuples: N calls in one round-trip.
+py_raw_t c_mx_feval_py_raw_batch(
+    mx_raw_t mx_raw_handle, int nargout, py_raw_t py_raw_in_batch) {
+  return mx_feval_py_raw_impl(
+      "MexPyProxy.mx_feval_py_raw_batch", mx_raw_handle, nargout,
+      py_raw_in_batch);
+}
+
+// Pins the numeric array stored as `mx_raw`, for a zero-copy NumPy view.
+int c_mx_pin(mx_raw_t mx_raw, mx_numeric_info_t* info) {
+  mxArray* mx_out[1] = {nullptr};
+  int out = mexCallMATLABCached(1, mx_out, "MexPyProxy.mx_raw_to_mx",
+                                {mx_raw});
+  if (out != 0) {
+    return out;
   }
+  return pin_table().pin(mx_out[0], info);
+}
 
-  mxDestroyArray(mx_mx_raw_handle);
-  mxDestroyArray(mx_nargout);
-  mxDestroyArray(mx_py_raw_in);
+// Allocates and pins a new (zeroed) array for Python to fill in; hand it to
+// MATLAB with `take_pinned`. Fewer than 2 dims are padded with 1s.
+int c_mx_create_numeric(const char* typestr, int ndim, const uint64_T* dims,
+                        mx_numeric_info_t* info) {
+  const NumericType* type = nullptr;
+  for (const auto& t : numeric_types) {
+    if (std::strcmp(t.typestr, typestr) == 0) {
+      type = &t;
+    }
+  }
+  if (!type || ndim < 0 || ndim > kMaxDims) {
+    return -1;
+  }
+  mwSize mx_dims[kMaxDims] = {1, 1};
+  for (int i = 0; i < ndim; ++i) {
+    mx_dims[i] = static_cast<mwSize>(dims[i]);
+  }
+  const mwSize mx_ndim = std::max(ndim, 2);
+  mxArray* value = type->class_id == mxLOGICAL_CLASS ?
+      mxCreateLogicalArray(mx_ndim, mx_dims) :
+      mxCreateNumericArray(mx_ndim, mx_dims, type->class_id, mxREAL);
+  return pin_table().pin(value, info);
+}
 
-  return py_raw_out;
+int c_mx_unpin(uint64_T pin) {
+  return pin_table().unpin(pin);
 }
 
 // </c_func_ptrs>
@@ -166,12 +440,16 @@ py_raw_t c_mx_feval_py_raw(mx_raw_t mx_raw_handle, int nargout, py_raw_t py_raw_
 // Create MATLAB struct containing raw values pointing to functions.
 mxArray* get_c_func_ptrs() {
   // Reference example: mxcreatestructarray.c
-  const int n = 4;
+  const int n = 8;
   const char* names[n] = {
     "c_mx_feval_py_raw",
+    "c_mx_feval_py_raw_batch",
     "c_simple",
     "c_mx_raw_ref_incr",
     "c_mx_raw_ref_decr",
+    "c_mx_pin",
+    "c_mx_create_numeric",
+    "c_mx_unpin",
   };
   // Store easily-accessible pointers.
   auto raw_cast = [](auto x) {
@@ -179,9 +457,13 @@ mxArray* get_c_func_ptrs() {
   };
   mx_raw_t ptrs_raw[n] = {
     raw_cast(&c_mx_feval_py_raw),
+    raw_cast(&c_mx_feval_py_raw_batch),
     raw_cast(&c_simple),
     raw_cast(&c_mx_raw_ref_incr),
-    raw_cast(&c_mx_raw_ref_decr)
+    raw_cast(&c_mx_raw_ref_decr),
+    raw_cast(&c_mx_pin),
+    raw_cast(&c_mx_create_numeric),
+    raw_cast(&c_mx_unpin)
   };
   mwSize dims[2] = {1, 1};
   mxArray* s = mxCreateStructArray(2, dims, n, names);
@@ -200,6 +482,11 @@ mxArray* get_c_func_ptrs() {
 // Wrap MEX function call.
 void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
   try {
+    static bool at_exit_registered = false;
+    if (!at_exit_registered) {
+      mexAtExit(&at_exit);
+      at_exit_registered = true;
+    }
     ex_assert(nrhs >= 1, usage);
     string op = mxToStdString(prhs[0]);
     if (op == "get_c_func_ptrs") {
@@ -212,6 +499,20 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
       ex_assert(nrhs == 1, usage);
       ex_assert(nlhs == 0, usage);
       c_simple();
+    } else if (op == "clear_cache") {
+      ex_assert(nrhs == 1, usage);
+      ex_assert(nlhs == 0, usage);
+      clear_call_cache();
+    } else if (op == "take_pinned") {
+      ex_assert(nrhs == 2, usage);
+      ex_assert(nlhs == 1, usage);
+      ex_assert(mxGetClassID(prhs[1]) == mxUINT64_CLASS, usage);
+      const uint64_T pin = mxGetUint64(prhs[1]);
+      mxArray* pinned = pin_table().get(pin);
+      ex_assert(pinned, "Unknown pin: " << pin);
+      // Python may still hold a view, so the pinned array stays until it is
+      // unpinned. Python must not write to it once it is handed over.
+      plhs[0] = mxCreateSharedDataCopy(pinned);
     } else {
       throw std::runtime_error("Invalid op: " + op);
     }
@@ -0,0 +1,157 @@
+#pragma once
+
+// Minimal stand-in for MATLAB's `matrix.h`, for benchmarking and testing
+// `mex_py_proxy.cpp` without MATLAB. Only what the proxy uses.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+typedef size_t mwSize;
+typedef uint64_t uint64_T;
+
+enum mxClassID { mxDOUBLE_CLASS, mxSINGLE_CLASS, mxINT8_CLASS, mxUINT8_CLASS,
+                 mxINT16_CLASS, mxUINT16_CLASS, mxINT32_CLASS, mxUINT32_CLASS,
+                 mxINT64_CLASS, mxUINT64_CLASS, mxLOGICAL_CLASS, mxCHAR_CLASS,
+                 mxSTRUCT_CLASS, mxFUNCTION_CLASS };
+enum mxComplexity { mxREAL, mxCOMPLEX };
+
+struct mxArray {
+  mxClassID class_id;
+  std::vector<mwSize> dims{1, 1};
+  // Shared between shared-data copies, as in MATLAB.
+  std::shared_ptr<std::vector<char>> data;
+  bool complex{};
+  std::string str;  // Strings, and function handle names.
+  std::vector<std::string> field_names;
+  std::vector<mxArray*> fields;
+  bool persistent{};
+};
+
+namespace mex_stub {
+// Arrays created / destroyed so far.
+inline int64_t& num_created() { static int64_t n = 0; return n; }
+inline int64_t& num_destroyed() { static int64_t n = 0; return n; }
+inline mxArray* create(mxClassID class_id) {
+  ++num_created();
+  mxArray* out = new mxArray();
+  out->class_id = class_id;
+  out->data = std::make_shared<std::vector<char>>();
+  return out;
+}
+inline size_t element_size(mxClassID class_id) {
+  switch (class_id) {
+    case mxINT8_CLASS: case mxUINT8_CLASS: case mxLOGICAL_CLASS:
+    case mxCHAR_CLASS:
+      return 1;
+    case mxINT16_CLASS: case mxUINT16_CLASS:
+      return 2;
+    case mxSINGLE_CLASS: case mxINT32_CLASS: case mxUINT32_CLASS:
+      return 4;
+    default:
+      return 8;
+  }
+}
+}  // namespace mex_stub
+
+inline mxArray* mxCreateNumericArray(mwSize ndim, const mwSize* dims,
+                                     mxClassID class_id,
+                                     mxComplexity complexity) {
+  mxArray* out = mex_stub::create(class_id);
+  out->dims.assign(dims, dims + ndim);
+  size_t numel = 1;
+  for (mwSize dim : out->dims) numel *= dim;
+  out->data->resize(numel * mex_stub::element_size(class_id));
+  out->complex = complexity == mxCOMPLEX;
+  return out;
+}
+
+inline mxArray* mxCreateNumericMatrix(mwSize m, mwSize n, mxClassID class_id,
+                                      mxComplexity complexity) {
+  const mwSize dims[] = {m, n};
+  return mxCreateNumericArray(2, dims, class_id, complexity);
+}
+
+inline mxArray* mxCreateLogicalArray(mwSize ndim, const mwSize* dims) {
+  return mxCreateNumericArray(ndim, dims, mxLOGICAL_CLASS, mxREAL);
+}
+
+inline mxArray* mxCreateDoubleScalar(double value) {
+  mxArray* out = mxCreateNumericMatrix(1, 1, mxDOUBLE_CLASS, mxREAL);
+  std::memcpy(out->data->data(), &value, sizeof(value));
+  return out;
+}
+
+inline mxArray* mxCreateString(const char* value) {
+  mxArray* out = mex_stub::create(mxCHAR_CLASS);
+  out->str = value;
+  return out;
+}
+
+inline mxArray* mxCreateStructArray(mwSize, const mwSize*, int n,
+                                    const char** names) {
+  mxArray* out = mex_stub::create(mxSTRUCT_CLASS);
+  for (int i = 0; i < n; ++i) out->field_names.push_back(names[i]);
+  out->fields.resize(n);
+  return out;
+}
+
+// Undocumented in MATLAB; a new header for the same data.
+extern "C" inline mxArray* mxCreateSharedDataCopy(const mxArray* pr) {
+  ++mex_stub::num_created();
+  mxArray* out = new mxArray(*pr);
+  out->persistent = false;
+  return out;
+}
+
+inline int mxGetFieldNumber(const mxArray* s, const char* name) {
+  for (size_t i = 0; i < s->field_names.size(); ++i) {
+    if (s->field_names[i] == name) return static_cast<int>(i);
+  }
+  return -1;
+}
+
+inline void mxSetFieldByNumber(mxArray* s, mwSize, int i, mxArray* value) {
+  s->fields[i] = value;
+}
+
+inline void mxDestroyArray(mxArray* array) {
+  if (!array) return;
+  ++mex_stub::num_destroyed();
+  for (mxArray* field : array->fields) mxDestroyArray(field);
+  delete array;
+}
+
+inline void* mxGetData(const mxArray* array) {
+  return array->data->empty() ? nullptr : array->data->data();
+}
+
+inline mxClassID mxGetClassID(const mxArray* array) {
+  return array->class_id;
+}
+
+inline mwSize mxGetNumberOfDimensions(const mxArray* array) {
+  return array->dims.size();
+}
+
+inline const mwSize* mxGetDimensions(const mxArray* array) {
+  return array->dims.data();
+}
+
+inline bool mxIsComplex(const mxArray* array) { return array->complex; }
+inline bool mxIsSparse(const mxArray*) { return false; }
+
+inline size_t mxGetN(const mxArray* array) { return array->str.size(); }
+
+inline int mxGetString(const mxArray* array, char* buffer, mwSize size) {
+  std::strncpy(buffer, array->str.c_str(), size);
+  buffer[size - 1] = '\0';
+  return 0;
+}
+
+inline void* mxMalloc(size_t size) { return std::malloc(size); }
+inline void mxFree(void* ptr) { std::free(ptr); }
@@ -0,0 +1,126 @@
+#pragma once
+
+// Minimal stand-in for MATLAB's `mex.h` (see `matrix.h`). `mexCallMATLAB`
+// knows only the `MexPyProxy` entry points, `str2func`, and `feval`; each
+// call counts as one round-trip and spins for `mex_stub::call_cost()`, to
+// stand in for the interpreter. `MexPyProxy.mx_raw_to_mx(i)` returns a
+// shared-data copy of `mex_stub::variables()[i]`. `MexPyProxy.mx_feval_py_raw`
+// spins for `mex_stub::item_cost()` (the `feval` and the marshalling of one
+// call's arguments), runs `mex_stub::on_feval()` (e.g. a nested call, as
+// Python calling back into MATLAB would), then returns its last argument
+// plus 1. `MexPyProxy.mx_feval_py_raw_batch` does the same, but spins once per
+// item, for `mex_stub::batch_items()` items (the stub cannot see the length
+// of the Python list).
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+#include "matrix.h"
+
+namespace mex_stub {
+inline int64_t& num_round_trips() { static int64_t n = 0; return n; }
+inline std::chrono::nanoseconds& call_cost() {
+  static std::chrono::nanoseconds cost{0};
+  return cost;
+}
+inline std::chrono::nanoseconds& item_cost() {
+  static std::chrono::nanoseconds cost{0};
+  return cost;
+}
+inline int& batch_items() {
+  static int n = 1;
+  return n;
+}
+inline void spin(std::chrono::nanoseconds duration) {
+  const auto end = std::chrono::steady_clock::now() + duration;
+  while (std::chrono::steady_clock::now() < end) {}
+}
+// Stand-in for the `Erasure` table; owned by the test.
+inline std::vector<mxArray*>& variables() {
+  static std::vector<mxArray*> values;
+  return values;
+}
+inline std::function<void()>& on_feval() {
+  static std::function<void()> hook;
+  return hook;
+}
+inline uint64_T get_uint64(const mxArray* in) {
+  return *static_cast<const uint64_T*>(mxGetData(in));
+}
+}  // namespace mex_stub
+
+inline int mexCallMATLAB(int nlhs, mxArray* plhs[], int nrhs, mxArray* prhs[],
+                         const char* name) {
+  const char* function = name;
+  if (std::strcmp(function, "str2func") == 0) {
+    mxArray* handle = mex_stub::create(mxFUNCTION_CLASS);
+    handle->str = prhs[0]->str;
+    plhs[0] = handle;
+    return 0;
+  }
+  if (std::strcmp(function, "feval") == 0) {
+    function = prhs[0]->str.c_str();
+    ++prhs;
+    --nrhs;
+  }
+  ++mex_stub::num_round_trips();
+  mex_stub::spin(mex_stub::call_cost());
+  const bool batch =
+      std::strcmp(function, "MexPyProxy.mx_feval_py_raw_batch") == 0;
+  if (batch || std::strcmp(function, "MexPyProxy.mx_feval_py_raw") == 0) {
+    if (nrhs != 3 || nlhs != 1) throw std::runtime_error("bad call");
+    mex_stub::spin((batch ? mex_stub::batch_items() : 1) *
+                   mex_stub::item_cost());
+    if (mex_stub::on_feval()) mex_stub::on_feval()();
+    mxArray* out = mxCreateNumericMatrix(1, 1, mxUINT64_CLASS, mxREAL);
+    *static_cast<uint64_T*>(mxGetData(out)) =
+        mex_stub::get_uint64(prhs[2]) + 1;
+    plhs[0] = out;
+    return 0;
+  }
+  if (std::strcmp(function, "MexPyProxy.mx_raw_to_mx") == 0) {
+    const uint64_T i = mex_stub::get_uint64(prhs[0]);
+    if (nrhs != 1 || nlhs != 1 || i >= mex_stub::variables().size()) {
+      throw std::runtime_error("bad call");
+    }
+    plhs[0] = mxCreateSharedDataCopy(mex_stub::variables()[i]);
+    return 0;
+  }
+  if (std::strcmp(function, "MexPyProxy.mx_raw_ref_incr") == 0 ||
+      std::strcmp(function, "MexPyProxy.mx_raw_ref_decr") == 0) {
+    return 0;
+  }
+  throw std::runtime_error(std::string("mex stub: unknown function ") +
+                           function);
+}
+
+inline mxArray* mexCallMATLABWithTrap(int nlhs, mxArray* plhs[], int nrhs,
+                                      mxArray* prhs[], const char* name) {
+  mexCallMATLAB(nlhs, plhs, nrhs, prhs, name);
+  return nullptr;
+}
+
+inline int mexMakeArrayPersistent(mxArray* array) {
+  array->persistent = true;
+  return 0;
+}
+
+inline int mexAtExit(void (*)()) { return 0; }
+
+inline int mexPrintf(const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  const int out = std::vprintf(format, args);
+  va_end(args);
+  return out;
+}
+
+inline void mexErrMsgIdAndTxt(const char* id, const char* format, ...) {
+  std::fprintf(stderr, "%s: %s\n", id, format);
+  std::abort();
+}
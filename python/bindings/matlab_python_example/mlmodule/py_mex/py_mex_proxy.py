@@ -2,7 +2,9 @@
 from __future__ import absolute_import, print_function
 
 import traceback
-from ctypes import PYFUNCTYPE, c_uint64, c_int
+from ctypes import (
+    PYFUNCTYPE, POINTER, Structure, byref, c_char, c_char_p, c_int, c_uint64,
+    c_void_p)
 
 from util import Erasure
 
@@ -28,6 +30,24 @@ c_mx_raw_ref_t = PYFUNCTYPE(c_int, mx_raw_t)
 # Simple example.
 c_simple_t = PYFUNCTYPE(c_int)
 
+# Zero-copy numeric arrays; see `PinTable` in `mex_py_proxy.cpp`.
+MX_MAX_DIMS = 32
+class mx_numeric_info_t(Structure):
+    _fields_ = [
+        ("pin", c_uint64),
+        ("data", c_void_p),
+        ("typestr", c_char * 4),
+        ("ndim", c_int),
+        ("dims", c_uint64 * MX_MAX_DIMS),
+    ]
+# int (mx_raw_t mx_raw, mx_numeric_info_t* info)
+c_mx_pin_t = PYFUNCTYPE(c_int, mx_raw_t, POINTER(mx_numeric_info_t))
+# int (const char* typestr, int ndim, const uint64_t* dims,
+#      mx_numeric_info_t* info)
+c_mx_create_numeric_t = PYFUNCTYPE(
+    c_int, c_char_p, c_int, POINTER(c_uint64), POINTER(mx_numeric_info_t))
+c_mx_unpin_t = PYFUNCTYPE(c_int, c_uint64)
+
 # Globals
 mx_funcs = {}
 funcs = {}
@@ -44,12 +64,19 @@ def init_c_func_ptrs(funcs_in):
     # Calling MEX through type erasure.
     funcs['c_mx_feval_py_raw'] = \
         c_mx_feval_py_raw_t(funcs_in['c_mx_feval_py_raw'])
+    # Same signature; `py_raw_in` is a list of argument tuples.
+    funcs['c_mx_feval_py_raw_batch'] = \
+        c_mx_feval_py_raw_t(funcs_in['c_mx_feval_py_raw_batch'])
     funcs['c_simple'] = \
         c_simple_t(funcs_in['c_simple'])
     funcs['c_mx_raw_ref_incr'] = \
         c_mx_raw_ref_t(funcs_in['c_mx_raw_ref_incr'])
     funcs['c_mx_raw_ref_decr'] = \
         c_mx_raw_ref_t(funcs_in['c_mx_raw_ref_decr'])
+    funcs['c_mx_pin'] = c_mx_pin_t(funcs_in['c_mx_pin'])
+    funcs['c_mx_create_numeric'] = \
+        c_mx_create_numeric_t(funcs_in['c_mx_create_numeric'])
+    funcs['c_mx_unpin'] = c_mx_unpin_t(funcs_in['c_mx_unpin'])
 
 def init_mx_funcs(mx_funcs_in):
     global mx_funcs
@@ -94,6 +121,90 @@ def mx_raw_feval_py(mx_raw_handle, nargout, *py_in):
         print("py.erasure: {}".format(erasure._values))
     return py_out
 
+# As above, for a list of argument tuples, in one trip through MEX.
+# Returns a tuple of output tuples.
+def mx_raw_feval_py_batch(mx_raw_handle, nargout, py_in_batch):
+    mx_feval_py_raw_batch = funcs['c_mx_feval_py_raw_batch']
+    py_raw_in = py_to_py_raw([tuple(py_in) for py_in in py_in_batch])
+    py_raw_out = (mx_feval_py_raw_batch(
+        c_uint64(mx_raw_handle), c_int(int(nargout)), c_uint64(py_raw_in)))
+    if py_raw_out == 0xBADF00D:
+        traceback.print_stack()
+        raise Exception("Error")
+    return py_raw_to_py(py_raw_out)
+
+# Keeps a pinned mxArray, and so its data, alive for the NumPy arrays viewing
+# it (as the `_pin` of their buffer).
+class MxPin(object):
+    def __init__(self, info, shape, dtype):
+        self.pin = info.pin
+        self.data = info.data
+        self.shape = tuple(shape)
+        self.dtype = dtype
+    def __del__(self):
+        # Nothing to unpin once the MEX file has been cleared.
+        unpin = funcs.get('c_mx_unpin')
+        if unpin is not None:
+            unpin(self.pin)
+
+def _pinned_to_numpy(info, shape, writeable):
+    import numpy as np
+    dtype = np.dtype(info.typestr.decode())
+    pin = MxPin(info, shape, dtype)
+    nbytes = dtype.itemsize * int(np.prod(shape))
+    if nbytes == 0:
+        out = np.empty(shape, dtype=dtype, order='F')
+    else:
+        buffer = (c_char * nbytes).from_address(info.data)
+        buffer._pin = pin
+        out = np.ndarray(shape, dtype=dtype, buffer=buffer, order='F')
+    out.flags.writeable = writeable
+    return out
+
+# Read-only NumPy view of the numeric MATLAB array stored as `mx_raw`,
+# without copying (column-major, like MATLAB). Does not take over
+# `mx_raw`'s reference.
+def mx_raw_to_numpy(mx_raw):
+    info = mx_numeric_info_t()
+    if funcs['c_mx_pin'](mx_raw, byref(info)) != 0:
+        traceback.print_stack()
+        raise Exception("Cannot pin mx_raw {} as numeric".format(mx_raw))
+    shape = tuple(int(info.dims[i]) for i in range(info.ndim))
+    return _pinned_to_numpy(info, shape, writeable=False)
+
+# Uninitialized column-major array in memory MATLAB allocated. Returning it
+# (unsliced) to MATLAB hands the memory over without copying; do not write
+# to it afterwards.
+def numpy_empty_mx(shape, dtype=float):
+    import numpy as np
+    if not hasattr(shape, '__len__'):
+        shape = (shape,)
+    shape = tuple(int(n) for n in shape)
+    dtype = np.dtype(dtype)
+    info = mx_numeric_info_t()
+    dims = (c_uint64 * max(len(shape), 1))(*shape)
+    if funcs['c_mx_create_numeric'](
+            dtype.str.encode(), len(shape), dims, byref(info)) != 0:
+        raise Exception("Unsupported dtype for MATLAB: {}".format(dtype))
+    return _pinned_to_numpy(info, shape, writeable=True)
+
+# The pin behind `array`, if it views a whole pinned mxArray; else -1.
+def pinned_id(array):
+    base = array
+    while base is not None and not hasattr(base, '_pin'):
+        if isinstance(base, memoryview):
+            base = base.obj
+        else:
+            base = getattr(base, 'base', None)
+    if base is None:
+        return -1
+    pin = base._pin
+    if (array.shape != pin.shape or array.dtype != pin.dtype or
+            array.ctypes.data != pin.data or
+            not (array.flags.f_contiguous or array.size <= 1)):
+        return -1
+    return pin.pin
+
 def mx_raw_ref_incr(mx_raw):
     out = funcs['c_mx_raw_ref_incr'](mx_raw)
     if out != 0:
@@ -141,6 +252,15 @@ class MxFunc(MxRaw):
         if len(out) == 1 and unpack_scalar:
             out = out[0]
         return out
+    def call_batch(self, args_batch, nargout=1, unpack_scalar=True):
+        # Like `[self.call(args) for args in args_batch]`, with one MEX
+        # round-trip.
+        if self.mx_raw is None:
+            raise Exception("Already destroyed")
+        outs = mx_raw_feval_py_batch(self.mx_raw, nargout, args_batch)
+        if nargout == 1 and unpack_scalar:
+            return [out[0] for out in outs]
+        return list(outs)
     def __call__(self, *args, **kwargs):
         return self.call(args, **kwargs)
 
@@ -0,0 +1,137 @@
+// Zero-copy numeric arrays (`c_mx_pin`, `c_mx_create_numeric`,
+// 'take_pinned') and reentrant cached calls, against stand-in MEX headers:
+//
+//   g++ -std=c++14 -I mex_stub test/mex_py_proxy_numeric_test.cpp -o /tmp/t
+//   /tmp/t
+
+#include <cstdlib>
+#include <iostream>
+
+#include "../mex_py_proxy.cpp"
+
+// Unlike `assert`, evaluated (and checked) with NDEBUG too: most checks
+// wrap the calls under test.
+#define CHECK(condition)                                              \
+  do {                                                                \
+    if (!(condition)) {                                               \
+      std::cerr << __FILE__ << ":" << __LINE__                        \
+                << ": CHECK failed: " #condition << std::endl;        \
+      std::abort();                                                   \
+    }                                                                 \
+  } while (false)
+
+namespace {
+
+template <typename T>
+T* data_of(const mxArray* value) {
+  return static_cast<T*>(mxGetData(value));
+}
+
+void test_pin_matlab_array() {
+  // A 3x2 MATLAB matrix, [1 4; 2 5; 3 6], stored at erasure index 0.
+  mxArray* matrix = mxCreateNumericMatrix(3, 2, mxDOUBLE_CLASS, mxREAL);
+  for (int i = 0; i < 6; ++i) {
+    data_of<double>(matrix)[i] = i + 1;
+  }
+  mex_stub::variables() = {matrix};
+
+  mx_numeric_info_t info{};
+  CHECK(c_mx_pin(0, &info) == 0);
+  CHECK(std::string(info.typestr) == "<f8");
+  CHECK(info.ndim == 2 && info.dims[0] == 3 && info.dims[1] == 2);
+  // No copy: NumPy sees MATLAB's buffer, column-major, so (i, j) is at
+  // i + 3 * j.
+  CHECK(info.data == mxGetData(matrix));
+  CHECK(static_cast<double*>(info.data)[1 + 3 * 1] == 5);
+
+  // MATLAB clearing the variable does not free the pinned data.
+  mxDestroyArray(matrix);
+  mex_stub::variables().clear();
+  CHECK(static_cast<double*>(info.data)[5] == 6);
+  CHECK(pin_table().size() == 1);
+  CHECK(c_mx_unpin(info.pin) == 0);
+  CHECK(c_mx_unpin(info.pin) == -1);
+  CHECK(pin_table().size() == 0);
+}
+
+void test_reject_unsupported() {
+  mex_stub::variables() = {
+      mxCreateNumericMatrix(2, 2, mxDOUBLE_CLASS, mxCOMPLEX),
+      mxCreateString("abc"),
+  };
+  mx_numeric_info_t info{};
+  CHECK(c_mx_pin(0, &info) == -1);
+  CHECK(c_mx_pin(1, &info) == -1);
+  CHECK(pin_table().size() == 0);
+  for (mxArray* value : mex_stub::variables()) {
+    mxDestroyArray(value);
+  }
+  mex_stub::variables().clear();
+
+  const uint64_T dims[] = {2};
+  CHECK(c_mx_create_numeric("<c16", 1, dims, &info) == -1);
+  CHECK(c_mx_create_numeric("<f8", kMaxDims + 1, dims, &info) == -1);
+}
+
+void test_create_and_take() {
+  // As NumPy would: `np.empty((2, 3, 4), dtype=np.int32, order='F')`.
+  const uint64_T dims[] = {2, 3, 4};
+  mx_numeric_info_t info{};
+  CHECK(c_mx_create_numeric("<i4", 3, dims, &info) == 0);
+  CHECK(info.ndim == 3 && info.dims[2] == 4);
+  int32_t* data = static_cast<int32_t*>(info.data);
+  for (int i = 0; i < 24; ++i) {
+    data[i] = 10 * i;
+  }
+
+  mxArray* op = mxCreateString("take_pinned");
+  mxArray* pin = mxCreateUint64Value(info.pin);
+  const mxArray* prhs[] = {op, pin};
+  mxArray* plhs[1] = {nullptr};
+  mexFunction(1, plhs, 2, prhs);
+  // MATLAB's array shares the buffer NumPy filled in.
+  CHECK(mxGetClassID(plhs[0]) == mxINT32_CLASS);
+  CHECK(mxGetNumberOfDimensions(plhs[0]) == 3);
+  CHECK(mxGetData(plhs[0]) == info.data);
+  // ... and keeps it once Python lets go.
+  CHECK(c_mx_unpin(info.pin) == 0);
+  CHECK(data_of<int32_t>(plhs[0])[23] == 230);
+  mxDestroyArray(plhs[0]);
+  mxDestroyArray(op);
+  mxDestroyArray(pin);
+
+  // 1-D is padded to a MATLAB column.
+  const uint64_T n[] = {5};
+  CHECK(c_mx_create_numeric("|b1", 1, n, &info) == 0);
+  mxArray* pinned = pin_table().get(info.pin);
+  CHECK(mxGetClassID(pinned) == mxLOGICAL_CLASS);
+  CHECK(mxGetNumberOfDimensions(pinned) == 2);
+  CHECK(mxGetDimensions(pinned)[0] == 5 && mxGetDimensions(pinned)[1] == 1);
+  CHECK(c_mx_unpin(info.pin) == 0);
+}
+
+void test_reentrant_calls() {
+  // The outer call's arguments must survive a nested call made while it
+  // runs (MATLAB -> Python -> MATLAB).
+  py_raw_t inner = 0;
+  mex_stub::on_feval() = [&inner]() {
+    mex_stub::on_feval() = nullptr;
+    inner = c_mx_feval_py_raw(7, 1, 100);
+  };
+  const py_raw_t outer = c_mx_feval_py_raw(3, 1, 10);
+  CHECK(inner == 101);
+  CHECK(outer == 11);
+}
+
+}  // namespace
+
+int main() {
+  test_pin_matlab_array();
+  test_reject_unsupported();
+  test_create_and_take();
+  test_reentrant_calls();
+  at_exit();
+  CHECK(mex_stub::num_created() == mex_stub::num_destroyed());
+  std::cout << "[ Done ]" << std::endl;
+  return 0;
+}
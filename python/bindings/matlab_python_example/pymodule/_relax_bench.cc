@@ -0,0 +1,73 @@
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "util/py_relax.h"
+
+namespace py = pybind11;
+
+/*
+ * Per-call argument conversion overhead, for `relax_bench_main.py`.
+ */
+class Sink {
+ public:
+  void set_value(const int& value) { total_ += value; }
+  void set_values(const std::vector<int>& values) {
+    for (int value : values) total_ += value;
+  }
+  int64_t total() const { return total_; }
+  double response(const int& order, const double& x) const {
+    return std::pow(x, order) + total_;
+  }
+ private:
+  int64_t total_ {};
+};
+
+// `int_relax` loaded with the uncached `duck_type_cast`, for comparison.
+struct UncachedIntRelax {
+  int_relax value;
+};
+
+namespace pybind11 {
+namespace detail {
+
+template <>
+struct type_caster<UncachedIntRelax> {
+  PYBIND11_TYPE_CASTER(UncachedIntRelax, _("int_relax_uncached"));
+
+  bool load(handle src, bool convert) {
+    return duck_type_cast<int_relax, int, double>(&value.value, src, convert);
+  }
+
+  static handle cast(UncachedIntRelax, return_value_policy, handle) {
+    return none().release();
+  }
+};
+
+}  // namespace detail
+}  // namespace pybind11
+
+PYBIND11_MODULE(_relax_bench, m) {
+  py::class_<Sink>(m, "Sink")
+    .def(py::init<>())
+    .def("total", &Sink::total)
+    // pybind11's own overload resolution: one overload per accepted type.
+    .def("set_overloaded",
+         [](Sink* self, int value) { self->set_value(value); })
+    .def("set_overloaded",
+         [](Sink* self, double value) { self->set_value(int_relax(value)); })
+    .def("set_uncached",
+         [](Sink* self, const UncachedIntRelax& value) {
+           self->set_value(value.value);
+         })
+    .def("set_relaxed", py_relax_overload_cast<int>(&Sink::set_value))
+    .def("set_values",
+         py_relax_overload_cast<std::vector<int>>(&Sink::set_values))
+    .def("response", py_relax_overload_cast<int, double>(&Sink::response))
+    .def("response_vectorized",
+         py_relax_vectorize<int, double>(&Sink::response));
+}
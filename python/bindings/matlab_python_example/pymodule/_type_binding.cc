@@ -24,6 +24,11 @@ class SimpleType {
     : value_(value) {}
   int value() const { return value_; }
   void set_value(const int& value) { value_ = value; }
+  int scaled(const int& scale) const { return value_ * scale; }
+  void set_value_sum(const std::vector<int>& values) {
+    value_ = 0;
+    for (int value : values) value_ += value;
+  }
  private:
   int value_ {};
 };
@@ -52,7 +57,11 @@ PYBIND11_MODULE(_type_binding, m) {
     .def(py::init<>())
     .def(py_relax_init<int>(), py::arg("value"))
     .def("value", &SimpleType::value)
-    .def("set_value", py_relax_overload_cast<int>(&SimpleType::set_value));
+    .def("set_value", py_relax_overload_cast<int>(&SimpleType::set_value))
+    .def("set_value_sum",
+         py_relax_overload_cast<std::vector<int>>(&SimpleType::set_value_sum))
+    .def("scaled", py_relax_overload_cast<int>(&SimpleType::scaled))
+    .def("scaled_vectorized", py_relax_vectorize<int>(&SimpleType::scaled));
 
   py::class_<EigenType> pyEigenType(m, "EigenType");
   pyEigenType
@@ -0,0 +1,5 @@
+from __future__ import absolute_import, division, print_function
+
+from pymodule.util.share_symbols import ShareSymbols
+with ShareSymbols():
+    from ._relax_bench import *
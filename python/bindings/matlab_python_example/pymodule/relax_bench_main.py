@@ -0,0 +1,63 @@
+#!/usr/bin/env python
+from __future__ import print_function, absolute_import
+
+# Per-call overhead of relaxed argument conversion, against pybind11's own
+# overload resolution:
+#   bazel run //python/bindings/pymodule:relax_bench_main
+
+import timeit
+
+from pymodule import relax_bench as rb
+
+N = 200000
+
+
+def per_call_ns(func, values):
+    start = timeit.default_timer()
+    for value in values:
+        func(value)
+    return (timeit.default_timer() - start) / len(values) * 1e9
+
+
+def main():
+    sink = rb.Sink()
+    inputs = [
+        ("int", list(range(N))),
+        ("float", [float(i) for i in range(N)]),
+    ]
+    try:
+        import numpy as np
+        inputs.append(("np.float64", list(np.arange(N, dtype=np.float64))))
+    except ImportError:
+        pass
+    for name, values in inputs:
+        print("{}:".format(name))
+        for method in ["set_overloaded", "set_uncached", "set_relaxed"]:
+            ns = per_call_ns(getattr(sink, method), values)
+            print("  {:<16} {:8.1f} ns/call".format(method, ns))
+        start = timeit.default_timer()
+        sink.set_values(values)
+        ns = (timeit.default_timer() - start) / len(values) * 1e9
+        print("  {:<16} {:8.1f} ns/item".format("set_values", ns))
+
+    # Sweeping a two-argument method over a parameter grid.
+    try:
+        import numpy as np
+    except ImportError:
+        return
+    orders, xs = np.meshgrid(np.arange(4), np.linspace(0, 1, N // 4))
+    orders, xs = orders.ravel(), xs.ravel()
+    print("grid of {}:".format(len(xs)))
+    start = timeit.default_timer()
+    looped = [sink.response(o, x) for o, x in zip(orders, xs)]
+    ns = (timeit.default_timer() - start) / len(xs) * 1e9
+    print("  {:<20} {:8.1f} ns/point".format("response", ns))
+    start = timeit.default_timer()
+    vectorized = sink.response_vectorized(orders, xs)
+    ns = (timeit.default_timer() - start) / len(xs) * 1e9
+    print("  {:<20} {:8.1f} ns/point".format("response_vectorized", ns))
+    assert np.allclose(looped, vectorized)
+
+
+if __name__ == "__main__":
+    main()
@@ -31,6 +31,42 @@ class TestTypeBinding(unittest.TestCase):
         bad_type = lambda: obj.set_value("bad")
         self.assertRaises(TypeError, bad_type)
 
+    def test_flexible_list(self):
+        obj = tb.SimpleType()
+        obj.set_value_sum([1, 2., 3])
+        self.assertEqual(obj.value(), 6)
+        obj.set_value_sum(npa([1., 2, 3, 4]))
+        self.assertEqual(obj.value(), 10)
+        bad_item = lambda: obj.set_value_sum([1, 1.5])
+        self.assertRaises(RuntimeError, bad_item)
+        bad_type = lambda: obj.set_value_sum("bad")
+        self.assertRaises(TypeError, bad_type)
+
+    def test_vectorized(self):
+        obj = tb.SimpleType(2)
+        self.assertEqual(obj.scaled(3.), 6)
+        out = obj.scaled_vectorized(npa([1., 2, 3]))
+        self.assertEqual(out.dtype, np.int32)
+        self.assertTrue(np.array_equal(out, [2, 4, 6]))
+        self.assertTrue(np.array_equal(obj.scaled_vectorized(5), [10]))
+        self.assertEqual(len(obj.scaled_vectorized(npa([]))), 0)
+        bad_item = lambda: obj.scaled_vectorized(npa([1, 1.5]))
+        self.assertRaises(RuntimeError, bad_item)
+        bad_shape = lambda: obj.scaled_vectorized(np.ones((2, 2)))
+        self.assertRaises(ValueError, bad_shape)
+        # Integer and bool arrays are read as integers, not via doubles.
+        self.assertTrue(np.array_equal(
+            obj.scaled_vectorized(np.array([3, -4], dtype=np.int64)),
+            [6, -8]))
+        self.assertTrue(np.array_equal(
+            obj.scaled_vectorized(np.array([True, False])), [2, 0]))
+        too_big = lambda: obj.scaled_vectorized(
+            np.array([2**40], dtype=np.int64))
+        self.assertRaises(OverflowError, too_big)
+        too_big_unsigned = lambda: obj.scaled_vectorized(
+            np.array([2**63], dtype=np.uint64))
+        self.assertRaises(OverflowError, too_big_unsigned)
+
     def test_numpy_basic(self):
         # Will reshape a flat nparray. Need to explicitly shape.
         value = npa([[1., 2, 3]]).T
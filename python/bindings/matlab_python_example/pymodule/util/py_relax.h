@@ -1,15 +1,34 @@
+#include <array>
 #include <cstddef>
 #include <cmath>
+#include <cstdint>
+#include <limits>
 #include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <pybind11/pybind11.h>
 #include <pybind11/eigen.h>
+#include <pybind11/numpy.h>
 #include <pybind11/stl.h>
 
 namespace py = pybind11;
 
 namespace detail {
 
+template <typename... Ts>
+struct all_arithmetic : std::true_type {};
+
+template <typename T, typename... Ts>
+struct all_arithmetic<T, Ts...>
+    : std::integral_constant<
+        bool, std::is_arithmetic<T>::value && all_arithmetic<Ts...>::value> {};
+
 template <typename Method>
 struct mem_fn_class {
   // Extract class from a class method pointer.
@@ -19,6 +38,8 @@ struct mem_fn_class {
   // http://en.cppreference.com/w/cpp/header/functional
   template <class R, class T, class... Args>
   static T helper(R (T::* pm)(Args...));
+  template <class R, class T, class... Args>
+  static T helper(R (T::* pm)(Args...) const);
 
   using type = decltype(helper(std::declval<Method>()));
 };
@@ -45,6 +66,177 @@ auto py_relax_overload_cast(const Method& method) {
   return relaxed;
 }
 
+namespace detail {
+
+template <typename T>
+using vectorize_array_t =
+    py::array_t<T, py::array::c_style | py::array::forcecast>;
+
+// Elements of one vectorized argument of type `T`, converted to a
+// contiguous array of `T`.
+template <typename T, typename = void>
+class vectorize_column {
+ public:
+  explicit vectorize_column(const py::array& src)
+      : array_(src), data_(array_.data()) {}
+
+  T operator[](Py_ssize_t i) const { return data_[i]; }
+
+ private:
+  vectorize_array_t<T> array_;
+  const T* data_{};
+};
+
+// Integral `T`: integer and bool arrays are read natively (as 64-bit
+// integers, range-checked against `T`), so they stay exact; anything else
+// is read as doubles and checked to be integer-valued, like
+// `RelaxIntegral`.
+template <typename T>
+class vectorize_column<T, std::enable_if_t<std::is_integral<T>::value>> {
+ public:
+  explicit vectorize_column(const py::array& src) {
+    const std::string kind = py::str(src.dtype().attr("kind"));
+    if (kind == "b" || kind == "i" || (kind == "u" && src.itemsize() < 8)) {
+      signed_ = vectorize_array_t<int64_t>(src);
+      signed_data_ = signed_.data();
+    } else if (kind == "u") {
+      unsigned_ = vectorize_array_t<uint64_t>(src);
+      unsigned_data_ = unsigned_.data();
+    } else {
+      floats_ = vectorize_array_t<double>(src);
+      float_data_ = floats_.data();
+    }
+  }
+
+  T operator[](Py_ssize_t i) const {
+    if (signed_data_) return checked(signed_data_[i]);
+    if (unsigned_data_) return checked(unsigned_data_[i]);
+    return static_cast<T>(typename py_relax_type<T>::type(float_data_[i]));
+  }
+
+ private:
+  template <typename W>
+  static T checked(W value) {
+    const bool fits = value < 0 ?
+        std::is_signed<T>::value &&
+            static_cast<int64_t>(value) >=
+                static_cast<int64_t>(std::numeric_limits<T>::min()) :
+        static_cast<uint64_t>(value) <=
+            static_cast<uint64_t>(std::numeric_limits<T>::max());
+    if (!fits) {
+      std::ostringstream msg;
+      msg << "py_relax_vectorize: " << value << " is out of range";
+      throw std::overflow_error(msg.str());
+    }
+    return static_cast<T>(value);
+  }
+
+  vectorize_array_t<int64_t> signed_;
+  vectorize_array_t<uint64_t> unsigned_;
+  vectorize_array_t<double> floats_;
+  const int64_t* signed_data_{};
+  const uint64_t* unsigned_data_{};
+  const double* float_data_{};
+};
+
+template <typename T>
+struct vectorize_arg { using type = py::array; };
+
+template <typename... Args, typename Base, typename Method, size_t... Is>
+auto vectorize_call(
+    Base* self, const Method& method,
+    const std::tuple<vectorize_column<Args>...>& columns,
+    const std::array<Py_ssize_t, sizeof...(Args)>& strides, Py_ssize_t i,
+    std::index_sequence<Is...>) {
+  return (self->*method)(std::get<Is>(columns)[i * strides[Is]]...);
+}
+
+template <typename... Args, typename Base, typename Method, typename Data>
+py::object vectorize_loop(
+    std::true_type /* void */, Base* self, const Method& method,
+    const Data& data, const std::array<Py_ssize_t, sizeof...(Args)>& strides,
+    Py_ssize_t size) {
+  {
+    py::gil_scoped_release release;
+    for (Py_ssize_t i = 0; i < size; ++i) {
+      vectorize_call<Args...>(self, method, data, strides, i,
+                              std::index_sequence_for<Args...>{});
+    }
+  }
+  return py::none();
+}
+
+template <typename... Args, typename Base, typename Method, typename Data>
+py::object vectorize_loop(
+    std::false_type /* void */, Base* self, const Method& method,
+    const Data& data, const std::array<Py_ssize_t, sizeof...(Args)>& strides,
+    Py_ssize_t size) {
+  using R = std::decay_t<decltype(vectorize_call<Args...>(
+      self, method, data, strides, 0, std::index_sequence_for<Args...>{}))>;
+  static_assert(std::is_arithmetic<R>::value,
+                "py_relax_vectorize: results must be arithmetic");
+  py::array_t<R> out(size);
+  R* out_data = out.mutable_data();
+  {
+    py::gil_scoped_release release;
+    for (Py_ssize_t i = 0; i < size; ++i) {
+      out_data[i] = vectorize_call<Args...>(
+          self, method, data, strides, i, std::index_sequence_for<Args...>{});
+    }
+  }
+  return std::move(out);
+}
+
+}  // namespace detail
+
+/*
+ * Vectorized companion of `py_relax_overload_cast`: each argument is a
+ * NumPy array (or anything convertible) of one common length N, or a scalar
+ * broadcast to N. Calls the method N times in C++ with the GIL released,
+ * and returns the results stacked in an array of length N (None for void).
+ * Arguments and results must be arithmetic. Integral arguments take
+ * integer (or bool) arrays exactly, with a range check, and integer-valued
+ * floats, like `RelaxIntegral`.
+ * @note Only works for instance methods. No general functions.
+ */
+template <typename ... Args, typename Method>
+auto py_relax_vectorize(const Method& method) {
+  static_assert(
+      detail::all_arithmetic<Args...>::value,
+      "py_relax_vectorize: arguments must be arithmetic");
+  using Base = typename detail::mem_fn_class<Method>::type;
+  auto vectorized = [=](
+      Base* self, const typename detail::vectorize_arg<Args>::type&... args) {
+    const std::array<Py_ssize_t, sizeof...(Args)> sizes{{args.size()...}};
+    const std::array<Py_ssize_t, sizeof...(Args)> ndims{{args.ndim()...}};
+    Py_ssize_t size = 1;
+    for (size_t k = 0; k < sizes.size(); ++k) {
+      if (ndims[k] > 1) {
+        throw std::invalid_argument(
+            "py_relax_vectorize: arguments must be scalars or 1-D arrays");
+      }
+      if (sizes[k] != 1) {
+        if (size != 1 && size != sizes[k]) {
+          throw std::invalid_argument(
+              "py_relax_vectorize: array arguments differ in length");
+        }
+        size = sizes[k];
+      }
+    }
+    std::array<Py_ssize_t, sizeof...(Args)> strides;
+    for (size_t k = 0; k < sizes.size(); ++k) {
+      strides[k] = sizes[k] == 1 ? 0 : 1;
+    }
+    const std::tuple<detail::vectorize_column<Args>...> data(
+        detail::vectorize_column<Args>(args)...);
+    using R = decltype((std::declval<Base*>()->*method)(
+        std::declval<Args>()...));
+    return detail::vectorize_loop<Args...>(
+        std::is_void<R>{}, self, method, data, strides, size);
+  };
+  return vectorized;
+}
+
 template <typename ... Args>
 auto py_relax_init() {
   return py::init<typename py_relax_type<Args>::type...>();
@@ -78,11 +270,115 @@ bool duck_type_cast(...) {
   return false;
 }
 
+// Same result as `duck_type_cast`, but remembers which option last loaded
+// each Python type (with and without `convert`) and tries it first, so repeat
+// calls only construct the winning caster. Assumes options accept or reject
+// mostly by Python type; if the remembered one rejects a value, the rest are
+// still tried in order. Loads run with the GIL held, so the cache needs no
+// lock; a type object reallocated at a stale address costs one wrong try.
+template <typename Type, typename... Options>
+class duck_type_dispatch {
+ public:
+  static bool load(Type* pvalue, handle src, bool convert) {
+    if (!src) {
+      return false;
+    }
+    PyTypeObject* type = Py_TYPE(src.ptr());
+    const size_t hint = find(type, convert);
+    const size_t index = load_from(pvalue, src, convert, hint);
+    if (index != hint && index != none) {
+      winners(convert)[type] = index;
+    }
+    return index != none;
+  }
+
+  // Loads every item of a list, tuple, or other iterable (e.g. a 1-D
+  // array) in one call. Runs of items of the same Python type also skip the
+  // cache lookup.
+  static bool load_sequence(std::vector<Type>* out, handle src, bool convert) {
+    if (!src || PyUnicode_Check(src.ptr()) || PyBytes_Check(src.ptr())) {
+      return false;
+    }
+    object seq = reinterpret_steal<object>(PySequence_Fast(src.ptr(), ""));
+    if (!seq) {
+      PyErr_Clear();
+      return false;
+    }
+    const Py_ssize_t size = PySequence_Fast_GET_SIZE(seq.ptr());
+    PyObject** items = PySequence_Fast_ITEMS(seq.ptr());
+    out->clear();
+    out->resize(size);
+    PyTypeObject* last_type = nullptr;
+    size_t last = none;
+    for (Py_ssize_t i = 0; i < size; ++i) {
+      PyTypeObject* type = Py_TYPE(items[i]);
+      const size_t hint = type == last_type ? last : find(type, convert);
+      const size_t index = load_from(&(*out)[i], items[i], convert, hint);
+      if (index == none) {
+        return false;
+      }
+      if (index != hint) {
+        winners(convert)[type] = index;
+      }
+      last_type = type;
+      last = index;
+    }
+    return true;
+  }
+
+ private:
+  using loader = bool (*)(Type*, handle, bool);
+  static constexpr size_t none = sizeof...(Options);
+
+  template <typename Option>
+  static bool load_option(Type* pvalue, handle src, bool convert) {
+    type_caster<Option> opt_value;
+    if (!opt_value.load(src, convert)) {
+      return false;
+    }
+    *pvalue = opt_value;
+    return true;
+  }
+
+  static const loader* loaders() {
+    static const loader table[] = {&load_option<Options>...};
+    return table;
+  }
+
+  static std::unordered_map<PyTypeObject*, size_t>& winners(bool convert) {
+    static std::unordered_map<PyTypeObject*, size_t> cache[2];
+    return cache[convert];
+  }
+
+  static size_t find(PyTypeObject* type, bool convert) {
+    const auto& cache = winners(convert);
+    auto iter = cache.find(type);
+    return iter != cache.end() ? iter->second : none;
+  }
+
+  // Index of the option that loaded `src`, trying `hint` first; `none` if
+  // they all failed.
+  static size_t load_from(Type* pvalue, handle src, bool convert,
+                          size_t hint) {
+    if (hint != none && loaders()[hint](pvalue, src, convert)) {
+      return hint;
+    }
+    for (size_t i = 0; i < none; ++i) {
+      if (i != hint && loaders()[i](pvalue, src, convert)) {
+        return i;
+      }
+    }
+    return none;
+  }
+};
+
 // Duck-type type_caster mixin
 template <typename Type, typename... Options>
 struct duck_type_caster_mixin {
+  using dispatch = duck_type_dispatch<Type, Options...>;
+
   bool load_impl(Type* pvalue, handle src, bool convert) {
-    return duck_type_cast<Type, Options...>(pvalue, src, convert);
+    return dispatch::load(pvalue, src, convert);
   }
 
   static handle cast(Type src, return_value_policy policy, handle parent) {
@@ -235,3 +531,55 @@ struct type_caster<RelaxMatrix<T>>
 
 } // namespace pybind11
 } // namespace detail
+
+
+// Relaxed `std::vector<T>`: a whole list / tuple / 1-D array of relaxed
+// values, loaded in one pass (see `duck_type_dispatch::load_sequence`).
+// Requires `py_relax_type<T>` to have a `duck_type_caster_mixin` caster.
+
+template <typename T>
+class RelaxVector {
+public:
+  using Item = typename py_relax_type<T>::type;
+
+  RelaxVector() = default;
+  operator std::vector<T>() const {
+    return std::vector<T>(items_.begin(), items_.end());
+  }
+  std::vector<Item>& items() { return items_; }
+  const std::vector<Item>& items() const { return items_; }
+private:
+  std::vector<Item> items_;
+};
+
+template <typename T>
+struct name_trait<RelaxVector<T>> {
+  static constexpr auto name = name_trait<T>::name + _("_relax_list");
+};
+
+template <typename T>
+struct py_relax_type<std::vector<T>> { using type = RelaxVector<T>; };
+
+namespace pybind11 {
+namespace detail {
+
+template <typename T>
+struct type_caster<RelaxVector<T>> {
+  using Item = typename RelaxVector<T>::Item;
+
+  PYBIND11_TYPE_CASTER(RelaxVector<T>, name_trait<RelaxVector<T>>::name);
+
+  bool load(handle src, bool convert) {
+    return make_caster<Item>::dispatch::load_sequence(
+        &value.items(), src, convert);
+  }
+
+  static handle cast(const RelaxVector<T>& src, return_value_policy policy,
+                     handle parent) {
+    return make_caster<std::vector<T>>::cast(
+        static_cast<std::vector<T>>(src), policy, parent);
+  }
+};
+
+}  // namespace detail
+}  // namespace pybind11
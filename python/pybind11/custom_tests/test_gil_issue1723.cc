@@ -1,8 +1,15 @@
 // From: https://github.com/pybind/pybind11/issues/1723
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <thread>
-#include <future>
 #include <functional>
+#include <vector>
 
 #include <pybind11/embed.h>
 #include <pybind11/eval.h>
@@ -15,66 +22,257 @@ void hello() {
   std::cout << "hello\n";
 }
 
+// A Python callable that C++ code may copy and drop without holding the GIL:
+// only the `shared_ptr` count changes, and the callable itself is released
+// with the GIL held.
+using PyCallback = std::shared_ptr<py::function>;
+
+// Requires the GIL.
+PyCallback make_py_callback(py::function func) {
+  return PyCallback(new py::function(std::move(func)), [](py::function* f) {
+    py::gil_scoped_acquire lock{};
+    delete f;
+  });
+}
+
 // Keep this as C++ code!
-struct Executor {
+// One worker thread running callbacks from any number of producers, in
+// order. C++ callbacks run without the GIL. Consecutive pending Python
+// callbacks run as one batch under a single GIL acquisition (at most
+// `max_py_batch` calls, so the interpreter is not starved), instead of
+// acquiring it once per call; each is released before the GIL is dropped.
+class Executor {
+ public:
   using Callback = std::function<void ()>;
+  using Clock = std::chrono::steady_clock;
 
-  void execute() {
-    auto func = channel.get_future().get();
-    func();
-  }
+  struct Stats {
+    int64_t cpp_calls{};
+    int64_t py_calls{};
+    // Calls (of either kind) that threw; reported and skipped.
+    int64_t errors{};
+    // GIL acquisitions.
+    int64_t py_batches{};
+    size_t queue_depth{};
+    size_t max_queue_depth{};
+    // Time spent waiting to acquire the GIL.
+    Clock::duration gil_wait{};
+    Clock::duration max_gil_wait{};
+  };
 
-  explicit Executor()
-    : channel(),
-      worker([this]{execute();}) {
-  }
+  explicit Executor(size_t max_py_batch = 256)
+    : max_py_batch_(std::max<size_t>(max_py_batch, 1)),
+      worker_([this]{ execute(); }) {}
+
+  // Thread-safe; none of these need the GIL.
+  void run(Callback callback) { push(Item{std::move(callback), nullptr}); }
+  void run_py(PyCallback callback) { push(Item{nullptr, std::move(callback)}); }
 
-  void run(Callback callback) {
-    channel.set_value(callback);
+  // Blocks until everything queued so far has run. Must not hold the GIL.
+  void wait_idle() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this]{ return queue_.empty() && !busy_; });
   }
 
+  // Runs what is still queued, then joins the worker. Releases the GIL while
+  // joining if the caller holds it, since pending Python callbacks need it.
   void stop() {
-    if (!stopped) {
-      worker.join();
-      stopped = true;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stopping_) {
+        throw std::runtime_error("Cannot stop twice");
+      }
+      stopping_ = true;
+    }
+    wake_.notify_one();
+    if (Py_IsInitialized() && PyGILState_Check()) {
+      py::gil_scoped_release release{};
+      worker_.join();
     } else {
-      throw std::runtime_error("Cannot stop twice");
+      worker_.join();
     }
   }
 
-  std::promise<Callback> channel;
-  std::thread worker;
-  bool stopped{false};
+  Stats stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats out = stats_;
+    out.queue_depth = queue_.size();
+    return out;
+  }
 
   ~Executor() {
-    if (!stopped) {
-      std::cerr
-          << "WARNING: Joining thread in destructor for Python stuff might "
-             "be bad, b/c the `std::function<>` dtor could cause a decref "
-             "without GIL being held. Call `stop()` explicitly instead!\n";
-      stop();
+    bool stopping;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping = stopping_;
+    }
+    // Safe with or without the GIL: Python callbacks are only ever released
+    // by the worker (holding the GIL) or by `PyCallback`'s deleter.
+    if (!stopping) stop();
+  }
+
+ private:
+  struct Item {
+    Callback cpp;
+    PyCallback py;
+  };
+
+  void push(Item item) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stopping_) {
+        throw std::runtime_error("Executor is stopped");
+      }
+      queue_.push_back(std::move(item));
+      stats_.max_queue_depth =
+          std::max(stats_.max_queue_depth, queue_.size());
+    }
+    wake_.notify_one();
+  }
+
+  void execute() {
+    std::deque<Item> batch;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        busy_ = false;
+        if (queue_.empty()) idle_.notify_all();
+        wake_.wait(lock, [this]{ return stopping_ || !queue_.empty(); });
+        if (queue_.empty()) break;
+        batch.swap(queue_);
+        busy_ = true;
+      }
+      run_batch(&batch);
+    }
+  }
+
+  // Calls `func`; if it throws, reports it and returns false, so one bad
+  // callback does not take down the worker (or the process).
+  template <typename Func>
+  static bool call_reporting_errors(const char* kind, Func& func) {
+    try {
+      func();
+      return true;
+    } catch (py::error_already_set& e) {
+      std::cerr << "Executor: " << kind << " callback raised: " << e.what()
+                << "\n";
+    } catch (const std::exception& e) {
+      std::cerr << "Executor: " << kind << " callback threw: " << e.what()
+                << "\n";
+    } catch (...) {
+      std::cerr << "Executor: " << kind
+                << " callback threw an unknown exception\n";
+    }
+    return false;
+  }
+
+  void run_batch(std::deque<Item>* items) {
+    int64_t cpp_calls = 0;
+    int64_t py_calls = 0;
+    int64_t py_batches = 0;
+    int64_t errors = 0;
+    Clock::duration gil_wait{};
+    Clock::duration max_gil_wait{};
+    while (!items->empty()) {
+      if (!items->front().py) {
+        Callback callback = std::move(items->front().cpp);
+        items->pop_front();
+        errors += !call_reporting_errors("C++", callback);
+        ++cpp_calls;
+        continue;
+      }
+      const Clock::time_point start = Clock::now();
+      py::gil_scoped_acquire lock{};
+      const Clock::duration wait = Clock::now() - start;
+      gil_wait += wait;
+      max_gil_wait = std::max(max_gil_wait, wait);
+      ++py_batches;
+      for (size_t n = 0;
+           n < max_py_batch_ && !items->empty() && items->front().py; ++n) {
+        // Released at the end of the iteration, with the GIL held.
+        PyCallback callback = std::move(items->front().py);
+        items->pop_front();
+        errors += !call_reporting_errors("Python", *callback);
+        ++py_calls;
+      }
     }
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.cpp_calls += cpp_calls;
+    stats_.py_calls += py_calls;
+    stats_.py_batches += py_batches;
+    stats_.errors += errors;
+    stats_.gil_wait += gil_wait;
+    stats_.max_gil_wait = std::max(stats_.max_gil_wait, max_gil_wait);
   }
+
+  const size_t max_py_batch_;
+  mutable std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable idle_;
+  std::deque<Item> queue_;
+  bool busy_{true};
+  bool stopping_{false};
+  Stats stats_;
+  // Last, so it starts after everything above is constructed.
+  std::thread worker_;
 };
 
+// Submits `callback` `count` times from each of `producers` C++ threads at
+// `rate_hz`, as an event source would; the GIL is only held to wrap it.
+void fire_events(
+    Executor& executor, py::function callback, int count, double rate_hz,
+    int producers) {
+  const PyCallback shared = make_py_callback(std::move(callback));
+  py::gil_scoped_release release{};
+  const auto period = std::chrono::duration_cast<Executor::Clock::duration>(
+      std::chrono::duration<double>(1 / rate_hz));
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p) {
+    threads.emplace_back([&]() {
+      auto next = Executor::Clock::now();
+      for (int i = 0; i < count; ++i) {
+        executor.run_py(shared);
+        next += period;
+        std::this_thread::sleep_until(next);
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+}
+
 void init_module(py::module m) {
   m.def("hello", &hello, "Say hello");
   py::class_<Executor>(m, "Executor")
-      .def(py::init<>())
+      .def(py::init<size_t>(), py::arg("max_py_batch") = 256)
       .def("run",
-        [](Executor& self, Executor::Callback callback) {
-          // Acquire when executing potential Python code!
-          // In general, you will want wrapped stuff to do GIL acquisition.
-          // NOTE: I (eric) dunno if `cpp_function` automatically does this or
-          // not...
-          auto gil_callback = [callback]() {
-            pybind11::gil_scoped_acquire lock{};
-            callback();
-          };
-          self.run(gil_callback);
+        [](Executor& self, py::function callback) {
+          self.run_py(make_py_callback(std::move(callback)));
         },
         py::arg("callback"))
-      .def("stop", &Executor::stop);
+      .def("wait_idle",
+        [](Executor& self) {
+          py::gil_scoped_release release{};
+          self.wait_idle();
+        })
+      .def("stop", &Executor::stop)
+      .def("stats",
+        [](const Executor& self) {
+          const Executor::Stats s = self.stats();
+          using us = std::chrono::duration<double, std::micro>;
+          py::dict out;
+          out["cpp_calls"] = s.cpp_calls;
+          out["py_calls"] = s.py_calls;
+          out["py_batches"] = s.py_batches;
+          out["errors"] = s.errors;
+          out["queue_depth"] = s.queue_depth;
+          out["max_queue_depth"] = s.max_queue_depth;
+          out["gil_wait_us"] = us(s.gil_wait).count();
+          out["max_gil_wait_us"] = us(s.max_gil_wait).count();
+          return out;
+        });
+  m.def("fire_events", &fire_events, py::arg("executor"),
+        py::arg("callback"), py::arg("count"), py::arg("rate_hz"),
+        py::arg("producers") = 1);
 }
 
 int main(int, char**) {
@@ -94,9 +292,28 @@ def bye():
 m.hello()
 ex = m.Executor()
 ex.run(callback=bye)
-# Give thread time to execute.
-time.sleep(0.1)
+def fail():
+    raise RuntimeError("expected")
+ex.run(callback=fail)
+ex.run(callback=bye)  # Still runs.
 ex.stop()
+assert ex.stats()["errors"] == 1, ex.stats()
+assert ex.stats()["py_calls"] == 3, ex.stats()
+
+# kHz event handlers, with the main thread busy in Python meanwhile.
+for max_py_batch in [1, 256]:
+    calls = [0]
+    def handler():
+        calls[0] += 1
+    ex = m.Executor(max_py_batch=max_py_batch)
+    start = time.time()
+    m.fire_events(ex, handler, count=2000, rate_hz=4000, producers=2)
+    busy = sum(range(100000))
+    ex.wait_idle()
+    print("max_py_batch={}: {} calls in {:.3f}s, {}".format(
+        max_py_batch, calls[0], time.time() - start, ex.stats()))
+    # Not stopped: the destructor drains and releases the handler safely.
+    del ex
 )""");
 
   py::print("[ Done ]");
@@ -1,7 +1,9 @@
 #include <pybind11/pybind11.h>
+#include <vtkPoints.h>
 #include <vtkPolyData.h>
 
 #include "vtk_pybind.h"
+#include "vtk_pybind_numpy.h"
 
 namespace py = pybind11;
 using rvp = py::return_value_policy;
@@ -46,4 +48,16 @@ PYBIND11_MODULE(vtk_pybind_example, m) {
   m.def("take_poly_cref", [](const vtkPolyData& poly) {
     return poly.GetClassName();
   });
+
+  // Zero-copy NumPy views.
+  m.def("points_as_array", [](vtkPolyData* poly) {
+    return vtk_pybind::as_numpy(poly->GetPoints()->GetData());
+  });
+  m.def("array_as_numpy", &vtk_pybind::as_numpy);
+  m.def("make_points", &vtk_pybind::points_from_numpy);
+  m.def("get_point", [](vtkPoints* points, vtkIdType i) {
+    double p[3];
+    points->GetPoint(i, p);
+    return py::make_tuple(p[0], p[1], p[2]);
+  });
 }
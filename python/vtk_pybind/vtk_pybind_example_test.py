@@ -2,6 +2,7 @@ import sys
 import trace
 import unittest
 
+import numpy as np
 import vtk
 
 # Module under test.
@@ -38,6 +39,41 @@ class TestVtkPybind(unittest.TestCase):
         check_take(mut.take_poly_ref)
         check_take(mut.take_poly_cref)
 
+    def test_numpy_view_of_vtk(self):
+        points = vtk.vtkPoints()
+        points.SetDataTypeToFloat()
+        points.InsertNextPoint(1, 2, 3)
+        points.InsertNextPoint(4, 5, 6)
+        poly = vtk.vtkPolyData()
+        poly.SetPoints(points)
+        xyz = mut.points_as_array(poly)
+        self.assertEqual(xyz.dtype, np.float32)
+        np.testing.assert_equal(xyz, [[1, 2, 3], [4, 5, 6]])
+        # Writes are visible to VTK.
+        xyz[1, 0] = 40
+        self.assertEqual(points.GetPoint(1), (40, 5, 6))
+        # The view keeps the VTK array alive.
+        del poly, points
+        np.testing.assert_equal(xyz[1], [40, 5, 6])
+
+    def test_vtk_view_of_numpy(self):
+        xyz = np.arange(6, dtype=np.float64).reshape(2, 3)
+        points = mut.make_points(xyz)
+        self.assertEqual(points.GetNumberOfPoints(), 2)
+        self.assertEqual(mut.get_point(points, 1), (3, 4, 5))
+        # Writes are visible to NumPy, and back.
+        xyz[1, 2] = 50
+        self.assertEqual(points.GetPoint(1), (3, 4, 50))
+        view = mut.array_as_numpy(points.GetData())
+        self.assertTrue(np.shares_memory(view, xyz))
+        # The VTK array keeps `xyz` alive.
+        del xyz, view
+        self.assertEqual(points.GetPoint(1), (3, 4, 50))
+        with self.assertRaises(RuntimeError):
+            mut.make_points(np.zeros((2, 6))[:, ::2])
+        with self.assertRaises(RuntimeError):
+            mut.make_points(np.zeros((2, 3), dtype=np.int32))
+
 
 if __name__ == "__main__":
     sys.stdout = sys.stderr
@@ -0,0 +1,153 @@
+#pragma once
+
+/// @file
+/// Zero-copy NumPy <-> VTK data arrays.
+///
+/// `as_numpy(array)` returns a (tuples, components) view of a VTK array's
+/// storage; the view keeps the VTK object alive. `from_numpy(a)` returns a
+/// VTK array over `a`'s memory; the VTK array keeps `a` alive. Either side
+/// may write through the view. Resizing the VTK array (e.g.
+/// `InsertNextTuple`) reallocates its storage and invalidates NumPy views
+/// taken earlier.
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <vtkCallbackCommand.h>
+#include <vtkCommand.h>
+#include <vtkDataArray.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkSmartPointer.h>
+#include <vtkType.h>
+#include <vtkVersion.h>
+
+#include "vtk_pybind.h"
+
+namespace vtk_pybind {
+
+namespace py = pybind11;
+
+/// NumPy dtype of VTK type `type` (e.g. `VTK_FLOAT`).
+inline py::dtype dtype_from_vtk_type(int type) {
+  switch (type) {
+    case VTK_SIGNED_CHAR: return py::dtype::of<int8_t>();
+    case VTK_UNSIGNED_CHAR: return py::dtype::of<uint8_t>();
+    case VTK_SHORT: return py::dtype::of<int16_t>();
+    case VTK_UNSIGNED_SHORT: return py::dtype::of<uint16_t>();
+    case VTK_INT: return py::dtype::of<int32_t>();
+    case VTK_UNSIGNED_INT: return py::dtype::of<uint32_t>();
+    case VTK_LONG_LONG: return py::dtype::of<int64_t>();
+    case VTK_UNSIGNED_LONG_LONG: return py::dtype::of<uint64_t>();
+    case VTK_ID_TYPE: return py::dtype::of<vtkIdType>();
+    case VTK_FLOAT: return py::dtype::of<float>();
+    case VTK_DOUBLE: return py::dtype::of<double>();
+  }
+  throw std::runtime_error(
+      "vtk_pybind: no dtype for VTK type " + std::to_string(type));
+}
+
+/// VTK type of NumPy dtype `dtype`.
+inline int vtk_type_from_dtype(const py::dtype& dtype) {
+  const std::string kind = py::str(dtype.attr("kind"));
+  const auto size = dtype.itemsize();
+  const int* types = nullptr;
+  if (kind == "i") {
+    static const int kSigned[] = {
+        VTK_SIGNED_CHAR, VTK_SHORT, VTK_INT, VTK_LONG_LONG};
+    types = kSigned;
+  } else if (kind == "u") {
+    static const int kUnsigned[] = {
+        VTK_UNSIGNED_CHAR, VTK_UNSIGNED_SHORT, VTK_UNSIGNED_INT,
+        VTK_UNSIGNED_LONG_LONG};
+    types = kUnsigned;
+  } else if (kind == "f" && size >= 4) {
+    static const int kFloat[] = {-1, -1, VTK_FLOAT, VTK_DOUBLE};
+    types = kFloat;
+  }
+  const int log2_size = size == 1 ? 0 : size == 2 ? 1 : size == 4 ? 2 :
+      size == 8 ? 3 : -1;
+  if (!types || log2_size < 0 || types[log2_size] < 0) {
+    throw std::runtime_error(
+        "vtk_pybind: no VTK type for dtype " +
+        std::string(py::str(dtype)));
+  }
+  return types[log2_size];
+}
+
+/// (tuples, components) view of `array`'s storage, whose base is the VTK
+/// Python wrapper of `array`.
+inline py::array as_numpy(vtkDataArray* array) {
+  if (!array) {
+    throw std::runtime_error("vtk_pybind: null array");
+  }
+#if VTK_MAJOR_VERSION * 100 + VTK_MINOR_VERSION >= 701
+  const bool contiguous =
+      array->GetArrayType() == vtkAbstractArray::AoSDataArrayTemplate;
+#elif VTK_MAJOR_VERSION * 100 + VTK_MINOR_VERSION >= 601
+  const bool contiguous = array->HasStandardMemoryLayout();
+#else
+  const bool contiguous = true;
+#endif
+  if (!contiguous) {
+    throw std::runtime_error(
+        "vtk_pybind: cannot view non-contiguous " +
+        std::string(array->GetClassName()));
+  }
+  py::object base = py::reinterpret_steal<py::object>(
+      py::detail::type_caster<vtkDataArray>::cast(
+          array, py::return_value_policy::reference, {}));
+  const py::ssize_t item = array->GetDataTypeSize();
+  const py::ssize_t components = array->GetNumberOfComponents();
+  return py::array(
+      dtype_from_vtk_type(array->GetDataType()),
+      std::vector<py::ssize_t>{array->GetNumberOfTuples(), components},
+      std::vector<py::ssize_t>{components * item, item},
+      array->GetVoidPointer(0), base);
+}
+
+/// VTK array over `a`'s memory; `a` must be writeable, C-contiguous, and
+/// 1-D (one component) or 2-D (tuples, components). A reference to `a` is
+/// held until the VTK array is deleted.
+inline vtkSmartPointer<vtkDataArray> from_numpy(py::array a) {
+  if (!(a.flags() & py::array::c_style)) {
+    throw std::runtime_error("vtk_pybind: array must be C-contiguous");
+  }
+  if (a.ndim() != 1 && a.ndim() != 2) {
+    throw std::runtime_error("vtk_pybind: array must be 1-D or 2-D");
+  }
+  vtkSmartPointer<vtkDataArray> out;
+  out.TakeReference(
+      vtkDataArray::CreateDataArray(vtk_type_from_dtype(a.dtype())));
+  out->SetNumberOfComponents(a.ndim() == 2 ? a.shape(1) : 1);
+  // save = 1: VTK does not own the memory.
+  out->SetVoidArray(a.mutable_data(), a.size(), 1);
+  // The observer (and so `owner`) is released when `out` is deleted.
+  vtkNew<vtkCallbackCommand> release;
+  release->SetClientData(new py::object(a));
+  release->SetClientDataDeleteCallback([](void* owner) {
+    py::gil_scoped_acquire gil;
+    delete static_cast<py::object*>(owner);
+  });
+  out->AddObserver(vtkCommand::DeleteEvent, release);
+  return out;
+}
+
+/// Points over an (N, 3) float32 or float64 array; see `from_numpy`.
+inline vtkSmartPointer<vtkPoints> points_from_numpy(py::array xyz) {
+  if (xyz.ndim() != 2 || xyz.shape(1) != 3) {
+    throw std::runtime_error("vtk_pybind: points must be (N, 3)");
+  }
+  vtkSmartPointer<vtkDataArray> data = from_numpy(xyz);
+  if (data->GetDataType() != VTK_FLOAT && data->GetDataType() != VTK_DOUBLE) {
+    throw std::runtime_error("vtk_pybind: points must be float32 or float64");
+  }
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  points->SetData(data);
+  return points;
+}
+
+}  // namespace vtk_pybind
@@ -0,0 +1,203 @@
+// Round-trip latency / throughput of `std_msgs/UInt8MultiArray` messages from
+// 1 KB to 16 MB, inter-process vs. intra-process.
+//
+//   latency_bench pong                 # Echoes "ping" to "pong".
+//   latency_bench ping [round_trips]   # Sweeps sizes against a `pong`.
+//   latency_bench intra [round_trips]  # Both nodes in this process.
+//
+// `ping` sends one message at a time and waits for the echo (closed loop),
+// reusing the same message: intra-process, a round trip moves the
+// `unique_ptr` there and back without copying; inter-process, it serializes
+// and copies twice. Throughput is `2 * size / round trip`.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rclcpp/rclcpp.hpp"
+#define STRINGIFY(x) #x
+#define POODLE(PKG, MSG) STRINGIFY(PKG/msg/MSG.hpp)
+#include POODLE(std_msgs, u_int8_multi_array)
+
+namespace {
+
+using Bytes = std_msgs::msg::UInt8MultiArray;
+using Clock = std::chrono::steady_clock;
+using namespace std::chrono_literals;
+
+// Untimed round trips before each size.
+constexpr int kWarmup = 10;
+// An echo this late is considered lost, and the size is skipped.
+constexpr Clock::duration kTimeout = 5s;
+
+// Sizes swept, in bytes.
+std::vector<size_t> Sizes() {
+  std::vector<size_t> sizes;
+  for (size_t size = 1 << 10; size <= (16 << 20); size *= 4) {
+    sizes.push_back(size);
+  }
+  return sizes;
+}
+
+std::string SizeName(size_t size) {
+  return size >= (1 << 20) ? std::to_string(size >> 20) + " MB" :
+      std::to_string(size >> 10) + " KB";
+}
+
+// The first 8 bytes of each message carry a sequence number, so late echoes
+// (after a timeout) are recognized and dropped.
+uint64_t GetSequence(const Bytes& message) {
+  uint64_t sequence;
+  std::memcpy(&sequence, message.data.data(), sizeof(sequence));
+  return sequence;
+}
+
+void SetSequence(uint64_t sequence, Bytes* message) {
+  std::memcpy(message->data.data(), &sequence, sizeof(sequence));
+}
+
+class Pong : public rclcpp::Node {
+ public:
+  explicit Pong(bool intra = false)
+      : Node("pong", /*namespace_=*/"", /*use_intra_process_comms=*/intra) {
+    publisher_ = this->create_publisher<Bytes>("pong");
+    subscription_ = this->create_subscription<Bytes>(
+        "ping", [this](std::unique_ptr<Bytes> message) {
+          publisher_->publish(message);
+        });
+  }
+
+ private:
+  rclcpp::Publisher<Bytes>::SharedPtr publisher_;
+  rclcpp::Subscription<Bytes>::SharedPtr subscription_;
+};
+
+class Ping : public rclcpp::Node {
+ public:
+  explicit Ping(int round_trips, bool intra = false)
+      : Node("ping", /*namespace_=*/"", /*use_intra_process_comms=*/intra),
+        round_trips_(round_trips),
+        sizes_(Sizes()) {
+    publisher_ = this->create_publisher<Bytes>("ping");
+    subscription_ = this->create_subscription<Bytes>(
+        "pong", [this](std::unique_ptr<Bytes> message) {
+          OnPong(std::move(message));
+        });
+    std::printf("%10s %12s %12s %12s %12s\n", "size", "p50 (us)", "p90 (us)",
+                "max (us)", "MB/s");
+    // Give discovery a moment, then check for lost messages once a second.
+    timer_ = this->create_wall_timer(1s, [this]() { OnTimer(); });
+  }
+
+ private:
+  void StartSize() {
+    round_trips_done_ = -kWarmup;
+    round_trip_seconds_.clear();
+    auto message = std::make_unique<Bytes>();
+    message->data.resize(sizes_[size_index_]);
+    Send(std::move(message));
+  }
+
+  void Send(std::unique_ptr<Bytes> message) {
+    SetSequence(++sequence_, message.get());
+    sent_ = Clock::now();
+    publisher_->publish(message);
+  }
+
+  void OnPong(std::unique_ptr<Bytes> message) {
+    const Clock::time_point received = Clock::now();
+    if (GetSequence(*message) != sequence_) return;
+    if (round_trips_done_++ >= 0) {
+      round_trip_seconds_.push_back(
+          std::chrono::duration<double>(received - sent_).count());
+    }
+    if (round_trips_done_ < round_trips_) {
+      Send(std::move(message));
+    } else {
+      Report(false);
+      NextSize();
+    }
+  }
+
+  void OnTimer() {
+    if (!started_) {
+      started_ = true;
+      StartSize();
+    } else if (Clock::now() - sent_ > kTimeout) {
+      Report(true);
+      NextSize();
+    }
+  }
+
+  void NextSize() {
+    if (++size_index_ < sizes_.size()) {
+      StartSize();
+    } else {
+      timer_->cancel();
+      rclcpp::shutdown();
+    }
+  }
+
+  void Report(bool timed_out) {
+    const size_t size = sizes_[size_index_];
+    std::vector<double>& seconds = round_trip_seconds_;
+    if (seconds.empty()) {
+      std::printf("%10s %12s\n", SizeName(size).c_str(), "timeout");
+      return;
+    }
+    std::sort(seconds.begin(), seconds.end());
+    double total = 0;
+    for (double s : seconds) total += s;
+    const double mean = total / seconds.size();
+    std::printf("%10s %12.1f %12.1f %12.1f %12.1f%s\n",
+                SizeName(size).c_str(), 1e6 * seconds[seconds.size() / 2],
+                1e6 * seconds[seconds.size() * 9 / 10], 1e6 * seconds.back(),
+                2 * size / mean / 1e6, timed_out ? "  (timed out)" : "");
+  }
+
+  const int round_trips_;
+  const std::vector<size_t> sizes_;
+  rclcpp::Publisher<Bytes>::SharedPtr publisher_;
+  rclcpp::Subscription<Bytes>::SharedPtr subscription_;
+  rclcpp::TimerBase::SharedPtr timer_;
+  bool started_{};
+  size_t size_index_{};
+  int round_trips_done_{};
+  uint64_t sequence_{};
+  Clock::time_point sent_{Clock::now()};
+  std::vector<double> round_trip_seconds_;
+};
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  rclcpp::init(argc, argv);
+  const std::string mode = argc > 1 ? argv[1] : "";
+  const int round_trips = argc > 2 ? std::atoi(argv[2]) : 100;
+  std::printf("%s, %s\n", rmw_get_implementation_identifier(), mode.c_str());
+  if (mode == "pong") {
+    rclcpp::spin(std::make_shared<Pong>());
+  } else if (mode == "ping") {
+    rclcpp::spin(std::make_shared<Ping>(round_trips));
+  } else if (mode == "intra") {
+    auto ping = std::make_shared<Ping>(round_trips, /*intra=*/true);
+    auto pong = std::make_shared<Pong>(/*intra=*/true);
+    rclcpp::executors::SingleThreadedExecutor executor;
+    executor.add_node(ping);
+    executor.add_node(pong);
+    executor.spin();
+  } else {
+    std::fprintf(stderr, "usage: %s pong | ping [n] | intra [n]\n", argv[0]);
+    rclcpp::shutdown();
+    return 1;
+  }
+  // `Ping` shuts down when the sweep is done.
+  if (rclcpp::ok()) rclcpp::shutdown();
+  return 0;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+// Publisher / subscriber nodes shared by `pub.cc`, `sub.cc`, and
+// `pub_sub_intra.cc`.
+//
+// Messages are published as `std::unique_ptr`, and received as one. Across
+// processes this is the same as publishing by value, but when both nodes live
+// in one process and are constructed with `intra = true` (Crystal's
+// `use_intra_process_comms`), the message is handed over without being
+// copied or serialized (the printed addresses match).
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "rclcpp/rclcpp.hpp"
+#define STRINGIFY(x) #x
+#define POODLE(PKG, MSG) STRINGIFY(PKG/msg/MSG.hpp)
+#include POODLE(std_msgs, string)
+
+class Pub : public rclcpp::Node {
+ public:
+  explicit Pub(bool intra = false)
+      : Node("pub", /*namespace_=*/"", /*use_intra_process_comms=*/intra) {
+    using namespace std::chrono_literals;
+    auto publisher = this->create_publisher<std_msgs::msg::String>("topic");
+    auto callback = [this, publisher]() {
+      auto message = std::make_unique<std_msgs::msg::String>();
+      message->data = "Hello, world! " + std::to_string(count_);
+      count_ += 1;
+      std::cout << "Pub: " << message->data << " (" << message.get() << ")\n";
+      // Ownership moves to the (intra-process) subscriber, if any.
+      publisher->publish(message);
+    };
+    timer_ = this->create_wall_timer(500ms, callback);
+  }
+
+ private:
+  rclcpp::TimerBase::SharedPtr timer_;
+  int count_{};
+};
+
+class Sub : public rclcpp::Node {
+ public:
+  explicit Sub(bool intra = false)
+      : Node("sub", /*namespace_=*/"", /*use_intra_process_comms=*/intra) {
+    subscription_ = this->create_subscription<std_msgs::msg::String>(
+        "topic", [](std::unique_ptr<std_msgs::msg::String> message) {
+          std::cout << "Sub: " << message->data << " (" << message.get()
+                    << ")\n";
+        });
+  }
+
+ private:
+  rclcpp::Subscription<std_msgs::msg::String>::SharedPtr subscription_;
+};
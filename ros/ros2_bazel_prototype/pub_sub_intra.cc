@@ -0,0 +1,16 @@
+// `pub` and `sub` in one process, with intra-process comms: each message is
+// moved from the publisher to the subscriber, never copied or serialized.
+#include "pub_sub.h"
+
+int main(int argc, char* argv[]) {
+  rclcpp::init(argc, argv);
+  std::cout << rmw_get_implementation_identifier() << std::endl;
+  auto pub = std::make_shared<Pub>(/*intra=*/true);
+  auto sub = std::make_shared<Sub>(/*intra=*/true);
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(pub);
+  executor.add_node(sub);
+  executor.spin();
+  rclcpp::shutdown();
+  return 0;
+}
@@ -0,0 +1,10 @@
+// Based on `examples/rclcpp/minimal_subscriber` @ 2dbcf9f
+#include "pub_sub.h"
+
+int main(int argc, char* argv[]) {
+  rclcpp::init(argc, argv);
+  std::cout << rmw_get_implementation_identifier() << std::endl;
+  rclcpp::spin(std::make_shared<Sub>());
+  rclcpp::shutdown();
+  return 0;
+}